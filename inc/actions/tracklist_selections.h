@@ -25,6 +25,8 @@
 #include "audio/track.h"
 #include "gui/backend/tracklist_selections.h"
 
+typedef struct MidiFile MidiFile;
+
 /**
  * @addtogroup actions
  *
@@ -137,6 +139,11 @@ typedef struct TracklistSelectionsAction
    */
   int                   pool_id;
 
+  /** MIDI file parsed once when making MIDI
+   * tracks from a file, shared by all the tracks
+   * (not serialized). */
+  MidiFile *            midi_file;
+
   /** Source sends that need to be deleted/
    * recreated on do/undo. */
   ChannelSend *         src_sends;
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Interval index of the audio regions of a track,
+ * used during playback.
+ */
+
+#ifndef __AUDIO_AUDIO_REGION_INDEX_H__
+#define __AUDIO_AUDIO_REGION_INDEX_H__
+
+#include <stdbool.h>
+
+#include "audio/curve.h"
+#include "utils/types.h"
+
+typedef struct Track Track;
+typedef struct AudioClip AudioClip;
+typedef struct StretchCache StretchCache;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Playback information of an audio region,
+ * computed when the index is built.
+ *
+ * Positions other than the start and end are
+ * relative to the region start.
+ */
+typedef struct AudioRegionIndexEntry
+{
+  /** Global start position in frames. */
+  long          start_frames;
+
+  /** Global end position in frames. */
+  long          end_frames;
+
+  long          loop_start_frames;
+  long          loop_end_frames;
+
+  /** Loop length in frames. */
+  long          loop_frames;
+
+  long          clip_start_frames;
+
+  /** Fade in end position in frames. */
+  long          fade_in_frames;
+
+  /** Fade out start position in frames. */
+  long          fade_out_frames;
+
+  /** Length of the fade out in frames. */
+  long          fade_out_len;
+
+  CurveOptions  fade_in_opts;
+  CurveOptions  fade_out_opts;
+
+  /** Clip to play. */
+  AudioClip *   clip;
+
+  /** Stretched frames of the region if it is in
+   * musical mode, otherwise NULL (a reference is
+   * held). */
+  StretchCache * stretch_cache;
+
+  /** Lane the region is in. */
+  int           lane_pos;
+
+  /** Whether the region is in musical mode. */
+  bool          musical_mode;
+
+  /** Whether the region should be bounced. */
+  bool          bounce;
+} AudioRegionIndexEntry;
+
+/**
+ * Index of the unmuted audio regions in all the
+ * lanes of a track, sorted by start position.
+ *
+ * The entries hold copies of everything needed
+ * for playback, so the index stays valid when
+ * regions are changed or freed until it is
+ * replaced.
+ *
+ * An index is immutable once published to the
+ * engine: changes create a new index that
+ * replaces the old one atomically, and the old one
+ * is freed later.
+ */
+typedef struct AudioRegionIndex
+{
+  /** Entries, sorted by start position. */
+  AudioRegionIndexEntry * entries;
+
+  /**
+   * Maximum end position of the entries up to
+   * and including each entry.
+   *
+   * This is non-decreasing, so the first entry
+   * that can overlap a range can be found with a
+   * binary search.
+   */
+  long *                  max_end_frames;
+
+  int                     num_entries;
+} AudioRegionIndex;
+
+/**
+ * Creates an index of the audio regions in the
+ * lanes of the given track.
+ *
+ * @note Not real-time safe.
+ */
+AudioRegionIndex *
+audio_region_index_new_from_track (
+  Track * track);
+
+/**
+ * Returns the index of the first entry that can
+ * overlap a range starting at the given frames,
+ * or AudioRegionIndex.num_entries if none can.
+ *
+ * Entries after the returned one must still be
+ * checked against the range, until one that
+ * starts after the range is found.
+ */
+int
+audio_region_index_find_first (
+  const AudioRegionIndex * self,
+  long                     start_frames);
+
+void
+audio_region_index_free (
+  AudioRegionIndex * self);
+
+/**
+ * @}
+ */
+
+#endif
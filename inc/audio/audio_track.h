@@ -39,15 +39,49 @@ audio_track_init (Track * track);
 void
 audio_track_setup (AudioTrack * self);
 
+/**
+ * Adds the frames of the regions that are hit in
+ * the given range to the given buffers.
+ *
+ * Only the regions in the track's region index
+ * overlapping the range are visited.
+ *
+ * Regions in musical mode are read from their
+ * stretched frames when they are ready for the
+ * current BPM, otherwise they are stretched in
+ * realtime. The regions that are not stretched in
+ * realtime are delayed by
+ * TrackProcessor.playback_latency.
+ *
+ * @param local_offset The local start frames.
+ * @param group Region group to fill (see
+ *   TrackProcessor.region_group_bufs), or -1 to
+ *   fill all regions.
+ * @param num_groups Number of region groups.
+ */
+void
+audio_track_fill_bufs_from_clips (
+  Track *         self,
+  float *         l,
+  float *         r,
+  const long      g_start_frames,
+  const nframes_t local_offset,
+  const nframes_t nframes,
+  const int       group,
+  const int       num_groups);
+
 /**
  * Fills the buffers in the given StereoPorts with
  * the frames from the current clip.
+ *
+ * @param local_offset The local start frames.
  */
 void
 audio_track_fill_stereo_ports_from_clip (
   Track *         self,
   StereoPorts *   stereo_ports,
   const long      g_start_frames,
-  nframes_t       nframes);
+  const nframes_t local_offset,
+  const nframes_t nframes);
 
 #endif // __AUDIO_TRACK_H__
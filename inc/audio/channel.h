@@ -362,6 +362,17 @@ void
 channel_set_balance_control (
   void * _channel, float pan);
 
+/**
+ * Sets the pan at the start of the next
+ * processing cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+channel_queue_balance_control (
+  void * _channel,
+  float  pan);
+
 /**
  * Adds to (or subtracts from) the pan.
  */
@@ -434,6 +445,8 @@ channel_set_current_r_db (
 
 /**
  * Sets fader to 0.0.
+ *
+ * To be used by the GTK thread.
  */
 void
 channel_reset_fader (Channel * channel);
@@ -31,6 +31,8 @@
 #include "utils/types.h"
 #include "utils/yaml.h"
 
+typedef struct AudioEncoder AudioEncoder;
+
 /**
  * @addtogroup audio
  *
@@ -93,6 +95,45 @@ typedef struct AudioClip
    * @see AudioClip.frames_written.
    */
   gint64        last_write;
+
+  /**
+   * Whether the frames are still being decoded in
+   * the background (not serialized).
+   *
+   * The clip has its final length but is silent
+   * until decoding finishes, and it is written to
+   * the pool by the decoder.
+   */
+  bool          decoding;
+
+  /**
+   * Number of regions in the arrangement and
+   * frozen tracks using the clip (not
+   * serialized).
+   *
+   * @see audio_pool_reload_clip_frame_bufs().
+   */
+  int           num_refs;
+
+  /** Number of references from the undo and
+   * redo history (not serialized). */
+  int           num_undo_refs;
+
+  /** Last time the clip was used in the
+   * arrangement, used to unload the least
+   * recently used clips first. */
+  gint64        last_used;
+
+  /**
+   * Number given when the clip is added to the
+   * pool, unique for the lifetime of the pool
+   * (not serialized).
+   *
+   * Used by background jobs to tell the clip
+   * apart from clips added later with the same
+   * pool ID.
+   */
+  unsigned int  generation;
 } AudioClip;
 
 static const cyaml_schema_field_t
@@ -134,6 +175,24 @@ AudioClip *
 audio_clip_new_from_file (
   const char * full_path);
 
+/**
+ * Creates a silent audio clip with the length the
+ * given file will have when decoded at the project
+ * sample rate.
+ *
+ * The name used is the basename of the file.
+ *
+ * @param[out] enc The encoder to decode the file
+ *   with (see audio_encoder_decode()).
+ *
+ * @return The clip, or NULL if the file could not
+ *   be opened.
+ */
+AudioClip *
+audio_clip_new_placeholder_from_file (
+  const char *    full_path,
+  AudioEncoder ** enc);
+
 /**
  * Creates an audio clip by copying the given float
  * array.
@@ -210,15 +269,6 @@ char *
 audio_clip_get_path_in_pool (
   AudioClip * self);
 
-/**
- * Returns whether the clip is used inside the
- * project (in actual project regions only, not
- * in undo stack).
- */
-bool
-audio_clip_is_in_use (
-  AudioClip * self);
-
 /**
  * To be called by audio_pool_remove_clip().
  *
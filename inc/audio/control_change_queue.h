@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Lock-free queue of control port value changes.
+ */
+
+#ifndef __AUDIO_CONTROL_CHANGE_QUEUE_H__
+#define __AUDIO_CONTROL_CHANGE_QUEUE_H__
+
+#include <stdbool.h>
+
+#include "utils/mpmc_queue.h"
+
+typedef struct Port Port;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/** Max number of changes waiting to be
+ * processed. */
+#define CONTROL_CHANGE_QUEUE_SIZE 1024
+
+/**
+ * A value change for a control port.
+ */
+typedef struct ControlChange
+{
+  Port *     port;
+
+  /** Value to set, or the value that was set. */
+  float      val;
+
+  /** Whether \ref ControlChange.val is
+   * normalized. */
+  bool       is_normalized;
+
+  /** Whether to forward a port control change
+   * event to the plugin UI. */
+  bool       forward_event;
+} ControlChange;
+
+/**
+ * Queue of control value changes passed between
+ * the GTK thread and the DSP thread without
+ * locking.
+ *
+ * Changes are stored in a preallocated array and
+ * passed around by pointer through 2 lock-free
+ * queues: one with the free slots and one with the
+ * pending changes, so neither side allocates or
+ * blocks.
+ */
+typedef struct ControlChangeQueue
+{
+  /** Preallocated changes. */
+  ControlChange * changes;
+
+  /** Changes available for pushing. */
+  MPMCQueue *     free_changes;
+
+  /** Changes pushed and not yet popped. */
+  MPMCQueue *     pending;
+} ControlChangeQueue;
+
+ControlChangeQueue *
+control_change_queue_new (void);
+
+/**
+ * Pushes a change to the queue.
+ *
+ * Realtime-safe.
+ *
+ * @return Whether the change was pushed (false if
+ *   the queue is full).
+ */
+bool
+control_change_queue_push (
+  ControlChangeQueue * self,
+  Port *               port,
+  float                val,
+  bool                 is_normalized,
+  bool                 forward_event);
+
+/**
+ * Pops the oldest change from the queue into
+ * \p change.
+ *
+ * Realtime-safe.
+ *
+ * @return Whether there was a change to pop.
+ */
+bool
+control_change_queue_pop (
+  ControlChangeQueue * self,
+  ControlChange *      change);
+
+/**
+ * Sets the values of all the pending changes in
+ * the order they were pushed.
+ *
+ * To be called by the DSP thread at the start of
+ * each cycle.
+ */
+void
+control_change_queue_apply (
+  ControlChangeQueue * self);
+
+/**
+ * Discards all the pending changes.
+ */
+void
+control_change_queue_clear (
+  ControlChangeQueue * self);
+
+void
+control_change_queue_free (
+  ControlChangeQueue * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -109,6 +109,18 @@ control_port_get_snapped_val_from_val (
   Port * self,
   float  val);
 
+/**
+ * Returns the snapped real value of the port's
+ * automation at the given timeline frames.
+ *
+ * To be used during processing for ports that
+ * have Port.automation_read set.
+ */
+float
+control_port_get_automation_val_at_frames (
+  Port * self,
+  long   g_frames);
+
 /**
  * Get the current real value of the control.
  *
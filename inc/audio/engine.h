@@ -35,6 +35,7 @@
 #include "audio/pool.h"
 #include "audio/sample_processor.h"
 #include "audio/transport.h"
+#include "utils/delay_locked_loop.h"
 #include "utils/types.h"
 #include "zix/sem.h"
 
@@ -48,6 +49,7 @@
 
 #ifdef HAVE_ALSA
 #include <alsa/asoundlib.h>
+#include <pthread.h>
 #endif
 
 #ifdef HAVE_SDL
@@ -70,6 +72,8 @@ typedef struct Router Router;
 typedef struct Metronome Metronome;
 typedef struct Project Project;
 typedef struct HardwareProcessor HardwareProcessor;
+typedef struct TempoMap TempoMap;
+typedef struct ControlChangeQueue ControlChangeQueue;
 
 /**
  * @addtogroup audio Audio
@@ -80,6 +84,10 @@ typedef struct HardwareProcessor HardwareProcessor;
 #define BLOCK_LENGTH 4096 // should be set by backend
 #define MIDI_BUF_SIZE 1024 // should be set by backend
 
+/** Default interval in frames at which automation
+ * is evaluated within a cycle. */
+#define ENGINE_DEFAULT_AUTOMATION_GRANULARITY 64
+
 #define MIDI_IN_NUM_EVENTS \
   AUDIO_ENGINE->midi_in->midi_events->num_events
 
@@ -213,7 +221,7 @@ static const char * audio_backend_str[] =
   /* TRANSLATORS: Dummy backend */
   __("Dummy"),
   __("Dummy (libsoundio)"),
-  "ALSA (not working)",
+  "ALSA",
   "ALSA (libsoundio)",
   "ALSA (rtaudio)",
   "JACK",
@@ -337,6 +345,16 @@ typedef struct AudioEngine
   /** Audio buffer size (block length). */
   nframes_t         block_length;
 
+  /**
+   * Interval in frames at which automation is
+   * evaluated within a cycle.
+   *
+   * Faders ramp their gain between these points
+   * and plugins with automated parameters are
+   * processed in sub-blocks of this size.
+   */
+  nframes_t         automation_granularity;
+
   /** Size of MIDI port buffers. */
   size_t            midi_buf_size;
 
@@ -346,6 +364,18 @@ typedef struct AudioEngine
   /** Number of frames/samples per tick. */
   double            frames_per_tick;
 
+  /**
+   * Tempo map used for frame/tick conversions.
+   *
+   * This is replaced atomically and must be
+   * accessed with engine_get_tempo_map().
+   */
+  TempoMap *        tempo_map;
+
+  /** Set when the tempo map needs to be
+   * rebuilt. */
+  volatile gint     tempo_map_dirty;
+
   /** True iff buffer size callback fired. */
   int               buf_size_set;
 
@@ -447,6 +477,22 @@ typedef struct AudioEngine
    * its ports are deleted. */
   ZixSem            port_operation_lock;
 
+  /**
+   * Control value changes from the GTK thread, set
+   * at the start of the next cycle.
+   *
+   * Pending changes are kept across skipped
+   * cycles.
+   */
+  ControlChangeQueue * ctrl_in_queue;
+
+  /**
+   * Control values changed by the DSP thread,
+   * passed to the GTK thread to update the UI
+   * without pushing events from the DSP thread.
+   */
+  ControlChangeQueue * ctrl_out_queue;
+
   /** Ok to process or not. */
   volatile gint     run;
 
@@ -465,11 +511,49 @@ typedef struct AudioEngine
 #ifdef HAVE_ALSA
   /** Alsa playback handle. */
   snd_pcm_t *       playback_handle;
+
+  /** Alsa capture handle, or NULL if the device
+   * can't capture. */
+  snd_pcm_t *       capture_handle;
   snd_seq_t *       seq_handle;
-  snd_pcm_hw_params_t * hw_params;
-  snd_pcm_sw_params_t * sw_params;
-  /** ALSA audio buffer. */
-  float *           alsa_out_buf;
+
+  /** Name of the opened device. */
+  char *            alsa_device;
+
+  snd_pcm_format_t  alsa_playback_format;
+  snd_pcm_format_t  alsa_capture_format;
+  unsigned int      alsa_num_playback_channels;
+  unsigned int      alsa_num_capture_channels;
+
+  /** Whether the capture stream is linked to the
+   * playback stream (sample-synchronous). */
+  bool              alsa_linked;
+
+  /**
+   * Memory-mapped device areas for the period
+   * being processed, or NULL outside processing.
+   *
+   * Hardware inputs are read and the monitor
+   * output is written directly from/to these.
+   */
+  const snd_pcm_channel_area_t * alsa_playback_areas;
+  snd_pcm_uframes_t alsa_playback_offset;
+  const snd_pcm_channel_area_t * alsa_capture_areas;
+  snd_pcm_uframes_t alsa_capture_offset;
+
+  /** ALSA audio thread. */
+  pthread_t         alsa_thread;
+
+  /** Whether \ref AudioEngine.alsa_thread was
+   * created and needs to be joined. */
+  bool              alsa_thread_started;
+
+  /** Set to 1 to stop the ALSA audio thread. */
+  volatile gint     alsa_stop;
+
+  /** Number of xruns since the device was
+   * opened. */
+  volatile gint     alsa_num_xruns;
 
   /**
    * Since ALSA MIDI runs in its own thread,
@@ -529,6 +613,19 @@ typedef struct AudioEngine
   /** Set to 1 to stop the dummy audio thread. */
   int               stop_dummy_audio_thread;
 
+  /**
+   * Whether the dummy audio thread should process
+   * cycles back to back without sleeping
+   * (freewheeling).
+   *
+   * Used for benchmarking.
+   */
+  volatile gint     dummy_freewheel;
+
+  /** Number of cycles processed by the dummy
+   * audio thread. */
+  volatile gint     dummy_num_cycles;
+
   /**
    * Timeline metadata like BPM, time signature, etc.
    */
@@ -555,6 +652,14 @@ typedef struct AudioEngine
    * cycle. */
   gint64            timestamp_end;
 
+  /**
+   * Loop filtering the cycle start times, used to
+   * place external MIDI events at exact frames.
+   *
+   * @see port_prepare_rtmidi_events().
+   */
+  DelayLockedLoop   dll;
+
   /** When first set, it is equal to the max
    * playback latency of all initial trigger
    * nodes. */
@@ -728,6 +833,46 @@ engine_update_frames_per_tick (
   const float         bpm,
   const sample_rate_t sample_rate);
 
+/**
+ * Returns the current tempo map.
+ *
+ * Safe to call from any thread.
+ */
+#define engine_get_tempo_map(self) \
+  ((TempoMap *) \
+   g_atomic_pointer_get (&(self)->tempo_map))
+
+/**
+ * Marks the tempo map as needing to be rebuilt.
+ *
+ * The map will be rebuilt in the GTK thread.
+ */
+#define engine_set_tempo_map_dirty(self) \
+  g_atomic_int_set (&(self)->tempo_map_dirty, 1)
+
+/**
+ * Applies the pending control changes from the GTK
+ * thread and publishes the pending changes from
+ * the DSP thread, so that the queues do not point
+ * to ports that are about to be freed.
+ *
+ * Must be called from the GTK thread while the
+ * engine is paused.
+ */
+void
+engine_flush_control_changes (
+  AudioEngine * self);
+
+/**
+ * Rebuilds the tempo map from the tempo track and
+ * publishes it to the DSP threads.
+ *
+ * @note Not real-time safe.
+ */
+void
+engine_update_tempo_map (
+  AudioEngine * self);
+
 /**
  * To be called by each implementation to prepare the
  * structures before processing.
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2019 Alexandros Theodotou <alex at zrythm dot org>
+ * Copyright (C) 2019-2021 Alexandros Theodotou <alex at zrythm dot org>
  *
  * This file is part of Zrythm
  *
@@ -17,27 +17,66 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#if 0
+/**
+ * \file
+ *
+ * Native ALSA audio backend.
+ */
+
+#include "zrythm-config.h"
 
 #ifdef HAVE_ALSA
 
 #ifndef __AUDIO_ENGINE_ALSA_H__
 #define __AUDIO_ENGINE_ALSA_H__
 
-#include <stdlib.h>
+#include <stdbool.h>
 
 #include "utils/types.h"
 
+#include <gtk/gtk.h>
+
 typedef struct AudioEngine AudioEngine;
 
 /**
- * Copy the cached MIDI events to the MIDI events
- * in the MIDI in port, used at the start of each
- * cycle. */
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/** Device used when none is selected. */
+#define ENGINE_ALSA_DEFAULT_DEVICE "hw:0"
+
+/** Max number of capture channels exposed. */
+#define ENGINE_ALSA_MAX_CHANNELS 64
+
+/** SCHED_FIFO priority of the audio thread. */
+#define ENGINE_ALSA_RT_PRIORITY 70
+
+/**
+ * Opens the selected device for playback and, if
+ * possible, capture, and configures it with the
+ * selected sample rate, period size and period
+ * count.
+ *
+ * @return Non-zero if fail.
+ */
+int
+engine_alsa_setup (
+  AudioEngine * self);
+
+/**
+ * Returns a list of names inside \ref names that
+ * must be free'd.
+ *
+ * @param input 1 for input, 0 for output.
+ */
 void
-engine_alsa_receive_midi_events (
+engine_alsa_get_device_names (
   AudioEngine * self,
-  int           print);
+  int           input,
+  char **       names,
+  int *         num_names);
 
 /**
  * Tests if ALSA works.
@@ -50,18 +89,26 @@ int
 engine_alsa_test (
   GtkWindow * win);
 
-int
-engine_alsa_midi_setup (
-  AudioEngine * self);
+/**
+ * Starts or stops the audio thread.
+ */
+void
+engine_alsa_activate (
+  AudioEngine * self,
+  bool          activate);
 
 /**
- * Prepares for processing.
+ * Copies the given capture channel of the current
+ * period into the given buffer.
  *
- * Called at the start of each process cycle.
+ * To be called during processing.
  */
 void
-engine_alsa_prepare_process (
-  AudioEngine * self);
+engine_alsa_read_capture (
+  AudioEngine *   self,
+  unsigned int    channel,
+  float *         buf,
+  const nframes_t nframes);
 
 /**
  * Fill the output buffers at the end of the
@@ -73,16 +120,15 @@ engine_alsa_fill_out_bufs (
   const nframes_t nframes);
 
 /**
- * Sets up the audio engine to use alsa.
+ * Closes the device.
  */
-int
-engine_alsa_setup (
-  AudioEngine * self,
-  int           loading);
-
 void
-engine_alsa_tear_down (void);
+engine_alsa_tear_down (
+  AudioEngine * self);
+
+/**
+ * @}
+ */
 
 #endif // header guard
 #endif // HAVE_ALSA
-#endif
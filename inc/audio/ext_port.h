@@ -118,6 +118,9 @@ typedef struct ExtPort
   /** RtAudio channel index. */
   unsigned int     rtaudio_channel_idx;
 
+  /** ALSA capture channel index. */
+  unsigned int     alsa_channel_idx;
+
   /** RtAudio device name. */
   char *           rtaudio_dev_name;
 
@@ -179,6 +182,9 @@ ext_port_fields_schema[] =
     ExtPort, type, ext_port_type_strings),
   YAML_FIELD_UINT (
     ExtPort, rtaudio_channel_idx),
+  CYAML_FIELD_UINT (
+    "alsa_channel_idx", CYAML_FLAG_OPTIONAL,
+    ExtPort, alsa_channel_idx),
 
   CYAML_FIELD_END
 };
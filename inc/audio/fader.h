@@ -248,6 +248,17 @@ fader_set_amp (
   void * self,
   float   amp);
 
+/**
+ * Sets the amplitude of the fader (0.0 to 2.0) at
+ * the start of the next processing cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+fader_queue_amp (
+  void * self,
+  float  amp);
+
 /**
  * Adds (or subtracts if negative) to the amplitude
  * of the fader (clamped at 0.0 to 2.0).
@@ -310,6 +321,17 @@ float
 fader_get_amp (
   void * self);
 
+/**
+ * Gets the fader amplitude (not db), including
+ * changes queued with fader_queue_amp() that might
+ * not be applied to the port yet.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+float
+fader_get_queued_amp (
+  void * self);
+
 /**
  * Gets whether mono compatibility is enabled.
  */
@@ -356,13 +378,25 @@ fader_clear_buffers (
 
 /**
  * Sets the fader levels from a normalized value
- * 0.0-1.0 (such as in widgets).
+ * 0.0-1.0.
  */
 void
 fader_set_fader_val (
   Fader * self,
   float   fader_val);
 
+/**
+ * Sets the fader levels from a normalized value
+ * 0.0-1.0 at the start of the next processing
+ * cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+fader_queue_fader_val (
+  Fader * self,
+  float   fader_val);
+
 /**
  * Disconnects all ports connected to the fader.
  */
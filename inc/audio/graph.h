@@ -152,6 +152,21 @@ typedef struct Graph
   GraphThread *        main_thread;
   gint                 num_threads;
 
+  /** Whether to collect per-node DSP stats.
+   *
+   * @see graph_profiler_set_enabled(). */
+  volatile gint        profiling;
+
+  /** Whether the DSP threads should reset the
+   * profiling stats at the start of the next
+   * cycle.
+   *
+   * @see graph_profiler_reset(). */
+  volatile gint        profiling_reset_requested;
+
+  /** Time the profiling stats were last reset. */
+  gint64               profiling_start_ns;
+
 } Graph;
 
 void
@@ -46,12 +46,14 @@
 
 #include <stdbool.h>
 
+#include "audio/graph_profiler.h"
 #include "utils/types.h"
 
 #include <gtk/gtk.h>
 
 typedef struct GraphNode GraphNode;
 typedef struct Graph Graph;
+typedef struct GraphThread GraphThread;
 typedef struct PassthroughProcessor
   PassthroughProcessor;
 typedef struct Port Port;
@@ -103,6 +105,13 @@ typedef enum GraphNodeType
   ROUTE_NODE_TYPE_HW_PROCESSOR,
 
   ROUTE_NODE_TYPE_MODULATOR_MACRO_PROCESOR,
+
+  /**
+   * Region group of an audio track.
+   *
+   * @see TrackProcessor.region_group_bufs.
+   */
+  ROUTE_NODE_TYPE_REGION_GROUP,
 } GraphNodeType;
 
 /**
@@ -143,6 +152,9 @@ typedef struct GraphNode
 
   Track *       track;
 
+  /** Region group index, if region group. */
+  int           region_group;
+
   /** Pre-Fader, if prefader node. */
   Fader *       prefader;
 
@@ -166,6 +178,10 @@ typedef struct GraphNode
   nframes_t     route_playback_latency;
 
   GraphNodeType type;
+
+  /** DSP stats, collected when profiling is
+   * enabled. */
+  GraphNodeStats stats;
 } GraphNode;
 
 /**
@@ -187,17 +203,22 @@ graph_node_print (
 
 /**
  * Processes the GraphNode.
+ *
+ * @param thread The thread processing the node,
+ *   used for profiling.
  */
 void
 graph_node_process (
-  GraphNode * node,
-  nframes_t   nframes);
+  GraphNode *   node,
+  nframes_t     nframes,
+  GraphThread * thread);
 
 /**
  * Returns the latency of only the given port,
  * without adding the previous/next latencies.
  *
  * It returns the plugin's latency if plugin,
+ * the latency of the realtime stretcher if track,
  * otherwise 0.
  */
 nframes_t
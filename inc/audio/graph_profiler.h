@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Per-node DSP load profiling for the routing
+ * graph.
+ */
+
+#ifndef __AUDIO_GRAPH_PROFILER_H__
+#define __AUDIO_GRAPH_PROFILER_H__
+
+#include <stdbool.h>
+#include <time.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct Graph Graph;
+typedef struct GraphNode GraphNode;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Number of histogram bins.
+ *
+ * Bin 0 holds durations below 1 microsecond and
+ * bin N holds durations in [2^(N-1), 2^N)
+ * microseconds. The last bin holds everything
+ * above.
+ */
+#define GRAPH_PROFILER_NUM_HIST_BINS 20
+
+/** Number of trace events kept per thread. */
+#define GRAPH_PROFILER_TRACE_SIZE 16384
+
+/** Returns whether profiling is enabled on the
+ * given graph. */
+#define graph_profiler_is_enabled(graph) \
+  g_atomic_int_get (&(graph)->profiling)
+
+/**
+ * Statistics for a single GraphNode.
+ *
+ * A node is processed by only 1 thread per cycle,
+ * so these are written without locking.
+ */
+typedef struct GraphNodeStats
+{
+  /** Time taken in the last run. */
+  gint64       last_ns;
+
+  /** Worst-case time taken. */
+  gint64       max_ns;
+
+  /** Total time taken since the last reset. */
+  gint64       total_ns;
+
+  /** Time the node was pushed to the trigger
+   * queue, or 0. */
+  gint64       queued_at_ns;
+
+  /** Worst-case time spent in the trigger
+   * queue. */
+  gint64       max_queue_wait_ns;
+
+  /** Total time spent in the trigger queue. */
+  gint64       total_queue_wait_ns;
+
+  /** Number of runs since the last reset. */
+  guint64      num_runs;
+
+  /** Duration histogram. */
+  guint        hist[GRAPH_PROFILER_NUM_HIST_BINS];
+} GraphNodeStats;
+
+/**
+ * A completed node run, used for trace exports.
+ */
+typedef struct GraphProfilerTraceEvent
+{
+  int          node_id;
+  gint64       start_ns;
+  gint64       end_ns;
+} GraphProfilerTraceEvent;
+
+/**
+ * Statistics for a single GraphThread.
+ *
+ * Only written by the thread that owns it.
+ */
+typedef struct GraphThreadStats
+{
+  /** Time spent processing nodes. */
+  gint64       busy_ns;
+
+  /** Time spent waiting for work. */
+  gint64       wait_ns;
+
+  /** Number of nodes processed. */
+  guint64      num_nodes;
+
+  /** Ring buffer of the last
+   * \ref GRAPH_PROFILER_TRACE_SIZE runs. */
+  GraphProfilerTraceEvent * trace;
+
+  /** Total number of events written to
+   * \ref GraphThreadStats.trace. */
+  volatile guint trace_head;
+} GraphThreadStats;
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ */
+static inline gint64
+graph_profiler_get_time_ns (void)
+{
+#ifdef _WOE32
+  return g_get_monotonic_time () * 1000;
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return
+    (gint64) ts.tv_sec * 1000000000 +
+    (gint64) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Records a run of a node.
+ *
+ * To be called from the DSP thread that processed
+ * the node.
+ */
+void
+graph_profiler_record_node (
+  GraphNodeStats *   node_stats,
+  GraphThreadStats * thread_stats,
+  int                node_id,
+  gint64             start_ns,
+  gint64             end_ns);
+
+/**
+ * Enables or disables profiling.
+ *
+ * Stats are reset when enabling.
+ */
+void
+graph_profiler_set_enabled (
+  Graph * graph,
+  bool    enabled);
+
+/**
+ * Requests a reset of all node and thread stats.
+ *
+ * The stats are reset by the DSP threads at the
+ * start of the next cycle, so they are never
+ * written concurrently.
+ */
+void
+graph_profiler_reset (
+  Graph * graph);
+
+/**
+ * Resets all node and thread stats if a reset was
+ * requested.
+ *
+ * To be called from the DSP thread that starts a
+ * cycle, while all the worker threads are idle.
+ */
+void
+graph_profiler_reset_if_requested (
+  Graph * graph);
+
+/**
+ * Returns the given percentile (0 to 100) of the
+ * run durations of the node, estimated from the
+ * histogram as the upper bound of the bin it
+ * falls in.
+ */
+gint64
+graph_profiler_get_percentile_ns (
+  const GraphNodeStats * stats,
+  double                 percentile);
+
+/**
+ * Returns the average DSP load of the node as a
+ * percentage of the time available per cycle.
+ */
+double
+graph_profiler_get_node_dsp_load (
+  GraphNode *   node,
+  nframes_t     block_length,
+  sample_rate_t sample_rate);
+
+/**
+ * Returns the utilization of the given thread (0.0
+ * to 1.0) since the last reset.
+ *
+ * @param thread_idx The thread index, or -1 for
+ *   the main thread.
+ */
+double
+graph_profiler_get_thread_utilization (
+  Graph * graph,
+  int     thread_idx);
+
+/**
+ * Exports the recorded trace events as a Chrome
+ * trace JSON file (viewable in chrome://tracing
+ * or Perfetto).
+ *
+ * @note Must be called from the GTK thread.
+ *
+ * @return Whether successful.
+ */
+bool
+graph_profiler_export_chrome_trace (
+  Graph *      graph,
+  const char * filepath,
+  GError **    error);
+
+/**
+ * @}
+ */
+
+#endif
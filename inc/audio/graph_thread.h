@@ -49,6 +49,7 @@
 #include <stdbool.h>
 #include <pthread.h>
 
+#include "audio/graph_profiler.h"
 #include "utils/types.h"
 
 #include <gtk/gtk.h>
@@ -91,6 +92,10 @@ typedef struct GraphThread
   /** LSP DSP context. */
   lsp_dsp_context_t lsp_ctx;
 #endif
+
+  /** DSP stats, collected when profiling is
+   * enabled. */
+  GraphThreadStats  stats;
 } GraphThread;
 
 /**
@@ -106,6 +111,15 @@ graph_thread_new (
   const bool is_main,
   Graph *    graph);
 
+/**
+ * Frees the thread.
+ *
+ * The thread must be joined first.
+ */
+void
+graph_thread_free (
+  GraphThread * self);
+
 /**
  * @}
  */
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2020 Alexandros Theodotou <alex at zrythm dot org>
+ * Copyright (C) 2020-2021 Alexandros Theodotou <alex at zrythm dot org>
  *
  * This file is part of Zrythm
  *
@@ -26,12 +26,78 @@
 #ifndef __AUDIO_MIDI_FILE_H__
 #define __AUDIO_MIDI_FILE_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * @addtogroup audio
  *
  * @{
  */
 
+/**
+ * A note parsed from a MIDI file.
+ */
+typedef struct MidiFileNote
+{
+  /** Start position in Zrythm ticks. */
+  double       start_ticks;
+
+  /** End position in Zrythm ticks. */
+  double       end_ticks;
+
+  uint8_t      pitch;
+  uint8_t      vel;
+} MidiFileNote;
+
+/**
+ * A track parsed from a MIDI file.
+ */
+typedef struct MidiFileTrack
+{
+  /** Track name, if any. */
+  char *         name;
+
+  /** Notes, sorted by start position. */
+  MidiFileNote * notes;
+  int            num_notes;
+  size_t         notes_size;
+
+  /** Position of the end-of-track event in
+   * Zrythm ticks, or -1 if not found. */
+  double         end_ticks;
+} MidiFileTrack;
+
+/**
+ * A MIDI file parsed into per-track note lists.
+ *
+ * The file is read once and its tracks are parsed
+ * in parallel.
+ */
+typedef struct MidiFile
+{
+  MidiFileTrack * tracks;
+  int             num_tracks;
+} MidiFile;
+
+/**
+ * Parses the given MIDI file.
+ *
+ * @param transport_ppqn PPQN to convert the
+ *   positions to.
+ *
+ * @return The parsed file, or NULL if the file
+ *   could not be read.
+ */
+MidiFile *
+midi_file_new (
+  const char * abs_path,
+  double       transport_ppqn);
+
+void
+midi_file_free (
+  MidiFile * self);
+
 /**
  * Returns the number of tracks in the MIDI file.
  */
@@ -28,6 +28,7 @@
 
 #include "audio/ext_port.h"
 #include "audio/midi.h"
+#include "audio/midi_event.h"
 #include "audio/port.h"
 
 /**
@@ -60,13 +61,65 @@ typedef struct MidiMapping
   volatile int   enabled;
 } MidiMapping;
 
+#define MIDI_MAPPINGS_MAX 2046
+
+/** Max number of buckets in a MidiMappingTable
+ * (enough for a load factor of 0.5 with
+ * \ref MIDI_MAPPINGS_MAX distinct keys). */
+#define MIDI_MAPPING_TABLE_MAX_BUCKETS 4096
+
+/**
+ * Mappings sharing the same first 2 bytes.
+ */
+typedef struct MidiMappingTableBucket
+{
+  /** First 2 bytes of the key (status << 8 |
+   * controller). */
+  uint16_t       key;
+
+  /** Number of mappings, or 0 if the bucket is
+   * empty. */
+  uint16_t       num_targets;
+
+  /** Index of the first mapping index in
+   * \ref MidiMappingTable.targets. */
+  int            first_target;
+} MidiMappingTableBucket;
+
+/**
+ * Immutable lookup table from the first 2 bytes of
+ * a MIDI message to the indices of the mappings
+ * bound to it.
+ *
+ * Uses open addressing with linear probing.
+ */
+typedef struct MidiMappingTable
+{
+  /** Buckets (power of 2). */
+  MidiMappingTableBucket * buckets;
+  int                      num_buckets;
+
+  /** Right shift for the multiplicative hash. */
+  int                      shift;
+
+  /** Mapping indices, grouped by bucket. */
+  int *                    targets;
+  int                      num_targets;
+} MidiMappingTable;
+
 /**
  * All MIDI mappings in Zrythm.
  */
 typedef struct MidiMappings
 {
-  MidiMapping     mappings[2046];
+  MidiMapping     mappings[MIDI_MAPPINGS_MAX];
   int             num_mappings;
+
+  /**
+   * Lookup table used by the DSP thread, replaced
+   * atomically whenever the mappings change.
+   */
+  MidiMappingTable * table;
 } MidiMappings;
 
 static const cyaml_schema_field_t
@@ -181,6 +234,20 @@ midi_mappings_apply (
   MidiMappings * self,
   midi_byte_t *  buf);
 
+/**
+ * Applies the given events to the matching ports.
+ *
+ * Only the last value of each key is applied, so
+ * dense CC streams cause one control change per
+ * mapping per cycle.
+ *
+ * Realtime-safe.
+ */
+void
+midi_mappings_apply_from_events (
+  MidiMappings * self,
+  MidiEvents *   events);
+
 /**
  * Get MIDI mappings for the given port.
  *
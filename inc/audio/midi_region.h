@@ -37,6 +37,7 @@ typedef struct MidiNote MidiNote;
 typedef struct ZRegion ZRegion;
 typedef struct MidiEvents MidiEvents;
 typedef struct ChordDescriptor ChordDescriptor;
+typedef struct MidiFileTrack MidiFileTrack;
 typedef ZRegion MidiRegion;
 typedef void MIDI_FILE;
 
@@ -57,10 +58,33 @@ midi_region_new (
   int              lane_pos,
   int              idx_inside_lane);
 
+/**
+ * Creates a MIDI region from a track of a parsed
+ * MIDI file, starting at the given Position.
+ *
+ * The notes are added in bulk.
+ *
+ * @return The region, or NULL if the track is
+ *   empty.
+ */
+ZRegion *
+midi_region_new_from_midi_file_track (
+  const Position *      start_pos,
+  const MidiFileTrack * track_data,
+  int                   track_pos,
+  int                   lane_pos,
+  int                   idx_inside_lane);
+
 /**
  * Creates a MIDI region from the given MIDI
  * file path, starting at the given Position.
  *
+ * @note When creating regions from multiple tracks
+ *   of the same file, parse the file once with
+ *   midi_file_new() and use
+ *   midi_region_new_from_midi_file_track()
+ *   instead.
+ *
  * @param idx The index of this track, starting from
  *   0. This will be sequential, ie, if idx 1 is
  *   requested and the MIDI file only has tracks
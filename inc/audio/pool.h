@@ -29,7 +29,11 @@
 #include "audio/clip.h"
 #include "utils/yaml.h"
 
+#include <glib.h>
+
 typedef struct Track Track;
+typedef struct UndoableAction UndoableAction;
+typedef struct StretchCache StretchCache;
 
 /**
  * @addtogroup audio
@@ -39,6 +43,20 @@ typedef struct Track Track;
 
 #define AUDIO_POOL (AUDIO_ENGINE->pool)
 
+/** Max number of threads used to decode files
+ * added with
+ * audio_pool_add_clip_from_file_async(). */
+#define AUDIO_POOL_MAX_DECODE_THREADS 8
+
+/** Max number of threads used to stretch the
+ * clips of regions in musical mode (see
+ * audio_pool_stretch_async()). */
+#define AUDIO_POOL_MAX_STRETCH_THREADS 2
+
+/** Default memory budget for clips not used in
+ * the arrangement, in MiB. */
+#define AUDIO_POOL_DEFAULT_MEMORY_BUDGET 512
+
 /**
  * An audio pool is a pool of audio files and their
  * corresponding float arrays in memory that are
@@ -59,6 +77,46 @@ typedef struct AudioPool
 
   /** Array sizes. */
   size_t         clips_size;
+
+  /** Last generation given to a clip added to
+   * the pool (see \ref AudioClip.generation). */
+  unsigned int   clip_generation;
+
+  /** Worker pool for decoding files in the
+   * background, created when needed. */
+  GThreadPool *  decode_pool;
+
+  /** Finished decode jobs waiting to be applied
+   * in the GTK thread. */
+  GAsyncQueue *  decoded_queue;
+
+  /** Number of decode jobs queued or not yet
+   * applied. */
+  int            num_pending_decodes;
+
+  /** Worker pool for stretching clips in the
+   * background, created when needed. */
+  GThreadPool *  stretch_pool;
+
+  /** Finished stretch jobs waiting to be applied
+   * in the GTK thread. */
+  GAsyncQueue *  stretched_queue;
+
+  /** Number of stretch jobs queued or not yet
+   * applied. */
+  int            num_pending_stretches;
+
+  /**
+   * Maximum size of the frames of clips not used
+   * in the arrangement to keep in memory, in
+   * bytes.
+   *
+   * Clips only referenced by the undo history are
+   * kept loaded until this is exceeded, then the
+   * least recently used ones are unloaded and
+   * reloaded from the pool when needed again.
+   */
+  size_t         memory_budget;
 } AudioPool;
 
 static const cyaml_schema_field_t
@@ -83,6 +141,14 @@ audio_pool_schema =
 
 /**
  * Inits after loading a project.
+ *
+ * The clips are decoded in parallel, starting
+ * from the ones used closest to the playhead, and
+ * this returns when all of them are loaded.
+ *
+ * Clips not used in the arrangement are loaded
+ * when needed (see
+ * audio_pool_load_clips_for_action()).
  */
 void
 audio_pool_init_loaded (
@@ -107,6 +173,67 @@ audio_pool_add_clip (
   AudioPool * self,
   AudioClip * clip);
 
+/**
+ * Adds a placeholder clip for the given file to
+ * the pool and decodes the file in a worker
+ * thread.
+ *
+ * The placeholder has the final length, so
+ * regions can be created from it immediately. It
+ * is silent until the decoded frames are applied
+ * in the GTK thread, and the decoder writes the
+ * file to the pool.
+ *
+ * @return The ID in the pool, or -1 if the file
+ *   could not be opened.
+ */
+int
+audio_pool_add_clip_from_file_async (
+  AudioPool *  self,
+  const char * path);
+
+/**
+ * Blocks until all the background decodes are
+ * finished and applies them.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+audio_pool_wait_for_decodes (
+  AudioPool * self);
+
+/**
+ * Stretches the given clip to the given BPM in a
+ * worker thread and publishes the result to the
+ * given cache in the GTK thread.
+ *
+ * The clip's frames are copied, so the clip can
+ * change while stretching. Jobs superseded by a
+ * newer request for the same cache are skipped
+ * before stretching, and their results are
+ * discarded.
+ *
+ * @param tempo_map_version Version of the tempo
+ *   map the BPM was taken from.
+ */
+void
+audio_pool_stretch_async (
+  AudioPool *    self,
+  StretchCache * cache,
+  AudioClip *    clip,
+  bpm_t          bpm,
+  unsigned int   tempo_map_version);
+
+/**
+ * Blocks until all the background stretches are
+ * finished and applies them.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+audio_pool_wait_for_stretches (
+  AudioPool * self);
+
 /**
  * Duplicates the clip with the given ID and returns
  * the duplicate.
@@ -166,6 +293,14 @@ audio_pool_gen_name_for_recording_clip (
  * use in the project from their files and frees the
  * buffers of clips not currently in use.
  *
+ * Clips are reference counted from the regions in
+ * the arrangement, frozen tracks and the undo
+ * history. Clips not used in the arrangement are
+ * unloaded when the total size of their frames
+ * exceeds \ref AudioPool.memory_budget,
+ * unreferenced clips first, then the least
+ * recently used ones.
+ *
  * This should be called whenever there is a relevant
  * change in the project (eg, object added/removed).
  */
@@ -173,6 +308,31 @@ void
 audio_pool_reload_clip_frame_bufs (
   AudioPool * self);
 
+/**
+ * Loads the frame buffers of the clips referenced
+ * by the given action, so that it can be
+ * performed or undone.
+ *
+ * To be called before pausing the engine for the
+ * action, since decoding can take a while. This
+ * is safe while the engine is running since it
+ * does not use unloaded clips.
+ */
+void
+audio_pool_load_clips_for_action (
+  AudioPool *      self,
+  UndoableAction * action);
+
+/**
+ * Removes files in the pool directory that do not
+ * belong to any clip in the pool.
+ *
+ * To be called when saving the project.
+ */
+void
+audio_pool_remove_orphan_files (
+  AudioPool * self);
+
 void
 audio_pool_free (
   AudioPool * self);
@@ -317,6 +317,18 @@ typedef struct Port
    * reading automation. */
   bool                value_changed_from_reading;
 
+  /**
+   * Whether the value is read from automation in
+   * the current split.
+   *
+   * Processors that support it then re-read the
+   * automation every
+   * AudioEngine.automation_granularity frames
+   * within the split with
+   * control_port_get_automation_val_at_frames().
+   */
+  bool                automation_read;
+
   /**
    * Last timestamp the control changed.
    *
@@ -952,6 +964,37 @@ port_set_control_value (
   const bool  is_normalized,
   const bool  forward_event);
 
+/**
+ * Sets the given control value at the start of
+ * the next processing cycle, without blocking.
+ *
+ * To be used by the GTK thread for continuous
+ * changes (eg, while dragging a knob). If the
+ * engine is not running, or too many changes are
+ * pending, the value is set immediately.
+ *
+ * @param is_normalized Whether the given value is
+ *   normalized between 0 and 1.
+ * @param forward_event Whether to forward a port
+ *   control change event to the plugin UI.
+ */
+void
+port_queue_control_value (
+  Port *      self,
+  const float val,
+  const bool  is_normalized,
+  const bool  forward_event);
+
+/**
+ * Pushes the UI events for a change in the
+ * control value.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+port_push_control_change_events (
+  Port * self);
+
 /**
  * Gets the given control value from the
  * corresponding underlying structure in the Port.
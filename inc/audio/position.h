@@ -130,6 +130,7 @@
   *(__pos) = POSITION_START
 
 typedef struct SnapGrid SnapGrid;
+typedef struct SnapObjectIndex SnapObjectIndex;
 typedef struct Track Track;
 typedef struct ZRegion ZRegion;
 
@@ -350,24 +351,21 @@ position_from_ticks (
  *   position the drag started at. This is only used
  *   when the "keep offset" setting is on.
  * @param pos Position to edit.
- * @param track Track, used when moving things in
- *   the timeline. If keep offset is on and this is
- *   passed, the objects in the track will be taken
- *   into account. If keep offset is on and this is
- *   NULL, all applicable objects will be taken into
- *   account. Not used if keep offset is off.
+ * @param obj_index Index of the objects to snap
+ *   to, used when moving things in the timeline.
+ *   Not used if snap to events is off.
  * @param region Region, used when moving
  *   things in the editor. Same behavior as @ref
- *   track.
+ *   obj_index.
  * @param sg SnapGrid options.
  */
 void
 position_snap (
-  Position *       start_pos,
-  Position *       pos,
-  Track    *       track,
-  ZRegion   *      region,
-  const SnapGrid * sg);
+  Position *              start_pos,
+  Position *              pos,
+  const SnapObjectIndex * obj_index,
+  ZRegion *               region,
+  const SnapGrid *        sg);
 
 /**
  * Sets the end position to be 1 snap point away
@@ -44,6 +44,7 @@ typedef struct TrackLane TrackLane;
 typedef struct _AudioClipWidget AudioClipWidget;
 typedef struct RegionLinkGroup RegionLinkGroup;
 typedef struct Stretcher Stretcher;
+typedef struct StretchCache StretchCache;
 
 /**
  * @addtogroup audio
@@ -177,6 +178,15 @@ typedef struct ZRegion
   /** Musical mode setting. */
   RegionMusicalMode musical_mode;
 
+  /**
+   * Timestretched frames used in musical mode
+   * (not serialized).
+   *
+   * Created when the region is first indexed in
+   * musical mode.
+   */
+  StretchCache *    stretch_cache;
+
   /** Array of split points. */
   Position *        split_points;
   int               num_split_points;
@@ -75,16 +75,26 @@ typedef struct RtMidiDevice
   /** Associated port. */
   Port *        port;
 
-  /** MIDI event ring buffer. */
+  /**
+   * MIDI event ring buffer.
+   *
+   * Single-producer single-consumer: written only
+   * by the RtMidi callback and read only by the
+   * engine, so neither side takes a lock.
+   *
+   * Each event is a MidiEventHeader holding the
+   * system time it was received at, followed by
+   * the message.
+   */
   ZixRing *     midi_ring;
 
   /** Events enqueued at the beginning of each
    * processing cycle from the ring. */
   MidiEvents *  events;
 
-  /** Semaphore for blocking writing events while
-   * events are being read. */
-  ZixSem        midi_ring_sem;
+  /** Number of events dropped because the ring
+   * was full. */
+  volatile gint num_dropped;
 
 } RtMidiDevice;
 
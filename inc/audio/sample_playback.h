@@ -30,6 +30,8 @@
 
 #include "utils/types.h"
 
+typedef struct SampleStream SampleStream;
+
 /**
  * @addtogroup audio
  *
@@ -60,6 +62,10 @@ typedef struct SamplePlayback
   /** Offset relative to the current processing cycle
    * to start playing the sample. */
   nframes_t      start_offset;
+
+  /** File streamed from disk, or NULL if playing
+   * back \ref SamplePlayback.buf. */
+  SampleStream * stream;
 } SamplePlayback;
 
 /**
@@ -75,6 +81,20 @@ sample_playback_init (
   float            vol,
   nframes_t        start_offset);
 
+/**
+ * Initializes a SamplePlayback with a file
+ * streamed from disk.
+ *
+ * The stream is released by the sample processor
+ * when the playback is removed.
+ */
+void
+sample_playback_init_with_stream (
+  SamplePlayback * self,
+  SampleStream *   stream,
+  float            vol,
+  nframes_t        start_offset);
+
 /**
  * @}
  */
@@ -31,6 +31,7 @@
 #include "utils/types.h"
 
 typedef struct StereoPorts StereoPorts;
+typedef struct MPMCQueue MPMCQueue;
 typedef enum MetronomeType MetronomeType;
 
 /**
@@ -42,6 +43,13 @@ typedef enum MetronomeType MetronomeType;
 #define SAMPLE_PROCESSOR \
   (AUDIO_ENGINE->sample_processor)
 
+/** Max number of samples playing at once. */
+#define SAMPLE_PROCESSOR_MAX_SAMPLES 256
+
+/** Max number of file streams waiting to be
+ * picked up by the DSP thread. */
+#define SAMPLE_PROCESSOR_MAX_QUEUED_STREAMS 16
+
 /**
  * A processor to be used in the routing graph for
  * playing samples independent of the timeline.
@@ -49,12 +57,21 @@ typedef enum MetronomeType MetronomeType;
 typedef struct SampleProcessor
 {
   /** An array of samples currently being played. */
-  SamplePlayback    current_samples[256];
+  SamplePlayback    current_samples[
+                      SAMPLE_PROCESSOR_MAX_SAMPLES];
   int               num_current_samples;
 
   /** The stereo out ports to be connected to the
    * main output. */
   StereoPorts *     stereo_out;
+
+  /** SampleStream's queued from other threads,
+   * to be picked up by the DSP thread. */
+  MPMCQueue *       stream_queue;
+
+  /** Set to stop the file streams currently
+   * playing. */
+  volatile gint     stop_streams;
 } SampleProcessor;
 
 static const cyaml_schema_field_t
@@ -128,12 +145,25 @@ sample_processor_queue_metronome (
 /**
  * Adds a sample to play to the queue from a file
  * path.
+ *
+ * The file is streamed from disk and replaces any
+ * file currently playing.
+ *
+ * @note Must be called from the GTK thread.
  */
 void
 sample_processor_queue_sample_from_file (
   SampleProcessor * self,
   const char *      path);
 
+/**
+ * Stops the files queued with
+ * sample_processor_queue_sample_from_file().
+ */
+void
+sample_processor_stop_file_playback (
+  SampleProcessor * self);
+
 void
 sample_processor_disconnect (
   SampleProcessor * self);
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Audio file streamed from disk for auditioning.
+ */
+
+#ifndef __AUDIO_SAMPLE_STREAM_H__
+#define __AUDIO_SAMPLE_STREAM_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include "ext/zita-resampler/resampler.h"
+#include "zix/ring.h"
+#include "zix/sem.h"
+
+#include <glib.h>
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/** Capacity of the ring buffer in frames. */
+#define SAMPLE_STREAM_RING_FRAMES 16384
+
+/** Number of frames decoded at a time by the
+ * decoder thread. */
+#define SAMPLE_STREAM_CHUNK_FRAMES 2048
+
+/**
+ * An audio file decoded from disk in a background
+ * thread and resampled to the engine sample rate.
+ *
+ * Decoded frames are passed to the DSP thread as
+ * interleaved stereo through a lock-free ring, so
+ * only \ref SAMPLE_STREAM_RING_FRAMES are kept in
+ * memory regardless of the file length.
+ *
+ * The decoder thread owns the stream: once the
+ * DSP side calls sample_stream_release(), the
+ * thread stops and frees it.
+ */
+typedef struct SampleStream
+{
+  char *          path;
+
+  /** SNDFILE handle. */
+  void *          sndfile;
+
+  /** Number of channels in the file. */
+  channels_t      file_channels;
+
+  /** Resampler, or NULL if the file is already at
+   * the target sample rate. */
+  ZitaResampler * resampler;
+
+  /** Frames read from the file (file channels). */
+  float *         file_buf;
+
+  /** Frames read from the file converted to
+   * interleaved stereo. */
+  float *         in_buf;
+
+  /** Number of frames in
+   * \ref SampleStream.in_buf not yet consumed by
+   * the resampler, and the position of the first
+   * one. */
+  unsigned int    in_pending;
+  unsigned int    in_pos;
+
+  /** Zero frames left to feed the resampler to
+   * flush it after the end of the file. */
+  unsigned int    flush_left;
+
+  /** Whether the end of the file was reached. */
+  bool            input_done;
+
+  /** Resampled interleaved stereo frames. */
+  float *         out_buf;
+
+  /** Interleaved stereo frames. */
+  ZixRing *       ring;
+
+  /** Posted when space is freed in the ring or
+   * when released. */
+  ZixSem          sem;
+
+  /** Set by the decoder thread when everything
+   * has been written to the ring. */
+  volatile gint   eof;
+
+  /** Set by the DSP thread when done with the
+   * stream. */
+  volatile gint   released;
+} SampleStream;
+
+/**
+ * Opens the given file and decodes the first
+ * \p prefetch_frames before returning, then
+ * starts decoding the rest in the background.
+ *
+ * @param samplerate Sample rate to resample to.
+ * @param prefetch_frames Number of frames to
+ *   decode synchronously so that playback can
+ *   start immediately.
+ *
+ * @return The stream, or NULL if the file could
+ *   not be opened.
+ */
+SampleStream *
+sample_stream_new (
+  const char *  path,
+  sample_rate_t samplerate,
+  nframes_t     prefetch_frames,
+  GError **     error);
+
+/**
+ * Reads up to \p nframes from the ring and adds
+ * them to the given buffers.
+ *
+ * Realtime-safe.
+ *
+ * @return The number of frames read, which is
+ *   less than \p nframes if the decoder fell
+ *   behind or at the end of the file.
+ */
+nframes_t
+sample_stream_read (
+  SampleStream * self,
+  float *        l,
+  float *        r,
+  nframes_t      nframes,
+  float          volume);
+
+/**
+ * Returns whether all the frames of the file have
+ * been read.
+ *
+ * Realtime-safe.
+ */
+bool
+sample_stream_is_finished (
+  SampleStream * self);
+
+/**
+ * Signals the decoder thread to stop and free the
+ * stream.
+ *
+ * The stream must not be used after this call.
+ *
+ * Realtime-safe.
+ */
+void
+sample_stream_release (
+  SampleStream * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -48,7 +48,6 @@
 /* FIXME rename to snap grid editor */
 #define SNAP_GRID_MIDI \
   (&PROJECT->snap_grid_midi)
-#define SNAP_GRID_DEFAULT_MAX_BAR 10000
 
 typedef enum NoteLength
 {
@@ -146,17 +145,6 @@ typedef struct SnapGrid
    * See NoteLengthType.
    */
   NoteLengthType   length_type;
-
-  /**
-   * Snap points to be used by the grid and by
-   * position
-   * to calculate previous/next snap point.
-   *
-   * Cache.
-   */
-  Position *       snap_points;
-  int              num_snap_points;
-  size_t           snap_points_size;
 } SnapGrid;
 
 static const cyaml_strval_t
@@ -257,18 +245,6 @@ snap_grid_get_ticks_from_length_and_type (
   NoteLength length,
   NoteType   type);
 
-/**
- * Updates snap points.
- */
-void
-snap_grid_update_snap_points (
-  SnapGrid * self,
-  int        max_bars);
-
-#define snap_grid_update_snap_points_default(sg) \
-  snap_grid_update_snap_points ( \
-    sg, SNAP_GRID_DEFAULT_MAX_BAR)
-
 /**
  * Gets a snap point's length in ticks.
  */
@@ -295,20 +271,104 @@ snap_grid_stringize (
   NoteType   note_type);
 
 /**
- * Returns the next or previous SnapGrid point.
+ * Returns the grid point at or before the given
+ * position, or false if there is none.
  *
- * Must not be free'd.
+ * Grid points are calculated from the snap length
+ * instead of being looked up.
+ */
+bool
+snap_grid_get_prev_grid_point (
+  const SnapGrid * self,
+  const Position * pos,
+  Position *       prev_pos);
+
+/**
+ * Returns the first grid point after the given
+ * position.
+ */
+void
+snap_grid_get_next_grid_point (
+  const SnapGrid * self,
+  const Position * pos,
+  Position *       next_pos);
+
+/**
+ * Returns the next or previous SnapGrid point.
  *
  * @param self Snap grid to search in.
  * @param pos Position to search for.
  * @param return_prev 1 to return the previous
- * element or 0 to return the next.
+ *   point or 0 to return the next. The previous
+ *   point is never before the start.
+ * @param ret_pos Position to fill in.
  */
-Position *
+void
 snap_grid_get_nearby_snap_point (
-  SnapGrid *       self,
+  const SnapGrid * self,
   const Position * pos,
-  const int        return_prev);
+  const int        return_prev,
+  Position *       ret_pos);
+
+/**
+ * Sorted start and end positions of the regions
+ * in a track, for snapping to events.
+ *
+ * This is built once (eg, at the start of a drag)
+ * so that each snap is a binary search instead of
+ * a scan of all the regions.
+ */
+typedef struct SnapObjectIndex
+{
+  /** Track the index was built for. */
+  Track *          track;
+
+  /** Sorted positions in ticks. */
+  double *         ticks;
+  int              num_ticks;
+  size_t           ticks_size;
+} SnapObjectIndex;
+
+/**
+ * Rebuilds the index for the given track, unless
+ * it was already built for it.
+ */
+void
+snap_object_index_update (
+  SnapObjectIndex * self,
+  Track *           track);
+
+/**
+ * Clears the index so that it is rebuilt the next
+ * time it is updated.
+ *
+ * @param free_memory Whether to also free the
+ *   allocated memory.
+ */
+void
+snap_object_index_clear (
+  SnapObjectIndex * self,
+  bool              free_memory);
+
+/**
+ * Returns the last indexed position at or before
+ * the given position, or false if none.
+ */
+bool
+snap_object_index_get_prev (
+  const SnapObjectIndex * self,
+  const Position *        pos,
+  Position *              prev_pos);
+
+/**
+ * Returns the first indexed position after the
+ * given position, or false if none.
+ */
+bool
+snap_object_index_get_next (
+  const SnapObjectIndex * self,
+  const Position *        pos,
+  Position *              next_pos);
 
 /**
  * @}
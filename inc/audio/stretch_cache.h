@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Timestretched frames of audio regions in
+ * musical mode, rendered in the background.
+ */
+
+#ifndef __AUDIO_STRETCH_CACHE_H__
+#define __AUDIO_STRETCH_CACHE_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioClip AudioClip;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Number of frames to crossfade over when
+ * switching from realtime stretching to the
+ * cached frames.
+ */
+#define STRETCH_CACHE_XFADE_FRAMES 1024
+
+/**
+ * Returns the current frames of the cache.
+ *
+ * Safe to call from any thread.
+ */
+#define stretch_cache_get_frames(self) \
+  ((StretchCacheFrames *) \
+   g_atomic_pointer_get (&(self)->frames))
+
+/**
+ * A clip stretched to a BPM.
+ *
+ * Frames are immutable once published to the
+ * engine.
+ */
+typedef struct StretchCacheFrames
+{
+  /** Stretched frames per channel (the right
+   * channel is the left channel for mono
+   * clips). */
+  float *       ch_frames[2];
+
+  /** Number of frames per channel. */
+  long          num_frames;
+
+  /** Clip that was stretched, only used for
+   * comparison. */
+  AudioClip *   clip;
+
+  /** Number of frames of the clip when it was
+   * stretched. */
+  long          clip_num_frames;
+
+  /** BPM the clip was stretched to. */
+  bpm_t         bpm;
+
+  /** Tempo map version the frames were rendered
+   * for.
+   *
+   * This is informative only: the frames are
+   * looked up by clip, clip frame count and BPM
+   * (see stretch_cache_get_frames_for()). */
+  unsigned int  tempo_map_version;
+} StretchCacheFrames;
+
+/**
+ * Timestretched frames of a region in musical
+ * mode.
+ *
+ * The frames are rendered in a worker thread when
+ * the tempo changes (see
+ * audio_pool_stretch_async()), and the realtime
+ * stretcher is only used until they are ready.
+ *
+ * The cache is owned by the region and referenced
+ * by the region indices and the pending stretch
+ * jobs, and it is freed later when the last
+ * reference is dropped.
+ */
+typedef struct StretchCache
+{
+  /**
+   * Current frames, or NULL.
+   *
+   * This is replaced atomically and must be
+   * accessed with stretch_cache_get_frames().
+   */
+  StretchCacheFrames * frames;
+
+  /** Number of references (GTK thread only). */
+  int                  num_refs;
+
+  /** Parameters of the last requested frames
+   * (GTK thread only). */
+  AudioClip *          requested_clip;
+  long                 requested_clip_num_frames;
+  bpm_t                requested_bpm;
+
+  /**
+   * Incremented on every request.
+   *
+   * Stretch jobs for older requests are skipped
+   * by the worker threads and their results are
+   * discarded. Must be accessed atomically.
+   */
+  volatile gint        request_generation;
+
+  /**
+   * Whether the region was last stretched in
+   * realtime.
+   *
+   * This and the members below are only used by
+   * the thread processing the region.
+   */
+  bool                 used_rt;
+
+  /** Expected start position of the next cycle
+   * after realtime stretching, used to only
+   * crossfade when playback is continuous. */
+  long                 next_frames;
+
+  /** Remaining frames of the crossfade from
+   * realtime stretching to the cached frames. */
+  nframes_t            xfade_frames_left;
+} StretchCache;
+
+/**
+ * Creates a new cache with a single reference.
+ */
+StretchCache *
+stretch_cache_new (void);
+
+void
+stretch_cache_ref (
+  StretchCache * self);
+
+/**
+ * Drops a reference and frees the cache later
+ * if it was the last one.
+ */
+void
+stretch_cache_unref (
+  StretchCache * self);
+
+/**
+ * Returns whether frames for the given clip and
+ * BPM need to be requested.
+ *
+ * @note Must be called from the GTK thread.
+ */
+bool
+stretch_cache_needs_request (
+  StretchCache * self,
+  AudioClip *    clip,
+  bpm_t          bpm);
+
+/**
+ * Returns the frames if they were stretched from
+ * the given clip to the given BPM, otherwise
+ * NULL.
+ *
+ * Real-time safe.
+ */
+const StretchCacheFrames *
+stretch_cache_get_frames_for (
+  StretchCache * self,
+  AudioClip *    clip,
+  bpm_t          bpm);
+
+/**
+ * Publishes the given frames to the engine and
+ * frees the previous ones later.
+ *
+ * @note Must be called from the GTK thread.
+ */
+void
+stretch_cache_set_frames (
+  StretchCache *       self,
+  StretchCacheFrames * frames);
+
+/**
+ * Stretches the given interleaved frames.
+ *
+ * This is not real-time safe and can be called
+ * from any thread.
+ *
+ * @param time_ratio The ratio to multiply time
+ *   by.
+ *
+ * @return The stretched frames, with the clip,
+ *   BPM and tempo map version left for the caller
+ *   to fill in, or NULL if stretching failed.
+ */
+StretchCacheFrames *
+stretch_cache_frames_new_stretched (
+  const float *  frames,
+  long           num_frames,
+  channels_t     channels,
+  sample_rate_t  sample_rate,
+  double         time_ratio);
+
+void
+stretch_cache_frames_free (
+  StretchCacheFrames * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Precomputed tempo map for fast frame/tick
+ * conversions.
+ */
+
+#ifndef __AUDIO_TEMPO_MAP_H__
+#define __AUDIO_TEMPO_MAP_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+typedef struct Track Track;
+
+/**
+ * @addtogroup audio
+ *
+ * @{
+ */
+
+/**
+ * Resolution in ticks used when sampling
+ * non-constant tempo automation (a sixteenth
+ * note).
+ */
+#define TEMPO_MAP_RESOLUTION_TICKS 240.0
+
+/**
+ * Returns whether the tempo map has tempo changes
+ * (more than 1 segment).
+ */
+#define tempo_map_has_tempo_changes(self) \
+  ((self) && (self)->num_segments > 1)
+
+/**
+ * A segment of constant tempo.
+ */
+typedef struct TempoMapSegment
+{
+  /** Start position in ticks. */
+  double        start_ticks;
+
+  /** Start position in frames (cumulative,
+   * not rounded). */
+  double        start_frames;
+
+  /** Frames per tick in this segment. */
+  double        frames_per_tick;
+
+  /** BPM in this segment. */
+  bpm_t         bpm;
+} TempoMapSegment;
+
+/**
+ * Piecewise-constant tempo map.
+ *
+ * A map is immutable once published to the
+ * engine: changes create a new map that replaces
+ * the old one atomically, and the old one is
+ * freed later.
+ *
+ * @note Region-local positions are converted as
+ *   if they were global positions.
+ */
+typedef struct TempoMap
+{
+  /** Segments, sorted by start position. */
+  TempoMapSegment * segments;
+  int               num_segments;
+
+  /** Ticks per beat used when building. */
+  double            ticks_per_beat;
+
+  /** Sample rate used when building. */
+  sample_rate_t     sample_rate;
+
+  /** Incremented each time a map is built. */
+  unsigned int      version;
+} TempoMap;
+
+/**
+ * Creates a tempo map with a single segment of
+ * the given BPM.
+ */
+TempoMap *
+tempo_map_new (
+  bpm_t         bpm,
+  double        ticks_per_beat,
+  sample_rate_t sample_rate);
+
+/**
+ * Creates a tempo map from the BPM automation of
+ * the given tempo track.
+ *
+ * Non-constant automation curves are sampled
+ * every \ref TEMPO_MAP_RESOLUTION_TICKS.
+ *
+ * @note Not real-time safe.
+ */
+TempoMap *
+tempo_map_new_from_tempo_track (
+  Track *       tempo_track,
+  double        ticks_per_beat,
+  sample_rate_t sample_rate);
+
+/**
+ * Returns the index of the segment that contains
+ * the given tick position.
+ */
+int
+tempo_map_get_segment_idx_at_ticks (
+  const TempoMap * self,
+  double           ticks);
+
+/**
+ * Returns the index of the segment that contains
+ * the given frame position.
+ */
+int
+tempo_map_get_segment_idx_at_frames (
+  const TempoMap * self,
+  double           frames);
+
+/**
+ * Converts ticks to (non-rounded) frames.
+ */
+double
+tempo_map_ticks_to_frames (
+  const TempoMap * self,
+  double           ticks);
+
+/**
+ * Converts frames to ticks.
+ */
+double
+tempo_map_frames_to_ticks (
+  const TempoMap * self,
+  double           frames);
+
+/**
+ * Returns the BPM at the given tick position.
+ */
+bpm_t
+tempo_map_get_bpm_at_ticks (
+  const TempoMap * self,
+  double           ticks);
+
+void
+tempo_map_free (
+  TempoMap * self);
+
+/**
+ * @}
+ */
+
+#endif
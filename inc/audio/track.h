@@ -58,6 +58,7 @@ typedef struct MusicalScale MusicalScale;
 typedef struct Modulator Modulator;
 typedef struct Marker Marker;
 typedef struct PluginDescriptor PluginDescriptor;
+typedef struct AudioRegionIndex AudioRegionIndex;
 typedef enum PassthroughProcessorType
   PassthroughProcessorType;
 typedef enum FaderType FaderType;
@@ -325,6 +326,36 @@ typedef struct Track
   /** Real-time time stretcher. */
   Stretcher *          rt_stretcher;
 
+  /**
+   * Index of the audio regions in all lanes, used
+   * during processing (not serialized).
+   *
+   * This is replaced atomically and must be
+   * accessed with track_get_region_index().
+   */
+  AudioRegionIndex *   region_index;
+
+  /** Set when the region index needs to be
+   * rebuilt. */
+  volatile gint        region_index_dirty;
+
+  /**
+   * Playback latency of the realtime stretcher,
+   * reported to the graph if any region needs
+   * stretching, otherwise 0 (not serialized).
+   *
+   * The regions that are not stretched in
+   * realtime are delayed by the latency
+   * compensated by the graph (see
+   * TrackProcessor.playback_latency) so that
+   * they stay aligned with the stretched ones.
+   */
+  nframes_t            stretch_latency;
+
+  /** Tempo map version the stretched frames of
+   * the regions were last requested for. */
+  unsigned int         stretch_tempo_map_version;
+
   /* ==== AUDIO TRACK END ==== */
 
   /* ==== CHORD TRACK ==== */
@@ -988,6 +1019,52 @@ void
 track_update_frames (
   Track * track);
 
+/**
+ * Returns the current region index.
+ *
+ * Safe to call from any thread.
+ */
+#define track_get_region_index(self) \
+  ((AudioRegionIndex *) \
+   g_atomic_pointer_get (&(self)->region_index))
+
+/**
+ * Marks the region index as needing to be
+ * rebuilt.
+ *
+ * The index will be rebuilt in the GTK thread.
+ */
+#define track_set_region_index_dirty(self) \
+  g_atomic_int_set (&(self)->region_index_dirty, 1)
+
+/**
+ * Rebuilds the region index from the regions in
+ * the lanes and publishes it to the DSP threads.
+ *
+ * Does nothing if the track is not an audio
+ * track.
+ *
+ * @note Not real-time safe.
+ */
+void
+track_update_region_index (
+  Track * self);
+
+/**
+ * Requests the stretched frames of the regions in
+ * musical mode that are missing or out of date
+ * with the tempo, and updates
+ * Track.stretch_latency.
+ *
+ * Does nothing if the track is not an audio
+ * track.
+ *
+ * @note Not real-time safe.
+ */
+void
+track_update_stretch_caches (
+  Track * self);
+
 /**
  * Returns the Fader (if applicable).
  *
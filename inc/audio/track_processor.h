@@ -45,6 +45,19 @@ typedef struct Track Track;
 #define IS_TRACK_PROCESSOR(tr) \
   ((tr) && (tr)->magic == TRACK_PROCESSOR_MAGIC)
 
+/**
+ * Number of lanes per region group.
+ *
+ * The lanes of audio tracks with more lanes than
+ * this are split into region groups that are
+ * processed in parallel and summed by the track
+ * processor.
+ */
+#define TRACK_PROCESSOR_LANES_PER_REGION_GROUP 8
+
+/** Maximum number of region groups. */
+#define TRACK_PROCESSOR_MAX_REGION_GROUPS 8
+
 /**
  * Automatable MIDI signals.
  */
@@ -130,6 +143,35 @@ typedef struct TrackProcessor
    * opposed to a clone). */
   bool             is_project;
 
+  /**
+   * Buffers the region groups are rendered into
+   * (L and R of each group, each
+   * \ref TrackProcessor.region_group_buf_size
+   * frames).
+   *
+   * Regions are assigned to groups by lane, so
+   * that group \p i processes the lanes where
+   * lane % num_region_groups == i.
+   */
+  float *          region_group_bufs;
+
+  /** Number of region groups, or 0 if the lanes
+   * are not split. */
+  int              num_region_groups;
+
+  /** Frames per channel in each region group
+   * buffer. */
+  nframes_t        region_group_buf_size;
+
+  /**
+   * Playback latency of the track compensated by
+   * the graph, set by the track's graph node
+   * before processing.
+   *
+   * @see Track.stretch_latency.
+   */
+  nframes_t        playback_latency;
+
   int              magic;
 } TrackProcessor;
 
@@ -222,6 +264,45 @@ Track *
 track_processor_get_track (
   TrackProcessor * self);
 
+/**
+ * Returns the number of region groups the lanes
+ * of the track should be split into, or 0 if they
+ * should not be split.
+ */
+int
+track_processor_get_num_region_groups_needed (
+  TrackProcessor * self);
+
+/**
+ * Sets the number of region groups and
+ * (re)allocates their buffers for the current
+ * block length.
+ *
+ * @note Must not be called while the groups are
+ *   being processed.
+ */
+void
+track_processor_set_num_region_groups (
+  TrackProcessor * self,
+  int              num_groups);
+
+/**
+ * Renders the regions of the given region group
+ * into its buffer.
+ *
+ * @param group Region group index.
+ * @param g_start_frames The global start frames.
+ * @param local_offset The local start frames.
+ * @param nframes The number of frames to process.
+ */
+void
+track_processor_process_region_group (
+  TrackProcessor * self,
+  const int        group,
+  const long       g_start_frames,
+  const nframes_t  local_offset,
+  const nframes_t  nframes);
+
 /**
  * Process the TrackProcessor.
  *
@@ -346,8 +346,14 @@ tracklist_get_visible_track_diff (
  * Handles a file drop inside the timeline or in
  * empty space in the tracklist.
  *
+ * Audio files are decoded in the background (see
+ * audio_pool_add_clip_from_file_async()), so
+ * their regions are created immediately and
+ * filled in when decoded.
+ *
  * @param uri_list URI list, if URI list was dropped.
- * @param file File, if SupportedFile was dropped.
+ * @param orig_file File, if SupportedFile was
+ *   dropped.
  * @param track Track, if any.
  * @param lane TrackLane, if any.
  * @param pos Position the file was dropped at, if
@@ -414,6 +420,22 @@ void
 tracklist_expose_ports_to_backend (
   Tracklist * self);
 
+/**
+ * Rebuilds the region indices of the tracks.
+ *
+ * The stretched frames of the regions are also
+ * requested again if the tempo map changed.
+ *
+ * @param force Whether to rebuild all indices,
+ *   instead of only the ones marked as dirty.
+ *
+ * @note Not real-time safe.
+ */
+void
+tracklist_update_region_indices (
+  Tracklist * self,
+  bool        force);
+
 Tracklist *
 tracklist_new (Project * project);
 
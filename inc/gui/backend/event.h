@@ -25,6 +25,10 @@
 #ifndef __GUI_BACKEND_EVENT_H__
 #define __GUI_BACKEND_EVENT_H__
 
+#include <stdbool.h>
+
+#include <gdk/gdk.h>
+
 /**
  * @addtogroup events
  *
@@ -170,6 +174,10 @@ typedef enum EventType
    * the graph. */
   ET_PLUGIN_LATENCY_CHANGED,
 
+  /** Sent when the latency of a track's region
+   * playback changes, to update the graph. */
+  ET_TRACK_LATENCY_CHANGED,
+
   /** Arranger highlight rectangle changed. */
   ET_ARRANGER_HIGHLIGHT_CHANGED,
 
@@ -198,6 +206,12 @@ typedef enum EventType
    * Param: Track.
    */
   ET_TRACK_FREEZE_CHANGED,
+
+  /** Files were added, removed or probed by the
+   * file index. */
+  ET_FILE_INDEX_UPDATED,
+
+  NUM_EVENT_TYPES,
 } EventType;
 
 /**
@@ -211,11 +225,33 @@ typedef struct ZEvent
   const char * func;
   int          lineno;
   char *       backtrace;
+
+  /**
+   * Area of the argument widget to redraw, if
+   * \ref ZEvent.has_rect is set.
+   *
+   * When events are merged, their areas are
+   * unioned.
+   */
+  GdkRectangle rect;
+
+  /** Whether only \ref ZEvent.rect needs to be
+   * redrawn. */
+  bool         has_rect;
 } ZEvent;
 
 ZEvent *
 event_new (void);
 
+/**
+ * Sets the area to redraw, or unsets it if
+ * \p rect is NULL.
+ */
+void
+event_set_rect (
+  ZEvent *             self,
+  const GdkRectangle * rect);
+
 void
 event_free (ZEvent * self);
 
@@ -29,12 +29,14 @@
 #ifndef __GUI_BACKEND_EVENT_MANAGER_H__
 #define __GUI_BACKEND_EVENT_MANAGER_H__
 
+#include "gui/backend/event.h"
 #include "utils/backtrace.h"
 #include "utils/mpmc_queue.h"
 #include "utils/object_pool.h"
 
+#include <gtk/gtk.h>
+
 typedef struct Zrythm Zrythm;
-typedef struct ZEvent ZEvent;
 
 /**
  * @addtogroup events
@@ -42,6 +44,58 @@ typedef struct ZEvent ZEvent;
  * @{
  */
 
+/**
+ * Time budget for handling events in a single
+ * dispatch, in microseconds.
+ *
+ * Events left over are handled in the next frame.
+ */
+#define EVENT_MANAGER_FRAME_BUDGET_USEC 8000
+
+/**
+ * If the frame clock has not dispatched events for
+ * this long (eg, when the window is minimized),
+ * the fallback timeout dispatches them instead.
+ */
+#define EVENT_MANAGER_FRAME_STALL_USEC 50000
+
+/**
+ * Statistics for a single event type.
+ *
+ * Only accessed from the GTK thread.
+ */
+typedef struct EventTypeStats
+{
+  /** Number of events pushed. */
+  guint64            num_pushed;
+
+  /** Number of pushed events that were merged
+   * into an already pending event. */
+  guint64            num_coalesced;
+
+  /** Number of events handled. */
+  guint64            num_dispatched;
+
+  /** Total time spent handling events. */
+  gint64             total_dispatch_usec;
+
+  /** Worst-case time spent handling an event. */
+  gint64             max_dispatch_usec;
+
+  /** Pushed events per second, measured over
+   * the last second. */
+  double             push_rate;
+
+  /** Handled events per second, measured over
+   * the last second. */
+  double             dispatch_rate;
+
+  /** Counts at the start of the current rate
+   * period. */
+  guint64            period_num_pushed;
+  guint64            period_num_dispatched;
+} EventTypeStats;
+
 /**
  * Event manager.
  */
@@ -61,6 +115,47 @@ typedef struct EventManager
   /** ID of the event processing source func. */
   guint              process_source_id;
 
+  /** ID of the frame clock tick callback, or 0. */
+  guint              tick_cb_id;
+
+  /** Widget the tick callback is attached to. */
+  GtkWidget *        tick_widget;
+
+  /**
+   * Events waiting to be handled, in the order
+   * they were first pushed.
+   */
+  GPtrArray *        pending_events;
+
+  /**
+   * Index of the first event in \ref
+   * pending_events that was not dispatched yet.
+   *
+   * The dispatched events are removed from the
+   * array at once when dispatching finishes.
+   */
+  guint              pending_events_start;
+
+  /**
+   * Pending events keyed by (type, arg), used to
+   * merge duplicates.
+   */
+  GHashTable *       pending_events_ht;
+
+  /** Last time events were dispatched. */
+  gint64             last_dispatch_time;
+
+  /** Per-type statistics. */
+  EventTypeStats     stats[NUM_EVENT_TYPES];
+
+  /** Start of the current rate period. */
+  gint64             stats_period_start;
+
+  /** Whether to log the statistics every rate
+   * period (set with the ZRYTHM_EVENT_STATS
+   * environment variable). */
+  bool               log_stats;
+
   /** A soft recalculation of the routing graph
    * is pending. */
   bool               pending_soft_recalc;
@@ -83,6 +178,13 @@ typedef struct EventManager
  * Push events.
  */
 #define EVENTS_PUSH(et,_arg) \
+  EVENTS_PUSH_RECT (et, _arg, NULL)
+
+/**
+ * Push events that only need to redraw the given
+ * area of the argument widget.
+ */
+#define EVENTS_PUSH_RECT(et,_arg,_rect) \
   if (ZRYTHM_HAVE_UI && EVENT_MANAGER && \
       EVENT_QUEUE && \
       (!PROJECT || !AUDIO_ENGINE || \
@@ -96,6 +198,7 @@ typedef struct EventManager
       _ev->lineno = __LINE__; \
       _ev->type = et; \
       _ev->arg = (void *) _arg; \
+      event_set_rect (_ev, _rect); \
       if (zrythm_app->gtk_thread == \
             g_thread_self ()) \
         { \
@@ -139,6 +242,17 @@ void
 event_manager_process_now (
   EventManager * self);
 
+/**
+ * Moves queued events into the pending events,
+ * merging events that have the same type and
+ * argument.
+ *
+ * Must only be called from the GTK thread.
+ */
+void
+event_manager_drain_queue (
+  EventManager * self);
+
 /**
  * Removes events where the arg matches the
  * given object.
@@ -148,6 +262,25 @@ event_manager_remove_events_for_obj (
   EventManager * self,
   void *         obj);
 
+/**
+ * Returns the statistics for the given event
+ * type.
+ *
+ * Must only be called from the GTK thread.
+ */
+const EventTypeStats *
+event_manager_get_type_stats (
+  EventManager * self,
+  EventType      type);
+
+/**
+ * Logs the statistics of all event types that
+ * were pushed at least once.
+ */
+void
+event_manager_log_stats (
+  EventManager * self);
+
 void
 event_manager_free (
   EventManager * self);
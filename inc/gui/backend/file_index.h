@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Background indexer for sample libraries.
+ */
+
+#ifndef __GUI_BACKEND_FILE_INDEX_H__
+#define __GUI_BACKEND_FILE_INDEX_H__
+
+#include <stdbool.h>
+
+#include "audio/supported_file.h"
+
+#include <gio/gio.h>
+
+/**
+ * @addtogroup gui_backend
+ *
+ * @{
+ */
+
+#define FILE_INDEX (FILE_MANAGER->index)
+
+/** Number of peaks in the waveform thumbnail. */
+#define FILE_INDEX_NUM_PEAKS 64
+
+/**
+ * Max number of samples (frames * channels) to
+ * decode when generating a waveform thumbnail.
+ *
+ * Longer files are indexed without a thumbnail.
+ */
+#define FILE_INDEX_MAX_PEAK_SAMPLES (4 * 1024 * 1024)
+
+/** Max number of indexer threads. */
+#define FILE_INDEX_MAX_THREADS 4
+
+/**
+ * Max number of directories to watch for
+ * changes.
+ *
+ * Directories above this limit are only
+ * refreshed on the next crawl.
+ */
+#define FILE_INDEX_MAX_MONITORS 2048
+
+/** Version of the on-disk cache format. */
+#define FILE_INDEX_CACHE_VERSION 1
+
+/**
+ * An indexed file or directory.
+ */
+typedef struct FileIndexEntry
+{
+  /** Absolute path. */
+  char *        abs_path;
+
+  /** Offset of the basename in
+   * \ref FileIndexEntry.abs_path. */
+  size_t        name_offset;
+
+  /** Casefolded basename, used for searching. */
+  char *        search_key;
+
+  ZFileType     type;
+
+  /** Modification time in microseconds. */
+  gint64        mtime;
+
+  /** Size in bytes. */
+  gint64        size;
+
+  /** Whether the audio info below is valid. */
+  bool          has_info;
+
+  unsigned int  sample_rate;
+  unsigned int  channels;
+  int           bit_rate;
+  int           bit_depth;
+  gint64        num_frames;
+
+  /** BPM parsed from the name, or 0. */
+  double        bpm;
+
+  /** Musical key parsed from the name (eg,
+   * "C#m"), or an empty string. */
+  char          key[8];
+
+  /** Waveform thumbnail (absolute peaks scaled to
+   * 0-255), if \ref FileIndexEntry.num_peaks is
+   * non-zero. */
+  guint8        peaks[FILE_INDEX_NUM_PEAKS];
+  int           num_peaks;
+
+  /** For directories, whether the children have
+   * been indexed. */
+  bool          listed;
+
+  /** Crawl generation this entry was last seen
+   * in. */
+  guint         seen_gen;
+} FileIndexEntry;
+
+/**
+ * A root directory to crawl.
+ */
+typedef struct FileIndexRoot
+{
+  char *        path;
+
+  /** Whether the root could be opened during
+   * the last crawl. */
+  bool          available;
+} FileIndexRoot;
+
+/**
+ * Query for \ref file_index_query().
+ */
+typedef struct FileIndexQuery
+{
+  /** Directory to search in. */
+  const char *  dir;
+
+  /** Whether to also return entries in
+   * subdirectories. */
+  bool          recursive;
+
+  /** Space-separated words that must all appear
+   * in the name (case-insensitive), or NULL. */
+  const char *  text;
+} FileIndexQuery;
+
+/**
+ * Index of the files under the sample library
+ * locations.
+ *
+ * Directories are crawled and audio files are
+ * probed in a thread pool, and the results are
+ * cached on disk so that only new or modified
+ * files need to be probed on the next run.
+ * Crawled directories are watched for changes.
+ *
+ * Entries are only accessed under
+ * \ref FileIndex.mutex; use the query functions
+ * to get copies.
+ */
+typedef struct FileIndex
+{
+  /** Absolute path -> FileIndexEntry. */
+  GHashTable *  entries;
+
+  /** Root directories (FileIndexRoot). */
+  GPtrArray *   roots;
+
+  GMutex        mutex;
+
+  GThreadPool * pool;
+
+  /** Number of queued or running tasks. */
+  volatile gint num_pending;
+
+  /** Task counter, used for FIFO ordering within
+   * the same priority. */
+  volatile gint task_seq;
+
+  /** Current crawl generation. */
+  guint         gen;
+
+  /** Whether a full crawl of the roots is in
+   * progress. */
+  bool          crawling;
+
+  /** File IDs of directories crawled in this
+   * generation, to avoid symlink loops. */
+  GHashTable *  visited_dirs;
+
+  /** Directory path -> GFileMonitor. */
+  GHashTable *  monitors;
+
+  /** Pending UI notification source, or 0. */
+  guint         notify_source_id;
+
+  /** Set when shutting down. */
+  volatile gint cancelled;
+
+  /** Cache file path, or NULL to not persist the
+   * index. */
+  char *        cache_path;
+
+  /** Whether there are unsaved changes. */
+  bool          dirty;
+
+  GMutex        save_mutex;
+} FileIndex;
+
+/**
+ * Creates a new index and loads the cache file,
+ * if any.
+ *
+ * @param cache_path Cache file path, or NULL.
+ */
+FileIndex *
+file_index_new (
+  const char * cache_path);
+
+/**
+ * Sets the root directories to index and starts
+ * crawling them.
+ *
+ * Entries outside the roots are dropped when the
+ * crawl finishes, except for entries of roots
+ * that are currently unavailable (eg, unmounted
+ * drives).
+ *
+ * @param paths NULL-terminated array of paths.
+ */
+void
+file_index_set_roots (
+  FileIndex *          self,
+  const char * const * paths);
+
+/**
+ * Queues the given file or directory to be
+ * (re)indexed before any other pending work.
+ */
+void
+file_index_request_path (
+  FileIndex *  self,
+  const char * path);
+
+/**
+ * Returns a copy of the entry for the given path,
+ * or NULL if not indexed.
+ */
+FileIndexEntry *
+file_index_get_entry (
+  FileIndex *  self,
+  const char * path);
+
+/**
+ * Returns whether the children of the given
+ * directory are indexed, so that the directory
+ * can be listed with file_index_query().
+ */
+bool
+file_index_is_dir_listed (
+  FileIndex *  self,
+  const char * dir);
+
+/**
+ * Returns copies of the entries matching the
+ * given query, sorted by path.
+ *
+ * @return A GPtrArray of FileIndexEntry that
+ *   frees its elements.
+ */
+GPtrArray *
+file_index_query (
+  FileIndex *            self,
+  const FileIndexQuery * query);
+
+/**
+ * Returns whether there is pending work.
+ */
+bool
+file_index_is_busy (
+  FileIndex * self);
+
+/**
+ * Blocks until all pending work is done.
+ *
+ * Used in tests.
+ */
+void
+file_index_wait (
+  FileIndex * self);
+
+/**
+ * Writes the index to the cache file.
+ *
+ * @return Whether successful.
+ */
+bool
+file_index_save (
+  FileIndex * self,
+  GError **   error);
+
+/**
+ * Parses BPM and key tags from a sample file name,
+ * eg "Loop_Cm_128bpm.wav" or "Pad 90 BPM F# minor".
+ *
+ * @param bpm Set to the BPM, or 0 if not found.
+ * @param key Set to the key (eg, "F#m"), or an
+ *   empty string if not found.
+ */
+void
+file_index_parse_tags_from_name (
+  const char * name,
+  double *     bpm,
+  char *       key,
+  size_t       key_size);
+
+/**
+ * Returns a human readable summary of the audio
+ * info, BPM and key of the entry.
+ */
+char *
+file_index_entry_get_info_str (
+  const FileIndexEntry * self);
+
+FileIndexEntry *
+file_index_entry_clone (
+  const FileIndexEntry * src);
+
+void
+file_index_entry_free (
+  FileIndexEntry * self);
+
+/**
+ * Stops the indexer threads, saves the index and
+ * frees the instance.
+ */
+void
+file_index_free (
+  FileIndex * self);
+
+/**
+ * @}
+ */
+
+#endif
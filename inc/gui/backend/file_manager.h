@@ -21,8 +21,10 @@
 #define __GUI_BACKEND_FILE_MANAGER_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct SupportedFile SupportedFile;
+typedef struct FileIndex FileIndex;
 
 /**
  * @addtogroup gui_backend
@@ -68,11 +70,10 @@ typedef struct FileManager
    *
    * To be updated every time location / collection
    * selection changes.
-   *
-   * FIXME this should be allocated dynamically.
    */
-  SupportedFile *          files[10000];
+  SupportedFile **         files;
   int                      num_files;
+  size_t                   files_size;
 
   /**
    * User collections.
@@ -92,6 +93,18 @@ typedef struct FileManager
   void *                   selection;
   FileBrowserSelectionType selection_type;
 
+  /**
+   * Text to search for under the current
+   * location, or NULL to list the location.
+   *
+   * Searching is only supported in indexed
+   * locations.
+   */
+  char *                   search_text;
+
+  /** Index of the sample library locations. */
+  FileIndex *              index;
+
 } FileManager;
 
 /**
@@ -113,6 +126,17 @@ file_manager_set_selection (
   FileBrowserSelectionType sel_type,
   bool                     load_files);
 
+/**
+ * Sets the text to search for under the current
+ * location, or NULL to clear the search.
+ *
+ * The files must be reloaded afterwards.
+ */
+void
+file_manager_set_search_text (
+  FileManager * self,
+  const char *  text);
+
 /**
  * Frees the file manager.
  */
@@ -28,6 +28,7 @@
 
 #include "gui/widgets/main_window.h"
 #include "audio/position.h"
+#include "audio/snap_grid.h"
 #include "utils/ui.h"
 
 #include <gtk/gtk.h>
@@ -230,6 +231,9 @@ typedef struct _ArrangerWidget
   /** Associated SnapGrid. */
   SnapGrid *     snap_grid;
 
+  /** Objects to snap to in the current drag. */
+  SnapObjectIndex snap_obj_index;
+
   /** Whether shift button is held down. */
   int            shift_held;
 
@@ -310,15 +314,34 @@ typedef struct _ArrangerWidget
    * playhead changes position. */
   int            last_playhead_px;
 
-  /** Set to 1 to redraw. */
+  /** Set to 1 to redraw all cached layers. */
   int            redraw;
 
-  cairo_t *      cached_cr;
+  /**
+   * Cached background layer (background, loop
+   * area, grid lines, ranges and track/key
+   * backgrounds).
+   */
+  cairo_t *      bg_layer_cr;
+  cairo_surface_t * bg_layer_surface;
+
+  /** Cached arranger object layer. */
+  cairo_t *      obj_layer_cr;
+  cairo_surface_t * obj_layer_surface;
 
-  cairo_surface_t * cached_surface;
+  /** Visible rectangle the cached layers
+   * correspond to. */
+  GdkRectangle   layer_rect;
 
-  /** Rectangle in the last call. */
-  GdkRectangle   last_rect;
+  /**
+   * Areas of the cached layers that need to be
+   * redrawn, in arranger coordinates.
+   *
+   * The playhead, selection and highlight are
+   * drawn on top of the layers on every draw, so
+   * they never damage the layers.
+   */
+  cairo_region_t * layer_damage;
 
   /**
    * Whether the current selections can link
@@ -550,6 +573,18 @@ SnapGrid *
 arranger_widget_get_snap_grid (
   ArrangerWidget * self);
 
+/**
+ * Returns the index of the objects in the given
+ * track to snap to, or NULL if no track is given.
+ *
+ * The index is built on first use and kept until
+ * the current drag ends.
+ */
+const SnapObjectIndex *
+arranger_widget_get_snap_obj_index (
+  ArrangerWidget * self,
+  Track *          track);
+
 /**
  * Called from MainWindowWidget because some
  * events don't reach here.
@@ -45,6 +45,22 @@ arranger_draw_cb (
   cairo_t *        cr,
   ArrangerWidget * self);
 
+/**
+ * Marks the given area (in arranger coordinates)
+ * of the cached layers for redrawing.
+ */
+void
+arranger_draw_damage_layers (
+  ArrangerWidget * self,
+  GdkRectangle *   rect);
+
+/**
+ * Frees the cached layers.
+ */
+void
+arranger_draw_free_layers (
+  ArrangerWidget * self);
+
 /**
  * @}
  */
@@ -65,6 +65,9 @@ typedef struct _BalanceControlWidget
 
   /** Balance at start of drag. */
   float              balance_at_start;
+
+  /** Balance set during the current drag. */
+  float              balance_during_drag;
 } BalanceControlWidget;
 
 /**
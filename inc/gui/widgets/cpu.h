@@ -55,6 +55,9 @@ typedef struct _CpuWidget
   /** Source func IDs. */
   guint                  cpu_source_id;
   guint                  dsp_source_id;
+
+  /** Click gesture to show the DSP profiler. */
+  GtkGestureMultiPress * mp;
 } CpuWidget;
 
 /**
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * DSP profiler dialog.
+ */
+
+#ifndef __GUI_WIDGETS_DSP_PROFILER_DIALOG_H__
+#define __GUI_WIDGETS_DSP_PROFILER_DIALOG_H__
+
+#include <gtk/gtk.h>
+
+#define DSP_PROFILER_DIALOG_WIDGET_TYPE \
+  (dsp_profiler_dialog_widget_get_type ())
+G_DECLARE_FINAL_TYPE (
+  DspProfilerDialogWidget,
+  dsp_profiler_dialog_widget,
+  Z, DSP_PROFILER_DIALOG_WIDGET,
+  GtkDialog)
+
+/**
+ * @addtogroup widgets
+ *
+ * @{
+ */
+
+/**
+ * Dialog that shows per-node DSP stats collected
+ * by the graph profiler.
+ */
+typedef struct _DspProfilerDialogWidget
+{
+  GtkDialog         parent_instance;
+
+  /** Toggle to enable/disable profiling. */
+  GtkCheckButton *  enable_btn;
+
+  /** Label showing engine and thread stats. */
+  GtkLabel *        summary_lbl;
+
+  GtkTreeView *     tree;
+  GtkListStore *    store;
+
+  /** Refresh source ID. */
+  guint             refresh_source_id;
+} DspProfilerDialogWidget;
+
+/**
+ * Creates the dialog.
+ */
+DspProfilerDialogWidget *
+dsp_profiler_dialog_widget_new (void);
+
+/**
+ * @}
+ */
+
+#endif
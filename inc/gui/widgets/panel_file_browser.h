@@ -55,10 +55,22 @@ typedef struct _PanelFileBrowserWidget
   GtkScrolledWindow *    file_scroll_window;
   SupportedFile *        selected_file_descr;
 
+  /** Whether the selected file was queued for
+   * indexing. */
+  bool                   file_info_requested;
+
   bool                   first_draw;
 } PanelFileBrowserWidget;
 
 PanelFileBrowserWidget *
 panel_file_browser_widget_new (void);
 
+/**
+ * Called when the file index changes to update
+ * the info of the selected file.
+ */
+void
+panel_file_browser_widget_refresh (
+  PanelFileBrowserWidget * self);
+
 #endif
@@ -168,6 +168,13 @@ typedef struct _PluginBrowserWidget
 
   /** Current search string. */
   char *               current_search;
+
+  /**
+   * PluginDescriptor -> rank + 1 of the plugins
+   * matching the current filters and search, or
+   * NULL if nothing is filtered.
+   */
+  GHashTable *         search_results;
 } PluginBrowserWidget;
 
 /**
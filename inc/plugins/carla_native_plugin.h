@@ -28,11 +28,15 @@
 #ifndef __PLUGINS_CARLA_NATIVE_PLUGIN_H__
 #define __PLUGINS_CARLA_NATIVE_PLUGIN_H__
 
+#include "utils/types.h"
+
 #ifdef HAVE_CARLA
 #include <CarlaNativePlugin.h>
 #include <CarlaUtils.h>
 #endif
 
+#include <glib.h>
+
 typedef struct PluginDescriptor PluginDescriptor;
 typedef void * CarlaPluginHandle;
 
@@ -44,6 +48,10 @@ typedef void * CarlaPluginHandle;
 
 #define CARLA_STATE_FILENAME "state.carla"
 
+/** Max number of audio channels of the Carla host
+ * plugins (the 64-channel patchbay). */
+#define CARLA_NATIVE_PLUGIN_MAX_CHANNELS 64
+
 /**
  * The type of the Carla plugin.
  */
@@ -66,11 +74,51 @@ typedef struct CarlaNativePlugin
 
   CarlaHostHandle  host_handle;
 
-  //uint32_t                 num_midi_events;
-  //NativeMidiEvent          midi_events[200];
   NativeTimeInfo   time_info;
+
+  /** MIDI events passed to the host plugin
+   * (MAX_MIDI_EVENTS). */
+  NativeMidiEvent * midi_events;
+
+  /** Audio buffers passed to the host plugin,
+   * pointing inside the port buffers or to the
+   * dummy buffers. */
+  float *          inbufs[
+    CARLA_NATIVE_PLUGIN_MAX_CHANNELS];
+  float *          outbufs[
+    CARLA_NATIVE_PLUGIN_MAX_CHANNELS];
 #endif
 
+  /**
+   * Carla plugin hosting the plugin.
+   *
+   * The rack has 2 ins and 2 outs, so plugins with
+   * more channels are hosted in a patchbay with
+   * enough channels.
+   */
+  CarlaPluginType  host_type;
+
+  /** Number of audio ins/outs of the host plugin. */
+  int              num_host_audio_ins;
+  int              num_host_audio_outs;
+
+  /** Silent buffer for host ins without a port. */
+  float *          zero_buf;
+
+  /** Scratch buffer for host outs without a
+   * port. */
+  float *          discard_buf;
+
+  /** Size of the dummy buffers in frames. */
+  nframes_t        bufs_size;
+
+  /** Patchbay ports reported while refreshing the
+   * patchbay, used to connect the plugin. */
+  GArray *         patchbay_ports;
+
+  /** Patchbay group of the plugin, or -1. */
+  int              patchbay_plugin_group;
+
   /** Pointer back to Plugin. */
   Plugin *         plugin;
 
@@ -169,6 +217,17 @@ carla_native_plugin_get_abs_state_file_path (
   CarlaNativePlugin * self,
   bool                is_backup);
 
+/**
+ * Allocates the dummy buffers for the given block
+ * length and notifies the host plugin.
+ *
+ * Must not be called while processing.
+ */
+void
+carla_native_plugin_update_buffer_size (
+  CarlaNativePlugin * self,
+  nframes_t           nframes);
+
 /**
  * Processes the plugin for this cycle.
  */
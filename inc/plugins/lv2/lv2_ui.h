@@ -60,8 +60,12 @@ lv2_ui_instantiate (
   void*        parent);
 
 /**
- * Read and apply control change events from UI,
- * for plugins that have their own UIs.
+ * Read and apply atom events from UI, for plugins
+ * that have their own UIs.
+ *
+ * Float control changes do not go through here,
+ * they are queued by
+ * lv2_ui_send_event_from_ui_to_plugin().
  *
  * Called in the real-time audio thread during
  * plugin processing.
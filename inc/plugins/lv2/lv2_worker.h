@@ -25,19 +25,86 @@
 
 #include "lv2/worker/worker.h"
 
+#include <glib.h>
+
 typedef struct Lv2Plugin Lv2Plugin;
+typedef struct MPMCQueue MPMCQueue;
+
+/** Maximum number of threads in the shared worker
+ * pool. */
+#define LV2_WORKER_POOL_MAX_THREADS 4
+
+/** Maximum number of workers that can be waiting
+ * to be serviced at the same time. */
+#define LV2_WORKER_POOL_MAX_QUEUED 4096
+
+#define LV2_WORKER_POOL \
+  (PLUGIN_MANAGER->lv2_worker_pool)
+
+/**
+ * Pool of non-realtime threads shared by the
+ * workers of all LV2 plugin instances.
+ *
+ * Workers with pending requests are queued in
+ * @ref Lv2WorkerPool.ready at most once. A thread
+ * takes a worker from the queue, runs one of its
+ * requests and puts it back at the end of the
+ * queue if it has more, so requests of the same
+ * instance run one at a time and in order, and
+ * busy instances don't starve the others.
+ */
+typedef struct Lv2WorkerPool
+{
+  ZixThread    threads[LV2_WORKER_POOL_MAX_THREADS];
+  int          num_threads;
+
+  /** Workers (LV2_Worker) waiting to be
+   * serviced. */
+  MPMCQueue *  ready;
+
+  /** Posted once for each worker pushed to
+   * @ref Lv2WorkerPool.ready. */
+  ZixSem       sem;
+
+  /** Set when the threads should stop. */
+  volatile gint exit;
+} Lv2WorkerPool;
 
 typedef struct {
 	Lv2Plugin *                 plugin;       ///< Pointer back to the plugin
 	ZixRing*                    requests;   ///< Requests to the worker
 	ZixRing*                    responses;  ///< Responses from the worker
 	void*                       response;   ///< Worker response buffer
-	ZixSem                      sem;        ///< Worker semaphore
-	ZixThread                   thread;     ///< Worker thread
+	Lv2WorkerPool*              pool;       ///< Pool running the requests
+	volatile gint               queued;     ///< Whether queued in the pool
+	volatile gint               num_pending; ///< Requests not run yet
 	const LV2_Worker_Interface* iface;      ///< Plugin worker interface
 	bool                        threaded;   ///< Run work in another thread
 } LV2_Worker;
 
+/**
+ * Creates the shared worker pool and starts its
+ * threads.
+ */
+Lv2WorkerPool *
+lv2_worker_pool_new (void);
+
+/**
+ * Stops the threads and frees the pool.
+ *
+ * Workers still queued are dropped.
+ */
+void
+lv2_worker_pool_free (
+  Lv2WorkerPool * self);
+
+/**
+ * Inits the worker.
+ *
+ * @param threaded Whether to run the requests in
+ *   @ref LV2_WORKER_POOL instead of the calling
+ *   thread.
+ */
 void
 lv2_worker_init (
   Lv2Plugin*                       plugin,
@@ -45,6 +112,13 @@ lv2_worker_init (
   const LV2_Worker_Interface* iface,
   bool                        threaded);
 
+/**
+ * Waits for the pool to finish with the worker
+ * and frees its resources.
+ *
+ * Lv2Plugin.exit must be set before calling this
+ * so that pending requests are dropped.
+ */
 void
 lv2_worker_finish (LV2_Worker* worker);
 
@@ -54,6 +128,14 @@ lv2_worker_schedule (
   uint32_t                   size,
   const void*                data);
 
+/**
+ * Returns the number of requests scheduled by
+ * the plugin instance that have not run yet.
+ */
+int
+lv2_worker_get_queue_depth (
+  LV2_Worker * worker);
+
 void
 lv2_worker_emit_responses (
   LV2_Worker* worker, LilvInstance* instance);
@@ -60,6 +60,10 @@ typedef struct _ModulatorWidget ModulatorWidget;
 #define PLUGIN_MIN_REFRESH_RATE 30.f
 #define PLUGIN_MAX_REFRESH_RATE 121.f
 
+/** Max number of threads used to instantiate
+ * plugins when loading a project. */
+#define PLUGIN_MAX_INSTANTIATION_THREADS 8
+
 /**
  * The base plugin
  * Inheriting plugins must have this as a child
@@ -125,6 +129,16 @@ typedef struct Plugin
    * plugin will be treated as disabled. */
   bool              instantiation_failed;
 
+  /**
+   * Messages for the user from instantiating the
+   * plugin in a worker thread, or NULL.
+   *
+   * Shown by plugin_instantiate_loaded_plugins()
+   * from the calling thread, since GTK can only be
+   * used from the GTK thread.
+   */
+  char *            instantiation_msg;
+
   /** Whether the plugin is currently activated
    * or not. */
   bool              activated;
@@ -252,6 +266,12 @@ static const cyaml_schema_value_t
     Plugin, plugin_fields_schema),
 };
 
+/**
+ * Inits the plugin after loading.
+ *
+ * Project plugins are not instantiated here, see
+ * plugin_instantiate_loaded_plugins().
+ */
 void
 plugin_init_loaded (
   Plugin * self,
@@ -531,6 +551,28 @@ plugin_instantiate (
   bool        project,
   LilvState * state);
 
+/**
+ * Instantiates and activates the given plugins of
+ * a project being loaded.
+ *
+ * Plugins whose descriptors allow it are
+ * instantiated (and their state restored) in
+ * parallel, with plugins sharing a binary
+ * instantiated one after the other. The rest are
+ * instantiated in the calling thread.
+ *
+ * Opening the plugin libraries touches the lilv
+ * world, so lilv_plugin_instantiate() itself is
+ * serialized by \ref PM_LILV_LOCK.
+ *
+ * Returns after all plugins are instantiated.
+ * Plugins that fail are disabled.
+ */
+void
+plugin_instantiate_loaded_plugins (
+  Plugin ** plugins,
+  int       num_plugins);
+
 /**
  * Sets the track and track_pos on the plugin.
  */
@@ -420,6 +420,16 @@ bool
 plugin_descriptor_has_custom_ui (
   PluginDescriptor * self);
 
+/**
+ * Returns whether instances of the plugin can be
+ * instantiated in a thread other than the GTK
+ * thread, concurrently with instances of other
+ * plugins.
+ */
+bool
+plugin_descriptor_is_instantiation_thread_safe (
+  const PluginDescriptor * self);
+
 void
 plugin_descriptor_free (
   PluginDescriptor * self);
@@ -34,9 +34,13 @@
 
 #include <lilv/lilv.h>
 
+#include <glib.h>
+
 typedef struct CachedPluginDescriptors
   CachedPluginDescriptors;
 typedef struct PluginCollections PluginCollections;
+typedef struct PluginSearchIndex PluginSearchIndex;
+typedef struct Lv2WorkerPool Lv2WorkerPool;
 
 /**
  * @addtogroup plugins
@@ -55,6 +59,7 @@ typedef struct PluginCollections PluginCollections;
 #define PM_URIDS (PLUGIN_MANAGER->urids)
 #define PM_SYMAP (PLUGIN_MANAGER->symap)
 #define PM_SYMAP_LOCK (PLUGIN_MANAGER->symap_lock)
+#define PM_LILV_LOCK (PLUGIN_MANAGER->lilv_lock)
 
 /**
  * Cached LV2 nodes.
@@ -185,11 +190,27 @@ typedef struct PluginManager
   /** Plugin collections. */
   PluginCollections *    collections;
 
+  /** Search index over the scanned plugins. */
+  PluginSearchIndex *    search_index;
+
+  /** Threads running the work of LV2 plugin
+   * instances. */
+  Lv2WorkerPool *        lv2_worker_pool;
+
   /** URI map for URID feature. */
   Symap*                 symap;
   /** Lock for URI map. */
   ZixSem                 symap_lock;
 
+  /**
+   * Lock for the lilv world, which is not
+   * thread-safe.
+   *
+   * Must be held when using the world while
+   * plugins may be instantiated in other threads.
+   */
+  GRecMutex              lilv_lock;
+
   /** URIDs. */
   Lv2URIDs               urids;
 
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Search index over the scanned plugins.
+ */
+
+#ifndef __PLUGINS_PLUGIN_SEARCH_INDEX_H__
+#define __PLUGINS_PLUGIN_SEARCH_INDEX_H__
+
+#include <stdbool.h>
+
+#include "plugins/plugin_descriptor.h"
+
+#include <glib.h>
+
+typedef struct PluginCollection PluginCollection;
+
+/**
+ * @addtogroup plugins
+ *
+ * @{
+ */
+
+#define PLUGIN_SEARCH_INDEX \
+  (PLUGIN_MANAGER->search_index)
+
+#define PLUGIN_SEARCH_NUM_PROTOCOLS (PROT_SF2 + 1)
+#define PLUGIN_SEARCH_NUM_CATEGORIES (PC_MIXER + 1)
+
+/**
+ * Plugin type filters.
+ */
+typedef enum PluginSearchType
+{
+  PLUGIN_SEARCH_TYPE_INSTRUMENT,
+  PLUGIN_SEARCH_TYPE_EFFECT,
+  PLUGIN_SEARCH_TYPE_MODULATOR,
+  PLUGIN_SEARCH_TYPE_MIDI_MODIFIER,
+  PLUGIN_SEARCH_NUM_TYPES,
+} PluginSearchType;
+
+/**
+ * An indexed descriptor.
+ */
+typedef struct PluginSearchEntry
+{
+  /** Descriptor (not owned). */
+  PluginDescriptor * descr;
+
+  /** Casefolded name. */
+  char *             name_key;
+
+  /** Casefolded name, author and category,
+   * used for substring matches. */
+  char *             text_key;
+
+  /** Key identifying the plugin, used to match
+   * descriptors in collections. */
+  char *             id_key;
+
+  /** Whether the descriptor was removed (the
+   * entry is reused on the next rebuild). */
+  bool               removed;
+} PluginSearchEntry;
+
+/**
+ * One search result.
+ */
+typedef struct PluginSearchResult
+{
+  PluginDescriptor * descr;
+
+  /** Relevance, higher is better. */
+  double             score;
+} PluginSearchResult;
+
+/**
+ * Query for plugin_search_index_query().
+ *
+ * All the given conditions must match.
+ */
+typedef struct PluginSearchQuery
+{
+  /** Space-separated words to search for in the
+   * name, author and category, or NULL. */
+  const char *            text;
+
+  /** Categories, any of which must match. */
+  const ZPluginCategory * categories;
+  int                     num_categories;
+
+  /** Protocols, any of which must match. */
+  const PluginProtocol *  protocols;
+  int                     num_protocols;
+
+  /** Types that must all match. */
+  bool                    types[PLUGIN_SEARCH_NUM_TYPES];
+
+  /** Collection to search in, or NULL. */
+  PluginCollection *      collection;
+} PluginSearchQuery;
+
+/**
+ * Index of plugin descriptors for fast searching
+ * and filtering in the plugin browser.
+ *
+ * Names, authors and categories are split into
+ * casefolded tokens (including camel case parts,
+ * eg, "ZynAddSubFX" -> "zyn", "add", "sub", "fx")
+ * that map to the entries containing them, and
+ * the protocol, category and type of each entry
+ * are kept in bitmaps so that filters are
+ * evaluated a word at a time.
+ *
+ * Text is matched by token (exact or prefix),
+ * then by substring, then by tolerating a typo or
+ * missing characters, and results are ranked
+ * accordingly.
+ *
+ * @note Must only be used from the GTK thread.
+ */
+typedef struct PluginSearchIndex
+{
+  /** Entries (PluginSearchEntry), in the order
+   * they were added. */
+  GArray *      entries;
+
+  /** Number of entries that are not removed. */
+  int           num_live;
+
+  /** PluginDescriptor pointer -> entry index + 1. */
+  GHashTable *  descr_to_idx;
+
+  /** PluginSearchEntry.id_key -> entry index + 1. */
+  GHashTable *  id_to_idx;
+
+  /** Token -> GArray of postings (entry index
+   * << 2 | field). */
+  GHashTable *  tokens;
+
+  /** Tokens sorted for prefix lookups, rebuilt
+   * when tokens are added. */
+  GPtrArray *   sorted_tokens;
+  bool          sorted_tokens_dirty;
+
+  /** Bitmaps with one bit per entry. */
+  guint64 *     live;
+  guint64 *     protocols[PLUGIN_SEARCH_NUM_PROTOCOLS];
+  guint64 *     categories[PLUGIN_SEARCH_NUM_CATEGORIES];
+  guint64 *     types[PLUGIN_SEARCH_NUM_TYPES];
+
+  /** Number of 64-bit words in each bitmap. */
+  size_t        num_words;
+} PluginSearchIndex;
+
+PluginSearchIndex *
+plugin_search_index_new (void);
+
+/**
+ * Adds the given descriptor to the index.
+ *
+ * Does nothing if already added.
+ */
+void
+plugin_search_index_add (
+  PluginSearchIndex * self,
+  PluginDescriptor *  descr);
+
+/**
+ * Removes the given descriptor from the index.
+ */
+void
+plugin_search_index_remove (
+  PluginSearchIndex * self,
+  PluginDescriptor *  descr);
+
+/**
+ * Updates the index to contain exactly the given
+ * descriptors, adding and removing only the ones
+ * that changed.
+ */
+void
+plugin_search_index_sync (
+  PluginSearchIndex *        self,
+  PluginDescriptor * const * descrs,
+  int                        num_descrs);
+
+/**
+ * Returns whether the query has any conditions.
+ */
+bool
+plugin_search_query_is_empty (
+  const PluginSearchQuery * query);
+
+/**
+ * Runs the given query.
+ *
+ * @return A GArray of PluginSearchResult sorted
+ *   by descending score, then by name.
+ */
+GArray *
+plugin_search_index_query (
+  PluginSearchIndex *       self,
+  const PluginSearchQuery * query);
+
+void
+plugin_search_index_free (
+  PluginSearchIndex * self);
+
+/**
+ * @}
+ */
+
+#endif
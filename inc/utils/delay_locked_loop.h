@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Delay-locked loop for filtering cycle times.
+ */
+
+#ifndef __UTILS_DELAY_LOCKED_LOOP_H__
+#define __UTILS_DELAY_LOCKED_LOOP_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+/** Default loop bandwidth in Hz. */
+#define DELAY_LOCKED_LOOP_DEFAULT_BANDWIDTH 1.0
+
+/**
+ * Second-order delay-locked loop that models the
+ * audio clock against the system clock.
+ *
+ * It is fed the (jittery) system time at the
+ * start of each processing cycle and predicts
+ * smooth start times of the current and next
+ * cycles, so that timestamps of external events
+ * can be converted to exact frame offsets.
+ *
+ * See "Using a DLL to filter time" by Fons
+ * Adriaensen.
+ */
+typedef struct DelayLockedLoop
+{
+  /** Filtered start time of the current cycle
+   * (usec). */
+  double        t0;
+
+  /** Predicted start time of the next cycle
+   * (usec). */
+  double        t1;
+
+  /** Filtered cycle period (usec). */
+  double        e2;
+
+  /** Loop coefficients. */
+  double        b;
+  double        c;
+
+  /** Loop bandwidth in Hz. */
+  double        bandwidth;
+
+  /** Cycle size and sample rate the loop is
+   * currently locked to. */
+  nframes_t     nframes;
+  sample_rate_t sample_rate;
+
+  /** Whether the loop has been started. */
+  bool          running;
+} DelayLockedLoop;
+
+/**
+ * Inits the loop with the given bandwidth in Hz.
+ *
+ * Lower values filter more jitter but take longer
+ * to lock.
+ */
+void
+delay_locked_loop_init (
+  DelayLockedLoop * self,
+  double            bandwidth);
+
+/**
+ * Restarts the loop at the given time.
+ */
+void
+delay_locked_loop_reset (
+  DelayLockedLoop * self,
+  gint64            time,
+  nframes_t         nframes,
+  sample_rate_t     sample_rate);
+
+/**
+ * Updates the loop with the system time at the
+ * start of a cycle.
+ *
+ * The loop is restarted if the cycle size or
+ * sample rate changed or if the time is too far
+ * off (eg, after an xrun).
+ */
+void
+delay_locked_loop_update (
+  DelayLockedLoop * self,
+  gint64            time,
+  nframes_t         nframes,
+  sample_rate_t     sample_rate);
+
+/**
+ * Converts the given system time to frames
+ * relative to the start of the current cycle.
+ *
+ * The result is negative for times before the
+ * start of the current cycle.
+ */
+double
+delay_locked_loop_time_to_frames (
+  const DelayLockedLoop * self,
+  gint64                  time);
+
+/**
+ * @}
+ */
+
+#endif
@@ -23,6 +23,35 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "utils/dsp_simd.h"
+
+/**
+ * Selects the built-in SIMD kernels to use based
+ * on the CPU.
+ *
+ * The level can be capped with the
+ * ZRYTHM_DSP_SIMD environment variable (0 for
+ * none, 1 for SSE2, 2 for AVX2, 3 for AVX-512).
+ */
+void
+dsp_init (void);
+
+/**
+ * Sets the built-in SIMD kernels to use.
+ *
+ * @note Must not be called while the engine is
+ *   processing.
+ */
+void
+dsp_set_simd_level (
+  DspSimdLevel level);
+
+/**
+ * Returns the built-in SIMD kernels in use.
+ */
+DspSimdLevel
+dsp_get_simd_level (void);
+
 /**
  * Fill the buffer with the given value.
  */
@@ -104,6 +133,24 @@ dsp_mix2 (
   float         k2,
   size_t        size);
 
+/**
+ * Calculate dest[i] = dest[i] * k1 + src[i] * k2,
+ * where k2 goes linearly from \p k2_start at the
+ * first sample to \p k2_end at the sample after
+ * the last one.
+ *
+ * Used for gain changes within a block so that
+ * consecutive ramps join without steps.
+ */
+void
+dsp_mix2_ramp (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2_start,
+  float         k2_end,
+  size_t        size);
+
 /**
  * Calculate
  * dst[i] = dst[i] + src1[i] * k1 + src2[i] * k2.
@@ -117,6 +164,39 @@ dsp_mix_add2 (
   float         k2,
   size_t        size);
 
+/**
+ * Calculate
+ * dest[i] = CLAMP (dest[i] * k1 + src[i] * k2)
+ * in a single pass.
+ */
+void
+dsp_mix2_limit1 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  float         minf,
+  float         maxf,
+  size_t        size);
+
+/**
+ * Calculate
+ * dest[i] = CLAMP (dest[i] + sum (srcs[j][i] * ks[j]))
+ * in a single pass over all the buffers.
+ *
+ * The destination is read and written once
+ * regardless of the number of sources.
+ */
+void
+dsp_gather_sum_limit1 (
+  float *               dest,
+  const float * const * srcs,
+  const float *         ks,
+  size_t                num_srcs,
+  float                 minf,
+  float                 maxf,
+  size_t                size);
+
 /**
  * Makes the two signals mono.
  *
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Built-in SIMD implementations of the DSP
+ * kernels, selected at runtime based on the CPU.
+ *
+ * These are used when LSP DSP is unavailable or
+ * disabled. Use the functions in utils/dsp.h
+ * instead of calling these directly.
+ */
+
+#ifndef __UTILS_DSP_SIMD_H__
+#define __UTILS_DSP_SIMD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+/**
+ * Instruction set used by the built-in kernels.
+ */
+typedef enum DspSimdLevel
+{
+  /** Plain C loops. */
+  DSP_SIMD_LEVEL_NONE,
+  DSP_SIMD_LEVEL_SSE2,
+  DSP_SIMD_LEVEL_AVX2,
+  DSP_SIMD_LEVEL_AVX512,
+} DspSimdLevel;
+
+/**
+ * A set of kernels for one instruction set.
+ *
+ * Loads and stores are unaligned, so these can be
+ * called with any offset into a buffer.
+ */
+typedef struct DspSimdFuncs
+{
+  void  (*fill) (
+    float * buf, float val, size_t size);
+  void  (*limit1) (
+    float * buf, float minf, float maxf,
+    size_t size);
+  /** Returns the absolute max (at least 0). */
+  float (*abs_max) (
+    const float * buf, size_t size);
+  /** Returns the min, or \p init if smaller. */
+  float (*min) (
+    const float * buf, float init, size_t size);
+  /** Returns the max, or \p init if larger. */
+  float (*max) (
+    const float * buf, float init, size_t size);
+  void  (*copy) (
+    float * dest, const float * src, size_t size);
+  void  (*add2) (
+    float * dest, const float * src, size_t size);
+  void  (*mul_k2) (
+    float * dest, float k, size_t size);
+  void  (*mix2) (
+    float * dest, const float * src, float k1,
+    float k2, size_t size);
+  void  (*mix2_ramp) (
+    float * dest, const float * src, float k1,
+    float k2_start, float k2_step, size_t size);
+  void  (*mix_add2) (
+    float * dest, const float * src1,
+    const float * src2, float k1, float k2,
+    size_t size);
+  void  (*mix2_limit1) (
+    float * dest, const float * src, float k1,
+    float k2, float minf, float maxf,
+    size_t size);
+  void  (*gather_sum_limit1) (
+    float * dest, const float * const * srcs,
+    const float * ks, size_t num_srcs,
+    float minf, float maxf, size_t size);
+} DspSimdFuncs;
+
+/**
+ * Returns the best instruction set supported by
+ * both the CPU and the compiler.
+ */
+DspSimdLevel
+dsp_simd_detect_level (void);
+
+/**
+ * Returns the kernels for the given level, or NULL
+ * for \ref DSP_SIMD_LEVEL_NONE or if the level
+ * was not compiled in.
+ */
+const DspSimdFuncs *
+dsp_simd_get_funcs (
+  DspSimdLevel level);
+
+const char *
+dsp_simd_level_to_string (
+  DspSimdLevel level);
+
+/**
+ * @}
+ */
+
+#endif
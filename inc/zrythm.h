@@ -124,6 +124,9 @@ typedef enum ZrythmDirType
   /** Gdb backtrace files. */
   ZRYTHM_DIR_USER_GDB,
 
+  /** Cached data that can be regenerated. */
+  ZRYTHM_DIR_USER_CACHE,
+
 } ZrythmDirType;
 
 /**
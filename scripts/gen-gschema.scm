@@ -418,6 +418,10 @@ Args:
                  "listen-notes" "b" "true"
                  "Listen to notes while they are moved"
                  "Whether to listen to MIDI notes while dragging them in the piano roll.")
+               (make-schema-key
+                 "file-browser-autoplay" "b" "true"
+                 "Autoplay files in the file browser"
+                 "Whether to play back audio files when they are selected in the file browser.")
                (make-schema-key-with-enum
                  "piano-roll-highlight"
                  "piano-roll-highlight" "none"
@@ -693,6 +697,14 @@ Args:
                      "sdl-audio-device-name" "s"
                      "" "SDL device"
                      "The name of the SDL device to use.")
+                   (make-schema-key
+                     "alsa-audio-device-name" "s"
+                     "hw:0" "ALSA device"
+                     "The name of the ALSA device to use for playback and capture.")
+                   (make-schema-key-with-range
+                     "alsa-periods" "u" "2" "16"
+                     "2" "Periods"
+                     "Number of periods in the ALSA device buffer. Higher values add latency but make dropouts less likely.")
                    (make-schema-key-with-enum
                      "sample-rate" "sample-rate"
                      "48000" "Samplerate"
@@ -701,6 +713,11 @@ Args:
                      "buffer-size" "buffer-size"
                      "512" "Buffer size"
                      "Buffer size to pass to the backend.")
+                   (make-schema-key-with-range
+                     "automation-granularity"
+                     "u" "8" "4096" "64"
+                     "Automation granularity"
+                     "Interval in samples at which automation is evaluated within a processing cycle. Smaller values follow fast automation more closely but use more CPU.")
                    (make-schema-key-with-enum
                      "midi-backend" "midi-backend"
                      "none" "MIDI backend"
@@ -724,6 +741,10 @@ Args:
                      "zrythm-dir" "s"
                      "" "Zrythm path"
                      "The directory used to save user data in.")
+                   (make-schema-key
+                     "sample-library-paths" "as" "[]"
+                     "Sample libraries"
+                     "Directories to index in the background for the file browser. Indexed directories can be browsed and searched instantly.")
                  )) ;; general/paths
              ))) ;; general
 
@@ -841,6 +862,11 @@ Args:
                      "0" "120" "1"
                      "Autosave interval"
                      "Interval to auto-save projects, in minutes. Auto-saving will be disabled if this is set to 0.")
+                   (make-schema-key-with-range
+                     "pool-memory-budget" "u"
+                     "0" "65536" "512"
+                     "Audio pool memory budget"
+                     "Maximum memory to use for audio clips that are not used in the project (eg, clips only used in the undo history), in MiB. The least recently used clips are unloaded first and reloaded from disk when needed.")
                  )) ;; projects/general
              ))) ;; projects
 
@@ -25,6 +25,7 @@
 #include "audio/supported_file.h"
 #include "audio/track.h"
 #include "audio/tracklist.h"
+#include "audio/transport.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "gui/widgets/main_window.h"
@@ -119,9 +120,14 @@ tracklist_selections_action_new (
   /* calculate number of tracks */
   if (file_descr && track_type == TRACK_TYPE_MIDI)
     {
+      /* parse the file once for all the tracks */
+      self->midi_file =
+        midi_file_new (
+          self->file_descr->abs_path,
+          transport_get_ppqn (TRANSPORT));
       self->num_tracks =
-        midi_file_get_num_tracks (
-          self->file_descr->abs_path);
+        self->midi_file ?
+          self->midi_file->num_tracks : 0;
     }
   else
     {
@@ -421,11 +427,14 @@ create_track (
           Position start_pos;
           position_set_to_pos (
             &start_pos, PLAYHEAD);
+          g_return_val_if_fail (
+            self->midi_file &&
+            idx < self->midi_file->num_tracks, -1);
           ZRegion * mr =
-            midi_region_new_from_midi_file (
+            midi_region_new_from_midi_file_track (
               &start_pos,
-              self->file_descr->abs_path,
-              pos, 0, 0, idx);
+              &self->midi_file->tracks[idx],
+              pos, 0, 0);
           if (mr)
             {
               track_add_region (
@@ -505,6 +514,18 @@ do_or_undo_create_or_delete (
     {
       if (create)
         {
+          /* the parsed MIDI file is not saved with
+           * the action */
+          if (self->file_descr &&
+              self->track_type == TRACK_TYPE_MIDI &&
+              !self->midi_file)
+            {
+              self->midi_file =
+                midi_file_new (
+                  self->file_descr->abs_path,
+                  transport_get_ppqn (TRANSPORT));
+            }
+
           for (int i = 0; i < self->num_tracks; i++)
             {
               int ret = create_track (self, i);
@@ -1287,6 +1308,8 @@ tracklist_selections_action_free (
     tracklist_selections_free, self->tls_before);
   object_free_w_func_and_null (
     tracklist_selections_free, self->tls_after);
+  object_free_w_func_and_null (
+    midi_file_free, self->midi_file);
 
   object_zero_and_free (self);
 }
@@ -113,11 +113,6 @@ do_or_undo (
     tempo_track_get_current_bpm (P_TEMPO_TRACK),
     AUDIO_ENGINE->sample_rate);
 
-  snap_grid_update_snap_points_default (
-    SNAP_GRID_TIMELINE);
-  snap_grid_update_snap_points_default (
-    SNAP_GRID_MIDI);
-
   if (self->type == TRANSPORT_ACTION_BPM_CHANGE)
     {
       /* get time ratio */
@@ -159,11 +154,6 @@ transport_action_do (
         TRANSPORT->time_sig.beats_per_bar,
         tempo_track_get_current_bpm (P_TEMPO_TRACK),
         AUDIO_ENGINE->sample_rate);
-
-      snap_grid_update_snap_points_default (
-        SNAP_GRID_TIMELINE);
-      snap_grid_update_snap_points_default (
-        SNAP_GRID_MIDI);
     }
   else
     {
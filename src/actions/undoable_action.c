@@ -18,6 +18,8 @@
  */
 
 #include "audio/engine.h"
+#include "audio/pool.h"
+#include "audio/tracklist.h"
 #include "actions/arranger_selections.h"
 #include "actions/mixer_selections_action.h"
 #include "actions/range_action.h"
@@ -107,6 +109,10 @@ pause_engine (
     {
       g_usleep (100);
     }
+
+  /* apply the changes queued before pausing, since
+   * the action might free their ports */
+  engine_flush_control_changes (AUDIO_ENGINE);
 }
 
 static void
@@ -138,6 +144,12 @@ undoable_action_do (UndoableAction * self)
   g_debug ("lock acquired");
 #endif
 
+  /* load clips unloaded from the pool before
+   * pausing, since decoding can take a while (the
+   * engine does not use unloaded clips) */
+  audio_pool_load_clips_for_action (
+    AUDIO_POOL, self);
+
   /* stop engine and give it some time to stop
    * running */
   EngineState state;
@@ -195,6 +207,16 @@ undoable_action_do (UndoableAction * self)
   g_debug ("lock released");
 #endif
 
+  /* load/unload clips before the engine can use
+   * them */
+  audio_pool_reload_clip_frame_bufs (AUDIO_POOL);
+
+  /* the tempo automation and the regions might
+   * have changed */
+  engine_update_tempo_map (AUDIO_ENGINE);
+  tracklist_update_region_indices (
+    TRACKLIST, true);
+
   /* restart engine */
   resume_engine (&state);
 
@@ -211,6 +233,12 @@ undoable_action_undo (UndoableAction * self)
 {
   /*zix_sem_wait (&AUDIO_ENGINE->port_operation_lock);*/
 
+  /* load clips unloaded from the pool before
+   * pausing, since decoding can take a while (the
+   * engine does not use unloaded clips) */
+  audio_pool_load_clips_for_action (
+    AUDIO_POOL, self);
+
   /* stop engine and give it some time to stop
    * running */
   EngineState state;
@@ -266,6 +294,16 @@ undoable_action_undo (UndoableAction * self)
 
   /*zix_sem_post (&AUDIO_ENGINE->port_operation_lock);*/
 
+  /* load/unload clips before the engine can use
+   * them */
+  audio_pool_reload_clip_frame_bufs (AUDIO_POOL);
+
+  /* the tempo automation and the regions might
+   * have changed */
+  engine_update_tempo_map (AUDIO_ENGINE);
+  tracklist_update_region_indices (
+    TRACKLIST, true);
+
   /* restart engine */
   resume_engine (&state);
 
@@ -21,6 +21,7 @@
 #include "audio/audio_region.h"
 #include "audio/clip.h"
 #include "audio/pool.h"
+#include "audio/stretch_cache.h"
 #include "audio/track.h"
 #include "gui/widgets/main_window.h"
 #include "gui/widgets/region.h"
@@ -29,6 +30,7 @@
 #include "utils/dsp.h"
 #include "utils/flags.h"
 #include "utils/io.h"
+#include "utils/objects.h"
 #include "zrythm_app.h"
 
 /**
@@ -281,4 +283,6 @@ audio_region_replace_frames (
 void
 audio_region_free_members (ZRegion * self)
 {
+  object_free_w_func_and_null (
+    stretch_cache_unref, self->stretch_cache);
 }
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "audio/audio_region.h"
+#include "audio/audio_region_index.h"
+#include "audio/position.h"
+#include "audio/region.h"
+#include "audio/stretch_cache.h"
+#include "audio/track.h"
+#include "audio/track_lane.h"
+#include "gui/backend/arranger_object.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+
+static int
+cmp_entries (
+  const void * _a,
+  const void * _b)
+{
+  const AudioRegionIndexEntry * a =
+    (const AudioRegionIndexEntry *) _a;
+  const AudioRegionIndexEntry * b =
+    (const AudioRegionIndexEntry *) _b;
+  if (a->start_frames != b->start_frames)
+    return a->start_frames < b->start_frames ? -1 : 1;
+
+  return a->lane_pos - b->lane_pos;
+}
+
+static void
+fill_entry (
+  AudioRegionIndexEntry * entry,
+  ZRegion *               r)
+{
+  ArrangerObject * r_obj = (ArrangerObject *) r;
+
+  entry->start_frames = r_obj->pos.frames;
+  entry->end_frames = r_obj->end_pos.frames;
+  entry->loop_start_frames =
+    position_to_frames (&r_obj->loop_start_pos);
+  entry->loop_end_frames =
+    position_to_frames (&r_obj->loop_end_pos);
+  entry->loop_frames =
+    arranger_object_get_loop_length_in_frames (
+      r_obj);
+  entry->clip_start_frames =
+    position_to_frames (&r_obj->clip_start_pos);
+  entry->fade_in_frames = r_obj->fade_in_pos.frames;
+  entry->fade_out_frames =
+    r_obj->fade_out_pos.frames;
+  entry->fade_out_len =
+    r_obj->end_pos.frames -
+    (r_obj->fade_out_pos.frames + r_obj->pos.frames);
+  entry->fade_in_opts = r_obj->fade_in_opts;
+  entry->fade_out_opts = r_obj->fade_out_opts;
+  entry->clip = audio_region_get_clip (r);
+  entry->stretch_cache = NULL;
+  entry->lane_pos = r->id.lane_pos;
+  entry->musical_mode = region_get_musical_mode (r);
+  entry->bounce = r->bounce;
+}
+
+/**
+ * Creates an index of the audio regions in the
+ * lanes of the given track.
+ *
+ * @note Not real-time safe.
+ */
+AudioRegionIndex *
+audio_region_index_new_from_track (
+  Track * track)
+{
+  g_return_val_if_fail (IS_TRACK (track), NULL);
+
+  AudioRegionIndex * self =
+    object_new (AudioRegionIndex);
+
+  int max_entries = 0;
+  for (int i = 0; i < track->num_lanes; i++)
+    {
+      max_entries += track->lanes[i]->num_regions;
+    }
+  if (max_entries == 0)
+    return self;
+
+  self->entries =
+    calloc (
+      (size_t) max_entries,
+      sizeof (AudioRegionIndexEntry));
+  for (int i = 0; i < track->num_lanes; i++)
+    {
+      TrackLane * lane = track->lanes[i];
+      for (int j = 0; j < lane->num_regions; j++)
+        {
+          ZRegion * r = lane->regions[j];
+          ArrangerObject * r_obj =
+            (ArrangerObject *) r;
+          if (r->id.type != REGION_TYPE_AUDIO ||
+              r_obj->muted)
+            continue;
+
+          AudioRegionIndexEntry * entry =
+            &self->entries[self->num_entries];
+          fill_entry (entry, r);
+
+          /* skip regions that can't be played */
+          if (!entry->clip || entry->loop_frames <= 0)
+            continue;
+
+          if (entry->musical_mode)
+            {
+              if (!r->stretch_cache)
+                {
+                  r->stretch_cache =
+                    stretch_cache_new ();
+                }
+              entry->stretch_cache =
+                r->stretch_cache;
+              stretch_cache_ref (
+                entry->stretch_cache);
+            }
+
+          self->num_entries++;
+        }
+    }
+
+  qsort (
+    self->entries, (size_t) self->num_entries,
+    sizeof (AudioRegionIndexEntry), cmp_entries);
+
+  self->max_end_frames =
+    calloc (
+      (size_t) MAX (self->num_entries, 1),
+      sizeof (long));
+  for (int i = 0; i < self->num_entries; i++)
+    {
+      self->max_end_frames[i] =
+        i == 0 ?
+          self->entries[i].end_frames :
+          MAX (
+            self->max_end_frames[i - 1],
+            self->entries[i].end_frames);
+    }
+
+  return self;
+}
+
+/**
+ * Returns the index of the first entry that can
+ * overlap a range starting at the given frames,
+ * or AudioRegionIndex.num_entries if none can.
+ *
+ * Entries after the returned one must still be
+ * checked against the range, until one that
+ * starts after the range is found.
+ */
+int
+audio_region_index_find_first (
+  const AudioRegionIndex * self,
+  long                     start_frames)
+{
+  /* the region end is inclusive */
+  int lo = 0;
+  int hi = self->num_entries;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (self->max_end_frames[mid] < start_frames)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+void
+audio_region_index_free (
+  AudioRegionIndex * self)
+{
+  for (int i = 0; i < self->num_entries; i++)
+    {
+      if (self->entries[i].stretch_cache)
+        {
+          stretch_cache_unref (
+            self->entries[i].stretch_cache);
+        }
+    }
+  free (self->entries);
+  free (self->max_end_frames);
+
+  object_zero_and_free (self);
+}
@@ -20,6 +20,7 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include "audio/audio_region_index.h"
 #include "audio/audio_track.h"
 #include "audio/automation_tracklist.h"
 #include "audio/clip.h"
@@ -27,6 +28,7 @@
 #include "audio/fade.h"
 #include "audio/pool.h"
 #include "audio/port.h"
+#include "audio/stretch_cache.h"
 #include "audio/stretcher.h"
 #include "audio/tempo_track.h"
 #include "project.h"
@@ -60,7 +62,6 @@ audio_track_setup (Track * self)
 static void
 timestretch_buf (
   Track *      self,
-  ZRegion *    r,
   AudioClip *  clip,
   size_t      in_frame_offset,
   double       timestretch_ratio,
@@ -69,8 +70,7 @@ timestretch_buf (
   unsigned int out_frame_offset,
   ssize_t      frames_to_process)
 {
-  g_return_if_fail (
-    r && self->rt_stretcher);
+  g_return_if_fail (self->rt_stretcher);
   stretcher_set_time_ratio (
     self->rt_stretcher, 1.0 / timestretch_ratio);
   size_t in_frames_to_process =
@@ -101,338 +101,459 @@ timestretch_buf (
 }
 
 /**
- * Fills the buffers in the given StereoPorts with
- * the frames from the current clip.
+ * Adds the frames of the region in the given
+ * index entry to the buffers.
+ *
+ * @param cached Stretched frames to read instead
+ *   of the clip, or NULL.
+ * @param gain Gain at the first frame, used when
+ *   crossfading.
+ * @param gain_step Gain change per frame.
  */
-void
-audio_track_fill_stereo_ports_from_clip (
-  Track *         self,
-  StereoPorts *   stereo_ports,
-  const long      g_start_frames,
-  nframes_t       nframes)
+static void
+fill_bufs_from_entry (
+  Track *                       self,
+  const AudioRegionIndexEntry * entry,
+  float *                       l,
+  float *                       r,
+  const long                    g_start_frames,
+  const nframes_t               local_offset,
+  const nframes_t               nframes,
+  const bool                    needs_rt_timestretch,
+  const double                  timestretch_ratio,
+  const StretchCacheFrames *    cached,
+  const float                   gain,
+  const float                   gain_step)
 {
-  g_return_if_fail (IS_TRACK (self) && stereo_ports);
-
-  long region_end_frames,
-       frames_start_from_cycle_start,
-       /*local_frames_end,*/
-       loop_start_frames,
-       loop_end_frames,
-       loop_frames,
-       clip_start_frames;
-  int i, k;
-  ssize_t buff_index;
-  unsigned int j;
-  long cycle_start_frames =
-    g_start_frames;
+  AudioClip * clip = entry->clip;
+  long cycle_start_frames = g_start_frames;
   long cycle_end_frames =
     cycle_start_frames + (long) nframes;
 
-  if (!TRANSPORT_IS_ROLLING)
+  /* the region end is inclusive */
+  if (entry->start_frames > cycle_end_frames - 1 ||
+      entry->end_frames < cycle_start_frames)
     return;
-
-  ZRegion * r;
-  ArrangerObject * r_obj;
-  TrackLane * lane;
-  for (k = 0; k < self->num_lanes; k++)
+  long frames_start_from_cycle_start =
+    cycle_start_frames - entry->start_frames;
+  long frames_start_from_cycle_start_adj =
+    frames_start_from_cycle_start +
+    entry->clip_start_frames;
+  while (frames_start_from_cycle_start_adj >=
+         entry->loop_end_frames)
     {
-      lane = self->lanes[k];
+      frames_start_from_cycle_start_adj -=
+        entry->loop_frames;
+    }
 
-      for (i = 0; i < lane->num_regions; i++)
-        {
-          r = lane->regions[i];
-          r_obj = (ArrangerObject *) r;
+  /* frames to skip if the region starts
+   * somewhere within this cycle */
+  unsigned int frames_to_skip = 0;
+  if (frames_start_from_cycle_start_adj < 0)
+    {
+      frames_to_skip =
+        (unsigned int)
+        (- frames_start_from_cycle_start_adj);
+    }
 
-          g_return_if_fail (IS_REGION (r));
+  /* frames to process if the region
+   * ends within this cycle */
+  long frames_to_process = (long) nframes;
+  if (cycle_end_frames >= entry->end_frames)
+    {
+      /* -1 because the region's last
+       * frame is not counted */
+      frames_to_process =
+        (entry->end_frames - 1) -
+          cycle_start_frames;
+    }
+  frames_to_process -= (long) frames_to_skip;
+  if (frames_to_process < 1)
+    return;
 
-          if (r_obj->muted)
-            continue;
+  long current_local_frames =
+    frames_start_from_cycle_start_adj;
+
+  /* buffers after timestretch */
+  float lbuf_after_ts[frames_to_process];
+  float rbuf_after_ts[frames_to_process];
+  dsp_fill (
+    lbuf_after_ts, 0,
+    (size_t) frames_to_process);
+  dsp_fill (
+    rbuf_after_ts, 0,
+    (size_t) frames_to_process);
+  unsigned int prev_j_offset =
+    frames_to_skip;
+
+  ssize_t buff_index = 0;
+  size_t buff_index_start =
+    (size_t) clip->num_frames + 16;
+  size_t buff_size = 0;
+  for (unsigned int j = 0;
+       (long) j < frames_to_process;
+       j++)
+    {
+      current_local_frames =
+        frames_start_from_cycle_start_adj +
+        (long) j + frames_to_skip;
+
+      /* if loop point hit in the
+       * cycle, go back to loop start */
+      while (
+        current_local_frames >=
+        entry->loop_end_frames)
+        {
+          current_local_frames =
+            (current_local_frames -
+              entry->loop_end_frames) +
+            entry->loop_start_frames;
+        }
 
-          /* skip if in bounce mode and the
-           * region should not be bounced */
-          if (AUDIO_ENGINE->bounce_mode !=
-                BOUNCE_OFF &&
-              (!r->bounce || !self->bounce))
-            continue;
+      buff_index =
+        (ssize_t) current_local_frames;
 
-          /* skip if region is currently being
-           * stretched FIXME what if stretching
-           * starts inside this - need a semaphore */
-          if (r->stretching)
-            continue;
+#define STRETCH \
+  timestretch_buf ( \
+    self, clip, buff_index_start, \
+    timestretch_ratio, \
+    lbuf_after_ts, rbuf_after_ts, \
+    prev_j_offset, \
+    ((j + frames_to_skip) - prev_j_offset) + 1)
 
-          /* if region hit */
-          if (region_is_hit_by_range (
-                r,
-                cycle_start_frames,
-                cycle_end_frames - 1, true))
+      /* if we are starting at a new
+       * point in the audio clip */
+      if (needs_rt_timestretch)
+        {
+          buff_index =
+            (ssize_t)
+            (buff_index *
+             timestretch_ratio);
+          if (buff_index <
+                (ssize_t)
+                buff_index_start)
             {
-              region_end_frames =
-                r_obj->end_pos.frames;
-              frames_start_from_cycle_start =
-                cycle_start_frames -
-                  r_obj->pos.frames;
-              /*local_frames_end =*/
-                /*frames_start_from_cycle_start + nframes;*/
-
-              loop_start_frames =
-                position_to_frames (
-                  &r_obj->loop_start_pos);
-              loop_end_frames =
-                position_to_frames (
-                  &r_obj->loop_end_pos);
-              loop_frames =
-                arranger_object_get_loop_length_in_frames (
-                  r_obj);
-              clip_start_frames =
-                position_to_frames (
-                  &r_obj->clip_start_pos);
-              long frames_start_from_cycle_start_adj =
-                frames_start_from_cycle_start +
-                clip_start_frames;
-              while (frames_start_from_cycle_start_adj >=
-                     loop_end_frames)
+              g_message (
+                "buff index (%zd) < buff index start (%zd)",
+                buff_index,
+                buff_index_start);
+              /* set the start point (
+               * used when
+               * timestretching) */
+              buff_index_start =
+                (size_t) buff_index;
+
+              /* timestretch the material
+               * up to this point */
+              if (buff_size > 0)
                 {
-                  frames_start_from_cycle_start_adj -=
-                    loop_frames;
+                  g_message (
+                    "buff size (%zd) > 0",
+                    buff_size);
+                  g_message ("j %u", j + frames_to_skip);
+                  STRETCH;
+                  prev_j_offset = j + frames_to_skip;
                 }
+              buff_size = 0;
+            }
+          else if ((long) j ==
+                     frames_to_process - 1)
+            {
+              g_message ("last sample");
+              g_message ("j %u", j + frames_to_skip);
+              STRETCH;
+              prev_j_offset = j + frames_to_skip;
+            }
+          else
+            {
+              buff_size++;
+            }
+        }
 
-              buff_index = 0;
-              AudioClip * clip =
-                audio_pool_get_clip (
-                  AUDIO_POOL, r->pool_id);
+      /* make sure we are within the bounds of
+       * the frame array, since the index may be
+       * older than the clip (eg, while recording
+       * into it) */
+      if (needs_rt_timestretch || buff_index < 0)
+        continue;
 
-              /* frames to skip if the region starts
-               * somewhere within this cycle */
-              unsigned int frames_to_skip = 0;
-              if (frames_start_from_cycle_start_adj < 0)
-                {
-                  frames_to_skip =
-                    (unsigned int)
-                    (- frames_start_from_cycle_start_adj);
-                }
+      if (cached)
+        {
+          if (buff_index < cached->num_frames)
+            {
+              lbuf_after_ts[j] =
+                cached->ch_frames[0][buff_index];
+              rbuf_after_ts[j] =
+                cached->ch_frames[1][buff_index];
+            }
+        }
+      else if (buff_index < clip->num_frames)
+        {
+          lbuf_after_ts[j] =
+            clip->ch_frames[0][buff_index];
+          rbuf_after_ts[j] =
+            clip->channels == 1 ?
+            clip->ch_frames[0][buff_index] :
+            clip->ch_frames[1][buff_index];
+        }
+    }
 
-              /* frames to process if the region
-               * ends within this cycle */
-              long frames_to_process =
-                (long) nframes;
-              if (cycle_end_frames >=
-                    region_end_frames)
-                {
-                  /* -1 because the region's last
-                   * frame is not counted */
-                  frames_to_process =
-                    (region_end_frames - 1) -
-                      cycle_start_frames;
-                }
-              frames_to_process -=
-                (long) frames_to_skip;
-              long current_local_frames =
-                frames_start_from_cycle_start_adj;
+#undef STRETCH
+
+  /* apply fades */
+  for (unsigned int j = 0;
+       (long) j < frames_to_process;
+       j++)
+    {
+      long local_frames =
+        frames_start_from_cycle_start + j +
+        frames_to_skip;
+      float fade_in = 1.f;
+      float fade_out = 1.f;
+      if (local_frames >= 0 &&
+          local_frames < entry->fade_in_frames)
+        {
+          fade_in =
+            (float)
+            fade_get_y_normalized (
+              (double) local_frames /
+              (double) entry->fade_in_frames,
+              (CurveOptions *) &entry->fade_in_opts,
+              1);
+        }
+      else if (local_frames >=
+                 entry->fade_out_frames)
+        {
+          fade_out =
+            (float)
+            fade_get_y_normalized (
+              (double)
+              (local_frames -
+                 entry->fade_out_frames) /
+              (double) entry->fade_out_len,
+              (CurveOptions *) &entry->fade_out_opts,
+              0);
+        }
+
+      float xfade =
+        CLAMP (
+          gain +
+            gain_step * (float) (j + frames_to_skip),
+          0.f, 1.f);
+
+      l[local_offset + j + frames_to_skip] +=
+        lbuf_after_ts[j] * fade_in * fade_out * xfade;
+      r[local_offset + j + frames_to_skip] +=
+        rbuf_after_ts[j] * fade_in * fade_out * xfade;
+    }
+}
+
+/**
+ * Adds the frames of the regions that are hit in
+ * the given range to the given buffers.
+ *
+ * Only the regions in the track's region index
+ * overlapping the range are visited.
+ *
+ * Regions in musical mode are read from their
+ * stretched frames when they are ready for the
+ * current BPM, otherwise they are stretched in
+ * realtime. The regions that are not stretched in
+ * realtime are delayed by
+ * TrackProcessor.playback_latency.
+ *
+ * @param local_offset The local start frames.
+ * @param group Region group to fill (see
+ *   TrackProcessor.region_group_bufs), or -1 to
+ *   fill all regions.
+ * @param num_groups Number of region groups.
+ */
+void
+audio_track_fill_bufs_from_clips (
+  Track *         self,
+  float *         l,
+  float *         r,
+  const long      g_start_frames,
+  const nframes_t local_offset,
+  const nframes_t nframes,
+  const int       group,
+  const int       num_groups)
+{
+  g_return_if_fail (IS_TRACK (self) && l && r);
+
+  if (!TRANSPORT_IS_ROLLING)
+    return;
 
-              /* restretch if necessary */
+  const AudioRegionIndex * index =
+    track_get_region_index (self);
+  if (!index)
+    return;
+
+  /* the regions that are not stretched in
+   * realtime are delayed by the stretcher latency
+   * compensated by the graph */
+  long latency =
+    (long) self->processor->playback_latency;
+  long delayed_g_start_frames =
+    g_start_frames - latency;
+  long cycle_end_frames =
+    g_start_frames + (long) nframes;
+
+  /* fetched once when a region needs it */
+  bpm_t cur_bpm = 0.f;
+  bool have_bpm = false;
+
+  for (int i =
+         audio_region_index_find_first (
+           index, delayed_g_start_frames);
+       i < index->num_entries; i++)
+    {
+      const AudioRegionIndexEntry * entry =
+        &index->entries[i];
+
+      /* the rest of the regions start after
+       * the cycle */
+      if (entry->start_frames >
+            cycle_end_frames - 1)
+        break;
+
+      /* the region end is inclusive */
+      if (entry->end_frames < delayed_g_start_frames)
+        continue;
+
+      /* skip if in bounce mode and the
+       * region should not be bounced */
+      if (AUDIO_ENGINE->bounce_mode !=
+            BOUNCE_OFF &&
+          (!entry->bounce || !self->bounce))
+        continue;
+
+      /* restretch if necessary */
+      AudioClip * clip = entry->clip;
+      double timestretch_ratio = 1.0;
+      bool needs_timestretch = false;
+      if (entry->musical_mode)
+        {
+          if (!have_bpm)
+            {
               Position g_start_pos;
               position_from_frames (
                 &g_start_pos, g_start_frames);
-              bpm_t cur_bpm =
+              cur_bpm =
                 tempo_track_get_bpm_at_pos (
                   P_TEMPO_TRACK, &g_start_pos);
-              double timestretch_ratio = 1.0;
-              bool needs_rt_timestretch = false;
-              if (region_get_musical_mode (r) &&
-                  !math_floats_equal (
-                    clip->bpm, cur_bpm))
-                {
-                  needs_rt_timestretch = true;
-                  timestretch_ratio =
-                    (double) cur_bpm /
-                    (double) clip->bpm;
-                  g_message (
-                    "timestretching: "
-                    "(cur bpm %f clip bpm %f) %f",
-                    (double) cur_bpm,
-                    (double) clip->bpm,
-                    timestretch_ratio);
-                }
-
-              if (frames_to_process < 1)
-                {
-                  /*g_message (*/
-                    /*"%s: %s:%s "*/
-                    /*"no frames to process,"*/
-                    /*"skipping...",*/
-                    /*__func__, self->name, r->name);*/
-                  continue;
-                }
-
-              /* buffers after timestretch */
-              float lbuf_after_ts[frames_to_process];
-              float rbuf_after_ts[frames_to_process];
-              dsp_fill (
-                lbuf_after_ts, 0,
-                (size_t) frames_to_process);
-              dsp_fill (
-                rbuf_after_ts, 0,
-                (size_t) frames_to_process);
-              unsigned int prev_j_offset =
-                frames_to_skip;
-
-              size_t buff_index_start =
-                (size_t) clip->num_frames + 16;
-              size_t buff_size = 0;
-              for (j = 0;
-                   (long) j < frames_to_process;
-                   j++)
-                {
-                  current_local_frames =
-                    frames_start_from_cycle_start_adj +
-                    (long) j + frames_to_skip;
-
-                  /* if loop point hit in the
-                   * cycle, go back to loop start */
-                  while (
-                    current_local_frames >=
-                    loop_end_frames)
-                    {
-                      current_local_frames =
-                        (current_local_frames -
-                          loop_end_frames) +
-                        loop_start_frames;
-                    }
-
-                  buff_index =
-                    (ssize_t) current_local_frames;
+              have_bpm = true;
+            }
+          if (!math_floats_equal (
+                clip->bpm, cur_bpm))
+            {
+              needs_timestretch = true;
+              timestretch_ratio =
+                (double) cur_bpm /
+                (double) clip->bpm;
+            }
+        }
 
-#define STRETCH \
-  timestretch_buf ( \
-    self, r, clip, buff_index_start, \
-    timestretch_ratio, \
-    lbuf_after_ts, rbuf_after_ts, \
-    prev_j_offset, \
-    ((j + frames_to_skip) - prev_j_offset) + 1)
+      /* regions that need timestretching may use
+       * the track's stretcher, so they are all
+       * processed by the first group */
+      if (group >= 0)
+        {
+          int entry_group =
+            needs_timestretch ?
+              0 : entry->lane_pos % num_groups;
+          if (entry_group != group)
+            continue;
+        }
 
-                  /* if we are starting at a new
-                   * point in the audio clip */
-                  if (needs_rt_timestretch)
-                    {
-                      buff_index =
-                        (ssize_t)
-                        (buff_index *
-                         timestretch_ratio);
-                      if (buff_index <
-                            (ssize_t)
-                            buff_index_start)
-                        {
-                          g_message (
-                            "buff index (%zd) < buff index start (%zd)",
-                            buff_index,
-                            buff_index_start);
-                          /* set the start point (
-                           * used when
-                           * timestretching) */
-                          buff_index_start =
-                            (size_t) buff_index;
-
-                          /* timestretch the material
-                           * up to this point */
-                          if (buff_size > 0)
-                            {
-                              g_message (
-                                "buff size (%zd) > 0",
-                                buff_size);
-                              g_message ("j %u", j + frames_to_skip);
-                              STRETCH;
-                              prev_j_offset = j + frames_to_skip;
-                            }
-                          buff_size = 0;
-                        }
-                      else if ((long) j ==
-                                 frames_to_process - 1)
-                        {
-                          g_message ("last sample");
-                          g_message ("j %u", j + frames_to_skip);
-                          STRETCH;
-                          prev_j_offset = j + frames_to_skip;
-                        }
-                      else
-                        {
-                          buff_size++;
-                          /*g_message ("buff index end %zu", buff_index_end);*/
-                        }
-                    }
-
-                  /* make sure we are within the
-                   * bounds of the frame array */
-                  /*g_warn_if_fail (*/
-                    /*buff_index >= 0 &&*/
-                    /*buff_index +*/
-                      /*(ssize_t)*/
-                      /*(clip->channels - 1) <*/
-                        /*(ssize_t)*/
-                        /*(clip->channels **/
-                           /*r->num_frames));*/
-
-                  if (!needs_rt_timestretch)
-                    {
-                      lbuf_after_ts[j] =
-                        clip->ch_frames[0][buff_index];
-                      rbuf_after_ts[j] =
-                        clip->channels == 1 ?
-                        clip->ch_frames[0][buff_index] :
-                        clip->ch_frames[1][buff_index];
-                    }
-                }
+      if (!needs_timestretch)
+        {
+          fill_bufs_from_entry (
+            self, entry, l, r,
+            delayed_g_start_frames, local_offset,
+            nframes, false, 1.0, NULL, 1.f, 0.f);
+          continue;
+        }
 
-              /* apply fades */
-              for (j = 0;
-                   (long) j < frames_to_process;
-                   j++)
-                {
-                  long local_frames =
-                    frames_start_from_cycle_start + j + frames_to_skip;
-                  float fade_in = 1.f;
-                  float fade_out = 1.f;
-                  if (local_frames >= 0 &&
-                      local_frames <
-                        r_obj->fade_in_pos.frames)
-                    {
-                      fade_in =
-                        (float)
-                        fade_get_y_normalized (
-                          (double) local_frames /
-                          (double)
-                          r_obj->fade_in_pos.frames,
-                          &r_obj->fade_in_opts, 1);
-                    }
-                  else if (local_frames >=
-                             r_obj->fade_out_pos.
-                               frames)
-                    {
-                      fade_out =
-                        (float)
-                        fade_get_y_normalized (
-                          (double)
-                          (local_frames -
-                              r_obj->fade_out_pos.
-                                frames) /
-                          (double)
-                          (r_obj->end_pos.frames -
-                            (r_obj->fade_out_pos.
-                               frames +
-                             r_obj->pos.frames)),
-                          &r_obj->fade_out_opts, 0);
-                    }
-
-                  stereo_ports->l->buf[
-                    j + frames_to_skip] =
-                      lbuf_after_ts[j] *
-                      fade_in * fade_out;
-                  stereo_ports->r->buf[
-                    j + frames_to_skip] =
-                      rbuf_after_ts[j] *
-                      fade_in * fade_out;
-                }
+      /* use the frames stretched in the background
+       * if they are ready for this BPM */
+      StretchCache * cache = entry->stretch_cache;
+      const StretchCacheFrames * cached =
+        cache ?
+          stretch_cache_get_frames_for (
+            cache, clip, cur_bpm) :
+          NULL;
+      if (!cached)
+        {
+          fill_bufs_from_entry (
+            self, entry, l, r, g_start_frames,
+            local_offset, nframes, true,
+            timestretch_ratio, NULL, 1.f, 0.f);
+          if (cache)
+            {
+              cache->used_rt = true;
+              cache->xfade_frames_left = 0;
+              cache->next_frames = cycle_end_frames;
             }
+          continue;
+        }
+
+      /* crossfade from realtime stretching if
+       * playback continues from it */
+      if (cache->used_rt)
+        {
+          cache->used_rt = false;
+          cache->xfade_frames_left =
+            cache->next_frames == g_start_frames ?
+              STRETCH_CACHE_XFADE_FRAMES : 0;
+        }
+      if (cache->xfade_frames_left == 0)
+        {
+          fill_bufs_from_entry (
+            self, entry, l, r,
+            delayed_g_start_frames, local_offset,
+            nframes, false, 1.0, cached, 1.f, 0.f);
+          continue;
         }
+
+      float gain_step =
+        1.f / (float) STRETCH_CACHE_XFADE_FRAMES;
+      float gain =
+        1.f -
+        (float) cache->xfade_frames_left * gain_step;
+      fill_bufs_from_entry (
+        self, entry, l, r, delayed_g_start_frames,
+        local_offset, nframes, false, 1.0, cached,
+        gain, gain_step);
+      fill_bufs_from_entry (
+        self, entry, l, r, g_start_frames,
+        local_offset, nframes, true,
+        timestretch_ratio, NULL, 1.f - gain,
+        - gain_step);
+      cache->xfade_frames_left -=
+        MIN (cache->xfade_frames_left, nframes);
+      cache->next_frames = cycle_end_frames;
     }
 }
+
+/**
+ * Fills the buffers in the given StereoPorts with
+ * the frames from the current clip.
+ *
+ * @param local_offset The local start frames.
+ */
+void
+audio_track_fill_stereo_ports_from_clip (
+  Track *         self,
+  StereoPorts *   stereo_ports,
+  const long      g_start_frames,
+  const nframes_t local_offset,
+  const nframes_t nframes)
+{
+  g_return_if_fail (IS_TRACK (self) && stereo_ports);
+
+  audio_track_fill_bufs_from_clips (
+    self, stereo_ports->l->buf,
+    stereo_ports->r->buf, g_start_frames,
+    local_offset, nframes, -1, 0);
+}
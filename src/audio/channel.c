@@ -930,11 +930,13 @@ channel_add_balance_control (
 
 /**
  * Sets fader to 0.0.
+ *
+ * To be used by the GTK thread.
  */
 void
 channel_reset_fader (Channel * self)
 {
-  fader_set_amp (self->fader, 1.0f);
+  fader_queue_amp (self->fader, 1.0f);
 }
 
 /**
@@ -1347,6 +1349,23 @@ channel_set_balance_control (
     channel->fader->balance, pan, 0, 0);
 }
 
+/**
+ * Sets the pan at the start of the next
+ * processing cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+channel_queue_balance_control (
+  void * _channel,
+  float  pan)
+{
+  Channel * channel = (Channel *) _channel;
+  port_queue_control_value (
+    channel->fader->balance, pan,
+    F_NOT_NORMALIZED, F_NO_PUBLISH_EVENTS);
+}
+
 float
 channel_get_balance_control (
   void * _channel)
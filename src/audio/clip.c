@@ -17,12 +17,15 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdlib.h>
 
 #include "audio/clip.h"
 #include "audio/encoder.h"
 #include "audio/engine.h"
 #include "audio/tempo_track.h"
+#include "audio/track.h"
+#include "audio/tracklist.h"
 #include "project.h"
 #include "utils/audio.h"
 #include "utils/dsp.h"
@@ -154,6 +157,71 @@ audio_clip_new_from_file (
   return self;
 }
 
+/**
+ * Creates a silent audio clip with the length the
+ * given file will have when decoded at the project
+ * sample rate.
+ *
+ * The name used is the basename of the file.
+ *
+ * @param[out] enc The encoder to decode the file
+ *   with (see audio_encoder_decode()).
+ *
+ * @return The clip, or NULL if the file could not
+ *   be opened.
+ */
+AudioClip *
+audio_clip_new_placeholder_from_file (
+  const char *    full_path,
+  AudioEncoder ** enc)
+{
+  int samplerate = (int) AUDIO_ENGINE->sample_rate;
+  g_return_val_if_fail (samplerate > 0, NULL);
+
+  AudioEncoder * _enc =
+    audio_encoder_new_from_file (full_path);
+  if (!_enc)
+    return NULL;
+
+  AudecInfo * nfo = &_enc->nfo;
+  if (nfo->channels == 0 || nfo->frames <= 0 ||
+      nfo->sample_rate == 0)
+    {
+      g_warning (
+        "Invalid audio file %s", full_path);
+      audec_close (_enc->audec_handle);
+      audio_encoder_free (_enc);
+      return NULL;
+    }
+
+  AudioClip * self =
+    calloc (1, sizeof (AudioClip));
+
+  self->samplerate = samplerate;
+  self->channels = (channels_t) nfo->channels;
+  self->num_frames =
+    (long)
+    ceil (
+      (double) nfo->frames *
+        ((double) samplerate /
+           (double) nfo->sample_rate));
+  self->frames =
+    calloc (
+      (size_t) self->num_frames *
+        (size_t) self->channels,
+      sizeof (sample_t));
+  self->name = g_path_get_basename (full_path);
+  self->pool_id = -1;
+  self->bpm =
+    tempo_track_get_current_bpm (P_TEMPO_TRACK);
+  self->decoding = true;
+  audio_clip_update_channel_caches (self, 0);
+
+  *enc = _enc;
+
+  return self;
+}
+
 /**
  * Creates an audio clip by copying the given float
  * array.
@@ -330,19 +398,6 @@ audio_clip_write_to_file (
   return ret;
 }
 
-/**
- * Returns whether the clip is used inside the
- * project (in actual project regions only, not
- * in undo stack).
- */
-bool
-audio_clip_is_in_use (
-  AudioClip * self)
-{
-  /* TODO */
-  return true;
-}
-
 /**
  * To be called by audio_pool_remove_clip().
  *
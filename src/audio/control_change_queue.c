@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audio/control_change_queue.h"
+#include "audio/port.h"
+#include "utils/objects.h"
+
+ControlChangeQueue *
+control_change_queue_new (void)
+{
+  ControlChangeQueue * self =
+    object_new (ControlChangeQueue);
+
+  self->changes =
+    g_new0 (ControlChange, CONTROL_CHANGE_QUEUE_SIZE);
+  self->free_changes = mpmc_queue_new ();
+  mpmc_queue_reserve (
+    self->free_changes, CONTROL_CHANGE_QUEUE_SIZE);
+  self->pending = mpmc_queue_new ();
+  mpmc_queue_reserve (
+    self->pending, CONTROL_CHANGE_QUEUE_SIZE);
+
+  for (int i = 0; i < CONTROL_CHANGE_QUEUE_SIZE; i++)
+    {
+      mpmc_queue_push_back (
+        self->free_changes, &self->changes[i]);
+    }
+
+  return self;
+}
+
+/**
+ * Pushes a change to the queue.
+ *
+ * Realtime-safe.
+ *
+ * @return Whether the change was pushed (false if
+ *   the queue is full).
+ */
+bool
+control_change_queue_push (
+  ControlChangeQueue * self,
+  Port *               port,
+  float                val,
+  bool                 is_normalized,
+  bool                 forward_event)
+{
+  ControlChange * change = NULL;
+  if (!mpmc_queue_dequeue (
+        self->free_changes, (void **) &change))
+    {
+      return false;
+    }
+
+  change->port = port;
+  change->val = val;
+  change->is_normalized = is_normalized;
+  change->forward_event = forward_event;
+
+  /* there are as many slots as changes, so this
+   * cannot fail */
+  mpmc_queue_push_back (self->pending, change);
+
+  return true;
+}
+
+/**
+ * Pops the oldest change from the queue into
+ * \p change.
+ *
+ * Realtime-safe.
+ *
+ * @return Whether there was a change to pop.
+ */
+bool
+control_change_queue_pop (
+  ControlChangeQueue * self,
+  ControlChange *      change)
+{
+  ControlChange * pending = NULL;
+  if (!mpmc_queue_dequeue (
+        self->pending, (void **) &pending))
+    {
+      return false;
+    }
+
+  *change = *pending;
+  mpmc_queue_push_back (
+    self->free_changes, pending);
+
+  return true;
+}
+
+/**
+ * Sets the values of all the pending changes in
+ * the order they were pushed.
+ *
+ * To be called by the DSP thread at the start of
+ * each cycle.
+ */
+void
+control_change_queue_apply (
+  ControlChangeQueue * self)
+{
+  ControlChange change;
+  while (control_change_queue_pop (self, &change))
+    {
+      port_set_control_value (
+        change.port, change.val,
+        change.is_normalized, change.forward_event);
+    }
+}
+
+/**
+ * Discards all the pending changes.
+ */
+void
+control_change_queue_clear (
+  ControlChangeQueue * self)
+{
+  ControlChange change;
+  while (control_change_queue_pop (self, &change));
+}
+
+void
+control_change_queue_free (
+  ControlChangeQueue * self)
+{
+  object_free_w_func_and_null (
+    mpmc_queue_free, self->free_changes);
+  object_free_w_func_and_null (
+    mpmc_queue_free, self->pending);
+  g_free_and_null (self->changes);
+
+  object_zero_and_free (self);
+}
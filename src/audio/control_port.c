@@ -19,6 +19,7 @@
 
 #include <math.h>
 
+#include "audio/automation_track.h"
 #include "audio/control_port.h"
 #include "audio/engine.h"
 #include "audio/port.h"
@@ -124,6 +125,31 @@ control_port_get_snapped_val_from_val (
   return val;
 }
 
+/**
+ * Returns the snapped real value of the port's
+ * automation at the given timeline frames.
+ *
+ * To be used during processing for ports that
+ * have Port.automation_read set.
+ */
+float
+control_port_get_automation_val_at_frames (
+  Port * self,
+  long   g_frames)
+{
+  g_return_val_if_fail (self->at, self->control);
+
+  Position pos;
+  position_from_frames (&pos, g_frames);
+  float val =
+    automation_track_get_val_at_pos (
+      self->at, &pos, false);
+
+  return
+    control_port_get_snapped_val_from_val (
+      self, val);
+}
+
 /**
  * Converts normalized value (0.0 to 1.0) to
  * real value (eg. -10.0 to 100.0).
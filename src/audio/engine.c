@@ -47,6 +47,7 @@
 #include "audio/automation_track.h"
 #include "audio/automation_tracklist.h"
 #include "audio/channel.h"
+#include "audio/control_change_queue.h"
 #include "audio/control_port.h"
 #include "audio/engine.h"
 #include "audio/engine_alsa.h"
@@ -67,16 +68,19 @@
 #include "audio/router.h"
 #include "audio/sample_playback.h"
 #include "audio/sample_processor.h"
+#include "audio/tempo_map.h"
 #include "audio/tempo_track.h"
 #include "audio/transport.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "gui/widgets/main_window.h"
+#include "plugins/carla_native_plugin.h"
 #include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
 #include "plugins/lv2_plugin.h"
 #include "project.h"
 #include "settings/settings.h"
+#include "utils/object_utils.h"
 #include "utils/objects.h"
 #include "utils/string.h"
 #include "utils/ui.h"
@@ -130,6 +134,96 @@ engine_update_frames_per_tick (
     {
       track_update_frames (TRACKLIST->tracks[i]);
     }
+
+  engine_set_tempo_map_dirty (self);
+}
+
+/**
+ * Applies the pending control changes from the GTK
+ * thread and publishes the pending changes from
+ * the DSP thread, so that the queues do not point
+ * to ports that are about to be freed.
+ *
+ * Must be called from the GTK thread while the
+ * engine is paused.
+ */
+void
+engine_flush_control_changes (
+  AudioEngine * self)
+{
+  g_return_if_fail (
+    !g_atomic_int_get (&self->cycle_running));
+
+  if (self->ctrl_in_queue)
+    {
+      control_change_queue_apply (
+        self->ctrl_in_queue);
+    }
+  if (self->ctrl_out_queue)
+    {
+      ControlChange change;
+      while (control_change_queue_pop (
+               self->ctrl_out_queue, &change))
+        {
+          if (ZRYTHM_HAVE_UI)
+            {
+              port_push_control_change_events (
+                change.port);
+            }
+        }
+    }
+}
+
+/**
+ * Rebuilds the tempo map from the tempo track and
+ * publishes it to the DSP threads.
+ *
+ * @note Not real-time safe.
+ */
+void
+engine_update_tempo_map (
+  AudioEngine * self)
+{
+  g_return_if_fail (
+    self->transport && P_TEMPO_TRACK);
+
+  g_atomic_int_set (&self->tempo_map_dirty, 0);
+
+  TempoMap * new_map =
+    tempo_map_new_from_tempo_track (
+      P_TEMPO_TRACK,
+      self->transport->ticks_per_beat,
+      self->sample_rate);
+  g_return_if_fail (new_map);
+
+  TempoMap * old_map =
+    engine_get_tempo_map (self);
+  bool conversions_changed =
+    tempo_map_has_tempo_changes (new_map) ||
+    tempo_map_has_tempo_changes (old_map);
+  g_atomic_pointer_set (
+    &self->tempo_map, new_map);
+
+  /* the old map may still be in use by the DSP
+   * threads in the current cycle */
+  if (old_map)
+    {
+      free_later (old_map, tempo_map_free);
+    }
+
+  /* update cached frames if the conversions
+   * changed */
+  if (conversions_changed)
+    {
+      transport_update_position_frames (
+        self->transport);
+      for (int i = 0; i < TRACKLIST->num_tracks;
+           i++)
+        {
+          track_update_frames (
+            TRACKLIST->tracks[i]);
+        }
+    }
 }
 
 /**
@@ -159,10 +253,8 @@ engine_pre_setup (
       break;
 #ifdef HAVE_ALSA
     case AUDIO_BACKEND_ALSA:
-#if 0
       ret =
-        engine_alsa_setup(self);
-#endif
+        engine_alsa_setup (self);
       break;
 #endif
 #ifdef HAVE_JACK
@@ -354,6 +446,16 @@ init_common (
 {
   self->metronome = metronome_new ();
   self->router = router_new ();
+  self->ctrl_in_queue = control_change_queue_new ();
+  self->ctrl_out_queue = control_change_queue_new ();
+  delay_locked_loop_init (
+    &self->dll, DELAY_LOCKED_LOOP_DEFAULT_BANDWIDTH);
+  self->automation_granularity =
+    ZRYTHM_TESTING ?
+      ENGINE_DEFAULT_AUTOMATION_GRANULARITY :
+      g_settings_get_uint (
+        S_P_GENERAL_ENGINE,
+        "automation-granularity");
 
   /* get audio backend */
   AudioBackend ab_code = AUDIO_BACKEND_DUMMY;
@@ -392,9 +494,7 @@ init_common (
 #endif
 #ifdef HAVE_ALSA
     case AUDIO_BACKEND_ALSA:
-#if 0
       self->audio_backend = AUDIO_BACKEND_ALSA;
-#endif
       break;
 #endif
 #ifdef HAVE_PORT_AUDIO
@@ -705,6 +805,10 @@ engine_activate (
   if (self->audio_backend == AUDIO_BACKEND_SDL)
     engine_sdl_activate (self, activate);
 #endif
+#ifdef HAVE_ALSA
+  if (self->audio_backend == AUDIO_BACKEND_ALSA)
+    engine_alsa_activate (self, activate);
+#endif
 #ifdef HAVE_RTAUDIO
   if (audio_backend_is_rtaudio (
         self->audio_backend))
@@ -767,7 +871,17 @@ engine_realloc_port_buffers (
   free (ports);
   for (int i = 0; i < TRACKLIST->num_tracks; i++)
     {
-      ch = TRACKLIST->tracks[i]->channel;
+      Track * tr = TRACKLIST->tracks[i];
+      if (tr->processor)
+        {
+          /* reallocate the region group buffers
+           * to the new size */
+          track_processor_set_num_region_groups (
+            tr->processor,
+            tr->processor->num_region_groups);
+        }
+
+      ch = tr->channel;
 
       if (!ch)
         continue;
@@ -789,6 +903,14 @@ engine_realloc_port_buffers (
                   lv2_plugin_allocate_port_buffers (
                     pl->lv2);
                 }
+#ifdef HAVE_CARLA
+              else if (pl->descr->open_with_carla &&
+                       pl->carla)
+                {
+                  carla_native_plugin_update_buffer_size (
+                    pl->carla, nframes);
+                }
+#endif
             }
         }
     }
@@ -904,13 +1026,6 @@ engine_process_prepare (
     case AUDIO_BACKEND_JACK:
       engine_jack_prepare_process (self);
       break;
-#endif
-#ifdef HAVE_ALSA
-    case AUDIO_BACKEND_ALSA:
-#if 0
-      engine_alsa_prepare_process (self);
-#endif
-      break;
 #endif
     default:
       break;
@@ -928,6 +1043,9 @@ engine_process_prepare (
       return;
     }
 
+  /* apply control changes from the UI */
+  control_change_queue_apply (self->ctrl_in_queue);
+
   /* reset all buffers */
   fader_clear_buffers (MONITOR_FADER);
   port_clear_buffer (self->midi_in);
@@ -1003,6 +1121,9 @@ engine_process (
     self->timestamp_start +
     (total_frames_to_process * 1000000) /
       self->sample_rate;
+  delay_locked_loop_update (
+    &self->dll, self->timestamp_start,
+    total_frames_to_process, self->sample_rate);
 
   /* Clear output buffers just in case we have to
    * return early */
@@ -1260,9 +1381,7 @@ engine_fill_out_bufs (
       break;
 #ifdef HAVE_ALSA
     case AUDIO_BACKEND_ALSA:
-#if 0
       engine_alsa_fill_out_bufs (self, nframes);
-#endif
       break;
 #endif
 #ifdef HAVE_JACK
@@ -1449,6 +1568,11 @@ engine_free (
       engine_jack_tear_down (self);
       break;
 #endif
+#ifdef HAVE_ALSA
+    case AUDIO_BACKEND_ALSA:
+      engine_alsa_tear_down (self);
+      break;
+#endif
 #ifdef HAVE_RTAUDIO
     case AUDIO_BACKEND_ALSA_RTAUDIO:
     case AUDIO_BACKEND_JACK_RTAUDIO:
@@ -1487,6 +1611,14 @@ engine_free (
     control_room_free, self->control_room);
   object_free_w_func_and_null (
     transport_free, self->transport);
+  object_free_w_func_and_null (
+    tempo_map_free, self->tempo_map);
+  object_free_w_func_and_null (
+    control_change_queue_free,
+    self->ctrl_in_queue);
+  object_free_w_func_and_null (
+    control_change_queue_free,
+    self->ctrl_out_queue);
 
   object_zero_and_free (self);
 
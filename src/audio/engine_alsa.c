@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2019-2020 Alexandros Theodotou <alex at zrythm dot org>
+ * Copyright (C) 2019-2021 Alexandros Theodotou <alex at zrythm dot org>
  *
  * This file is part of Zrythm
  *
@@ -17,84 +17,293 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "zrythm-config.h"
+/**
+ * \file
+ *
+ * Native ALSA audio backend.
+ *
+ * Playback and capture streams of the same device
+ * are linked so they start and stop together, and
+ * data is read from and written to the
+ * memory-mapped device buffers directly during
+ * processing.
+ */
 
-#if 0
+#include "zrythm-config.h"
 
 #ifdef HAVE_ALSA
 
+#include <errno.h>
 #include <math.h>
-#include <stdio.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "audio/engine.h"
 #include "audio/engine_alsa.h"
-#include "audio/midi.h"
 #include "audio/port.h"
 #include "project.h"
+#include "settings/settings.h"
+#include "utils/string.h"
 #include "utils/ui.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
 
 #include <alsa/asoundlib.h>
 #include <pthread.h>
 
+#include <gtk/gtk.h>
 #include <glib/gi18n.h>
 
-#define POLY 10
+/**
+ * Returns the address of the given frame in the
+ * given channel area.
+ */
+static inline char *
+get_frame_addr (
+  const snd_pcm_channel_area_t * area,
+  snd_pcm_uframes_t              frame)
+{
+  return
+    (char *) area->addr +
+    ((area->first + frame * area->step) >> 3);
+}
+
+static inline float
+read_sample (
+  const char *     addr,
+  snd_pcm_format_t format)
+{
+  switch (format)
+    {
+    case SND_PCM_FORMAT_FLOAT:
+      return *(const float *) addr;
+    case SND_PCM_FORMAT_S32:
+      return
+        (float)
+        ((double) *(const int32_t *) addr /
+           2147483648.0);
+    case SND_PCM_FORMAT_S16:
+      return
+        (float) *(const int16_t *) addr / 32768.f;
+    default:
+      return 0.f;
+    }
+}
+
+static inline void
+write_sample (
+  char *           addr,
+  snd_pcm_format_t format,
+  float            val)
+{
+  val = CLAMP (val, -1.f, 1.f);
+  switch (format)
+    {
+    case SND_PCM_FORMAT_FLOAT:
+      *(float *) addr = val;
+      break;
+    case SND_PCM_FORMAT_S32:
+      *(int32_t *) addr =
+        (int32_t) lrint ((double) val * 2147483647.0);
+      break;
+    case SND_PCM_FORMAT_S16:
+      *(int16_t *) addr =
+        (int16_t) lrintf (val * 32767.f);
+      break;
+    default:
+      break;
+    }
+}
 
+/**
+ * Sets the hardware params of the given stream.
+ *
+ * The sample rate and period size are taken from
+ * the engine, and updated for the playback
+ * stream. The capture stream must match them
+ * exactly.
+ *
+ * @param[out] format The chosen sample format.
+ * @param[out] channels The number of channels.
+ *
+ * @return Non-zero if fail.
+ */
 static int
-set_sw_params (AudioEngine * self)
+set_hw_params (
+  AudioEngine *      self,
+  snd_pcm_t *        handle,
+  bool               is_playback,
+  unsigned int       periods,
+  snd_pcm_format_t * format,
+  unsigned int *     channels)
 {
-  int err;
+  const char * stream =
+    is_playback ? "playback" : "capture";
+  snd_pcm_hw_params_t * hw_params;
+  snd_pcm_hw_params_alloca (&hw_params);
+
+#define CHECK_ERR(msg) \
+  if (err < 0) \
+    { \
+      g_warning ( \
+        "[ALSA] %s: " msg ": %s", stream, \
+        snd_strerror (err)); \
+      return err; \
+    }
+
+  int err = snd_pcm_hw_params_any (handle, hw_params);
+  CHECK_ERR ("Failed to choose all parameters");
 
-  /* get current swparams */
+  /* prefer non-interleaved so that each channel is
+   * contiguous */
   err =
-    snd_pcm_sw_params_current (
-      self->playback_handle, self->sw_params);
+    snd_pcm_hw_params_set_access (
+      handle, hw_params,
+      SND_PCM_ACCESS_MMAP_NONINTERLEAVED);
   if (err < 0)
     {
-      g_warning (
-        "Cannot init sw params: %s",
-        snd_strerror (err));
-      return err;
+      err =
+        snd_pcm_hw_params_set_access (
+          handle, hw_params,
+          SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    }
+  CHECK_ERR ("Device does not support mmap access");
+
+  const snd_pcm_format_t formats[] = {
+    SND_PCM_FORMAT_FLOAT, SND_PCM_FORMAT_S32,
+    SND_PCM_FORMAT_S16, };
+  err = -EINVAL;
+  for (size_t i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      err =
+        snd_pcm_hw_params_set_format (
+          handle, hw_params, formats[i]);
+      if (err == 0)
+        {
+          *format = formats[i];
+          break;
+        }
     }
+  CHECK_ERR ("No supported sample format");
 
-  /* allow the transfer when at least period_size
-   * samples can be processed */
-  g_warn_if_fail (self->block_length > 0);
+  if (is_playback)
+    {
+      /* at least stereo */
+      unsigned int min_channels = 0;
+      snd_pcm_hw_params_get_channels_min (
+        hw_params, &min_channels);
+      *channels = MAX (min_channels, 2);
+    }
+  else
+    {
+      /* expose all inputs */
+      unsigned int max_channels = 0;
+      snd_pcm_hw_params_get_channels_max (
+        hw_params, &max_channels);
+      *channels =
+        MIN (max_channels, ENGINE_ALSA_MAX_CHANNELS);
+    }
   err =
-    snd_pcm_sw_params_set_avail_min (
-      self->playback_handle, self->sw_params,
-      self->block_length);
-  if (err < 0)
+    snd_pcm_hw_params_set_channels (
+      handle, hw_params, *channels);
+  CHECK_ERR ("Cannot set channels");
+
+  if (is_playback)
     {
-      g_warning (
-        "Cannot set avail min: %s",
-        snd_strerror (err));
-      return err;
+      err =
+        snd_pcm_hw_params_set_rate_near (
+          handle, hw_params, &self->sample_rate,
+          NULL);
+    }
+  else
+    {
+      err =
+        snd_pcm_hw_params_set_rate (
+          handle, hw_params, self->sample_rate, 0);
     }
+  CHECK_ERR ("Cannot set sample rate");
+
+  snd_pcm_uframes_t period_size =
+    self->block_length;
+  if (is_playback)
+    {
+      err =
+        snd_pcm_hw_params_set_period_size_near (
+          handle, hw_params, &period_size, NULL);
+    }
+  else
+    {
+      err =
+        snd_pcm_hw_params_set_period_size (
+          handle, hw_params, period_size, 0);
+    }
+  CHECK_ERR ("Cannot set period size");
 
-  /* start the transfer whena period is full */
   err =
-    snd_pcm_sw_params_set_start_threshold (
-      self->playback_handle,
-      self->sw_params,
-      self->block_length);
+    snd_pcm_hw_params_set_periods_near (
+      handle, hw_params, &periods, NULL);
+  CHECK_ERR ("Cannot set period count");
+
+  err =
+    snd_pcm_hw_params_set_buffer_size (
+      handle, hw_params, period_size * periods);
+  CHECK_ERR ("Cannot set buffer size");
+
+  err = snd_pcm_hw_params (handle, hw_params);
+  CHECK_ERR ("Cannot set hw params");
+
+#undef CHECK_ERR
+
+  self->block_length = (nframes_t) period_size;
+
+  g_message (
+    "[ALSA] %s: %u channels, format %s, rate %u, "
+    "period size %lu, %u periods",
+    stream, *channels,
+    snd_pcm_format_name (*format),
+    self->sample_rate, period_size, periods);
+
+  return 0;
+}
+
+static int
+set_sw_params (
+  AudioEngine * self,
+  snd_pcm_t *   handle)
+{
+  snd_pcm_sw_params_t * sw_params;
+  snd_pcm_sw_params_alloca (&sw_params);
+
+  int err =
+    snd_pcm_sw_params_current (handle, sw_params);
   if (err < 0)
     {
       g_warning (
-        "Cannot set start threshold: %s",
+        "[ALSA] Cannot init sw params: %s",
         snd_strerror (err));
       return err;
     }
 
-  /* write the parameters to the playback device */
-  err =
-    snd_pcm_sw_params (
-      self->playback_handle, self->sw_params);
+  /* wake up when a whole period can be
+   * processed */
+  snd_pcm_sw_params_set_avail_min (
+    handle, sw_params, self->block_length);
+
+  /* streams are started explicitly after
+   * prefilling the playback buffer */
+  snd_pcm_uframes_t boundary;
+  snd_pcm_sw_params_get_boundary (
+    sw_params, &boundary);
+  snd_pcm_sw_params_set_start_threshold (
+    handle, sw_params, boundary);
+
+  err = snd_pcm_sw_params (handle, sw_params);
   if (err < 0)
     {
       g_warning (
-        "Cannot set sw params: %s",
+        "[ALSA] Cannot set sw params: %s",
         snd_strerror (err));
       return err;
     }
@@ -102,223 +311,389 @@ set_sw_params (AudioEngine * self)
   return 0;
 }
 
-static void
-set_hw_params (
+/**
+ * Fills the playback buffer with silence and
+ * starts the streams.
+ */
+static int
+start_streams (
   AudioEngine * self)
 {
-  int err, dir;
-
-  /* choose all parameters */
-  err =
-    snd_pcm_hw_params_any (
-      self->playback_handle, self->hw_params);
-  if (err < 0)
-    g_warning (
-      "Failed to choose all parameters: %s",
-      snd_strerror (err));
+  snd_pcm_sframes_t avail =
+    snd_pcm_avail_update (self->playback_handle);
+  while (avail > 0)
+    {
+      const snd_pcm_channel_area_t * areas;
+      snd_pcm_uframes_t offset;
+      snd_pcm_uframes_t frames =
+        (snd_pcm_uframes_t) avail;
+      int err =
+        snd_pcm_mmap_begin (
+          self->playback_handle, &areas, &offset,
+          &frames);
+      if (err < 0)
+        return err;
+      snd_pcm_areas_silence (
+        areas, offset,
+        self->alsa_num_playback_channels, frames,
+        self->alsa_playback_format);
+      snd_pcm_sframes_t committed =
+        snd_pcm_mmap_commit (
+          self->playback_handle, offset, frames);
+      if (committed < 0)
+        return (int) committed;
+      avail -= committed;
+    }
 
-  /* set interleaved read/write format */
-  err =
-    snd_pcm_hw_params_set_access (
-      self->playback_handle, self->hw_params,
-      SND_PCM_ACCESS_RW_INTERLEAVED);
+  int err = snd_pcm_start (self->playback_handle);
   if (err < 0)
-    g_warning (
-      "Cannot set access type: %s",
-      snd_strerror (err));
+    return err;
 
-  /* set the sample format */
-  err =
-    snd_pcm_hw_params_set_format (
-      self->playback_handle, self->hw_params,
-      SND_PCM_FORMAT_FLOAT_LE);
-  if (err < 0)
-    g_warning (
-      "Cannot set format: %s",
-      snd_strerror (err));
+  /* linked streams start together */
+  if (self->capture_handle && !self->alsa_linked)
+    {
+      err = snd_pcm_start (self->capture_handle);
+    }
 
-  /* set num channels */
-  err =
-    snd_pcm_hw_params_set_channels (
-      self->playback_handle, self->hw_params, 2);
-  if (err < 0)
-    g_warning (
-      "Cannot set channels: %s",
-      snd_strerror (err));
+  return err;
+}
 
-  /* set sample rate */
-  err =
-    snd_pcm_hw_params_set_rate_near (
-      self->playback_handle, self->hw_params,
-      &self->sample_rate, 0);
-  if (err < 0)
-    g_warning (
-      "Cannot set sample rate: %s",
-      snd_strerror (err));
+/**
+ * Recovers from an xrun or suspend and restarts
+ * the streams.
+ */
+static int
+recover (
+  AudioEngine * self,
+  int           err)
+{
+  g_atomic_int_inc (&self->alsa_num_xruns);
 
-  /* set periods */
-  snd_pcm_hw_params_set_periods (
-    self->playback_handle, self->hw_params, 2, 0);
+  gint64 cur_time = g_get_monotonic_time ();
+  if (cur_time - self->last_xrun_notification >
+        6000000)
+    {
+      g_warning (
+        "[ALSA] XRUN occurred (%s, %d total) - "
+        "consider increasing the buffer size or "
+        "period count",
+        snd_strerror (err),
+        g_atomic_int_get (&self->alsa_num_xruns));
+      self->last_xrun_notification = cur_time;
+    }
 
-  snd_pcm_uframes_t period_size =
-    self->block_length;
-  dir = 0;
-  err =
-    snd_pcm_hw_params_set_period_size_near (
-      self->playback_handle, self->hw_params,
-      &period_size, &dir);
-  if (err < 0)
-    g_warning (
-      "Unable to set perriod size %lu for playback: "
-      "%s",
-      period_size,
-      snd_strerror (err));
-  dir = 0;
-  err =
-    snd_pcm_hw_params_get_period_size (
-      self->hw_params, &period_size, &dir);
-  if (err < 0)
-    g_warning (
-      "Unable to perriod size %lu for playback: %s",
-      period_size,
-      snd_strerror (err));
-  self->block_length = (nframes_t) period_size;
+  if (err == -ESTRPIPE)
+    {
+      while ((err =
+                snd_pcm_resume (
+                  self->playback_handle)) ==
+               -EAGAIN)
+        {
+          g_usleep (1000);
+        }
+    }
 
-  snd_pcm_uframes_t buffer_size =
-    period_size * 2; /* 2 channels */
-  err =
-    snd_pcm_hw_params_set_buffer_size_near (
-      self->playback_handle, self->hw_params,
-      &buffer_size);
+  snd_pcm_drop (self->playback_handle);
+  if (self->capture_handle && !self->alsa_linked)
+    {
+      snd_pcm_drop (self->capture_handle);
+    }
+  err = snd_pcm_prepare (self->playback_handle);
   if (err < 0)
-    g_warning (
-      "Unable to set buffer size %lu for playback: %s",
-      buffer_size,
-      snd_strerror (err));
-  err =
-    snd_pcm_hw_params_get_buffer_size (
-      self->hw_params, &buffer_size);
-
-  if (2 * period_size  > buffer_size)
-    g_warning ("Buffer %lu too small",
-               buffer_size);
+    return err;
+  if (self->capture_handle && !self->alsa_linked)
+    {
+      err = snd_pcm_prepare (self->capture_handle);
+      if (err < 0)
+        return err;
+    }
 
-	// write the parameters to device
-  err =
-    snd_pcm_hw_params (
-      self->playback_handle, self->hw_params);
-  if (err < 0)
-    g_warning (
-      "Cannot set hw params: %s",
-      snd_strerror (err));
+  return start_streams (self);
 }
 
-static inline snd_pcm_sframes_t
-process_cb (
-  AudioEngine* self,
-  snd_pcm_sframes_t nframes)
+/**
+ * Processes one chunk of at most a period.
+ *
+ * @return Negative ALSA error code if fail.
+ */
+static int
+process_chunk (
+  AudioEngine *     self,
+  snd_pcm_uframes_t frames)
 {
-  self->nframes = (nframes_t) nframes;
+  snd_pcm_uframes_t play_frames = frames;
+  int err =
+    snd_pcm_mmap_begin (
+      self->playback_handle,
+      &self->alsa_playback_areas,
+      &self->alsa_playback_offset,
+      &play_frames);
+  if (err < 0)
+    return err;
+  frames = play_frames;
+
+  if (self->capture_handle)
+    {
+      snd_pcm_uframes_t capture_frames = frames;
+      err =
+        snd_pcm_mmap_begin (
+          self->capture_handle,
+          &self->alsa_capture_areas,
+          &self->alsa_capture_offset,
+          &capture_frames);
+      if (err < 0)
+        return err;
+      frames = MIN (frames, capture_frames);
+    }
 
-  memset (
-    self->alsa_out_buf, 0, (size_t) (nframes * 2));
-  engine_process (self, self->nframes);
+  /* silence in case the engine doesn't fill
+   * the buffers */
+  snd_pcm_areas_silence (
+    self->alsa_playback_areas,
+    self->alsa_playback_offset,
+    self->alsa_num_playback_channels, frames,
+    self->alsa_playback_format);
 
-  return
-    snd_pcm_writei (
+  if (frames > 0)
+    {
+      engine_process (self, (nframes_t) frames);
+    }
+
+  snd_pcm_sframes_t committed =
+    snd_pcm_mmap_commit (
       self->playback_handle,
-      self->alsa_out_buf,
-      (snd_pcm_uframes_t) nframes);
+      self->alsa_playback_offset, frames);
+  self->alsa_playback_areas = NULL;
+  if (committed >= 0 &&
+      (snd_pcm_uframes_t) committed != frames)
+    {
+      committed = -EPIPE;
+    }
+  if (self->capture_handle)
+    {
+      snd_pcm_sframes_t capture_committed =
+        snd_pcm_mmap_commit (
+          self->capture_handle,
+          self->alsa_capture_offset, frames);
+      self->alsa_capture_areas = NULL;
+      if (committed >= 0 &&
+          (capture_committed < 0 ||
+           (snd_pcm_uframes_t) capture_committed !=
+             frames))
+        {
+          committed =
+            capture_committed < 0 ?
+              capture_committed : -EPIPE;
+        }
+    }
+
+  return committed < 0 ? (int) committed : 0;
 }
 
-/**
- * Called when an alsa MIDI event is received on
- * any registered port.
- */
-static inline int
-on_midi_event (
-  AudioEngine* self)
+static void
+set_rt_priority (void)
+{
+  struct sched_param param;
+  memset (&param, 0, sizeof (param));
+  param.sched_priority = ENGINE_ALSA_RT_PRIORITY;
+  int ret =
+    pthread_setschedparam (
+      pthread_self (), SCHED_FIFO, &param);
+  if (ret)
+    {
+      g_warning (
+        "[ALSA] Cannot set SCHED_FIFO priority %d "
+        "for the audio thread: %s",
+        ENGINE_ALSA_RT_PRIORITY, strerror (ret));
+    }
+}
+
+static void *
+audio_thread (
+  void * data)
 {
-  snd_seq_event_t *ev;
-  Port * port;
+  AudioEngine * self = (AudioEngine *) data;
 
-  uint32_t time = 0;
+  set_rt_priority ();
 
-  do
+  int err = start_streams (self);
+  if (err < 0)
     {
-      /* get alsa seq event */
-      snd_seq_event_input (
-        self->seq_handle, &ev);
+      g_warning (
+        "[ALSA] Cannot start streams: %s",
+        snd_strerror (err));
+      return NULL;
+    }
 
-      /* find the zrythm port by the alsa seq
-       * port ID */
-      port =
-        port_find_by_alsa_seq_id (
-          ev->dest.port);
+  while (!g_atomic_int_get (&self->alsa_stop))
+    {
+      err = snd_pcm_wait (self->playback_handle, 100);
+      if (err == 0)
+        {
+          /* timeout - check if we should stop */
+          continue;
+        }
+      if (err < 0)
+        {
+          err = recover (self, err);
+          if (err < 0)
+            break;
+          continue;
+        }
 
-      g_return_val_if_fail (port, -1);
+      snd_pcm_sframes_t avail =
+        snd_pcm_avail_update (self->playback_handle);
+      if (avail >= 0 && self->capture_handle)
+        {
+          snd_pcm_sframes_t capture_avail =
+            snd_pcm_avail_update (
+              self->capture_handle);
+          avail =
+            capture_avail < 0 ?
+              capture_avail :
+              MIN (avail, capture_avail);
+        }
+      if (avail < 0)
+        {
+          err = recover (self, (int) avail);
+          if (err < 0)
+            break;
+          continue;
+        }
 
-      zix_sem_wait (
-        &port->midi_events->access_sem);
+      /* process whole periods */
+      while (avail >= (snd_pcm_sframes_t) self->block_length)
+        {
+          err =
+            process_chunk (self, self->block_length);
+          if (err < 0)
+            {
+              err = recover (self, err);
+              break;
+            }
+          avail -= self->block_length;
+        }
+      if (err < 0)
+        break;
+    }
 
-      switch (ev->type)
+  if (err < 0)
+    {
+      g_critical (
+        "[ALSA] Stopping audio thread: %s",
+        snd_strerror (err));
+    }
+
+  return NULL;
+}
+
+/**
+ * Copies the given capture channel of the current
+ * period into the given buffer.
+ *
+ * To be called during processing.
+ */
+void
+engine_alsa_read_capture (
+  AudioEngine *   self,
+  unsigned int    channel,
+  float *         buf,
+  const nframes_t nframes)
+{
+  const snd_pcm_channel_area_t * areas =
+    self->alsa_capture_areas;
+  if (!areas ||
+      channel >= self->alsa_num_capture_channels)
+    return;
+
+  const snd_pcm_channel_area_t * area =
+    &areas[channel];
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      buf[i] =
+        read_sample (
+          get_frame_addr (
+            area, self->alsa_capture_offset + i),
+          self->alsa_capture_format);
+    }
+}
+
+/**
+ * Fill the output buffers at the end of the
+ * cycle.
+ */
+void
+engine_alsa_fill_out_bufs (
+  AudioEngine *   self,
+  const nframes_t nframes)
+{
+  const snd_pcm_channel_area_t * areas =
+    self->alsa_playback_areas;
+  if (!areas)
+    return;
+
+#ifdef TRIAL_VER
+  if (self->limit_reached)
+    return;
+#endif
+
+  float * bufs[2] = {
+    self->monitor_out->l->buf,
+    self->monitor_out->r->buf, };
+  for (unsigned int ch = 0; ch < 2; ch++)
+    {
+      const snd_pcm_channel_area_t * area =
+        &areas[ch];
+      for (nframes_t i = 0; i < nframes; i++)
         {
-        /* see https://www.alsa-project.org/alsa-doc/alsa-lib/group___seq_events.html for more */
-        case SND_SEQ_EVENT_PITCHBEND:
-          g_message ("pitch %d",
-                     ev->data.control.value);
-          midi_events_add_pitchbend (
-            port->midi_events, 1,
-            (midi_byte_t)
-            ev->data.control.value,
-            time++, 1);
-          break;
-        case SND_SEQ_EVENT_CONTROLLER:
-          g_message ("modulation %d",
-                     ev->data.control.value);
-          midi_events_add_control_change (
-            port->midi_events,
-            1, (midi_byte_t) ev->data.control.param,
-            (midi_byte_t) ev->data.control.value,
-            time++, 1);
-          break;
-        case SND_SEQ_EVENT_NOTEON:
-          g_message ("note on: note %d vel %d",
-                     ev->data.note.note,
-                     ev->data.note.velocity);
-          /*g_message ("time %u:%u",*/
-                     /*ev->time.time.tv_sec,*/
-                     /*ev->time.time.tv_nsec);*/
-          midi_events_add_note_on (
-            port->midi_events,
-            1, ev->data.note.note,
-            ev->data.note.velocity,
-            time++, 1);
-          break;
-        case SND_SEQ_EVENT_NOTEOFF:
-          g_message ("note off: note %d",
-                     ev->data.note.note);
-          midi_events_add_note_off (
-            port->midi_events,
-            1, ev->data.note.note,
-            time++, 1);
-          /* FIXME passing ticks, should pass
-           * frames */
-          break;
-        default:
-          g_message ("Unknown MIDI event received");
-          break;
-      }
+          write_sample (
+            get_frame_addr (
+              area, self->alsa_playback_offset + i),
+            self->alsa_playback_format,
+            bufs[ch][i]);
+        }
+    }
+}
 
-      zix_sem_post (
-        &port->midi_events->access_sem);
+/**
+ * Returns a list of names inside \ref names that
+ * must be free'd.
+ *
+ * @param input 1 for input, 0 for output.
+ */
+void
+engine_alsa_get_device_names (
+  AudioEngine * self,
+  int           input,
+  char **       names,
+  int *         num_names)
+{
+  *num_names = 0;
 
-      snd_seq_free_event(ev);
-    } while (
-        snd_seq_event_input_pending (
-          self->seq_handle, 0) > 0);
+  void ** hints;
+  if (snd_device_name_hint (-1, "pcm", &hints) < 0)
+    return;
 
-  return 0;
+  const char * ioid_to_skip =
+    input ? "Output" : "Input";
+  for (void ** hint = hints;
+       *hint && *num_names < 1024; hint++)
+    {
+      char * name =
+        snd_device_name_get_hint (*hint, "NAME");
+      char * ioid =
+        snd_device_name_get_hint (*hint, "IOID");
+      if (name &&
+          !string_is_equal (name, "null") &&
+          (!ioid ||
+           !string_is_equal (ioid, ioid_to_skip)))
+        {
+          names[(*num_names)++] = g_strdup (name);
+        }
+      free (name);
+      free (ioid);
+    }
+  snd_device_name_free_hint (hints);
 }
 
 /**
@@ -332,11 +707,17 @@ int
 engine_alsa_test (
   GtkWindow * win)
 {
+  char * device =
+    g_settings_get_string (
+      S_P_GENERAL_ENGINE, "alsa-audio-device-name");
   snd_pcm_t * playback_handle;
   int err =
-    snd_pcm_open(
-      &playback_handle, "default",
-      SND_PCM_STREAM_PLAYBACK, 0);
+    snd_pcm_open (
+      &playback_handle,
+      strlen (device) > 0 ?
+        device : ENGINE_ALSA_DEFAULT_DEVICE,
+      SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+  g_free (device);
   if (err < 0)
     {
       char * msg =
@@ -348,228 +729,199 @@ engine_alsa_test (
       g_free (msg);
       return 1;
     }
+  snd_pcm_close (playback_handle);
 
-  return err;
+  return 0;
 }
 
 /**
- * Fill the output buffers at the end of the
- * cycle.
+ * Opens the selected device for playback and, if
+ * possible, capture, and configures it with the
+ * selected sample rate, period size and period
+ * count.
+ *
+ * @return Non-zero if fail.
  */
-void
-engine_alsa_fill_out_bufs (
-  AudioEngine *   self,
-  const nframes_t nframes)
+int
+engine_alsa_setup (
+  AudioEngine * self)
 {
-  for (unsigned int i = 0; i < nframes; i++)
+  g_message ("setting up ALSA...");
+
+  char * device =
+    g_settings_get_string (
+      S_P_GENERAL_ENGINE, "alsa-audio-device-name");
+  if (!device || strlen (device) == 0)
     {
-      self->alsa_out_buf[i * 2] =
-        self->monitor_out->l->buf[i];
-      self->alsa_out_buf[i * 2 + 1] =
-        self->monitor_out->l->buf[i];
+      g_free (device);
+      device = g_strdup (ENGINE_ALSA_DEFAULT_DEVICE);
     }
-}
+  self->alsa_device = device;
+  unsigned int periods =
+    g_settings_get_uint (
+      S_P_GENERAL_ENGINE, "alsa-periods");
+  self->sample_rate =
+    (sample_rate_t)
+    engine_samplerate_enum_to_int (
+      (AudioEngineSamplerate)
+      g_settings_get_enum (
+        S_P_GENERAL_ENGINE, "sample-rate"));
+  self->block_length =
+    (nframes_t)
+    engine_buffer_size_enum_to_int (
+      (AudioEngineBufferSize)
+      g_settings_get_enum (
+        S_P_GENERAL_ENGINE, "buffer-size"));
+  self->midi_buf_size = 4096;
 
-static void *
-audio_thread (void * _self)
-{
-  AudioEngine * self = (AudioEngine *) _self;
+  g_message (
+    "[ALSA] Opening device %s with sample rate %u, "
+    "period size %u and %u periods",
+    device, self->sample_rate, self->block_length,
+    periods);
 
-  int err;
-  err =
-    snd_pcm_open(
-      &self->playback_handle, "plughw:0,0",
+  int err =
+    snd_pcm_open (
+      &self->playback_handle, device,
       SND_PCM_STREAM_PLAYBACK, 0);
   if (err < 0)
-    g_warning (
-      "%s [ALSA]: Cannot open audio device: %s",
-      __func__, snd_strerror (err));
+    {
+      g_warning (
+        "[ALSA] Cannot open %s for playback: %s",
+        device, snd_strerror (err));
+      self->playback_handle = NULL;
+      return -1;
+    }
+  if (set_hw_params (
+        self, self->playback_handle, true, periods,
+        &self->alsa_playback_format,
+        &self->alsa_num_playback_channels) ||
+      set_sw_params (self, self->playback_handle))
+    {
+      engine_alsa_tear_down (self);
+      return -1;
+    }
 
-  /* set hw params */
+  /* capture is optional */
   err =
-    snd_pcm_hw_params_malloc (&self->hw_params);
+    snd_pcm_open (
+      &self->capture_handle, device,
+      SND_PCM_STREAM_CAPTURE, 0);
   if (err < 0)
-    g_warning (
-      "Cannot allocate hw params: %s",
-      snd_strerror (err));
-  set_hw_params (self);
+    {
+      g_message (
+        "[ALSA] Cannot open %s for capture, "
+        "continuing without inputs: %s",
+        device, snd_strerror (err));
+      self->capture_handle = NULL;
+    }
+  else if (
+    set_hw_params (
+      self, self->capture_handle, false, periods,
+      &self->alsa_capture_format,
+      &self->alsa_num_capture_channels) ||
+    set_sw_params (self, self->capture_handle))
+    {
+      g_message (
+        "[ALSA] Capture does not support the "
+        "playback configuration, continuing "
+        "without inputs");
+      snd_pcm_close (self->capture_handle);
+      self->capture_handle = NULL;
+      self->alsa_num_capture_channels = 0;
+    }
 
-  /* set sw params */
-  err = snd_pcm_sw_params_malloc (&self->sw_params);
-  if (err < 0)
-    g_warning (
-      "Cannot allocate sw params: %s",
-      snd_strerror (err));
-  set_sw_params (self);
-  g_warn_if_fail (self->block_length > 0);
-
-  g_usleep (8000);
-
-  struct pollfd *pfds;
-  int nfds =
-    snd_pcm_poll_descriptors_count (
-      self->playback_handle);
-  pfds =
-    (struct pollfd *)
-    alloca (
-      (size_t) nfds * sizeof (struct pollfd));
-  snd_pcm_poll_descriptors (
-    self->playback_handle, pfds,
-    (unsigned int) nfds);
-  nframes_t frames_processed;
-  int l1;
-  while (1)
-    {
-      if (poll (pfds, (nfds_t) nfds, 1000) > 0)
+  if (self->capture_handle)
+    {
+      err =
+        snd_pcm_link (
+          self->capture_handle,
+          self->playback_handle);
+      self->alsa_linked = err == 0;
+      if (!self->alsa_linked)
         {
-          for (l1 = 0; l1 < nfds; l1++)
-            {
-              while (pfds[l1].revents > 0)
-                {
-                  frames_processed =
-                    (nframes_t)
-                    process_cb (
-                      self, self->block_length);
-                  if (frames_processed <
-                        self->block_length)
-                    {
-                      g_warning ("XRUN");
-                      snd_pcm_prepare (
-                        self->playback_handle);
-                    }
-                }
-            }
+          g_warning (
+            "[ALSA] Cannot link capture and "
+            "playback, they may drift: %s",
+            snd_strerror (err));
         }
     }
-  return NULL;
+
+  g_message ("ALSA setup complete");
+
+  return 0;
 }
 
-static void *
-midi_thread (void * _self)
+/**
+ * Starts or stops the audio thread.
+ */
+void
+engine_alsa_activate (
+  AudioEngine * self,
+  bool          activate)
 {
-  AudioEngine * self = (AudioEngine *) _self;
-
-  int err =
-    snd_seq_open (
-      &self->seq_handle, "default",
-      SND_SEQ_OPEN_DUPLEX, 0);
-  if (err < 0)
+  if (activate)
     {
-      g_warning (
-        "Error opening ALSA sequencer: %s",
-        snd_strerror (err));
+      g_message ("%s: activating...", __func__);
+      g_atomic_int_set (&self->alsa_stop, 0);
+      int ret =
+        pthread_create (
+          &self->alsa_thread, NULL,
+          &audio_thread, self);
+      self->alsa_thread_started = ret == 0;
+      if (ret)
+        {
+          g_critical (
+            "Failed to create ALSA audio thread: %s",
+            strerror (ret));
+        }
     }
-
-  snd_seq_set_client_name (
-    self->seq_handle, "Zrythm");
-
-  int seq_nfds, l1;
-  struct pollfd *pfds;
-  seq_nfds =
-    snd_seq_poll_descriptors_count (
-      self->seq_handle, POLLIN);
-  pfds =
-    (struct pollfd *)
-    alloca (
-      sizeof (struct pollfd) * (size_t) seq_nfds);
-  snd_seq_poll_descriptors (
-    self->seq_handle, pfds,
-    (unsigned int) seq_nfds, POLLIN);
-
-  while (1)
+  else
     {
-      if (poll (pfds, (nfds_t) seq_nfds, 1000) > 0)
+      g_message ("%s: deactivating...", __func__);
+      g_atomic_int_set (&self->alsa_stop, 1);
+      if (self->alsa_thread_started)
         {
-          for (l1 = 0; l1 < seq_nfds; l1++)
-            {
-               if (pfds[l1].revents > 0)
-                 {
-                   if (!PROJECT->loaded ||
-                       !AUDIO_ENGINE->run)
-                     {
-                       g_usleep (1000);
-                     }
-                   on_midi_event (self);
-                 }
-            }
+          pthread_join (self->alsa_thread, NULL);
+          self->alsa_thread_started = false;
+        }
+      snd_pcm_drop (self->playback_handle);
+      if (self->capture_handle && !self->alsa_linked)
+        {
+          snd_pcm_drop (self->capture_handle);
+        }
+      snd_pcm_prepare (self->playback_handle);
+      if (self->capture_handle && !self->alsa_linked)
+        {
+          snd_pcm_prepare (self->capture_handle);
         }
     }
 
-  return NULL;
+  g_message ("%s: done", __func__);
 }
 
 /**
- * Prepares for processing.
- *
- * Called at the start of each process cycle.
+ * Closes the device.
  */
 void
-engine_alsa_prepare_process (
+engine_alsa_tear_down (
   AudioEngine * self)
 {
-  memset (
-    self->alsa_out_buf, 0,
-    2 * AUDIO_ENGINE->block_length *
-      sizeof (float));
-}
-
-int
-engine_alsa_setup (
-  AudioEngine *self)
-{
-  g_message ("setting up ALSA...");
-
-  self->block_length = 512;
-  self->sample_rate = 44100;
-  self->midi_buf_size = 4096;
-  self->alsa_out_buf =
-    (float *) malloc (
-      2 * sizeof (float) * self->block_length);
-
-  pthread_t thread_id;
-  int ret =
-    pthread_create (
-      &thread_id, NULL,
-      &audio_thread, self);
-  if (ret)
+  if (self->capture_handle)
     {
-      perror (
-        "Failed to create ALSA audio thread:");
-      return -1;
+      if (self->alsa_linked)
+        {
+          snd_pcm_unlink (self->capture_handle);
+        }
+      snd_pcm_close (self->capture_handle);
+      self->capture_handle = NULL;
     }
-
-  /* wait for the thread to initialize */
-  g_usleep (100000);
-
-  g_message ("ALSA setup complete");
-
-  return 0;
-}
-
-int
-engine_alsa_midi_setup (
-  AudioEngine * self,
-  int           loading)
-{
-  /*if (loading)*/
-    /*{*/
-    /*}*/
-  /*else*/
-    /*{*/
-    /*}*/
-  g_message ("creating ALSA midi thread");
-
-  pthread_t thread_id;
-  pthread_create (
-    &thread_id, NULL,
-    &midi_thread, self);
-
-  /* wait for the thread to initialize the seq */
-  g_usleep (100000);
-
-  return 0;
+  if (self->playback_handle)
+    {
+      snd_pcm_close (self->playback_handle);
+      self->playback_handle = NULL;
+    }
+  g_free_and_null (self->alsa_device);
 }
 
 #endif
-
-#endif
@@ -23,6 +23,7 @@
 #include "audio/port.h"
 #include "audio/tempo_track.h"
 #include "project.h"
+#include "utils/env.h"
 #include "zrythm_app.h"
 
 #include <gtk/gtk.h>
@@ -51,7 +52,14 @@ process_cb (gpointer data)
         break;
 
       engine_process (self, self->block_length);
-      g_usleep (sleep_time);
+      g_atomic_int_inc (&self->dummy_num_cycles);
+
+      /* when freewheeling, start the next cycle
+       * immediately */
+      if (!g_atomic_int_get (&self->dummy_freewheel))
+        {
+          g_usleep (sleep_time);
+        }
     }
 
   return NULL;
@@ -88,13 +96,17 @@ engine_dummy_setup (
       self->sample_rate = 44100;
     }
 
+  self->dummy_freewheel =
+    env_get_int ("ZRYTHM_DUMMY_FREEWHEEL", 0);
+
   g_warn_if_fail (
     TRANSPORT &&
     TRANSPORT->time_sig.beats_per_bar >= 1);
 
   g_message (
-    "Dummy Engine set up [samplerate: %u]",
-    self->sample_rate);
+    "Dummy Engine set up [samplerate: %u]%s",
+    self->sample_rate,
+    self->dummy_freewheel ? " (freewheeling)" : "");
 
   return 0;
 }
@@ -21,6 +21,7 @@
 
 #include "audio/engine.h"
 #include "audio/engine_jack.h"
+#include "audio/engine_alsa.h"
 #include "audio/engine_rtaudio.h"
 #include "audio/engine_rtmidi.h"
 #include "audio/ext_port.h"
@@ -259,6 +260,20 @@ ext_port_activate (
                   JACK_PORT_T (self->port->data)));
               break;
 #endif
+#ifdef HAVE_ALSA
+            case AUDIO_BACKEND_ALSA:
+              if (self->type != EXT_PORT_TYPE_ALSA)
+                {
+                  g_message (
+                    "skipping %s (not ALSA)",
+                    self->full_name);
+                  return;
+                }
+              /* data is read from the device
+               * during processing */
+              self->port = port;
+              break;
+#endif
 #ifdef HAVE_RTAUDIO
             case AUDIO_BACKEND_ALSA_RTAUDIO:
             case AUDIO_BACKEND_JACK_RTAUDIO:
@@ -365,7 +380,10 @@ ext_port_matches_backend (
 #endif
 #ifdef HAVE_ALSA
         case AUDIO_BACKEND_ALSA:
-          break;
+          if (self->type == EXT_PORT_TYPE_ALSA)
+            return true;
+          else
+            return false;
 #endif
         default:
           break;
@@ -627,6 +645,46 @@ get_ext_ports_from_rtmidi (
 }
 #endif
 
+#ifdef HAVE_ALSA
+/**
+ * Collects the capture channels of the ALSA
+ * device in use.
+ */
+static void
+get_ext_ports_from_alsa (
+  PortFlow   flow,
+  ExtPort ** arr,
+  int *      size)
+{
+  *size = 0;
+  /* note: this is an output port from the graph
+   * side that will be used as an input port on
+   * the zrythm side */
+  if (flow != FLOW_OUTPUT ||
+      !AUDIO_ENGINE->capture_handle)
+    return;
+
+  for (unsigned int i = 0;
+       i < AUDIO_ENGINE->alsa_num_capture_channels;
+       i++)
+    {
+      if (arr)
+        {
+          ExtPort * self =
+            calloc (1, sizeof (ExtPort));
+          self->alsa_channel_idx = i;
+          self->full_name =
+            g_strdup_printf (
+              "%s (in %u)",
+              AUDIO_ENGINE->alsa_device, i);
+          self->type = EXT_PORT_TYPE_ALSA;
+          arr[*size] = self;
+        }
+      (*size)++;
+    }
+}
+#endif
+
 #ifdef HAVE_RTAUDIO
 /**
  * Creates an ExtPort from a RtAudio port.
@@ -810,6 +868,8 @@ ext_ports_get (
 #endif
 #ifdef HAVE_ALSA
         case AUDIO_BACKEND_ALSA:
+          get_ext_ports_from_alsa (
+            flow, arr, size);
           break;
 #endif
         default:
@@ -894,6 +954,8 @@ ext_port_clone (
 #endif
   newport->rtaudio_channel_idx =
     ext_port->rtaudio_channel_idx;
+  newport->alsa_channel_idx =
+    ext_port->alsa_channel_idx;
   newport->rtaudio_dev_name =
     ext_port->rtaudio_dev_name;
 #ifdef HAVE_RTAUDIO
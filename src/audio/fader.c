@@ -32,6 +32,7 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/dsp.h"
+#include "utils/flags.h"
 #include "utils/math.h"
 #include "utils/objects.h"
 #include "zrythm.h"
@@ -451,6 +452,30 @@ fader_set_amp (void * _fader, float amp)
     self);
 }
 
+/**
+ * Sets the amplitude of the fader (0.0 to 2.0) at
+ * the start of the next processing cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+fader_queue_amp (
+  void * _fader,
+  float  amp)
+{
+  Fader * self = (Fader *) _fader;
+  g_return_if_fail (IS_FADER (self));
+
+  port_queue_control_value (
+    self->amp, amp, F_NOT_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
+
+  /* the port value might not be set yet */
+  self->volume = math_amp_to_dbfs (amp);
+  self->fader_val =
+    math_get_fader_val_from_amp (amp);
+}
+
 /**
  * Adds (or subtracts if negative) to the amplitude
  * of the fader (clamped at 0.0 to 2.0).
@@ -477,6 +502,21 @@ fader_get_amp (void * _self)
   return self->amp->control;
 }
 
+/**
+ * Gets the fader amplitude (not db), including
+ * changes queued with fader_queue_amp() that might
+ * not be applied to the port yet.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+float
+fader_get_queued_amp (
+  void * _self)
+{
+  Fader * self = (Fader *) _self;
+  return math_dbfs_to_amp (self->volume);
+}
+
 /**
  * Gets whether mono compatibility is enabled.
  */
@@ -514,19 +554,25 @@ fader_get_fader_val (
   return ((Fader *) self)->fader_val;
 }
 
-/**
- * Sets the fader levels from a normalized value
- * 0.0-1.0 (such as in widgets).
- */
-void
-fader_set_fader_val (
+static void
+set_fader_val (
   Fader * self,
-  float   fader_val)
+  float   fader_val,
+  bool    queue)
 {
-  self->fader_val = fader_val;
   float fader_amp =
     math_get_amp_val_from_fader (fader_val);
-  fader_set_amp (self, fader_amp);
+  if (queue)
+    {
+      port_queue_control_value (
+        self->amp, fader_amp, F_NOT_NORMALIZED,
+        F_NO_PUBLISH_EVENTS);
+    }
+  else
+    {
+      fader_set_amp (self, fader_amp);
+    }
+  self->fader_val = fader_val;
   self->volume = math_amp_to_dbfs (fader_amp);
 
   if (self == MONITOR_FADER)
@@ -537,6 +583,33 @@ fader_set_fader_val (
     }
 }
 
+/**
+ * Sets the fader levels from a normalized value
+ * 0.0-1.0.
+ */
+void
+fader_set_fader_val (
+  Fader * self,
+  float   fader_val)
+{
+  set_fader_val (self, fader_val, false);
+}
+
+/**
+ * Sets the fader levels from a normalized value
+ * 0.0-1.0 at the start of the next processing
+ * cycle.
+ *
+ * To be used by the GTK thread (eg, widgets).
+ */
+void
+fader_queue_fader_val (
+  Fader * self,
+  float   fader_val)
+{
+  set_fader_val (self, fader_val, true);
+}
+
 Channel *
 fader_get_channel (
   Fader * self)
@@ -717,6 +790,85 @@ fader_update_track_pos (
     }
 }
 
+/**
+ * Returns the left and right gains at the given
+ * timeline frames, reading automation if the
+ * amplitude or balance is automated.
+ */
+static void
+get_gains_at_frames (
+  Fader * self,
+  long    g_frames,
+  float * gain_l,
+  float * gain_r)
+{
+  float amp =
+    self->amp->automation_read ?
+      control_port_get_automation_val_at_frames (
+        self->amp, g_frames) :
+      self->amp->control;
+  float pan =
+    self->balance->automation_read ?
+      control_port_get_automation_val_at_frames (
+        self->balance, g_frames) :
+      self->balance->control;
+
+  float calc_l, calc_r;
+  balance_control_get_calc_lr (
+    BALANCE_CONTROL_ALGORITHM_LINEAR,
+    pan, &calc_l, &calc_r);
+  *gain_l = amp * calc_l;
+  *gain_r = amp * calc_r;
+}
+
+/**
+ * Applies the gain to the split, ramping it
+ * between automation points every
+ * AudioEngine.automation_granularity frames.
+ */
+static void
+apply_automated_gain (
+  Fader *         self,
+  long            g_start_frames,
+  nframes_t       start_frame,
+  const nframes_t nframes)
+{
+  nframes_t granularity =
+    MAX (AUDIO_ENGINE->automation_granularity, 1);
+  float * out_l =
+    &self->stereo_out->l->buf[start_frame];
+  float * out_r =
+    &self->stereo_out->r->buf[start_frame];
+  const float * in_l =
+    &self->stereo_in->l->buf[start_frame];
+  const float * in_r =
+    &self->stereo_in->r->buf[start_frame];
+
+  float gain_l, gain_r;
+  get_gains_at_frames (
+    self, g_start_frames, &gain_l, &gain_r);
+  for (nframes_t offset = 0; offset < nframes;)
+    {
+      nframes_t len =
+        MIN (granularity, nframes - offset);
+      float next_gain_l, next_gain_r;
+      get_gains_at_frames (
+        self, g_start_frames + offset + len,
+        &next_gain_l, &next_gain_r);
+
+      dsp_mix2_ramp (
+        &out_l[offset], &in_l[offset], 1.f,
+        gain_l, next_gain_l, len);
+      dsp_mix2_ramp (
+        &out_r[offset], &in_r[offset], 1.f,
+        gain_r, next_gain_r, len);
+
+      gain_l = next_gain_l;
+      gain_r = next_gain_r;
+      offset += len;
+    }
+}
+
 /**
  * Process the Fader.
  *
@@ -812,22 +964,32 @@ fader_process (
           else /* if not muted */
             {
               /* apply fader and pan */
-              dsp_mix2 (
-                &self->stereo_out->l->buf[
-                  start_frame],
-                &self->stereo_in->l->buf[
-                  start_frame],
-                1.f,
-                amp * calc_l,
-                nframes);
-              dsp_mix2 (
-                &self->stereo_out->r->buf[
-                  start_frame],
-                &self->stereo_in->r->buf[
-                  start_frame],
-                1.f,
-                amp * calc_r,
-                nframes);
+              if (self->amp->automation_read ||
+                  self->balance->automation_read)
+                {
+                  apply_automated_gain (
+                    self, g_start_frames,
+                    start_frame, nframes);
+                }
+              else
+                {
+                  dsp_mix2 (
+                    &self->stereo_out->l->buf[
+                      start_frame],
+                    &self->stereo_in->l->buf[
+                      start_frame],
+                    1.f,
+                    amp * calc_l,
+                    nframes);
+                  dsp_mix2 (
+                    &self->stereo_out->r->buf[
+                      start_frame],
+                    &self->stereo_in->r->buf[
+                      start_frame],
+                    1.f,
+                    amp * calc_r,
+                    nframes);
+                }
 
               /* make mono if mono compat
                * enabled. equal amplitude is
@@ -41,6 +41,7 @@
 #include "audio/fader.h"
 #include "audio/graph.h"
 #include "audio/graph_node.h"
+#include "audio/graph_profiler.h"
 #include "audio/graph_thread.h"
 #include "audio/hardware_processor.h"
 #include "audio/port.h"
@@ -110,10 +111,21 @@ graph_on_reached_terminal_node (
         &self->terminal_refcnt,
         (unsigned int) self->n_terminal_nodes);
 
+      /* all the threads are idle so the stats
+       * can be reset safely */
+      graph_profiler_reset_if_requested (self);
+
       /* and start the initial nodes */
+      bool profiling =
+        graph_profiler_is_enabled (self);
+      gint64 now =
+        profiling ?
+          graph_profiler_get_time_ns () : 0;
       for (size_t i = 0;
            i < self->n_init_triggers; ++i)
         {
+          self->init_trigger_list[i]->
+            stats.queued_at_ns = now;
           g_atomic_int_inc (
             &self->trigger_queue_size);
           mpmc_queue_push_back_node (
@@ -529,6 +541,28 @@ graph_setup (
       graph_create_node (
         self, ROUTE_NODE_TYPE_TRACK, tr);
 
+      /* add the region groups of audio tracks with
+       * many lanes */
+      if (tr->type == TRACK_TYPE_AUDIO)
+        {
+          int num_groups =
+            track_processor_get_num_region_groups_needed (
+              tr->processor);
+          if (rechain)
+            {
+              track_processor_set_num_region_groups (
+                tr->processor, num_groups);
+            }
+          for (int j = 0; j < num_groups; j++)
+            {
+              node =
+                graph_create_node (
+                  self, ROUTE_NODE_TYPE_REGION_GROUP,
+                  tr);
+              node->region_group = j;
+            }
+        }
+
       for (int j = 0; j < tr->num_modulators; j++)
         {
           pl = tr->modulators[j];
@@ -707,6 +741,22 @@ graph_setup (
               graph_node_connect (node2, node);
               graph_node_connect (
                 initial_processor_node, node2);
+
+              /* region groups are summed by the
+               * track */
+              for (size_t j = 0;
+                   j < self->num_setup_graph_nodes; j++)
+                {
+                  node2 = self->setup_graph_nodes[j];
+                  if (node2->type !=
+                        ROUTE_NODE_TYPE_REGION_GROUP ||
+                      node2->track != tr)
+                    continue;
+
+                  graph_node_connect (node2, node);
+                  graph_node_connect (
+                    initial_processor_node, node2);
+                }
             }
           port = tr->processor->stereo_in->l;
           node2 =
@@ -1130,6 +1180,12 @@ graph_new (
   g_atomic_int_set (&self->idle_thread_cnt, 0);
   g_atomic_int_set (&self->trigger_queue_size, 0);
 
+  self->profiling_start_ns =
+    graph_profiler_get_time_ns ();
+  g_atomic_int_set (
+    &self->profiling,
+    env_get_int ("ZRYTHM_DSP_PROFILING", 0) != 0);
+
   return self;
 }
 
@@ -1424,6 +1480,15 @@ graph_free (
   object_zero_and_free (
     self->terminal_nodes);
 
+  /* threads are already joined at this point */
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      object_free_w_func_and_null (
+        graph_thread_free, self->threads[i]);
+    }
+  object_free_w_func_and_null (
+    graph_thread_free, self->main_thread);
+
   zix_sem_destroy (&self->callback_start);
   zix_sem_destroy (&self->callback_done);
   zix_sem_destroy (&self->trigger);
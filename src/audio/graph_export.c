@@ -74,6 +74,11 @@ get_parent_graph (
     case ROUTE_NODE_TYPE_MODULATOR_MACRO_PROCESOR:
       parent_node = node;
       break;
+    case ROUTE_NODE_TYPE_REGION_GROUP:
+      parent_node =
+        graph_find_node_from_track (
+          node->graph, node->track, true);
+      break;
     case ROUTE_NODE_TYPE_PORT:
       {
         switch (node->port->id.owner_type)
@@ -42,6 +42,7 @@
 #include "audio/fader.h"
 #include "audio/graph.h"
 #include "audio/graph_node.h"
+#include "audio/graph_thread.h"
 #include "audio/master_track.h"
 #include "audio/midi_event.h"
 #include "audio/port.h"
@@ -105,6 +106,12 @@ graph_node_get_name (
       return
         g_strdup (
           node->track->name);
+    case ROUTE_NODE_TYPE_REGION_GROUP:
+      return
+        g_strdup_printf (
+          "%s Region Group %d",
+          node->track->name,
+          node->region_group + 1);
     case ROUTE_NODE_TYPE_PREFADER:
       {
         Track * track =
@@ -142,6 +149,7 @@ graph_node_get_pointer (
       return node->pl;
       break;
     case ROUTE_NODE_TYPE_TRACK:
+    case ROUTE_NODE_TYPE_REGION_GROUP:
       return node->track;
       break;
     case ROUTE_NODE_TYPE_FADER:
@@ -285,6 +293,8 @@ process_node (
         if (track->type != TRACK_TYPE_TEMPO &&
             track->type != TRACK_TYPE_MARKER)
           {
+            track->processor->playback_latency =
+              node->playback_latency;
             track_processor_process (
               track->processor,
               g_start_frames, local_offset,
@@ -292,6 +302,11 @@ process_node (
           }
       }
       break;
+    case ROUTE_NODE_TYPE_REGION_GROUP:
+      track_processor_process_region_group (
+        node->track->processor, node->region_group,
+        g_start_frames, local_offset, nframes);
+      break;
     case ROUTE_NODE_TYPE_PORT:
       {
         /* decide what to do based on what port it
@@ -335,13 +350,22 @@ process_node (
  */
 void
 graph_node_process (
-  GraphNode * node,
-  nframes_t   nframes)
+  GraphNode *   node,
+  nframes_t     nframes,
+  GraphThread * thread)
 {
   g_return_if_fail (
     node && node->graph && node->graph->router &&
     nframes == node->graph->router->nsamples);
 
+  bool profiling =
+    graph_profiler_is_enabled (node->graph);
+  gint64 start_ns = 0;
+  if (profiling)
+    {
+      start_ns = graph_profiler_get_time_ns ();
+    }
+
   /*g_message (*/
     /*"processing %s", graph_node_get_name (node));*/
 
@@ -443,6 +467,15 @@ graph_node_process (
     }
 
 node_process_finish:
+  if (profiling)
+    {
+      graph_profiler_record_node (
+        &node->stats,
+        thread ? &thread->stats : NULL,
+        node->id, start_ns,
+        graph_profiler_get_time_ns ());
+    }
+
   on_node_finish (node);
 }
 
@@ -465,6 +498,12 @@ graph_node_trigger (
       /* all nodes that feed this node have
        * completed, so this node be processed
        * now. */
+      if (graph_profiler_is_enabled (self->graph))
+        {
+          self->stats.queued_at_ns =
+            graph_profiler_get_time_ns ();
+        }
+
       g_atomic_int_inc (
         &self->graph->trigger_queue_size);
       /*g_message ("triggering node, pushing back");*/
@@ -523,6 +562,7 @@ add_depends (
  * without adding the previous/next latencies.
  *
  * It returns the plugin's latency if plugin,
+ * the latency of the realtime stretcher if track,
  * otherwise 0.
  */
 nframes_t
@@ -535,7 +575,7 @@ graph_node_get_single_playback_latency (
       /* latency is already set at this point */
       return node->pl->latency;
     case ROUTE_NODE_TYPE_TRACK:
-      return 0;
+      return node->track->stretch_latency;
     default:
       break;
     }
@@ -634,6 +674,7 @@ graph_node_new (
         (SampleProcessor *) data;
       break;
     case ROUTE_NODE_TYPE_TRACK:
+    case ROUTE_NODE_TYPE_REGION_GROUP:
       node->track = (Track *) data;
       break;
     case ROUTE_NODE_TYPE_INITIAL_PROCESSOR:
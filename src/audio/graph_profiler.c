@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "audio/graph.h"
+#include "audio/graph_node.h"
+#include "audio/graph_profiler.h"
+#include "audio/graph_thread.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+
+/**
+ * Returns the histogram bin for the given
+ * duration.
+ */
+static inline int
+get_hist_bin (
+  gint64 duration_ns)
+{
+  gint64 usec = duration_ns / 1000;
+  int bin = 0;
+  while (usec > 0 &&
+         bin < GRAPH_PROFILER_NUM_HIST_BINS - 1)
+    {
+      usec >>= 1;
+      bin++;
+    }
+  return bin;
+}
+
+/**
+ * Records a run of a node.
+ *
+ * To be called from the DSP thread that processed
+ * the node.
+ */
+void
+graph_profiler_record_node (
+  GraphNodeStats *   node_stats,
+  GraphThreadStats * thread_stats,
+  int                node_id,
+  gint64             start_ns,
+  gint64             end_ns)
+{
+  gint64 duration = end_ns - start_ns;
+
+  /* node stats */
+  node_stats->last_ns = duration;
+  node_stats->total_ns += duration;
+  if (duration > node_stats->max_ns)
+    node_stats->max_ns = duration;
+  node_stats->hist[get_hist_bin (duration)]++;
+  if (node_stats->queued_at_ns > 0 &&
+      node_stats->queued_at_ns <= start_ns)
+    {
+      gint64 queue_wait =
+        start_ns - node_stats->queued_at_ns;
+      node_stats->total_queue_wait_ns += queue_wait;
+      if (queue_wait > node_stats->max_queue_wait_ns)
+        node_stats->max_queue_wait_ns = queue_wait;
+    }
+  node_stats->queued_at_ns = 0;
+  node_stats->num_runs++;
+
+  if (!thread_stats)
+    return;
+
+  /* thread stats */
+  thread_stats->busy_ns += duration;
+  thread_stats->num_nodes++;
+  if (thread_stats->trace)
+    {
+      guint head =
+        (guint)
+        g_atomic_int_get (&thread_stats->trace_head);
+      GraphProfilerTraceEvent * ev =
+        &thread_stats->trace[
+          head % GRAPH_PROFILER_TRACE_SIZE];
+      ev->node_id = node_id;
+      ev->start_ns = start_ns;
+      ev->end_ns = end_ns;
+      g_atomic_int_set (
+        &thread_stats->trace_head, head + 1);
+    }
+}
+
+static void
+reset_thread_stats (
+  GraphThread * thread)
+{
+  if (!thread)
+    return;
+
+  GraphThreadStats * stats = &thread->stats;
+  stats->busy_ns = 0;
+  stats->wait_ns = 0;
+  stats->num_nodes = 0;
+  g_atomic_int_set (&stats->trace_head, 0);
+}
+
+/**
+ * Requests a reset of all node and thread stats.
+ *
+ * The stats are reset by the DSP threads at the
+ * start of the next cycle, so they are never
+ * written concurrently.
+ */
+void
+graph_profiler_reset (
+  Graph * graph)
+{
+  g_atomic_int_set (
+    &graph->profiling_reset_requested, 1);
+}
+
+/**
+ * Resets all node and thread stats if a reset was
+ * requested.
+ *
+ * To be called from the DSP thread that starts a
+ * cycle, while all the worker threads are idle.
+ */
+void
+graph_profiler_reset_if_requested (
+  Graph * graph)
+{
+  if (!g_atomic_int_compare_and_exchange (
+         &graph->profiling_reset_requested, 1, 0))
+    return;
+
+  for (int i = 0; i < graph->n_graph_nodes; i++)
+    {
+      object_set_to_zero (
+        &graph->graph_nodes[i]->stats);
+    }
+  for (int i = 0; i < graph->num_threads; i++)
+    {
+      reset_thread_stats (graph->threads[i]);
+    }
+  reset_thread_stats (graph->main_thread);
+
+  graph->profiling_start_ns =
+    graph_profiler_get_time_ns ();
+}
+
+/**
+ * Enables or disables profiling.
+ *
+ * Stats are reset when enabling.
+ */
+void
+graph_profiler_set_enabled (
+  Graph * graph,
+  bool    enabled)
+{
+  if (enabled)
+    {
+      graph_profiler_reset (graph);
+    }
+
+  g_message (
+    "%s: %s DSP profiling", __func__,
+    enabled ? "enabling" : "disabling");
+
+  g_atomic_int_set (&graph->profiling, enabled);
+}
+
+/**
+ * Returns the given percentile (0 to 100) of the
+ * run durations of the node, estimated from the
+ * histogram as the upper bound of the bin it
+ * falls in.
+ */
+gint64
+graph_profiler_get_percentile_ns (
+  const GraphNodeStats * stats,
+  double                 percentile)
+{
+  guint64 total = 0;
+  for (int i = 0; i < GRAPH_PROFILER_NUM_HIST_BINS;
+       i++)
+    {
+      total += stats->hist[i];
+    }
+  if (total == 0)
+    return 0;
+
+  guint64 target =
+    (guint64)
+    ceil (
+      (CLAMP (percentile, 0.0, 100.0) / 100.0) *
+        (double) total);
+  target = MAX (target, 1);
+  guint64 count = 0;
+  for (int i = 0; i < GRAPH_PROFILER_NUM_HIST_BINS;
+       i++)
+    {
+      count += stats->hist[i];
+      if (count < target)
+        continue;
+
+      /* the last bin has no upper bound */
+      if (i == GRAPH_PROFILER_NUM_HIST_BINS - 1)
+        return stats->max_ns;
+
+      gint64 upper_ns = ((gint64) 1 << i) * 1000;
+      return MIN (upper_ns, stats->max_ns);
+    }
+
+  return stats->max_ns;
+}
+
+/**
+ * Returns the average DSP load of the node as a
+ * percentage of the time available per cycle.
+ */
+double
+graph_profiler_get_node_dsp_load (
+  GraphNode *   node,
+  nframes_t     block_length,
+  sample_rate_t sample_rate)
+{
+  GraphNodeStats * stats = &node->stats;
+  if (stats->num_runs == 0 || sample_rate == 0)
+    return 0.0;
+
+  double ns_per_cycle =
+    ((double) block_length * 1000000000.0) /
+      (double) sample_rate;
+  double avg_ns =
+    (double) stats->total_ns /
+      (double) stats->num_runs;
+
+  return (avg_ns * 100.0) / ns_per_cycle;
+}
+
+/**
+ * Returns the utilization of the given thread (0.0
+ * to 1.0) since the last reset.
+ *
+ * @param thread_idx The thread index, or -1 for
+ *   the main thread.
+ */
+double
+graph_profiler_get_thread_utilization (
+  Graph * graph,
+  int     thread_idx)
+{
+  GraphThread * thread =
+    thread_idx < 0 ?
+      graph->main_thread :
+      graph->threads[thread_idx];
+  g_return_val_if_fail (thread, 0.0);
+
+  gint64 elapsed =
+    graph_profiler_get_time_ns () -
+      graph->profiling_start_ns;
+  if (elapsed <= 0)
+    return 0.0;
+
+  return
+    CLAMP (
+      (double) thread->stats.busy_ns /
+        (double) elapsed,
+      0.0, 1.0);
+}
+
+static GraphNode *
+find_node (
+  Graph * graph,
+  int     id)
+{
+  if (id >= 0 && id < graph->n_graph_nodes &&
+      graph->graph_nodes[id]->id == id)
+    {
+      return graph->graph_nodes[id];
+    }
+
+  for (int i = 0; i < graph->n_graph_nodes; i++)
+    {
+      if (graph->graph_nodes[i]->id == id)
+        return graph->graph_nodes[i];
+    }
+
+  return NULL;
+}
+
+static void
+append_thread_events (
+  Graph *       graph,
+  GraphThread * thread,
+  GString *     str,
+  bool *        first)
+{
+  if (!thread || !thread->stats.trace)
+    return;
+
+  GraphThreadStats * stats = &thread->stats;
+  guint head =
+    (guint)
+    g_atomic_int_get (&stats->trace_head);
+  guint start =
+    head > GRAPH_PROFILER_TRACE_SIZE ?
+      head - GRAPH_PROFILER_TRACE_SIZE : 0;
+  for (guint i = start; i < head; i++)
+    {
+      GraphProfilerTraceEvent * ev =
+        &stats->trace[i % GRAPH_PROFILER_TRACE_SIZE];
+      if (ev->end_ns < ev->start_ns ||
+          ev->start_ns < graph->profiling_start_ns)
+        continue;
+
+      GraphNode * node = find_node (graph, ev->node_id);
+      if (!node)
+        continue;
+
+      char * name = graph_node_get_name (node);
+      char * escaped = g_strescape (name, NULL);
+      g_string_append_printf (
+        str,
+        "%s\n{\"name\":\"%s\",\"cat\":\"dsp\","
+        "\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+        "\"ts\":%.3f,\"dur\":%.3f}",
+        *first ? "" : ",",
+        escaped, thread->id,
+        (double)
+        (ev->start_ns - graph->profiling_start_ns) /
+          1000.0,
+        (double) (ev->end_ns - ev->start_ns) /
+          1000.0);
+      *first = false;
+      g_free (escaped);
+      g_free (name);
+    }
+}
+
+/**
+ * Exports the recorded trace events as a Chrome
+ * trace JSON file (viewable in chrome://tracing
+ * or Perfetto).
+ *
+ * @note Must be called from the GTK thread.
+ *
+ * @return Whether successful.
+ */
+bool
+graph_profiler_export_chrome_trace (
+  Graph *      graph,
+  const char * filepath,
+  GError **    error)
+{
+  g_return_val_if_fail (graph && filepath, false);
+
+  GString * str =
+    g_string_new ("{\"traceEvents\":[");
+  bool first = true;
+  for (int i = 0; i < graph->num_threads; i++)
+    {
+      append_thread_events (
+        graph, graph->threads[i], str, &first);
+    }
+  append_thread_events (
+    graph, graph->main_thread, str, &first);
+  g_string_append (
+    str, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+  char * content = g_string_free (str, false);
+  bool ret =
+    g_file_set_contents (
+      filepath, content, -1, error);
+  g_free (content);
+
+  g_message (
+    "%s: exported DSP trace to %s (%s)",
+    __func__, filepath, ret ? "ok" : "failed");
+
+  return ret;
+}
@@ -159,7 +159,19 @@ worker_thread (void * arg)
                 graph->num_threads);
             }
 
-          zix_sem_wait (&graph->trigger);
+          if (graph_profiler_is_enabled (graph))
+            {
+              gint64 wait_start =
+                graph_profiler_get_time_ns ();
+              zix_sem_wait (&graph->trigger);
+              thread->stats.wait_ns +=
+                graph_profiler_get_time_ns () -
+                  wait_start;
+            }
+          else
+            {
+              zix_sem_wait (&graph->trigger);
+            }
 
           if (g_atomic_int_get (&graph->terminate))
             {
@@ -191,7 +203,7 @@ worker_thread (void * arg)
       g_message ("[%d]: running node", thread->id);
 #endif
       graph_node_process (
-        to_run, graph->router->nsamples);
+        to_run, graph->router->nsamples, thread);
 
     }
 
@@ -272,6 +284,10 @@ graph_thread_new (
 
   self->id = id;
   self->graph = graph;
+  self->stats.trace =
+    calloc (
+      GRAPH_PROFILER_TRACE_SIZE,
+      sizeof (GraphProfilerTraceEvent));
 
 #ifdef HAVE_JACK
   if (AUDIO_ENGINE->audio_backend ==
@@ -310,3 +326,17 @@ graph_thread_new (
 
   return self;
 }
+
+/**
+ * Frees the thread.
+ *
+ * The thread must be joined first.
+ */
+void
+graph_thread_free (
+  GraphThread * self)
+{
+  free (self->stats.trace);
+
+  object_zero_and_free (self);
+}
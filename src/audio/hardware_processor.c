@@ -18,6 +18,7 @@
  */
 
 #include "audio/engine.h"
+#include "audio/engine_alsa.h"
 #include "audio/ext_port.h"
 #include "audio/hardware_processor.h"
 #include "audio/midi_event.h"
@@ -479,6 +480,13 @@ hardware_processor_process (
             port, 0, nframes);
           break;
 #endif
+#ifdef HAVE_ALSA
+        case AUDIO_BACKEND_ALSA:
+          engine_alsa_read_capture (
+            AUDIO_ENGINE, ext_port->alsa_channel_idx,
+            port->buf, nframes);
+          break;
+#endif
 #ifdef HAVE_RTAUDIO
         case AUDIO_BACKEND_ALSA_RTAUDIO:
         case AUDIO_BACKEND_JACK_RTAUDIO:
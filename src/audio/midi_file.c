@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2020 Alexandros Theodotou <alex at zrythm dot org>
+ * Copyright (C) 2020-2021 Alexandros Theodotou <alex at zrythm dot org>
  *
  * This file is part of Zrythm
  *
@@ -17,7 +17,11 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+
 #include "audio/midi_file.h"
+#include "utils/arrays.h"
+#include "utils/objects.h"
 
 #include <ext/midilib/src/midifile.h>
 
@@ -39,3 +43,237 @@ midi_file_get_num_tracks (
 
   return num;
 }
+
+/**
+ * Shared state of the threads parsing the tracks.
+ */
+typedef struct ParseJob
+{
+  const MIDI_FILE * mf;
+  MidiFile *        self;
+
+  /** Ticks per MIDI file PPQN tick. */
+  double            ticks_ratio;
+
+  /** Next track index to parse. */
+  volatile gint     next_track;
+} ParseJob;
+
+/**
+ * Ends the first unended note with the given
+ * pitch.
+ */
+static void
+end_note (
+  MidiFileTrack * track,
+  int *           unended,
+  int *           num_unended,
+  int             pitch,
+  double          ticks)
+{
+  for (int i = 0; i < *num_unended; i++)
+    {
+      MidiFileNote * note = &track->notes[unended[i]];
+      if (note->pitch != pitch)
+        continue;
+
+      note->end_ticks = ticks;
+      (*num_unended)--;
+      for (int j = i; j < *num_unended; j++)
+        {
+          unended[j] = unended[j + 1];
+        }
+      return;
+    }
+
+  g_message (
+    "Found a Note off event without a "
+    "corresponding Note on. Skipping...");
+}
+
+static void
+parse_track (
+  const ParseJob * job,
+  int              idx)
+{
+  MidiFileTrack * track = &job->self->tracks[idx];
+  track->end_ticks = -1.0;
+
+  /* indices of notes without a note off yet */
+  int * unended = NULL;
+  int num_unended = 0;
+  size_t unended_size = 0;
+
+  MIDI_MSG msg;
+  midiReadInitMessage (&msg);
+  while (midiReadGetNextMessage (job->mf, idx, &msg))
+    {
+      double ticks =
+        (double) msg.dwAbsPos * job->ticks_ratio;
+      int ev =
+        msg.bImpliedMsg ? msg.iImpliedMsg : msg.iType;
+
+      switch (ev)
+        {
+        case msgNoteOff:
+          end_note (
+            track, unended, &num_unended,
+            msg.MsgData.NoteOff.iNote, ticks);
+          break;
+        case msgNoteOn:
+          {
+            array_double_size_if_full (
+              track->notes, track->num_notes,
+              track->notes_size, MidiFileNote);
+            MidiFileNote * note =
+              &track->notes[track->num_notes];
+            note->start_ticks = ticks;
+            /* until a note off is found */
+            note->end_ticks = ticks + 1.0;
+            note->pitch =
+              (uint8_t) msg.MsgData.NoteOn.iNote;
+            note->vel =
+              (uint8_t) msg.MsgData.NoteOn.iVolume;
+
+            array_double_size_if_full (
+              unended, num_unended, unended_size,
+              int);
+            unended[num_unended++] =
+              track->num_notes;
+            track->num_notes++;
+          }
+          break;
+        case msgMetaEvent:
+          switch (msg.MsgData.MetaEvent.iType)
+            {
+            case metaTrackName:
+              if (!track->name && msg.iMsgSize > 3)
+                {
+                  track->name =
+                    g_strndup (
+                      (char *)
+                      msg.MsgData.MetaEvent.Data.Text.
+                        pData,
+                      msg.iMsgSize - 3);
+                }
+              break;
+            case metaEndSequence:
+              track->end_ticks = ticks;
+              break;
+            default:
+              break;
+            }
+          break;
+        default:
+          break;
+        }
+    }
+
+  midiReadFreeMessage (&msg);
+  free (unended);
+}
+
+static gpointer
+parse_worker (
+  gpointer data)
+{
+  ParseJob * job = (ParseJob *) data;
+
+  while (true)
+    {
+      int idx =
+        g_atomic_int_add (&job->next_track, 1);
+      if (idx >= job->self->num_tracks)
+        break;
+
+      parse_track (job, idx);
+    }
+
+  return NULL;
+}
+
+/**
+ * Parses the given MIDI file.
+ *
+ * @param transport_ppqn PPQN to convert the
+ *   positions to.
+ *
+ * @return The parsed file, or NULL if the file
+ *   could not be read.
+ */
+MidiFile *
+midi_file_new (
+  const char * abs_path,
+  double       transport_ppqn)
+{
+  MIDI_FILE * mf = midiFileOpen (abs_path);
+  g_return_val_if_fail (mf, NULL);
+
+  MidiFile * self = object_new (MidiFile);
+  self->num_tracks = midiReadGetNumTracks (mf);
+  self->tracks =
+    calloc (
+      (size_t) MAX (self->num_tracks, 1),
+      sizeof (MidiFileTrack));
+
+  ParseJob job = {
+    .mf = mf,
+    .self = self,
+    .ticks_ratio =
+      transport_ppqn /
+        (double) midiFileGetPPQN (mf),
+    .next_track = 0,
+  };
+
+  /* tracks are independent, so parse them in
+   * parallel (midilib keeps the read state per
+   * track) */
+  int num_threads =
+    MIN (
+      self->num_tracks,
+      (int) g_get_num_processors ());
+  if (num_threads > 1)
+    {
+      GThread ** threads =
+        calloc (
+          (size_t) num_threads, sizeof (GThread *));
+      for (int i = 0; i < num_threads; i++)
+        {
+          threads[i] =
+            g_thread_new (
+              "midi_file_parse", parse_worker, &job);
+        }
+      for (int i = 0; i < num_threads; i++)
+        {
+          g_thread_join (threads[i]);
+        }
+      free (threads);
+    }
+  else
+    {
+      parse_worker (&job);
+    }
+
+  midiFileClose (mf);
+
+  g_message (
+    "%s: parsed %d tracks from %s",
+    __func__, self->num_tracks, abs_path);
+
+  return self;
+}
+
+void
+midi_file_free (
+  MidiFile * self)
+{
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      MidiFileTrack * track = &self->tracks[i];
+      g_free (track->name);
+      free (track->notes);
+    }
+  free (self->tracks);
+
+  object_zero_and_free (self);
+}
@@ -23,9 +23,141 @@
 #include "gui/backend/event_manager.h"
 #include "project.h"
 #include "utils/arrays.h"
+#include "utils/object_utils.h"
 #include "utils/objects.h"
 #include "zrythm_app.h"
 
+static inline uint16_t
+get_table_key (
+  const midi_byte_t * buf)
+{
+  return (uint16_t) ((buf[0] << 8) | buf[1]);
+}
+
+/**
+ * Returns the index of the bucket for the given
+ * key, or of the empty bucket where it would be
+ * inserted.
+ */
+static inline int
+find_bucket (
+  const MidiMappingTable * table,
+  uint16_t                 key)
+{
+  int mask = table->num_buckets - 1;
+  int idx =
+    (int)
+    (((uint32_t) key * 2654435761u) >>
+       table->shift) & mask;
+  while (table->buckets[idx].num_targets > 0 &&
+         table->buckets[idx].key != key)
+    {
+      idx = (idx + 1) & mask;
+    }
+  return idx;
+}
+
+static void
+midi_mapping_table_free (
+  MidiMappingTable * self)
+{
+  g_free (self->buckets);
+  g_free (self->targets);
+
+  object_zero_and_free (self);
+}
+
+static MidiMappingTable *
+midi_mapping_table_new (
+  MidiMappings * self)
+{
+  MidiMappingTable * table =
+    object_new (MidiMappingTable);
+
+  int num_buckets = 16;
+  int bits = 4;
+  while (num_buckets < self->num_mappings * 2)
+    {
+      num_buckets *= 2;
+      bits++;
+    }
+  g_warn_if_fail (
+    num_buckets <= MIDI_MAPPING_TABLE_MAX_BUCKETS);
+  table->num_buckets = num_buckets;
+  table->shift = 32 - bits;
+  table->buckets =
+    g_new0 (MidiMappingTableBucket, num_buckets);
+
+  /* count the mappings of each key */
+  for (int i = 0; i < self->num_mappings; i++)
+    {
+      uint16_t key =
+        get_table_key (self->mappings[i].key);
+      MidiMappingTableBucket * bucket =
+        &table->buckets[find_bucket (table, key)];
+      bucket->key = key;
+      bucket->num_targets++;
+    }
+
+  /* assign each bucket its range of targets */
+  int * fill = g_new0 (int, num_buckets);
+  for (int i = 0; i < num_buckets; i++)
+    {
+      MidiMappingTableBucket * bucket =
+        &table->buckets[i];
+      if (bucket->num_targets == 0)
+        continue;
+
+      bucket->first_target = table->num_targets;
+      table->num_targets += bucket->num_targets;
+    }
+
+  /* fill in the mapping indices in order */
+  table->targets =
+    g_new (int, MAX (table->num_targets, 1));
+  for (int i = 0; i < self->num_mappings; i++)
+    {
+      int idx =
+        find_bucket (
+          table,
+          get_table_key (self->mappings[i].key));
+      MidiMappingTableBucket * bucket =
+        &table->buckets[idx];
+      table->targets[
+        bucket->first_target + fill[idx]++] = i;
+    }
+  g_free (fill);
+
+  return table;
+}
+
+/**
+ * Rebuilds the lookup table used by the DSP
+ * thread.
+ *
+ * Must be called whenever mappings are added,
+ * removed or moved.
+ */
+static void
+rebuild_table (
+  MidiMappings * self)
+{
+  MidiMappingTable * table =
+    midi_mapping_table_new (self);
+
+  MidiMappingTable * old_table =
+    g_atomic_pointer_get (&self->table);
+  g_atomic_pointer_set (&self->table, table);
+
+  /* the old table may still be in use by the DSP
+   * thread in the current cycle */
+  if (old_table)
+    {
+      free_later (
+        old_table, midi_mapping_table_free);
+    }
+}
+
 /**
  * Initializes the MidiMappings after a Project
  * is loaded.
@@ -41,6 +173,8 @@ midi_mappings_init_loaded (
         port_find_from_identifier (
           &mapping->dest_id);
     }
+
+  rebuild_table (self);
 }
 
 static void
@@ -82,7 +216,8 @@ midi_mappings_bind_at (
   bool           fire_events)
 {
   g_return_if_fail (
-    self && buf && dest_port);
+    self && buf && dest_port &&
+    self->num_mappings < MIDI_MAPPINGS_MAX);
 
   for (int i = self->num_mappings; i > idx; i--)
     {
@@ -103,6 +238,8 @@ midi_mappings_bind_at (
   g_atomic_int_set (
     &mapping->enabled, (guint) true);
 
+  rebuild_table (self);
+
   char str[100];
   midi_ctrl_change_get_ch_and_description (
     buf, str);
@@ -141,6 +278,8 @@ midi_mappings_unbind (
     }
   self->num_mappings--;
 
+  rebuild_table (self);
+
   if (fire_events && ZRYTHM_HAVE_UI)
     {
       EVENTS_PUSH (ET_MIDI_BINDINGS_CHANGED, NULL);
@@ -169,6 +308,35 @@ midi_mapping_get_index (
   g_return_val_if_reached (-1);
 }
 
+/**
+ * Applies the value to the mappings in the given
+ * bucket.
+ */
+static void
+apply_bucket (
+  MidiMappings *                 self,
+  const MidiMappingTable *       table,
+  const MidiMappingTableBucket * bucket,
+  midi_byte_t                    value)
+{
+  float normalized_val = (float) value / 127.f;
+  for (int i = 0; i < bucket->num_targets; i++)
+    {
+      MidiMapping * mapping =
+        &self->mappings[
+          table->targets[bucket->first_target + i]];
+      if (!g_atomic_int_get (&mapping->enabled))
+        continue;
+
+      g_return_if_fail (mapping->dest);
+      port_set_control_value (
+        mapping->dest,
+        control_port_normalized_val_to_real (
+          mapping->dest, normalized_val),
+        false, true);
+    }
+}
+
 /**
  * Applies the given buffer to the matching ports.
  */
@@ -177,23 +345,87 @@ midi_mappings_apply (
   MidiMappings * self,
   midi_byte_t *  buf)
 {
-  for (int i = 0; i < self->num_mappings; i++)
+  MidiMappingTable * table =
+    (MidiMappingTable *)
+    g_atomic_pointer_get (&self->table);
+  if (!table)
+    return;
+
+  MidiMappingTableBucket * bucket =
+    &table->buckets[
+      find_bucket (table, get_table_key (buf))];
+  if (bucket->num_targets > 0)
     {
-      MidiMapping * mapping = &self->mappings[i];
+      apply_bucket (self, table, bucket, buf[2]);
+    }
+}
 
-      if (g_atomic_int_get (&mapping->enabled) &&
-          mapping->key[0] == buf[0] &&
-          mapping->key[1] == buf[1])
-        {
-          g_return_if_fail (mapping->dest);
-          float normalized_val =
-            (float) buf[2] / 127.f;
-          port_set_control_value (
-            mapping->dest,
-            control_port_normalized_val_to_real (
-              mapping->dest, normalized_val),
-            false, true);
-        }
+/**
+ * Applies the given events to the matching ports.
+ *
+ * Only the last value of each key is applied, so
+ * dense CC streams cause one control change per
+ * mapping per cycle.
+ *
+ * Realtime-safe.
+ */
+void
+midi_mappings_apply_from_events (
+  MidiMappings * self,
+  MidiEvents *   events)
+{
+  MidiMappingTable * table =
+    (MidiMappingTable *)
+    g_atomic_pointer_get (&self->table);
+  if (!table || table->num_targets == 0 ||
+      events->num_events == 0)
+    return;
+
+  /* find the last event of each key, walking
+   * backwards */
+  guint64 seen_buckets[
+    MIDI_MAPPING_TABLE_MAX_BUCKETS / 64];
+  guint64 is_last[(MAX_MIDI_EVENTS + 63) / 64];
+  memset (
+    seen_buckets, 0,
+    (size_t) ((table->num_buckets + 63) / 64) *
+      sizeof (guint64));
+  memset (
+    is_last, 0,
+    (size_t) ((events->num_events + 63) / 64) *
+      sizeof (guint64));
+  for (int i = events->num_events - 1; i >= 0; i--)
+    {
+      midi_byte_t * buf =
+        events->events[i].raw_buffer;
+      int idx =
+        find_bucket (table, get_table_key (buf));
+      if (table->buckets[idx].num_targets == 0)
+        continue;
+
+      guint64 bit = (guint64) 1 << (idx % 64);
+      if (seen_buckets[idx / 64] & bit)
+        continue;
+
+      seen_buckets[idx / 64] |= bit;
+      is_last[i / 64] |= (guint64) 1 << (i % 64);
+    }
+
+  /* apply them in order, so that if several keys
+   * are mapped to the same port the last one
+   * wins */
+  for (int i = 0; i < events->num_events; i++)
+    {
+      if (!(is_last[i / 64] & ((guint64) 1 << (i % 64))))
+        continue;
+
+      midi_byte_t * buf =
+        events->events[i].raw_buffer;
+      apply_bucket (
+        self, table,
+        &table->buckets[
+          find_bucket (table, get_table_key (buf))],
+        buf[2]);
     }
 }
 
@@ -218,6 +450,8 @@ midi_mappings_free (
         ext_port_free,
         self->mappings[i].device_port);
     }
+  object_free_w_func_and_null (
+    midi_mapping_table_free, self->table);
 
   object_zero_and_free (self);
 }
@@ -40,6 +40,7 @@
 #include "audio/channel.h"
 #include "audio/exporter.h"
 #include "audio/midi_event.h"
+#include "audio/midi_file.h"
 #include "audio/midi_note.h"
 #include "audio/midi_region.h"
 #include "audio/region.h"
@@ -382,45 +383,35 @@ midi_region_remove_midi_note (
 }
 
 /**
- * Creates a MIDI region from the given MIDI
- * file path, starting at the given Position.
+ * Creates a MIDI region from a track of a parsed
+ * MIDI file, starting at the given Position.
  *
- * @param idx The index of this track, starting from
- *   0. This will be sequential, ie, if idx 1 is
- *   requested and the MIDI file only has tracks
- *   5 and 7, it will use track 7.
+ * The notes are added in bulk.
+ *
+ * @return The region, or NULL if the track is
+ *   empty.
  */
 ZRegion *
-midi_region_new_from_midi_file (
-  const Position * start_pos,
-  const char *     abs_path,
-  int              track_pos,
-  int              lane_pos,
-  int              idx_inside_lane,
-  int              idx)
+midi_region_new_from_midi_file_track (
+  const Position *      start_pos,
+  const MidiFileTrack * track_data,
+  int                   track_pos,
+  int                   lane_pos,
+  int                   idx_inside_lane)
 {
-  g_message (
-    "%s: reading from %s...", __func__, abs_path);
+  /* an end-of-track at the start means an empty
+   * track */
+  if (math_doubles_equal (
+        track_data->end_ticks,
+        start_pos->total_ticks))
+    {
+      return NULL;
+    }
 
   ZRegion * self = object_new (ZRegion);
 
   self->id.type = REGION_TYPE_MIDI;
 
-  MIDI_FILE * mf =
-    midiFileOpen (abs_path);
-  g_return_val_if_fail (mf, NULL);
-
-  bool print_details = false;
-
-  char str[128];
-  int ev;
-  MIDI_MSG msg;
-  int i, iNum;
-  unsigned int j;
-  Position pos;
-  MidiNote * mn;
-  double ticks;
-
   Position end_pos;
   position_from_ticks (
     &end_pos, start_pos->total_ticks + 1);
@@ -428,343 +419,102 @@ midi_region_new_from_midi_file (
     self, start_pos, &end_pos, track_pos,
     lane_pos, idx_inside_lane);
 
-  midiReadInitMessage (&msg);
-  iNum = midiReadGetNumTracks(mf);
-  double ppqn = (double) midiFileGetPPQN (mf);
-  double transport_ppqn =
-    transport_get_ppqn (TRANSPORT);
+  if (track_data->name)
+    {
+      region_set_name (
+        self, track_data->name, 0);
+    }
 
-  for(i = 0; i < iNum; i++)
+  /* add all the notes at once */
+  self->midi_notes_size =
+    (size_t) MAX (track_data->num_notes, 1);
+  self->midi_notes =
+    realloc (
+      self->midi_notes,
+      self->midi_notes_size * sizeof (MidiNote *));
+  Position pos, note_end_pos;
+  for (int i = 0; i < track_data->num_notes; i++)
     {
-      if (i != idx)
-        continue;
+      const MidiFileNote * note =
+        &track_data->notes[i];
+      position_from_ticks (
+        &pos, note->start_ticks);
+      position_from_ticks (
+        &note_end_pos, note->end_ticks);
+      MidiNote * mn =
+        midi_note_new (
+          &self->id, &pos, &note_end_pos,
+          note->pitch, note->vel);
+      midi_note_set_region_and_index (mn, self, i);
+      self->midi_notes[i] = mn;
+    }
+  self->num_midi_notes = track_data->num_notes;
 
-      g_message (
-        "%s: reading MIDI Track %d", __func__, i);
-      while(midiReadGetNextMessage (mf, i, &msg))
+  if (track_data->end_ticks >= 0.0)
+    {
+      position_from_ticks (
+        &pos, track_data->end_ticks);
+      arranger_object_end_pos_setter (
+        (ArrangerObject *) self,  &pos);
+      arranger_object_loop_end_pos_setter (
+        (ArrangerObject *) self,  &pos);
+
+      if (ZRYTHM_HAVE_UI &&
+          pos.bars > TRANSPORT->total_bars - 8)
         {
-          /* convert time to zrythm time */
-          ticks =
-            ((double) msg.dwAbsPos * transport_ppqn) /
-            ppqn;
-          position_from_ticks (&pos, ticks);
-          if (print_details)
-            {
-              g_message (
-                "dwAbsPos: %d ", msg.dwAbsPos);
-            }
-          position_print (&pos);
+          transport_update_total_bars (
+            TRANSPORT, pos.bars + 8,
+            F_PUBLISH_EVENTS);
+        }
+    }
 
-          if (ZRYTHM_HAVE_UI &&
-              pos.bars > TRANSPORT->total_bars -8)
-            {
-              transport_update_total_bars (
-                TRANSPORT, pos.bars + 8,
-                F_PUBLISH_EVENTS);
-            }
+  g_message (
+    "%s: created region with %d notes",
+    __func__, self->num_midi_notes);
 
-          if (msg.bImpliedMsg)
-            {
-              ev = msg.iImpliedMsg;
-            }
-          else
-            {
-              ev = msg.iType;
-            }
+  return self;
+}
 
-          if (muGetMIDIMsgName (str, ev) &&
-              print_details)
-            {
-              g_message("MIDI msg name: %s", str);
-            }
-          switch(ev)
-            {
-            case msgNoteOff:
-              if (print_details)
-                {
-                  g_message (
-                    "Note off at %d "
-                    "[ch %d pitch %d]",
-                    msg.dwAbsPos,
-                    msg.MsgData.NoteOff.iChannel,
-                    msg.MsgData.NoteOff.iNote);
-                }
-              mn =
-                midi_region_pop_unended_note (
-                  self, msg.MsgData.NoteOff.iNote);
-              if (mn)
-                {
-                  arranger_object_end_pos_setter (
-                    (ArrangerObject *) mn,  &pos);
-                }
-              else
-                {
-                  g_message (
-                    "Found a Note off event without "
-                    "a corresponding Note on. "
-                    "Skipping...");
-                }
-              break;
-            case msgNoteOn:
-              if (print_details)
-                {
-                  g_message (
-                    "Note on at %d "
-                    "[ch %d pitch %d vel %d]",
-                    msg.dwAbsPos,
-                    msg.MsgData.NoteOn.iChannel,
-                    msg.MsgData.NoteOn.iNote,
-                    msg.MsgData.NoteOn.iVolume);
-                }
-              midi_region_start_unended_note (
-                self, &pos, NULL,
-                msg.MsgData.NoteOn.iNote,
-                msg.MsgData.NoteOn.iVolume, 0);
-              break;
-            case  msgNoteKeyPressure:
-              muGetNameFromNote (
-                str,
-                msg.MsgData.NoteKeyPressure.iNote);
-              if (print_details)
-                {
-                  g_message (
-                    "(%.2d) %s %d",
-                    msg.MsgData.NoteKeyPressure.
-                      iChannel,
-                    str,
-                    msg.MsgData.NoteKeyPressure.
-                      iPressure);
-                }
-              break;
-            case  msgSetParameter:
-              muGetControlName (
-                str,
-                msg.MsgData.NoteParameter.iControl);
-              if (print_details)
-                {
-                  g_message (
-                    "(%.2d) %s -> %d",
-                    msg.MsgData.NoteParameter.iChannel,
-                    str,
-                    msg.MsgData.NoteParameter.iParam);
-                }
-              break;
-            case  msgSetProgram:
-              muGetInstrumentName (
-                str,
-                msg.MsgData.ChangeProgram.iProgram);
-              if (print_details)
-                {
-                  g_message (
-                    "(%.2d) %s",
-                    msg.MsgData.ChangeProgram.iChannel,
-                    str);
-                }
-              break;
-            case msgChangePressure:
-              muGetControlName (
-                str,
-                msg.MsgData.ChangePressure.
-                  iPressure);
-              if (print_details)
-                {
-                  g_message (
-                    "(%.2d) %s",
-                    msg.MsgData.ChangePressure.iChannel,
-                    str);
-                }
-              break;
-            case msgSetPitchWheel:
-              if (print_details)
-                {
-                  g_message (
-                    "(%.2d) %d",
-                    msg.MsgData.PitchWheel.iChannel,
-                    msg.MsgData.PitchWheel.iPitch);
-                }
-              break;
-            case msgMetaEvent:
-              if (print_details)
-                {
-                  g_message ("---- meta events");
-                }
-              switch(msg.MsgData.MetaEvent.iType)
-                {
-                case metaMIDIPort:
-                  if (print_details)
-                    {
-                      g_message (
-                        "MIDI Port = %d",
-                        msg.MsgData.MetaEvent.Data.
-                          iMIDIPort);
-                    }
-                  break;
-                case metaSequenceNumber:
-                  if (print_details)
-                    {
-                      g_message (
-                        "Sequence Number = %d",
-                        msg.MsgData.MetaEvent.Data.
-                          iSequenceNumber);
-                    }
-                  break;
-                case  metaTextEvent:
-                  if (print_details)
-                    {
-                      g_message (
-                        "Text = '%s'",
-                        msg.MsgData.MetaEvent.Data.Text.
-                          pData);
-                    }
-                  break;
-                case  metaCopyright:
-                  if (print_details)
-                    {
-                      g_message (
-                        "Copyright = '%s'",
-                        msg.MsgData.MetaEvent.Data.Text.
-                          pData);
-                    }
-                  break;
-                case  metaTrackName:
-                  {
-                    char tmp[6000];
-                    strncpy (
-                      tmp,
-                      (char *) msg.MsgData.MetaEvent.Data.
-                        Text.pData,
-                      msg.iMsgSize - 3);
-                    tmp[msg.iMsgSize - 3] = '\0';
-                    region_set_name (
-                      self, tmp, 0);
-                    g_warn_if_fail (self->name);
-                    g_message (
-                      "[data sz %d] Track name = '%s'",
-                      msg.iMsgSize - 3, self->name);
-                  }
-                  break;
-                case  metaInstrument:
-                  g_message (
-                    "Instrument = '%s'",
-                    msg.MsgData.MetaEvent.Data.Text.
-                      pData);
-                  break;
-                case  metaLyric:
-                  g_message (
-                    "Lyric = '%s'",
-                    msg.MsgData.MetaEvent.
-                      Data.Text.pData);
-                  break;
-                case  metaMarker:
-                  g_message (
-                    "Marker = '%s'",
-                    msg.MsgData.MetaEvent.
-                      Data.Text.pData);
-                  break;
-                case  metaCuePoint:
-                  g_message (
-                    "Cue point = '%s'",
-                    msg.MsgData.MetaEvent.
-                      Data.Text.pData);
-                  break;
-                case  metaEndSequence:
-                  g_message ("End Sequence");
-                  if (position_is_equal (
-                        &pos, start_pos))
-                    {
-                       /* this is an empty track,
-                        * so return NULL
-                       * instead */
-                      return NULL;
-                    }
-                  arranger_object_end_pos_setter (
-                    (ArrangerObject *) self,  &pos);
-                  arranger_object_loop_end_pos_setter (
-                    (ArrangerObject *) self,  &pos);
-                  break;
-                case  metaSetTempo:
-                  g_message (
-                    "tempo %d",
-                    msg.MsgData.MetaEvent.Data.
-                      Tempo.iBPM);
-                  break;
-                case  metaSMPTEOffset:
-                  g_message (
-                    "SMPTE offset = %d:%d:%d.%d %d",
-                    msg.MsgData.MetaEvent.Data.
-                      SMPTE.iHours,
-                    msg.MsgData.MetaEvent.Data.
-                      SMPTE.iMins,
-                    msg.MsgData.MetaEvent.Data.
-                      SMPTE.iSecs,
-                    msg.MsgData.MetaEvent.Data.
-                      SMPTE.iFrames,
-                    msg.MsgData.MetaEvent.Data.
-                      SMPTE.iFF);
-                  break;
-                case metaTimeSig:
-                  g_message (
-                    "Time sig = %d/%d",
-                    msg.MsgData.MetaEvent.Data.
-                      TimeSig.iNom,
-                    msg.MsgData.MetaEvent.Data.
-                      TimeSig.iDenom /
-                      MIDI_NOTE_CROCHET);
-                  break;
-                case metaKeySig:
-                  if (muGetKeySigName (
-                        str,
-                        msg.MsgData.MetaEvent.
-                          Data.KeySig.iKey))
-                    g_message("Key sig = %s", str);
-                  break;
-                case  metaSequencerSpecific:
-                  g_message("Sequencer specific = ");
-                  /*HexList(msg.MsgData.MetaEvent.Data.Sequencer.pData, msg.MsgData.MetaEvent.Data.Sequencer.iSize);*/
-                  break;
-                }
-              break;
+/**
+ * Creates a MIDI region from the given MIDI
+ * file path, starting at the given Position.
+ *
+ * @note When creating regions from multiple tracks
+ *   of the same file, parse the file once with
+ *   midi_file_new() and use
+ *   midi_region_new_from_midi_file_track()
+ *   instead.
+ *
+ * @param idx The index of this track, starting from
+ *   0. This will be sequential, ie, if idx 1 is
+ *   requested and the MIDI file only has tracks
+ *   5 and 7, it will use track 7.
+ */
+ZRegion *
+midi_region_new_from_midi_file (
+  const Position * start_pos,
+  const char *     abs_path,
+  int              track_pos,
+  int              lane_pos,
+  int              idx_inside_lane,
+  int              idx)
+{
+  g_message (
+    "%s: reading from %s...", __func__, abs_path);
 
-            case msgSysEx1:
-            case msgSysEx2:
-              g_message("Sysex = ");
-              /*HexList(msg.MsgData.SysEx.pData, msg.MsgData.SysEx.iSize);*/
-              break;
-            }
+  MidiFile * mf =
+    midi_file_new (
+      abs_path, transport_get_ppqn (TRANSPORT));
+  g_return_val_if_fail (mf, NULL);
+  g_return_val_if_fail (
+    idx >= 0 && idx < mf->num_tracks, NULL);
 
-          /* print the hex */
-          if (ev == msgSysEx1 ||
-              (ev==msgMetaEvent &&
-               msg.MsgData.MetaEvent.iType ==
-                 metaSequencerSpecific))
-            {
-            /* Already done a hex dump */
-            }
-          else if (print_details)
-            {
-              char txt[600];
-              char tmp[100];
-              strcpy (txt, "[");
-              if (msg.bImpliedMsg)
-                {
-                  sprintf (
-                    tmp, "%.2x!", msg.iImpliedMsg);
-                  strcat (txt, tmp);
-                }
-              for (j = 0; j < msg.iMsgSize; j++)
-                {
-                  sprintf(
-                    tmp, " %.2x ", msg.data[j]);
-                  strcat (txt, tmp);
-                }
-              strcat (txt, "]");
-              g_message ("%s", txt);
-            }
-        }
-    }
+  ZRegion * self =
+    midi_region_new_from_midi_file_track (
+      start_pos, &mf->tracks[idx], track_pos,
+      lane_pos, idx_inside_lane);
 
-  midiReadFreeMessage (&msg);
-  midiFileClose (mf);
+  midi_file_free (mf);
 
   g_message ("%s: done", __func__);
 
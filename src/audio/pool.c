@@ -19,29 +19,603 @@
 
 #include <stdlib.h>
 
+#include "actions/undo_manager.h"
 #include "audio/clip.h"
+#include "audio/encoder.h"
 #include "audio/pool.h"
+#include "audio/stretch_cache.h"
 #include "audio/track.h"
+#include "audio/tracklist.h"
+#include "audio/transport.h"
+#include "gui/backend/event.h"
+#include "gui/backend/event_manager.h"
+#include "project.h"
+#include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/audio.h"
+#include "utils/dsp.h"
+#include "utils/flags.h"
 #include "utils/io.h"
+#include "utils/math.h"
+#include "utils/object_utils.h"
 #include "utils/objects.h"
 #include "utils/string.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
 
 #include <gtk/gtk.h>
+#include <glib/gi18n.h>
+
+/**
+ * Where a clip reference comes from.
+ */
+typedef enum ClipRefType
+{
+  /** A region in the arrangement or a frozen
+   * track. */
+  CLIP_REF_ARRANGEMENT,
+
+  /** An action in the undo/redo history. */
+  CLIP_REF_UNDO,
+
+  /** An action about to be performed or undone
+   * (the clip is loaded). */
+  CLIP_REF_LOAD,
+} ClipRefType;
+
+/**
+ * Returns the size of the frames of the clip in
+ * memory.
+ */
+static size_t
+get_clip_size (
+  AudioClip * clip)
+{
+  /* interleaved frames + channel caches */
+  return
+    2 * (size_t) clip->num_frames *
+    (size_t) clip->channels * sizeof (float);
+}
+
+static bool
+clip_is_loaded (
+  AudioClip * clip)
+{
+  return clip->frames && clip->num_frames > 0;
+}
+
+static size_t
+get_memory_budget (void)
+{
+  unsigned int mib =
+    ZRYTHM_TESTING ?
+      AUDIO_POOL_DEFAULT_MEMORY_BUDGET :
+      g_settings_get_uint (
+        S_P_PROJECTS_GENERAL,
+        "pool-memory-budget");
+  return (size_t) mib * 1024 * 1024;
+}
+
+/**
+ * Returns the clip with the given ID, or NULL if
+ * it doesn't exist.
+ */
+static AudioClip *
+find_clip (
+  AudioPool * self,
+  int         pool_id)
+{
+  if (pool_id < 0)
+    return NULL;
+
+  /* the ID is normally the index */
+  if (pool_id < self->num_clips &&
+      self->clips[pool_id]->pool_id == pool_id)
+    return self->clips[pool_id];
+
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      if (self->clips[i]->pool_id == pool_id)
+        return self->clips[i];
+    }
+
+  return NULL;
+}
+
+static void
+add_ref (
+  AudioPool * self,
+  int         pool_id,
+  ClipRefType type)
+{
+  AudioClip * clip = find_clip (self, pool_id);
+  if (!clip)
+    return;
+
+  switch (type)
+    {
+    case CLIP_REF_ARRANGEMENT:
+      clip->num_refs++;
+      break;
+    case CLIP_REF_UNDO:
+      clip->num_undo_refs++;
+      break;
+    case CLIP_REF_LOAD:
+      if (!clip->decoding && !clip_is_loaded (clip))
+        {
+          g_message (
+            "reloading clip %s", clip->name);
+          audio_clip_init_loaded (clip);
+        }
+      clip->last_used = g_get_monotonic_time ();
+      break;
+    }
+}
+
+static void
+add_region_ref (
+  AudioPool * self,
+  ZRegion *   r,
+  ClipRefType type)
+{
+  if (!r || r->id.type != REGION_TYPE_AUDIO)
+    return;
+
+  add_ref (self, r->pool_id, type);
+}
+
+static void
+add_track_refs (
+  AudioPool * self,
+  Track *     track,
+  ClipRefType type)
+{
+  if (!track)
+    return;
+
+  if (track->frozen)
+    {
+      add_ref (self, track->pool_id, type);
+    }
+
+  if (track->type != TRACK_TYPE_AUDIO)
+    return;
+
+  for (int i = 0; i < track->num_lanes; i++)
+    {
+      TrackLane * lane = track->lanes[i];
+      for (int j = 0; j < lane->num_regions; j++)
+        {
+          add_region_ref (
+            self, lane->regions[j], type);
+        }
+    }
+}
+
+static void
+add_selections_refs (
+  AudioPool *          self,
+  ArrangerSelections * sel,
+  ClipRefType          type)
+{
+  if (!sel)
+    return;
+
+  switch (sel->type)
+    {
+    case ARRANGER_SELECTIONS_TYPE_TIMELINE:
+      {
+        TimelineSelections * ts =
+          (TimelineSelections *) sel;
+        for (int i = 0; i < ts->num_regions; i++)
+          {
+            add_region_ref (
+              self, ts->regions[i], type);
+          }
+      }
+      break;
+    case ARRANGER_SELECTIONS_TYPE_AUDIO:
+      add_ref (
+        self, ((AudioSelections *) sel)->pool_id,
+        type);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+add_tracklist_selections_refs (
+  AudioPool *           self,
+  TracklistSelections * tls,
+  ClipRefType           type)
+{
+  if (!tls)
+    return;
+
+  for (int i = 0; i < tls->num_tracks; i++)
+    {
+      add_track_refs (self, tls->tracks[i], type);
+    }
+}
+
+/**
+ * Adds references to the clips used by the given
+ * action.
+ */
+static void
+add_action_refs (
+  AudioPool *      self,
+  UndoableAction * action,
+  ClipRefType      type)
+{
+  switch (action->type)
+    {
+    case UA_ARRANGER_SELECTIONS:
+      {
+        ArrangerSelectionsAction * a =
+          (ArrangerSelectionsAction *) action;
+        add_selections_refs (self, a->sel, type);
+        add_selections_refs (
+          self, a->sel_after, type);
+        for (int i = 0; i < a->num_split_objs; i++)
+          {
+            ArrangerObject * objs[] = {
+              a->r1[i], a->r2[i] };
+            for (int j = 0; j < 2; j++)
+              {
+                if (objs[j] &&
+                    objs[j]->type ==
+                      ARRANGER_OBJECT_TYPE_REGION)
+                  {
+                    add_region_ref (
+                      self, (ZRegion *) objs[j],
+                      type);
+                  }
+              }
+          }
+        add_region_ref (
+          self, a->region_before, type);
+        add_region_ref (
+          self, a->region_after, type);
+      }
+      break;
+    case UA_TRACKLIST_SELECTIONS:
+      {
+        TracklistSelectionsAction * a =
+          (TracklistSelectionsAction *) action;
+        add_tracklist_selections_refs (
+          self, a->tls_before, type);
+        add_tracklist_selections_refs (
+          self, a->tls_after, type);
+        add_ref (self, a->pool_id, type);
+      }
+      break;
+    case UA_RANGE:
+      {
+        RangeAction * a = (RangeAction *) action;
+        add_selections_refs (
+          self, (ArrangerSelections *) a->sel_before,
+          type);
+        add_selections_refs (
+          self, (ArrangerSelections *) a->sel_after,
+          type);
+      }
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+add_undo_stack_refs (
+  AudioPool * self,
+  UndoStack * stack)
+{
+  if (!stack)
+    return;
+
+  for (size_t i = 0; i < stack->num_as_actions; i++)
+    {
+      add_action_refs (
+        self, (UndoableAction *) stack->as_actions[i],
+        CLIP_REF_UNDO);
+    }
+  for (size_t i = 0;
+       i < stack->num_tracklist_selections_actions;
+       i++)
+    {
+      add_action_refs (
+        self,
+        (UndoableAction *)
+        stack->tracklist_selections_actions[i],
+        CLIP_REF_UNDO);
+    }
+  for (size_t i = 0; i < stack->num_range_actions;
+       i++)
+    {
+      add_action_refs (
+        self,
+        (UndoableAction *) stack->range_actions[i],
+        CLIP_REF_UNDO);
+    }
+}
+
+/**
+ * Recounts the references to each clip.
+ */
+static void
+update_refs (
+  AudioPool * self)
+{
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      self->clips[i]->num_refs = 0;
+      self->clips[i]->num_undo_refs = 0;
+    }
+
+  if (TRACKLIST)
+    {
+      for (int i = 0; i < TRACKLIST->num_tracks; i++)
+        {
+          add_track_refs (
+            self, TRACKLIST->tracks[i],
+            CLIP_REF_ARRANGEMENT);
+        }
+    }
+
+  if (UNDO_MANAGER)
+    {
+      add_undo_stack_refs (
+        self, UNDO_MANAGER->undo_stack);
+      add_undo_stack_refs (
+        self, UNDO_MANAGER->redo_stack);
+    }
+}
+
+/**
+ * Frees the frames of the clip, making sure it
+ * can be reloaded from the pool first.
+ */
+static void
+unload_clip (
+  AudioClip * clip)
+{
+  char * path = audio_clip_get_path_in_pool (clip);
+  if (!g_file_test (path, G_FILE_TEST_EXISTS))
+    {
+      audio_clip_write_to_pool (clip, false);
+    }
+  g_free (path);
+
+  g_message (
+    "unloading clip %s (%d undo refs)",
+    clip->name, clip->num_undo_refs);
+
+  clip->num_frames = 0;
+  free (clip->frames);
+  clip->frames = NULL;
+  for (unsigned int i = 0; i < clip->channels; i++)
+    {
+      object_zero_and_free (clip->ch_frames[i]);
+    }
+}
+
+/**
+ * Sorts unreferenced clips first, then the least
+ * recently used ones.
+ */
+static int
+cmp_clip_eviction_order (
+  const void * _a,
+  const void * _b)
+{
+  AudioClip * a = *(AudioClip * const *) _a;
+  AudioClip * b = *(AudioClip * const *) _b;
+  bool a_unref = a->num_undo_refs == 0;
+  bool b_unref = b->num_undo_refs == 0;
+  if (a_unref != b_unref)
+    return a_unref ? -1 : 1;
+
+  if (a->last_used != b->last_used)
+    return a->last_used < b->last_used ? -1 : 1;
+
+  return a->pool_id - b->pool_id;
+}
+
+typedef struct ClipLoadOrder
+{
+  AudioClip * clip;
+
+  /** Distance of the closest region using the
+   * clip from the playhead, in ticks. */
+  double      distance;
+} ClipLoadOrder;
+
+static int
+cmp_clip_load_order (
+  const void * _a,
+  const void * _b)
+{
+  const ClipLoadOrder * a =
+    (const ClipLoadOrder *) _a;
+  const ClipLoadOrder * b =
+    (const ClipLoadOrder *) _b;
+  if (a->distance != b->distance)
+    return a->distance < b->distance ? -1 : 1;
+
+  /* keep the pool order otherwise */
+  return a->clip->pool_id - b->clip->pool_id;
+}
+
+/**
+ * Fills in the distance of each clip from the
+ * playhead, based on the regions using it.
+ *
+ * Clips not used by any region go last.
+ */
+static void
+get_clip_distances (
+  AudioPool *     self,
+  ClipLoadOrder * order)
+{
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      order[i].clip = self->clips[i];
+      order[i].distance = G_MAXDOUBLE;
+    }
+
+  if (!TRACKLIST || !TRANSPORT)
+    return;
+
+  double playhead = PLAYHEAD->total_ticks;
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (track->type != TRACK_TYPE_AUDIO)
+        continue;
+
+      for (int j = 0; j < track->num_lanes; j++)
+        {
+          TrackLane * lane = track->lanes[j];
+          for (int k = 0; k < lane->num_regions; k++)
+            {
+              ZRegion * r = lane->regions[k];
+              ArrangerObject * r_obj =
+                (ArrangerObject *) r;
+              double start = r_obj->pos.total_ticks;
+              double end = r_obj->end_pos.total_ticks;
+              double distance = 0.0;
+              if (playhead < start)
+                distance = start - playhead;
+              else if (playhead > end)
+                distance = playhead - end;
+
+              for (int l = 0; l < self->num_clips; l++)
+                {
+                  if (order[l].clip->pool_id ==
+                        r->pool_id)
+                    {
+                      order[l].distance =
+                        MIN (
+                          order[l].distance,
+                          distance);
+                      break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Decodes the clip.
+ *
+ * Runs in a worker thread.
+ */
+static void
+load_clip (
+  AudioClip *   clip,
+  GAsyncQueue * loaded_queue)
+{
+  audio_clip_init_loaded (clip);
+  g_async_queue_push (loaded_queue, clip);
+}
 
 /**
  * Inits after loading a project.
+ *
+ * The clips are decoded in parallel, starting
+ * from the ones used closest to the playhead, and
+ * this returns when all of them are loaded.
+ *
+ * Clips not used in the arrangement are loaded
+ * when needed (see
+ * audio_pool_load_clips_for_action()).
  */
 void
 audio_pool_init_loaded (
   AudioPool * self)
 {
   self->clips_size = (size_t) self->num_clips;
+  self->memory_budget = get_memory_budget ();
+  if (self->num_clips == 0)
+    return;
 
-  for (int i = 0; i < self->num_clips; i++)
+  ClipLoadOrder * order =
+    g_new (ClipLoadOrder, (gsize) self->num_clips);
+  get_clip_distances (self, order);
+  qsort (
+    order, (size_t) self->num_clips,
+    sizeof (ClipLoadOrder), cmp_clip_load_order);
+
+  /* clips only used in the undo history are
+   * loaded when needed */
+  int num_to_load = self->num_clips;
+  if (TRACKLIST)
+    {
+      update_refs (self);
+      num_to_load = 0;
+      for (int i = 0; i < self->num_clips; i++)
+        {
+          if (order[i].clip->num_refs > 0)
+            {
+              order[num_to_load++] = order[i];
+            }
+        }
+    }
+
+  GAsyncQueue * loaded_queue = g_async_queue_new ();
+  GError * err = NULL;
+  GThreadPool * thread_pool =
+    g_thread_pool_new (
+      (GFunc) load_clip, loaded_queue,
+      CLAMP (
+        audio_get_num_cores (), 1,
+        AUDIO_POOL_MAX_DECODE_THREADS),
+      F_NOT_EXCLUSIVE, &err);
+  if (!thread_pool)
     {
-      audio_clip_init_loaded (self->clips[i]);
+      g_warning (
+        "failed to create thread pool, loading "
+        "clips serially: %s", err->message);
+      g_error_free (err);
+      for (int i = 0; i < num_to_load; i++)
+        {
+          audio_clip_init_loaded (order[i].clip);
+        }
     }
+  else
+    {
+      for (int i = 0; i < num_to_load; i++)
+        {
+          g_thread_pool_push (
+            thread_pool, order[i].clip, NULL);
+        }
+
+      /* report progress as clips are loaded */
+      for (int i = 0; i < num_to_load; i++)
+        {
+          AudioClip * clip =
+            (AudioClip *)
+            g_async_queue_pop (loaded_queue);
+          char msg[200];
+          sprintf (
+            msg, _("Loading audio clips (%d/%d)"),
+            i + 1, num_to_load);
+          if (zrythm_app && ZRYTHM)
+            {
+              zrythm_app_set_progress_status (
+                zrythm_app, msg, ZRYTHM->progress);
+            }
+          g_debug ("loaded %s", clip->name);
+        }
+
+      g_thread_pool_free (thread_pool, false, true);
+    }
+
+  g_async_queue_unref (loaded_queue);
+  g_free (order);
 }
 
 /**
@@ -57,6 +631,7 @@ audio_pool_new ()
   self->clips =
     calloc (
       self->clips_size, sizeof (AudioClip *));
+  self->memory_budget = get_memory_budget ();
 
   return self;
 }
@@ -163,6 +738,7 @@ audio_pool_add_clip (
 
   int next_id = get_next_id (self);
   clip->pool_id = next_id;
+  clip->generation = ++self->clip_generation;
 
   array_append (
     self->clips, self->num_clips, clip);
@@ -193,6 +769,532 @@ audio_pool_get_clip (
   g_return_val_if_reached (NULL);
 }
 
+/**
+ * A file being decoded for a placeholder clip.
+ */
+typedef struct DecodeJob
+{
+  /** ID of the placeholder clip in the pool. */
+  int            pool_id;
+
+  /** Generation of the placeholder clip, so that
+   * a clip added later with the same ID is not
+   * mistaken for it (see \ref
+   * AudioClip.generation). */
+  unsigned int   clip_generation;
+
+  AudioEncoder * enc;
+
+  /** Path to write the decoded file to. */
+  char *         pool_path;
+
+  /** Length and format of the placeholder. */
+  long           num_frames;
+  channels_t     channels;
+  int            samplerate;
+
+  /** Decoded interleaved frames, or NULL if
+   * decoding failed. */
+  float *        frames;
+
+  /** Decoded per-channel frames. */
+  float *        ch_frames[16];
+} DecodeJob;
+
+static void
+decode_job_free (
+  DecodeJob * job)
+{
+  if (job->enc)
+    {
+      audio_encoder_free (job->enc);
+    }
+  g_free (job->pool_path);
+  free (job->frames);
+  for (channels_t i = 0; i < job->channels; i++)
+    {
+      free (job->ch_frames[i]);
+    }
+
+  object_zero_and_free (job);
+}
+
+/**
+ * Swaps the decoded frames into the placeholder
+ * clip, if it is still in the pool.
+ */
+static void
+apply_decoded (
+  AudioPool * self,
+  DecodeJob * job)
+{
+  AudioClip * clip = find_clip (self, job->pool_id);
+  if (clip &&
+      clip->generation != job->clip_generation)
+    {
+      clip = NULL;
+    }
+
+  if (!clip)
+    {
+      g_message (
+        "clip for %s was removed while decoding",
+        job->pool_path);
+
+      /* remove the written file unless another
+       * clip uses the same path */
+      for (int i = 0; i < self->num_clips; i++)
+        {
+          char * path =
+            audio_clip_get_path_in_pool (
+              self->clips[i]);
+          bool same =
+            string_is_equal (path, job->pool_path);
+          g_free (path);
+          if (same)
+            return;
+        }
+      io_remove (job->pool_path);
+      return;
+    }
+
+  clip->decoding = false;
+  if (!job->frames)
+    return;
+
+  /* the frames may have been unloaded in the
+   * meantime, in which case they will be loaded
+   * from the written file */
+  if (clip->frames &&
+      clip->num_frames == job->num_frames &&
+      clip->channels == job->channels)
+    {
+      /* the engine might be reading the silent
+       * frames, so swap in the decoded buffers and
+       * free the old ones after the cycle */
+      float * old_frames = clip->frames;
+      g_atomic_pointer_set (
+        &clip->frames, job->frames);
+      job->frames = NULL;
+      free_later (old_frames, free);
+      for (channels_t i = 0; i < clip->channels; i++)
+        {
+          float * old_ch_frames = clip->ch_frames[i];
+          g_atomic_pointer_set (
+            &clip->ch_frames[i], job->ch_frames[i]);
+          job->ch_frames[i] = NULL;
+          free_later (old_ch_frames, free);
+        }
+    }
+
+  /* redraw the regions using the clip */
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (track->type != TRACK_TYPE_AUDIO)
+        continue;
+
+      for (int j = 0; j < track->num_lanes; j++)
+        {
+          TrackLane * lane = track->lanes[j];
+          for (int k = 0; k < lane->num_regions; k++)
+            {
+              ZRegion * r = lane->regions[k];
+              if (r->pool_id == clip->pool_id)
+                {
+                  EVENTS_PUSH (
+                    ET_ARRANGER_OBJECT_CHANGED, r);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Applies the finished decode jobs.
+ */
+static int
+on_decoded (
+  AudioPool * self)
+{
+  DecodeJob * job;
+  while ((job =
+            g_async_queue_try_pop (
+              self->decoded_queue)))
+    {
+      apply_decoded (self, job);
+      decode_job_free (job);
+      self->num_pending_decodes--;
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Decodes the file and writes it to the pool.
+ *
+ * Runs in a worker thread.
+ */
+static void
+decode_job_run (
+  DecodeJob * job,
+  AudioPool * self)
+{
+  AudioEncoder * enc = job->enc;
+  audio_encoder_decode (
+    enc, job->samplerate, F_NO_SHOW_PROGRESS);
+  if (enc->num_out_frames > 0 &&
+      enc->channels == job->channels)
+    {
+      /* match the placeholder length */
+      size_t size =
+        (size_t) job->num_frames *
+          (size_t) job->channels;
+      size_t decoded_size =
+        (size_t)
+        MIN (enc->num_out_frames, job->num_frames) *
+          (size_t) job->channels;
+      job->frames = calloc (size, sizeof (float));
+      dsp_copy (
+        job->frames, enc->out_frames, decoded_size);
+      for (channels_t i = 0; i < job->channels; i++)
+        {
+          job->ch_frames[i] =
+            malloc (
+              (size_t) job->num_frames *
+                sizeof (float));
+          for (long j = 0; j < job->num_frames; j++)
+            {
+              job->ch_frames[i][j] =
+                job->frames[
+                  j * (long) job->channels + i];
+            }
+        }
+
+      audio_write_raw_file (
+        job->frames, 0, job->num_frames,
+        (uint32_t) job->samplerate,
+        job->channels, job->pool_path);
+    }
+  else
+    {
+      g_warning (
+        "Failed to decode %s", enc->file);
+    }
+
+  object_free_w_func_and_null (
+    audio_encoder_free, job->enc);
+
+  g_async_queue_push (self->decoded_queue, job);
+  g_idle_add (
+    (GSourceFunc) on_decoded, self);
+}
+
+/**
+ * Adds a placeholder clip for the given file to
+ * the pool and decodes the file in a worker
+ * thread.
+ *
+ * The placeholder has the final length, so
+ * regions can be created from it immediately. It
+ * is silent until the decoded frames are applied
+ * in the GTK thread, and the decoder writes the
+ * file to the pool.
+ *
+ * @return The ID in the pool, or -1 if the file
+ *   could not be opened.
+ */
+int
+audio_pool_add_clip_from_file_async (
+  AudioPool *  self,
+  const char * path)
+{
+  AudioEncoder * enc = NULL;
+  AudioClip * clip =
+    audio_clip_new_placeholder_from_file (
+      path, &enc);
+  if (!clip)
+    return -1;
+
+  int id = audio_pool_add_clip (self, clip);
+  g_return_val_if_fail (id >= 0, -1);
+
+  if (!self->decode_pool)
+    {
+      self->decoded_queue = g_async_queue_new ();
+      GError * err = NULL;
+      self->decode_pool =
+        g_thread_pool_new (
+          (GFunc) decode_job_run, self,
+          CLAMP (
+            audio_get_num_cores (), 1,
+            AUDIO_POOL_MAX_DECODE_THREADS),
+          F_NOT_EXCLUSIVE, &err);
+      g_return_val_if_fail (
+        self->decode_pool, -1);
+    }
+
+  DecodeJob * job = object_new (DecodeJob);
+  job->pool_id = clip->pool_id;
+  job->clip_generation = clip->generation;
+  job->enc = enc;
+  job->pool_path = audio_clip_get_path_in_pool (clip);
+  job->num_frames = clip->num_frames;
+  job->channels = clip->channels;
+  job->samplerate = clip->samplerate;
+
+  self->num_pending_decodes++;
+  g_thread_pool_push (self->decode_pool, job, NULL);
+
+  return id;
+}
+
+/**
+ * Blocks until all the background decodes are
+ * finished and applies them.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+audio_pool_wait_for_decodes (
+  AudioPool * self)
+{
+  while (self->num_pending_decodes > 0)
+    {
+      DecodeJob * job =
+        g_async_queue_pop (self->decoded_queue);
+      apply_decoded (self, job);
+      decode_job_free (job);
+      self->num_pending_decodes--;
+    }
+}
+
+/**
+ * A clip being stretched for a StretchCache.
+ */
+typedef struct StretchJob
+{
+  /** The cache to publish the result to (a
+   * reference is held). */
+  StretchCache *       cache;
+
+  /** The clip, only used for comparison. */
+  AudioClip *          clip;
+
+  /** Copy of the clip's interleaved frames. */
+  float *              frames;
+  long                 num_frames;
+  channels_t           channels;
+
+  bpm_t                clip_bpm;
+  bpm_t                bpm;
+  unsigned int         tempo_map_version;
+  sample_rate_t        sample_rate;
+
+  /** Generation of the request (see \ref
+   * StretchCache.request_generation). */
+  gint                 generation;
+
+  /** The stretched frames, or NULL if stretching
+   * failed. */
+  StretchCacheFrames * result;
+} StretchJob;
+
+static void
+stretch_job_free (
+  StretchJob * job)
+{
+  stretch_cache_unref (job->cache);
+  free (job->frames);
+  object_free_w_func_and_null (
+    stretch_cache_frames_free, job->result);
+
+  object_zero_and_free (job);
+}
+
+/**
+ * Publishes the stretched frames to the cache if
+ * they are for the latest request.
+ */
+static void
+apply_stretched (
+  StretchJob * job)
+{
+  StretchCache * cache = job->cache;
+
+  /* the region was freed */
+  if (cache->num_refs == 1)
+    return;
+
+  if (!job->result ||
+      job->generation !=
+        g_atomic_int_get (
+          &cache->request_generation))
+    return;
+
+  stretch_cache_set_frames (cache, job->result);
+  job->result = NULL;
+}
+
+/**
+ * Applies the finished stretch jobs.
+ */
+static int
+on_stretched (
+  AudioPool * self)
+{
+  StretchJob * job;
+  while ((job =
+            g_async_queue_try_pop (
+              self->stretched_queue)))
+    {
+      apply_stretched (job);
+      stretch_job_free (job);
+      self->num_pending_stretches--;
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Stretches the copied frames, unless a newer
+ * stretch was requested for the cache.
+ *
+ * Runs in a worker thread.
+ */
+static void
+stretch_job_run (
+  StretchJob * job,
+  AudioPool *  self)
+{
+  /* skip the job if a newer stretch was requested
+   * in the meantime since its result would be
+   * discarded */
+  if (job->generation ==
+        g_atomic_int_get (
+          &job->cache->request_generation))
+    {
+      job->result =
+        stretch_cache_frames_new_stretched (
+          job->frames, job->num_frames,
+          job->channels, job->sample_rate,
+          (double) job->clip_bpm /
+            (double) job->bpm);
+      if (job->result)
+        {
+          job->result->clip = job->clip;
+          job->result->clip_num_frames =
+            job->num_frames;
+          job->result->bpm = job->bpm;
+          job->result->tempo_map_version =
+            job->tempo_map_version;
+        }
+      else
+        {
+          g_warning (
+            "Failed to stretch clip to %f BPM",
+            (double) job->bpm);
+        }
+    }
+
+  /* the copy is no longer needed */
+  free (job->frames);
+  job->frames = NULL;
+
+  g_async_queue_push (self->stretched_queue, job);
+  g_idle_add (
+    (GSourceFunc) on_stretched, self);
+}
+
+/**
+ * Stretches the given clip to the given BPM in a
+ * worker thread and publishes the result to the
+ * given cache in the GTK thread.
+ *
+ * The clip's frames are copied, so the clip can
+ * change while stretching. Jobs superseded by a
+ * newer request for the same cache are skipped
+ * before stretching, and their results are
+ * discarded.
+ *
+ * @param tempo_map_version Version of the tempo
+ *   map the BPM was taken from.
+ */
+void
+audio_pool_stretch_async (
+  AudioPool *    self,
+  StretchCache * cache,
+  AudioClip *    clip,
+  bpm_t          bpm,
+  unsigned int   tempo_map_version)
+{
+  g_return_if_fail (
+    cache && clip && clip->frames &&
+    clip->num_frames > 0);
+
+  if (!self->stretch_pool)
+    {
+      self->stretched_queue = g_async_queue_new ();
+      GError * err = NULL;
+      self->stretch_pool =
+        g_thread_pool_new (
+          (GFunc) stretch_job_run, self,
+          CLAMP (
+            audio_get_num_cores () / 2, 1,
+            AUDIO_POOL_MAX_STRETCH_THREADS),
+          F_NOT_EXCLUSIVE, &err);
+      g_return_if_fail (self->stretch_pool);
+    }
+
+  cache->requested_clip = clip;
+  cache->requested_clip_num_frames =
+    clip->num_frames;
+  cache->requested_bpm = bpm;
+
+  StretchJob * job = object_new (StretchJob);
+  job->generation =
+    g_atomic_int_add (
+      &cache->request_generation, 1) + 1;
+  job->cache = cache;
+  stretch_cache_ref (cache);
+  job->clip = clip;
+  job->num_frames = clip->num_frames;
+  job->channels = clip->channels;
+  size_t num_samples =
+    (size_t) clip->num_frames *
+      (size_t) clip->channels;
+  job->frames =
+    malloc (num_samples * sizeof (float));
+  dsp_copy (job->frames, clip->frames, num_samples);
+  job->clip_bpm = clip->bpm;
+  job->bpm = bpm;
+  job->tempo_map_version = tempo_map_version;
+  job->sample_rate = AUDIO_ENGINE->sample_rate;
+
+  self->num_pending_stretches++;
+  g_thread_pool_push (self->stretch_pool, job, NULL);
+}
+
+/**
+ * Blocks until all the background stretches are
+ * finished and applies them.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+audio_pool_wait_for_stretches (
+  AudioPool * self)
+{
+  while (self->num_pending_stretches > 0)
+    {
+      StretchJob * job =
+        g_async_queue_pop (self->stretched_queue);
+      apply_stretched (job);
+      stretch_job_free (job);
+      self->num_pending_stretches--;
+    }
+}
+
 /**
  * Duplicates the clip with the given ID and returns
  * the duplicate.
@@ -280,6 +1382,14 @@ audio_pool_remove_clip (
  * use in the project from their files and frees the
  * buffers of clips not currently in use.
  *
+ * Clips are reference counted from the regions in
+ * the arrangement, frozen tracks and the undo
+ * history. Clips not used in the arrangement are
+ * unloaded when the total size of their frames
+ * exceeds \ref AudioPool.memory_budget,
+ * unreferenced clips first, then the least
+ * recently used ones.
+ *
  * This should be called whenever there is a relevant
  * change in the project (eg, object added/removed).
  */
@@ -287,30 +1397,167 @@ void
 audio_pool_reload_clip_frame_bufs (
   AudioPool * self)
 {
+  update_refs (self);
+
+  gint64 now = g_get_monotonic_time ();
+  GPtrArray * unused = g_ptr_array_new ();
+  size_t unused_size = 0;
   for (int i = 0; i < self->num_clips; i++)
     {
       AudioClip * clip = self->clips[i];
-      bool in_use = audio_clip_is_in_use (clip);
 
-      if (in_use && clip->num_frames == 0)
+      /* frames are filled in when decoded */
+      if (clip->decoding)
+        continue;
+
+      if (clip->num_refs > 0)
         {
-          /* load from the file */
-          audio_clip_init_loaded (clip);
+          clip->last_used = now;
+          if (!clip_is_loaded (clip))
+            {
+              /* load from the file (this is
+               * normally done before pausing the
+               * engine by
+               * audio_pool_load_clips_for_action()) */
+              g_message (
+                "loading clip %s", clip->name);
+              audio_clip_init_loaded (clip);
+            }
         }
-      else if (!in_use && clip->num_frames > 0)
+      else if (clip_is_loaded (clip))
         {
-          /* unload frames */
-          clip->num_frames = 0;
-          free (clip->frames);
-          clip->frames = NULL;
+          g_ptr_array_add (unused, clip);
+          unused_size += get_clip_size (clip);
         }
     }
+
+  if (unused_size > self->memory_budget)
+    {
+      g_ptr_array_sort (
+        unused, cmp_clip_eviction_order);
+      for (guint i = 0;
+           i < unused->len &&
+             unused_size > self->memory_budget;
+           i++)
+        {
+          AudioClip * clip =
+            (AudioClip *) g_ptr_array_index (
+              unused, i);
+          unused_size -= get_clip_size (clip);
+          unload_clip (clip);
+        }
+    }
+
+  g_ptr_array_free (unused, true);
+}
+
+/**
+ * Loads the frame buffers of the clips referenced
+ * by the given action, so that it can be
+ * performed or undone.
+ *
+ * To be called before pausing the engine for the
+ * action, since decoding can take a while. This
+ * is safe while the engine is running since it
+ * does not use unloaded clips.
+ */
+void
+audio_pool_load_clips_for_action (
+  AudioPool *      self,
+  UndoableAction * action)
+{
+  g_return_if_fail (self && action);
+
+  add_action_refs (self, action, CLIP_REF_LOAD);
+}
+
+/**
+ * Removes files in the pool directory that do not
+ * belong to any clip in the pool.
+ *
+ * To be called when saving the project.
+ */
+void
+audio_pool_remove_orphan_files (
+  AudioPool * self)
+{
+  char * pool_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_POOL, false);
+  if (!g_file_test (pool_dir, G_FILE_TEST_IS_DIR))
+    {
+      g_free (pool_dir);
+      return;
+    }
+
+  GHashTable * clip_paths =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free, NULL);
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      g_hash_table_add (
+        clip_paths,
+        audio_clip_get_path_in_pool (
+          self->clips[i]));
+    }
+
+  char ** files =
+    io_get_files_in_dir_ending_in (
+      pool_dir, F_NO_RECURSIVE, ".wav");
+  for (int i = 0; files[i]; i++)
+    {
+      if (g_hash_table_contains (
+            clip_paths, files[i]))
+        continue;
+
+      g_message (
+        "removing orphan pool file %s", files[i]);
+      io_remove (files[i]);
+    }
+
+  g_strfreev (files);
+  g_hash_table_destroy (clip_paths);
+  g_free (pool_dir);
 }
 
 void
 audio_pool_free (
   AudioPool * self)
 {
+  if (self->decode_pool)
+    {
+      /* finish the decodes and discard the
+       * results */
+      g_thread_pool_free (
+        self->decode_pool, false, true);
+      while (g_source_remove_by_user_data (self));
+      DecodeJob * job;
+      while ((job =
+                g_async_queue_try_pop (
+                  self->decoded_queue)))
+        {
+          decode_job_free (job);
+        }
+      g_async_queue_unref (self->decoded_queue);
+    }
+
+  if (self->stretch_pool)
+    {
+      /* finish the stretches and discard the
+       * results */
+      g_thread_pool_free (
+        self->stretch_pool, false, true);
+      while (g_source_remove_by_user_data (self));
+      StretchJob * job;
+      while ((job =
+                g_async_queue_try_pop (
+                  self->stretched_queue)))
+        {
+          stretch_job_free (job);
+        }
+      g_async_queue_unref (self->stretched_queue);
+    }
+
   for (int i = 0; i < self->num_clips; i++)
     {
       object_free_w_func_and_null (
@@ -27,6 +27,7 @@
 #include "project.h"
 #include "audio/channel.h"
 #include "audio/clip.h"
+#include "audio/control_change_queue.h"
 #include "audio/control_port.h"
 #ifdef HAVE_JACK
 #include "audio/engine_jack.h"
@@ -62,6 +63,10 @@
 
 #define AUDIO_RING_SIZE 65536
 
+/** Max number of source buffers summed in 1 pass
+ * in port_process(). */
+#define MAX_SUM_SRCS 32
+
 /**
  * This function finds the Ports corresponding to
  * the PortIdentifiers for srcs and dests.
@@ -2018,6 +2023,14 @@ port_sum_data_from_rtmidi (
 /**
  * Dequeue the midi events from the ring
  * buffers into \ref RtMidiDevice.events.
+ *
+ * Events are delayed by exactly one cycle: an
+ * event received during the previous cycle is
+ * placed at the same position in the current
+ * cycle, using the engine's delay-locked loop to
+ * convert its time to frames. Events received
+ * after the current cycle started are left for
+ * the next cycle.
  */
 void
 port_prepare_rtmidi_events (
@@ -2028,7 +2041,8 @@ port_prepare_rtmidi_events (
     midi_backend_is_rtmidi (
       AUDIO_ENGINE->midi_backend));
 
-  gint64 cur_time = g_get_monotonic_time ();
+  const DelayLockedLoop * dll = &AUDIO_ENGINE->dll;
+  const nframes_t nframes = dll->nframes;
   for (int i = 0; i < self->num_rtmidi_ins; i++)
     {
       RtMidiDevice * dev = self->rtmidi_ins[i];
@@ -2036,66 +2050,56 @@ port_prepare_rtmidi_events (
       /* clear the events */
       midi_events_clear (dev->events, 0);
 
-      uint32_t read_space = 0;
-      zix_sem_wait (&dev->midi_ring_sem);
-      do
-        {
-          read_space =
-            zix_ring_read_space (dev->midi_ring);
-          if (read_space <= sizeof(MidiEventHeader))
+      MidiEventHeader h = { 0, 0 };
+      while (
+        zix_ring_peek (
+          dev->midi_ring, &h, sizeof (h)) ==
+            sizeof (h))
+        {
+          /* the message may still be being
+           * written */
+          if (zix_ring_read_space (dev->midi_ring) <
+                sizeof (h) + h.size)
+            break;
+
+          double frame =
+            delay_locked_loop_time_to_frames (
+              dll, (gint64) h.time) +
+            (double) nframes;
+          if (frame >= (double) nframes)
             {
-              /* no more events */
+              /* received during this cycle */
               break;
             }
 
-          /* peek the next event header to check
-           * the time */
-          MidiEventHeader h = { 0, 0 };
-          zix_ring_peek (
-            dev->midi_ring, &h, sizeof (h));
-          g_return_if_fail (h.size > 0);
-
-          /* read event header */
-          zix_ring_read (
-            dev->midi_ring, &h, sizeof (h));
-
-          /* read event body */
+          zix_ring_skip (dev->midi_ring, sizeof (h));
           midi_byte_t raw[h.size];
           zix_ring_read (
-            dev->midi_ring, raw, sizeof (raw));
+            dev->midi_ring, raw, (uint32_t) h.size);
 
-          /* calculate event timestamp */
-          gint64 length =
-            cur_time - self->last_midi_dequeue;
+          /* events older than a cycle (eg, after
+           * an xrun) are played immediately */
           midi_time_t ev_time =
-            (midi_time_t)
-            (((double) h.time / (double) length) *
-            (double) AUDIO_ENGINE->block_length);
-
-          if (ev_time >= AUDIO_ENGINE->block_length)
-            {
-              g_warning (
-                "event with invalid time %u "
-                "received. the maximum allowed time "
-                "is %" PRIu32 ". setting it to "
-                "%u...",
-                ev_time,
-                AUDIO_ENGINE->block_length - 1,
-                AUDIO_ENGINE->block_length - 1);
-              ev_time =
-                (midi_byte_t)
-                (AUDIO_ENGINE->block_length - 1);
-            }
+            frame > 0.0 ?
+              (midi_time_t) frame : 0;
 
           midi_events_add_event_from_buf (
             dev->events,
             ev_time, raw, (int) h.size,
             F_NOT_QUEUED);
-        } while (
-            read_space > sizeof (MidiEventHeader));
-      zix_sem_post (&dev->midi_ring_sem);
+        }
+
+      int num_dropped =
+        g_atomic_int_get (&dev->num_dropped);
+      if (num_dropped > 0)
+        {
+          g_atomic_int_add (
+            &dev->num_dropped, - num_dropped);
+          g_warning (
+            "RtMidi: %d events dropped (ring full)",
+            num_dropped);
+        }
     }
-  self->last_midi_dequeue = cur_time;
 }
 #endif // HAVE_RTMIDI
 
@@ -2380,9 +2384,61 @@ send_data_to_windows_mme (
 }
 #endif
 
+/**
+ * Pushes the UI events for a change in the
+ * control value.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+port_push_control_change_events (
+  Port * self)
+{
+  if (self->lv2_port)
+    {
+      /* LV2 UIs are notified by
+       * port_forward_control_change_event() */
+    }
+  else if (
+    self->id.owner_type ==
+      PORT_OWNER_TYPE_PLUGIN)
+    {
+      Plugin * pl = port_get_plugin (self, 1);
+      if (pl)
+        {
+          EVENTS_PUSH (
+            ET_PLUGIN_STATE_CHANGED, pl);
+        }
+    }
+  else if (self->id.owner_type ==
+             PORT_OWNER_TYPE_FADER &&
+           self->id.flags &
+             PORT_FLAG_AMPLITUDE)
+    {
+      Track * track = port_get_track (self, 1);
+      g_return_if_fail (
+        track && track->channel);
+      EVENTS_PUSH (
+        ET_CHANNEL_FADER_VAL_CHANGED,
+        track->channel);
+    }
+  else if (self->id.owner_type ==
+             PORT_OWNER_TYPE_TRACK)
+    {
+      Track * track = port_get_track (self, 1);
+      EVENTS_PUSH (
+        ET_TRACK_STATE_CHANGED, track);
+    }
+}
+
 /**
  * To be called when a control's value changes
  * so that a message can be sent to the UI.
+ *
+ * When called from a thread other than the GTK
+ * thread, the change is passed through
+ * \ref AudioEngine.ctrl_out_queue instead of
+ * pushing events directly.
  */
 static void
 port_forward_control_change_event (
@@ -2396,28 +2452,24 @@ port_forward_control_change_event (
       Lv2Plugin * lv2_plugin = pl->lv2;
       lv2_ui_send_control_val_event_from_plugin_to_ui (
         lv2_plugin, lv2_port);
+      return;
     }
   else if (
     self->id.owner_type ==
       PORT_OWNER_TYPE_PLUGIN)
     {
+#ifdef HAVE_CARLA
       Plugin * pl = port_get_plugin (self, 1);
-      if (pl)
+      if (pl && pl->descr->open_with_carla &&
+          self->carla_param_id >= 0)
         {
-#ifdef HAVE_CARLA
-          if (pl->descr->open_with_carla &&
-              self->carla_param_id >= 0)
-            {
-              g_return_if_fail (pl->carla);
-              carla_native_plugin_set_param_value (
-                pl->carla,
-                (uint32_t) self->carla_param_id,
-                self->control);
-            }
-#endif
-          EVENTS_PUSH (
-            ET_PLUGIN_STATE_CHANGED, pl);
+          g_return_if_fail (pl->carla);
+          carla_native_plugin_set_param_value (
+            pl->carla,
+            (uint32_t) self->carla_param_id,
+            self->control);
         }
+#endif
     }
   else if (self->id.owner_type ==
              PORT_OWNER_TYPE_FADER &&
@@ -2432,16 +2484,23 @@ port_forward_control_change_event (
           track->channel->widget);
       fader_update_volume_and_fader_val (
         track->channel->fader);
-      EVENTS_PUSH (
-        ET_CHANNEL_FADER_VAL_CHANGED,
-        track->channel);
     }
-  else if (self->id.owner_type ==
-             PORT_OWNER_TYPE_TRACK)
+
+  if (!ZRYTHM_HAVE_UI)
+    return;
+
+  if (g_thread_self () == zrythm_app->gtk_thread)
     {
-      Track * track = port_get_track (self, 1);
-      EVENTS_PUSH (
-        ET_TRACK_STATE_CHANGED, track);
+      port_push_control_change_events (self);
+    }
+  else if (AUDIO_ENGINE &&
+           AUDIO_ENGINE->ctrl_out_queue)
+    {
+      /* if the queue is full the UI will catch
+       * up on the next change */
+      control_change_queue_push (
+        AUDIO_ENGINE->ctrl_out_queue, self,
+        self->control, false, false);
     }
 }
 
@@ -2513,6 +2572,41 @@ port_set_control_value (
     }
 }
 
+/**
+ * Sets the given control value at the start of
+ * the next processing cycle, without blocking.
+ *
+ * To be used by the GTK thread for continuous
+ * changes (eg, while dragging a knob). If the
+ * engine is not running, or too many changes are
+ * pending, the value is set immediately.
+ *
+ * @param is_normalized Whether the given value is
+ *   normalized between 0 and 1.
+ * @param forward_event Whether to forward a port
+ *   control change event to the plugin UI.
+ */
+void
+port_queue_control_value (
+  Port *      self,
+  const float val,
+  const bool  is_normalized,
+  const bool  forward_event)
+{
+  if (AUDIO_ENGINE && AUDIO_ENGINE->activated &&
+      g_atomic_int_get (&AUDIO_ENGINE->run) &&
+      AUDIO_ENGINE->ctrl_in_queue &&
+      control_change_queue_push (
+        AUDIO_ENGINE->ctrl_in_queue, self, val,
+        is_normalized, forward_event))
+    {
+      return;
+    }
+
+  port_set_control_value (
+    self, val, is_normalized, forward_event);
+}
+
 /**
  * Gets the given control value from the
  * corresponding underlying structure in the Port.
@@ -2751,12 +2845,8 @@ port_process (
                 }
 
               /* send cc to mapped ports */
-              for (int i = 0; i < events->num_events; i++)
-                {
-                  MidiEvent * ev = &events->events[i];
-                  midi_mappings_apply (
-                    MIDI_MAPPINGS, ev->raw_buffer);
-                }
+              midi_mappings_apply_from_events (
+                MIDI_MAPPINGS, events);
             }
         }
 
@@ -2934,32 +3024,19 @@ port_process (
             }
         }
 
-      for (k = 0; k < port->num_srcs; k++)
+      if (port->num_srcs > 0)
         {
-          src_port = port->srcs[k];
-          int dest_idx =
-            port_get_dest_index (
-              src_port, port);
-          if (!src_port->dest_enabled[dest_idx])
-            continue;
-
           float minf, maxf, depth_range;
           if (port->id.type == TYPE_AUDIO)
             {
               minf = -1.f;
               maxf = 1.f;
             }
-          else if (port->id.type == TYPE_CV)
+          else
             {
               maxf = port->maxf;
               minf = port->minf;
             }
-          else
-            {
-              g_warn_if_reached ();
-              minf = 0.f;
-              maxf = 0.f;
-            }
           depth_range =
             (maxf - minf) / 2.f;
 
@@ -2969,19 +3046,55 @@ port_process (
               maxf = 2.f;
             }
 
-          /* sum the signals */
-          float multiplier =
-            depth_range *
-              src_port->multipliers[
+          /* gather the enabled sources and sum
+           * them in 1 pass, clamping only at the
+           * end */
+          const float * srcs[MAX_SUM_SRCS];
+          float multipliers[MAX_SUM_SRCS];
+          size_t num_gathered = 0;
+          bool flushed = false;
+          for (k = 0; k < port->num_srcs; k++)
+            {
+              src_port = port->srcs[k];
+              int dest_idx =
                 port_get_dest_index (
-                  src_port, port)];
-          dsp_mix2 (
-            &port->buf[local_offset],
-            &src_port->buf[local_offset],
-            1.f, multiplier, nframes);
-          dsp_limit1 (
-            &port->buf[local_offset],
-            minf, maxf, nframes);
+                  src_port, port);
+              if (!src_port->dest_enabled[dest_idx])
+                continue;
+
+              srcs[num_gathered] =
+                &src_port->buf[local_offset];
+              multipliers[num_gathered] =
+                depth_range *
+                  src_port->multipliers[dest_idx];
+              num_gathered++;
+
+              /* flush without clamping if there are
+               * more sources than fit */
+              if (num_gathered == MAX_SUM_SRCS)
+                {
+                  dsp_gather_sum_limit1 (
+                    &port->buf[local_offset],
+                    srcs, multipliers,
+                    num_gathered,
+                    - INFINITY, INFINITY, nframes);
+                  num_gathered = 0;
+                  flushed = true;
+                }
+            }
+          if (num_gathered > 0)
+            {
+              dsp_gather_sum_limit1 (
+                &port->buf[local_offset],
+                srcs, multipliers, num_gathered,
+                minf, maxf, nframes);
+            }
+          else if (flushed)
+            {
+              dsp_limit1 (
+                &port->buf[local_offset],
+                minf, maxf, nframes);
+            }
         }
 
       if (port->id.flow == FLOW_OUTPUT)
@@ -3090,6 +3203,7 @@ port_process (
             g_return_if_fail (
               at == found_at);
           }
+        port->automation_read = false;
         if (at &&
             port->id.flags &
               PORT_FLAG_AUTOMATABLE &&
@@ -3115,6 +3229,7 @@ port_process (
                   port, val, true);
                 port->value_changed_from_reading =
                   true;
+                port->automation_read = true;
               }
           }
 
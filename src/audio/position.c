@@ -22,6 +22,7 @@
 #include "audio/engine.h"
 #include "audio/position.h"
 #include "audio/snap_grid.h"
+#include "audio/tempo_map.h"
 #include "audio/transport.h"
 #include "gui/widgets/arranger.h"
 #include "gui/widgets/bot_dock_edge.h"
@@ -48,6 +49,19 @@ long
 position_to_frames (
   const Position * position)
 {
+  /* use the tempo map if there are tempo
+   * changes */
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  if (tempo_map_has_tempo_changes (tempo_map))
+    {
+      return
+        math_round_double_to_long (
+          tempo_map_ticks_to_frames (
+            tempo_map,
+            position_to_ticks (position)));
+    }
+
   double frames =
     AUDIO_ENGINE->frames_per_tick *
       (position->bars > 0 ?
@@ -266,11 +280,28 @@ position_add_frames (
   const long frames)
 {
   long new_frames = pos->frames + frames;
-  position_set_tick (
-    pos,
-    (double) pos->ticks + pos->sub_tick +
-      ((double) frames /
-        AUDIO_ENGINE->frames_per_tick));
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  if (tempo_map_has_tempo_changes (tempo_map))
+    {
+      double ticks_diff =
+        tempo_map_frames_to_ticks (
+          tempo_map, (double) new_frames) -
+        tempo_map_frames_to_ticks (
+          tempo_map, (double) pos->frames);
+      position_set_tick (
+        pos,
+        (double) pos->ticks + pos->sub_tick +
+          ticks_diff);
+    }
+  else
+    {
+      position_set_tick (
+        pos,
+        (double) pos->ticks + pos->sub_tick +
+          ((double) frames /
+            AUDIO_ENGINE->frames_per_tick));
+    }
   pos->frames = new_frames;
   g_warn_if_fail (
     pos->sub_tick >= 0.0 &&
@@ -377,15 +408,11 @@ closest_snap_point (Position * pos, ///< position
  * Gets the previous snap point.
  *
  * @param pos The position to reference.
- * @param track Track, used when moving things in
- *   the timeline. If keep offset is on and this is
- *   passed, the objects in the track will be taken
- *   into account. If keep offset is on and this is
- *   NULL, all applicable objects will be taken into
- *   account. Not used if keep offset is off.
+ * @param obj_index Index of the objects to snap
+ *   to, or NULL to only snap to the grid.
  * @param region Region, used when moving
  *   things in the editor. Same behavior as @ref
- *   track.
+ *   obj_index.
  * @param sg SnapGrid options.
  * @param prev_snap_point The position to set.
  *
@@ -393,64 +420,30 @@ closest_snap_point (Position * pos, ///< position
  */
 static inline bool
 get_prev_snap_point (
-  const Position * pos,
-  Track *          track,
-  ZRegion *        region,
-  const SnapGrid * sg,
-  Position *       prev_sp)
+  const Position *        pos,
+  const SnapObjectIndex * obj_index,
+  ZRegion *               region,
+  const SnapGrid *        sg,
+  Position *              prev_sp)
 {
-  const Position * snap_point;
-
   bool snapped = false;
   if (sg->snap_to_grid)
     {
-      for (int i = sg->num_snap_points - 1; i >= 0;
-           i--)
-        {
-          snap_point = &sg->snap_points[i];
-          if (position_is_before_or_equal (
-                snap_point, pos))
-            {
-              position_set_to_pos (
-                prev_sp, snap_point);
-              snapped = true;
-              break;
-            }
-        }
+      snapped =
+        snap_grid_get_prev_grid_point (
+          sg, pos, prev_sp);
     }
 
-  if (track)
+  if (obj_index)
     {
-      for (int i = 0; i < track->num_lanes; i++)
+      Position obj_sp;
+      if (snap_object_index_get_prev (
+            obj_index, pos, &obj_sp) &&
+          (!snapped ||
+           position_is_after (&obj_sp, prev_sp)))
         {
-          TrackLane * lane = track->lanes[i];
-          for (int j = 0; j < lane->num_regions;
-               j++)
-            {
-              ZRegion * r = lane->regions[j];
-              ArrangerObject * r_obj =
-                (ArrangerObject *) r;
-              snap_point = &r_obj->pos;
-              if (position_is_before_or_equal (
-                    snap_point, pos) &&
-                  position_is_after (
-                    snap_point, prev_sp))
-                {
-                  position_set_to_pos (
-                    prev_sp, snap_point);
-                  snapped = true;
-                }
-              snap_point = &r_obj->end_pos;
-              if (position_is_before_or_equal (
-                    snap_point, pos) &&
-                  position_is_after (
-                    snap_point, prev_sp))
-                {
-                  position_set_to_pos (
-                    prev_sp, snap_point);
-                  snapped = true;
-                }
-            }
+          position_set_to_pos (prev_sp, &obj_sp);
+          snapped = true;
         }
     }
   else if (region)
@@ -471,15 +464,11 @@ get_prev_snap_point (
  * Get next snap point.
  *
  * @param pos Position to reference.
- * @param track Track, used when moving things in
- *   the timeline. If keep offset is on and this is
- *   passed, the objects in the track will be taken
- *   into account. If keep offset is on and this is
- *   NULL, all applicable objects will be taken into
- *   account. Not used if keep offset is off.
+ * @param obj_index Index of the objects to snap
+ *   to, or NULL to only snap to the grid.
  * @param region Region, used when moving
  *   things in the editor. Same behavior as @ref
- *   track.
+ *   obj_index.
  * @param sg SnapGrid options.
  * @param next_snap_point Position to set.
  *
@@ -487,62 +476,30 @@ get_prev_snap_point (
  */
 static inline bool
 get_next_snap_point (
-  const Position * pos,
-  Track *          track,
-  ZRegion *        region,
-  const SnapGrid * sg,
-  Position *       next_sp)
+  const Position *        pos,
+  const SnapObjectIndex * obj_index,
+  ZRegion *               region,
+  const SnapGrid *        sg,
+  Position *              next_sp)
 {
-  const Position * snap_point;
-
   bool snapped = false;
   if (sg->snap_to_grid)
     {
-      for (int i = 0; i < sg->num_snap_points; i++)
-        {
-          snap_point = &sg->snap_points[i];
-          if (position_is_after (snap_point, pos))
-            {
-              position_set_to_pos (
-                next_sp, snap_point);
-              snapped = true;
-              break;
-            }
-        }
+      snap_grid_get_next_grid_point (
+        sg, pos, next_sp);
+      snapped = true;
     }
 
-  if (track)
+  if (obj_index)
     {
-      for (int i = 0; i < track->num_lanes; i++)
+      Position obj_sp;
+      if (snap_object_index_get_next (
+            obj_index, pos, &obj_sp) &&
+          (!snapped ||
+           position_is_before (&obj_sp, next_sp)))
         {
-          TrackLane * lane = track->lanes[i];
-          for (int j = 0; j < lane->num_regions;
-               j++)
-            {
-              ZRegion * r = lane->regions[j];
-              ArrangerObject * r_obj =
-                (ArrangerObject *) r;
-              snap_point = &r_obj->pos;
-              if (position_is_after (
-                    snap_point, pos) &&
-                  position_is_before (
-                    snap_point, next_sp))
-                {
-                  position_set_to_pos (
-                    next_sp, snap_point);
-                  snapped = true;
-                }
-              snap_point = &r_obj->end_pos;
-              if (position_is_after (
-                    snap_point, pos) &&
-                  position_is_before (
-                    snap_point, next_sp))
-                {
-                  position_set_to_pos (
-                    next_sp, snap_point);
-                  snapped = true;
-                }
-            }
+          position_set_to_pos (next_sp, &obj_sp);
+          snapped = true;
         }
     }
   else if (region)
@@ -566,24 +523,21 @@ get_next_snap_point (
  *   position the drag started at. This is only used
  *   when the "keep offset" setting is on.
  * @param pos Position to edit.
- * @param track Track, used when moving things in
- *   the timeline. If snap to events is on and this is
- *   passed, the objects in the track will be taken
- *   into account. If snap to events is on and this is
- *   NULL, all applicable objects will be taken into
- *   account. Not used if snap to events is off.
+ * @param obj_index Index of the objects to snap
+ *   to, used when moving things in the timeline.
+ *   Not used if snap to events is off.
  * @param region Region, used when moving
  *   things in the editor. Same behavior as @ref
- *   track.
+ *   obj_index.
  * @param sg SnapGrid options.
  */
 void
 position_snap (
-  Position *       start_pos,
-  Position *       pos,
-  Track *          track,
-  ZRegion *        region,
-  const SnapGrid * sg)
+  Position *              start_pos,
+  Position *              pos,
+  const SnapObjectIndex * obj_index,
+  ZRegion *               region,
+  const SnapGrid *        sg)
 {
   /* this should only be called if snap is on.
    * the check should be done before calling */
@@ -592,7 +546,7 @@ position_snap (
   if (!sg->snap_to_events)
     {
       region = NULL;
-      track = NULL;
+      obj_index = NULL;
     }
 
   /* snap to grid without offset */
@@ -602,10 +556,10 @@ position_snap (
       Position prev_sp, next_sp;
       bool prev_snapped =
         get_prev_snap_point (
-          pos, track, region, sg, &prev_sp);
+          pos, obj_index, region, sg, &prev_sp);
       bool next_snapped =
         get_next_snap_point (
-          pos, track, region, sg, &next_sp);
+          pos, obj_index, region, sg, &next_sp);
       Position * closest_sp = NULL;
       if (prev_snapped && next_snapped)
         {
@@ -637,10 +591,10 @@ position_snap (
       Position prev_sp, next_sp;
       bool prev_snapped =
         get_prev_snap_point (
-          pos, track, region, sg, &prev_sp);
+          pos, obj_index, region, sg, &prev_sp);
       bool next_snapped =
         get_next_snap_point (
-          pos, track, region, sg, &next_sp);
+          pos, obj_index, region, sg, &next_sp);
       Position * closest_sp = NULL;
       if (prev_snapped && next_snapped)
         {
@@ -664,7 +618,7 @@ position_snap (
       /* get previous snap point from start pos */
       Position prev_sp_from_start_pos;
       get_prev_snap_point (
-        start_pos, track, region, sg,
+        start_pos, obj_index, region, sg,
         &prev_sp_from_start_pos);
 
       /* get diff from previous snap point */
@@ -693,6 +647,19 @@ position_from_seconds (
   Position * position,
   double secs)
 {
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  if (tempo_map_has_tempo_changes (tempo_map))
+    {
+      position_from_ticks (
+        position,
+        tempo_map_frames_to_ticks (
+          tempo_map,
+          secs *
+            (double) AUDIO_ENGINE->sample_rate));
+      return;
+    }
+
   position_from_ticks (
     position,
     (secs * (double) AUDIO_ENGINE->sample_rate) /
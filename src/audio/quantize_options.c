@@ -25,58 +25,14 @@
 #include "audio/snap_grid.h"
 #include "audio/transport.h"
 #include "project.h"
-#include "utils/algorithms.h"
 
 #include <gtk/gtk.h>
 
-/**
- * Updates snap points.
- */
-void
-quantize_options_update_quantize_points (
-  QuantizeOptions * self)
-{
-  Position tmp, end_pos;
-  position_init (&tmp);
-  position_set_to_bar (
-    &end_pos,
-    TRANSPORT->total_bars + 1);
-  self->num_q_points = 0;
-  position_set_to_pos (
-    &self->q_points[self->num_q_points++],
-    &tmp);
-  long ticks =
-    snap_grid_get_ticks_from_length_and_type (
-      self->note_length,
-      self->note_type);
-  long swing_offset =
-    (long)
-    (((float) self->swing / 100.f) *
-    (float) ticks / 2.f);
-  while (position_is_before (&tmp, &end_pos))
-    {
-      position_add_ticks (
-        &tmp, ticks);
-
-      /* delay every second point by swing */
-      if ((self->num_q_points + 1) % 2 == 0)
-        {
-          position_add_ticks (
-            &tmp, swing_offset);
-        }
-
-      position_set_to_pos (
-        &self->q_points[self->num_q_points++],
-        &tmp);
-    }
-}
-
 void
 quantize_options_init (QuantizeOptions *   self,
                 NoteLength   note_length)
 {
   self->note_length = note_length;
-  self->num_q_points = 0;
   self->note_type = NOTE_TYPE_NORMAL;
   self->amount = 100;
   self->adj_start = 1;
@@ -165,37 +121,80 @@ quantize_options_clone (
   opts->swing = src->swing;
   opts->rand_ticks = src->rand_ticks;
 
-  quantize_options_update_quantize_points (opts);
-
   return opts;
 }
 
-static Position *
-get_prev_point (
-  QuantizeOptions * self,
-  Position *        pos)
+/**
+ * Returns the position of the quantize point with
+ * the given index, in ticks.
+ *
+ * Every second point is delayed by the swing
+ * amount.
+ */
+static inline double
+get_point_ticks (
+  long idx,
+  long ticks,
+  long swing_offset)
 {
-  Position * prev_point = NULL;
-  algorithms_binary_search_nearby (
-    self->q_points, pos, 1, 1,
-    self->num_q_points, Position *,
-    position_compare, &, prev_point, NULL);
-
-  return prev_point;
+  return
+    (double)
+    (idx * ticks + (idx % 2 == 1 ? swing_offset : 0));
 }
 
-static Position *
-get_next_point (
+/**
+ * Gets the quantize points at or before and at or
+ * after the given position.
+ *
+ * @return Whether the points were found.
+ */
+static bool
+get_nearby_points (
   QuantizeOptions * self,
-  Position *        pos)
+  Position *        pos,
+  Position *        prev_point,
+  Position *        next_point)
 {
-  Position * next_point = NULL;
-  algorithms_binary_search_nearby (
-    self->q_points, pos, 0, 1,
-    self->num_q_points, Position *,
-    position_compare, &, next_point, NULL);
+  if (pos->total_ticks < 0.0)
+    return false;
+
+  long ticks =
+    snap_grid_get_ticks_from_length_and_type (
+      self->note_length, self->note_type);
+  g_return_val_if_fail (ticks > 0, false);
+  long swing_offset =
+    (long)
+    (((float) self->swing / 100.f) *
+    (float) ticks / 2.f);
+
+  /* the swing offset is at most half the
+   * interval, so the points around pos are the
+   * point at its interval and one of its
+   * neighbors */
+  long idx =
+    (long) floor (pos->total_ticks / (double) ticks);
+  double idx_ticks =
+    get_point_ticks (idx, ticks, swing_offset);
+  if (idx_ticks <= pos->total_ticks)
+    {
+      position_from_ticks (prev_point, idx_ticks);
+      position_from_ticks (
+        next_point,
+        idx_ticks >= pos->total_ticks ?
+          idx_ticks :
+          get_point_ticks (
+            idx + 1, ticks, swing_offset));
+    }
+  else
+    {
+      position_from_ticks (
+        prev_point,
+        get_point_ticks (
+          idx - 1, ticks, swing_offset));
+      position_from_ticks (next_point, idx_ticks);
+    }
 
-  return next_point;
+  return true;
 }
 
 /**
@@ -214,12 +213,13 @@ quantize_options_quantize_position (
   QuantizeOptions * self,
   Position *        pos)
 {
-  Position * prev_point =
-    get_prev_point (self, pos);
-  Position * next_point =
-    get_next_point (self, pos);
-  g_return_val_if_fail (
-    prev_point && next_point, 0);
+  Position prev_pos, next_pos;
+  bool found =
+    get_nearby_points (
+      self, pos, &prev_pos, &next_pos);
+  g_return_val_if_fail (found, 0);
+  Position * prev_point = &prev_pos;
+  Position * next_point = &next_pos;
 
   const double upper = self->rand_ticks;
   const double lower = - self->rand_ticks;
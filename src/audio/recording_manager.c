@@ -26,6 +26,7 @@
 #include "audio/recording_event.h"
 #include "audio/recording_manager.h"
 #include "audio/track.h"
+#include "audio/tracklist.h"
 #include "audio/transport.h"
 #include "gui/backend/arranger_object.h"
 #include "project.h"
@@ -989,6 +990,7 @@ handle_audio_event (
     r_obj->end_pos.frames - r_obj->pos.frames);
 
   r_obj->fade_out_pos = r_obj->loop_end_pos;
+  track_set_region_index_dirty (tr);
 
   /* handle the samples normally */
   nframes_t cur_local_offset = 0;
@@ -1575,6 +1577,14 @@ recording_manager_process_events (
     }
   /*g_message ("processed %d events", i);*/
 
+  /* update the region indices of the tracks
+   * being recorded */
+  if (PROJECT && TRACKLIST)
+    {
+      tracklist_update_region_indices (
+        TRACKLIST, false);
+    }
+
   return G_SOURCE_CONTINUE;
 }
 
@@ -157,6 +157,16 @@ router_recalc_graph (
       zix_sem_wait (&self->graph_access);
       graph_setup (self->graph, 1, 1);
       zix_sem_post (&self->graph_access);
+
+      /* ports might have been removed */
+      if (AUDIO_ENGINE &&
+          !g_atomic_int_get (&AUDIO_ENGINE->run) &&
+          !g_atomic_int_get (
+            &AUDIO_ENGINE->cycle_running))
+        {
+          engine_flush_control_changes (
+            AUDIO_ENGINE);
+        }
     }
 
   g_message ("done");
@@ -87,30 +87,35 @@ midi_in_cb (
   size_t                message_size,
   RtMidiDevice *        self)
 {
-  zix_sem_wait (&self->midi_ring_sem);
-
-  /* generate timestamp */
-  gint64 cur_time = g_get_monotonic_time ();
-  gint64 ts =
-    cur_time - self->port->last_midi_dequeue;
-  g_return_if_fail (ts >= 0);
-  char portname[900];
-  port_get_full_designation (self->port, portname);
-  g_debug (
-    "[%s] message received of size %zu at %ld",
-    portname, message_size, ts);
-
-  /* add to ring buffer */
+  /* the absolute system time is used instead of
+   * the RtMidi delta so it can be mapped to a
+   * frame using the engine's clock model */
   MidiEventHeader h = {
-    .time = (uint64_t) ts, .size = message_size,
+    .time = (uint64_t) g_get_monotonic_time (),
+    .size = message_size,
   };
+
+  /* only this thread writes, so if there is space
+   * for the whole event now there will still be
+   * space after writing the header */
+  if (message_size == 0)
+    return;
+
+  if (zix_ring_write_space (self->midi_ring) <
+        sizeof (MidiEventHeader) + message_size)
+    {
+      g_atomic_int_inc (&self->num_dropped);
+      return;
+    }
+
+  /* the reader waits until the message is
+   * written after the header */
   zix_ring_write (
     self->midi_ring,
     (uint8_t *) &h, sizeof (MidiEventHeader));
   zix_ring_write (
-    self->midi_ring, message, message_size);
-
-  zix_sem_post (&self->midi_ring_sem);
+    self->midi_ring, message,
+    (uint32_t) message_size);
 }
 
 static bool rtmidi_device_first_run = false;
@@ -234,9 +239,9 @@ rtmidi_device_new (
     zix_ring_new (
       sizeof (uint8_t) * (size_t) MIDI_BUFFER_SIZE);
 
-  self->events = midi_events_new (port);
+  zix_ring_mlock (self->midi_ring);
 
-  zix_sem_init (&self->midi_ring_sem, 1);
+  self->events = midi_events_new (port);
 
   return self;
 }
@@ -361,8 +366,6 @@ rtmidi_device_free (
   if (self->events)
     midi_events_free (self->events);
 
-  zix_sem_destroy (&self->midi_ring_sem);
-
   free (self);
 }
 
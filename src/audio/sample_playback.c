@@ -41,4 +41,29 @@ sample_playback_init (
   self->offset = 0;
   self->channels = channels;
   self->start_offset = start_offset;
+  self->stream = NULL;
+}
+
+/**
+ * Initializes a SamplePlayback with a file
+ * streamed from disk.
+ *
+ * The stream is released by the sample processor
+ * when the playback is removed.
+ */
+void
+sample_playback_init_with_stream (
+  SamplePlayback * self,
+  SampleStream *   stream,
+  float            vol,
+  nframes_t        start_offset)
+{
+  g_return_if_fail (stream);
+  self->buf = NULL;
+  self->buf_size = 0;
+  self->volume = vol;
+  self->offset = 0;
+  self->channels = 2;
+  self->start_offset = start_offset;
+  self->stream = stream;
 }
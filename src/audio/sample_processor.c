@@ -21,15 +21,28 @@
 #include "audio/metronome.h"
 #include "audio/port.h"
 #include "audio/sample_processor.h"
+#include "audio/sample_stream.h"
 #include "project.h"
+#include "utils/mpmc_queue.h"
 #include "utils/objects.h"
 
 #include <glib/gi18n.h>
 
+static void
+init_common (
+  SampleProcessor * self)
+{
+  self->stream_queue = mpmc_queue_new ();
+  mpmc_queue_reserve (
+    self->stream_queue,
+    SAMPLE_PROCESSOR_MAX_QUEUED_STREAMS);
+}
+
 void
 sample_processor_init_loaded (
   SampleProcessor * self)
 {
+  init_common (self);
 }
 
 /**
@@ -50,9 +63,68 @@ sample_processor_new (void)
     IS_PORT (self->stereo_out->l) &&
     IS_PORT (self->stereo_out->r));
 
+  init_common (self);
+
   return self;
 }
 
+/**
+ * Releases the file streams currently playing and
+ * removes their playbacks.
+ */
+static void
+stop_streams (
+  SampleProcessor * self)
+{
+  for (int i = self->num_current_samples - 1;
+       i >= 0; i--)
+    {
+      SamplePlayback * sp =
+        &self->current_samples[i];
+      if (sp->stream)
+        {
+          sample_processor_remove_sample_playback (
+            self, sp);
+        }
+    }
+}
+
+/**
+ * Starts playing the file streams queued from
+ * other threads.
+ */
+static void
+dequeue_streams (
+  SampleProcessor * self)
+{
+  SampleStream * stream;
+  while (
+    mpmc_queue_dequeue (
+      self->stream_queue, (void **) &stream))
+    {
+      /* only one file is auditioned at a time */
+      stop_streams (self);
+
+      if (self->num_current_samples >=
+            SAMPLE_PROCESSOR_MAX_SAMPLES)
+        {
+          sample_stream_release (stream);
+          continue;
+        }
+
+      sample_playback_init_with_stream (
+        &self->current_samples[
+          self->num_current_samples++],
+        stream, 1.f, 0);
+    }
+
+  if (g_atomic_int_compare_and_exchange (
+        &self->stop_streams, 1, 0))
+    {
+      stop_streams (self);
+    }
+}
+
 /**
  * Clears the buffers.
  */
@@ -63,10 +135,15 @@ sample_processor_prepare_process (
 {
   port_clear_buffer (self->stereo_out->l);
   port_clear_buffer (self->stereo_out->r);
+
+  dequeue_streams (self);
 }
 
 /**
  * Removes a SamplePlayback from the array.
+ *
+ * If the playback is streaming a file, the stream
+ * is released.
  */
 void
 sample_processor_remove_sample_playback (
@@ -81,23 +158,65 @@ sample_processor_remove_sample_playback (
       if (in_sp != sp)
         continue;
 
+      if (sp->stream)
+        {
+          sample_stream_release (sp->stream);
+          sp->stream = NULL;
+        }
+
       for (j = i; j < self->num_current_samples - 1;
            j++)
         {
           sp = &self->current_samples[j];
           next_sp = &self->current_samples[j + 1];
-
-          sp->buf = next_sp->buf;
-          sp->buf_size = next_sp->buf_size;
-          sp->offset = next_sp->offset;
-          sp->volume = next_sp->volume;
-          sp->start_offset = next_sp->start_offset;
+          *sp = *next_sp;
         }
       break;
     }
   self->num_current_samples--;
 }
 
+/**
+ * Adds the next frames of a streamed file to the
+ * given buffers.
+ *
+ * @return Whether the whole file was played.
+ */
+static bool
+process_stream (
+  SamplePlayback * sp,
+  float *          l,
+  float *          r,
+  const nframes_t  cycle_offset,
+  const nframes_t  nframes)
+{
+  nframes_t start;
+  if (sp->offset > 0)
+    {
+      start = cycle_offset;
+    }
+  else if (sp->start_offset >= cycle_offset &&
+           sp->start_offset < cycle_offset + nframes)
+    {
+      start = sp->start_offset;
+    }
+  else
+    {
+      return false;
+    }
+
+  /* frames that are not decoded yet are skipped
+   * (silence) rather than waited for */
+  nframes_t read =
+    sample_stream_read (
+      sp->stream, &l[start], &r[start],
+      (cycle_offset + nframes) - start,
+      sp->volume);
+  sp->offset += (long) read;
+
+  return sample_stream_is_finished (sp->stream);
+}
+
 
 /**
  * Process the samples for the given number of
@@ -117,7 +236,8 @@ sample_processor_process (
   SamplePlayback * sp;
   g_return_if_fail (
     self && self->stereo_out &&
-    self->num_current_samples < 256 &&
+    self->num_current_samples <=
+      SAMPLE_PROCESSOR_MAX_SAMPLES &&
     self->stereo_out->l &&
     self->stereo_out->l->buf &&
     self->stereo_out->r &&
@@ -130,6 +250,17 @@ sample_processor_process (
       sp = &self->current_samples[i];
       g_return_if_fail (sp->channels > 0);
 
+      if (sp->stream)
+        {
+          if (process_stream (
+                sp, l, r, cycle_offset, nframes))
+            {
+              sample_processor_remove_sample_playback (
+                self, sp);
+            }
+          continue;
+        }
+
       /* if sample is already playing */
       if (sp->offset > 0)
         {
@@ -234,7 +365,9 @@ sample_processor_queue_metronome (
   nframes_t         offset)
 {
   g_return_if_fail (
-    METRONOME->emphasis && METRONOME->normal);
+    METRONOME->emphasis && METRONOME->normal &&
+    self->num_current_samples <
+      SAMPLE_PROCESSOR_MAX_SAMPLES);
 
   /*g_message ("metronome queued for %d", offset);*/
   SamplePlayback * sp =
@@ -274,7 +407,47 @@ sample_processor_queue_sample_from_file (
   SampleProcessor * self,
   const char *      path)
 {
-  /* TODO */
+  g_return_if_fail (path);
+
+  /* decode enough frames to cover the first
+   * cycles while the decoder thread starts */
+  nframes_t prefetch =
+    MAX (4096, 2 * AUDIO_ENGINE->block_length);
+
+  GError * err = NULL;
+  SampleStream * stream =
+    sample_stream_new (
+      path, AUDIO_ENGINE->sample_rate, prefetch,
+      &err);
+  if (!stream)
+    {
+      g_warning (
+        "Failed to stream %s: %s", path,
+        err->message);
+      g_error_free (err);
+      return;
+    }
+
+  g_atomic_int_set (&self->stop_streams, 0);
+  if (!mpmc_queue_push_back (
+         self->stream_queue, stream))
+    {
+      g_warning (
+        "Too many queued samples, ignoring %s",
+        path);
+      sample_stream_release (stream);
+    }
+}
+
+/**
+ * Stops the files queued with
+ * sample_processor_queue_sample_from_file().
+ */
+void
+sample_processor_stop_file_playback (
+  SampleProcessor * self)
+{
+  g_atomic_int_set (&self->stop_streams, 1);
 }
 
 void
@@ -290,6 +463,31 @@ sample_processor_free (
 {
   sample_processor_disconnect (self);
 
+  /* release the file streams */
+  for (int i = 0; i < self->num_current_samples;
+       i++)
+    {
+      SamplePlayback * sp =
+        &self->current_samples[i];
+      if (sp->stream)
+        {
+          sample_stream_release (sp->stream);
+          sp->stream = NULL;
+        }
+    }
+  if (self->stream_queue)
+    {
+      SampleStream * stream;
+      while (
+        mpmc_queue_dequeue (
+          self->stream_queue, (void **) &stream))
+        {
+          sample_stream_release (stream);
+        }
+    }
+  object_free_w_func_and_null (
+    mpmc_queue_free, self->stream_queue);
+
   object_free_w_func_and_null (
     stereo_ports_free, self->stereo_out);
 
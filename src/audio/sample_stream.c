@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <string.h>
+
+#include "audio/sample_stream.h"
+#include "utils/objects.h"
+
+#include <glib/gi18n.h>
+
+#include <sndfile.h>
+
+/** Size of an interleaved stereo frame in
+ * bytes. */
+#define FRAME_BYTES (2 * sizeof (float))
+
+/** Frames read from the ring at a time in the DSP
+ * thread. */
+#define READ_CHUNK_FRAMES 256
+
+/**
+ * Half the length of the resampler filter.
+ */
+#define RESAMPLER_HLEN 32
+
+static void
+free_stream (
+  SampleStream * self)
+{
+  if (self->sndfile)
+    {
+      sf_close ((SNDFILE *) self->sndfile);
+    }
+  object_free_w_func_and_null (
+    zita_resampler_free, self->resampler);
+  object_free_w_func_and_null (
+    zix_ring_free, self->ring);
+  zix_sem_destroy (&self->sem);
+  g_free (self->file_buf);
+  g_free (self->in_buf);
+  g_free (self->out_buf);
+  g_free (self->path);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Reads the next frames from the file into
+ * \ref SampleStream.in_buf.
+ *
+ * @return The number of frames read.
+ */
+static unsigned int
+read_file (
+  SampleStream * self)
+{
+  sf_count_t read =
+    sf_readf_float (
+      (SNDFILE *) self->sndfile, self->file_buf,
+      SAMPLE_STREAM_CHUNK_FRAMES);
+  if (read <= 0)
+    return 0;
+
+  channels_t ch = self->file_channels;
+  for (sf_count_t i = 0; i < read; i++)
+    {
+      float * src = &self->file_buf[i * ch];
+      self->in_buf[i * 2] = src[0];
+      self->in_buf[i * 2 + 1] =
+        ch > 1 ? src[1] : src[0];
+    }
+
+  return (unsigned int) read;
+}
+
+/**
+ * Decodes up to \ref SAMPLE_STREAM_CHUNK_FRAMES
+ * frames into the ring, if there is space.
+ *
+ * @return Whether frames were written.
+ */
+static bool
+decode_chunk (
+  SampleStream * self)
+{
+  if (g_atomic_int_get (&self->eof))
+    return false;
+
+  if (zix_ring_write_space (self->ring) <
+        SAMPLE_STREAM_CHUNK_FRAMES * FRAME_BYTES)
+    return false;
+
+  unsigned int produced = 0;
+  if (!self->resampler)
+    {
+      produced = read_file (self);
+      if (produced > 0)
+        {
+          zix_ring_write (
+            self->ring, self->in_buf,
+            produced * FRAME_BYTES);
+        }
+    }
+  else
+    {
+      ZitaResampler * r = self->resampler;
+      r->out_count = SAMPLE_STREAM_CHUNK_FRAMES;
+      r->out_data = self->out_buf;
+      while (r->out_count > 0)
+        {
+          if (self->in_pending == 0 &&
+              !self->input_done)
+            {
+              self->in_pending = read_file (self);
+              self->in_pos = 0;
+              if (self->in_pending == 0)
+                {
+                  self->input_done = true;
+                  self->flush_left =
+                    (unsigned int)
+                    zita_resampler_inpsize (r) / 2;
+                }
+            }
+
+          unsigned int inp_count;
+          if (self->in_pending > 0)
+            {
+              inp_count = self->in_pending;
+              r->inp_data =
+                &self->in_buf[self->in_pos * 2];
+            }
+          else if (self->flush_left > 0)
+            {
+              inp_count = self->flush_left;
+              r->inp_data = NULL;
+            }
+          else
+            break;
+
+          r->inp_count = inp_count;
+          zita_resampler_process (r);
+          unsigned int consumed =
+            inp_count - r->inp_count;
+          if (self->in_pending > 0)
+            {
+              self->in_pending -= consumed;
+              self->in_pos += consumed;
+            }
+          else
+            {
+              self->flush_left -= consumed;
+            }
+        }
+      produced =
+        SAMPLE_STREAM_CHUNK_FRAMES - r->out_count;
+      if (produced > 0)
+        {
+          zix_ring_write (
+            self->ring, self->out_buf,
+            produced * FRAME_BYTES);
+        }
+    }
+
+  if (produced < SAMPLE_STREAM_CHUNK_FRAMES)
+    {
+      g_atomic_int_set (&self->eof, 1);
+    }
+
+  return produced > 0;
+}
+
+static gpointer
+decoder_thread (
+  gpointer data)
+{
+  SampleStream * self = (SampleStream *) data;
+
+  while (!g_atomic_int_get (&self->released))
+    {
+      while (
+        !g_atomic_int_get (&self->released) &&
+        decode_chunk (self));
+
+      zix_sem_wait (&self->sem);
+    }
+
+  free_stream (self);
+
+  return NULL;
+}
+
+/**
+ * Opens the given file and decodes the first
+ * \p prefetch_frames before returning, then
+ * starts decoding the rest in the background.
+ *
+ * @param samplerate Sample rate to resample to.
+ * @param prefetch_frames Number of frames to
+ *   decode synchronously so that playback can
+ *   start immediately.
+ *
+ * @return The stream, or NULL if the file could
+ *   not be opened.
+ */
+SampleStream *
+sample_stream_new (
+  const char *  path,
+  sample_rate_t samplerate,
+  nframes_t     prefetch_frames,
+  GError **     error)
+{
+  g_return_val_if_fail (
+    path && samplerate > 0, NULL);
+
+  SF_INFO info;
+  memset (&info, 0, sizeof (info));
+  SNDFILE * sndfile = sf_open (path, SFM_READ, &info);
+  if (!sndfile)
+    {
+      g_set_error (
+        error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+        _("Failed to open %s: %s"), path,
+        sf_strerror (NULL));
+      return NULL;
+    }
+  if (info.channels <= 0 || info.samplerate <= 0)
+    {
+      g_set_error (
+        error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+        _("Invalid audio file %s"), path);
+      sf_close (sndfile);
+      return NULL;
+    }
+
+  SampleStream * self = object_new (SampleStream);
+  self->path = g_strdup (path);
+  self->sndfile = sndfile;
+  self->file_channels = (channels_t) info.channels;
+  self->file_buf =
+    g_malloc_n (
+      (gsize) SAMPLE_STREAM_CHUNK_FRAMES *
+        (gsize) info.channels,
+      sizeof (float));
+  self->in_buf =
+    g_malloc_n (
+      SAMPLE_STREAM_CHUNK_FRAMES * 2,
+      sizeof (float));
+  self->ring =
+    zix_ring_new (
+      SAMPLE_STREAM_RING_FRAMES * FRAME_BYTES);
+  zix_ring_mlock (self->ring);
+  zix_sem_init (&self->sem, 0);
+
+  if ((sample_rate_t) info.samplerate != samplerate)
+    {
+      self->resampler = zita_resampler_new ();
+      if (zita_resampler_setup (
+            self->resampler,
+            (unsigned int) info.samplerate,
+            samplerate, 2, RESAMPLER_HLEN) != 0)
+        {
+          g_set_error (
+            error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+            _("Cannot resample %s from %d Hz to "
+            "%u Hz"), path, info.samplerate,
+            samplerate);
+          free_stream (self);
+          return NULL;
+        }
+      self->out_buf =
+        g_malloc_n (
+          SAMPLE_STREAM_CHUNK_FRAMES * 2,
+          sizeof (float));
+
+      /* skip the filter delay so that the output
+       * is aligned with the input */
+      ZitaResampler * r = self->resampler;
+      r->inp_count =
+        (unsigned int)
+        zita_resampler_inpsize (r) / 2 - 1;
+      r->inp_data = NULL;
+      r->out_count = 99999;
+      r->out_data = NULL;
+      zita_resampler_process (r);
+    }
+
+  /* decode the head synchronously */
+  prefetch_frames =
+    MIN (
+      prefetch_frames,
+      SAMPLE_STREAM_RING_FRAMES -
+        SAMPLE_STREAM_CHUNK_FRAMES);
+  while (zix_ring_read_space (self->ring) <
+           prefetch_frames * FRAME_BYTES &&
+         decode_chunk (self));
+
+  GError * err = NULL;
+  GThread * thread =
+    g_thread_try_new (
+      "sample_stream", decoder_thread, self, &err);
+  if (!thread)
+    {
+      g_propagate_error (error, err);
+      free_stream (self);
+      return NULL;
+    }
+  g_thread_unref (thread);
+
+  return self;
+}
+
+/**
+ * Reads up to \p nframes from the ring and adds
+ * them to the given buffers.
+ *
+ * Realtime-safe.
+ *
+ * @return The number of frames read, which is
+ *   less than \p nframes if the decoder fell
+ *   behind or at the end of the file.
+ */
+nframes_t
+sample_stream_read (
+  SampleStream * self,
+  float *        l,
+  float *        r,
+  nframes_t      nframes,
+  float          volume)
+{
+  float tmp[READ_CHUNK_FRAMES * 2];
+  nframes_t avail =
+    (nframes_t)
+    (zix_ring_read_space (self->ring) / FRAME_BYTES);
+  nframes_t to_read = MIN (avail, nframes);
+  nframes_t done = 0;
+  while (done < to_read)
+    {
+      nframes_t chunk =
+        MIN (to_read - done, READ_CHUNK_FRAMES);
+      zix_ring_read (
+        self->ring, tmp,
+        (uint32_t) (chunk * FRAME_BYTES));
+      for (nframes_t i = 0; i < chunk; i++)
+        {
+          l[done + i] += tmp[i * 2] * volume;
+          r[done + i] += tmp[i * 2 + 1] * volume;
+        }
+      done += chunk;
+    }
+
+  if (done > 0)
+    {
+      /* wake up the decoder */
+      zix_sem_post (&self->sem);
+    }
+
+  return done;
+}
+
+/**
+ * Returns whether all the frames of the file have
+ * been read.
+ *
+ * Realtime-safe.
+ */
+bool
+sample_stream_is_finished (
+  SampleStream * self)
+{
+  return
+    g_atomic_int_get (&self->eof) &&
+    zix_ring_read_space (self->ring) == 0;
+}
+
+/**
+ * Signals the decoder thread to stop and free the
+ * stream.
+ *
+ * The stream must not be used after this call.
+ *
+ * Realtime-safe.
+ */
+void
+sample_stream_release (
+  SampleStream * self)
+{
+  g_atomic_int_set (&self->released, 1);
+  zix_sem_post (&self->sem);
+}
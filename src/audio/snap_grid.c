@@ -17,12 +17,17 @@
  * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+#include <stdlib.h>
+
 #include "audio/engine.h"
 #include "audio/snap_grid.h"
+#include "audio/track.h"
+#include "audio/track_lane.h"
 #include "audio/transport.h"
+#include "gui/backend/arranger_object.h"
 #include "project.h"
 #include "settings/settings.h"
-#include "utils/algorithms.h"
 #include "utils/arrays.h"
 
 #include <gtk/gtk.h>
@@ -215,52 +220,6 @@ snap_grid_get_default_ticks (
     }
 }
 
-static void
-add_snap_point (
-  SnapGrid * self,
-  Position * snap_point)
-{
-  array_double_size_if_full (
-    self->snap_points, self->num_snap_points,
-    self->snap_points_size, Position);
-  position_from_ticks (
-    &self->snap_points[self->num_snap_points++],
-    snap_point->total_ticks);
-  /*position_set_to_pos (*/
-    /*&self->snap_points[self->num_snap_points++],*/
-    /*snap_point);*/
-}
-
-/**
- * Updates snap points.
- */
-void
-snap_grid_update_snap_points (
-  SnapGrid * self,
-  int        max_bars)
-{
-  POSITION_INIT_ON_STACK (tmp);
-  Position end_pos;
-  position_set_to_bar (
-    &end_pos, max_bars);
-  self->num_snap_points = 0;
-  add_snap_point (self, &tmp);
-  long ticks = snap_grid_get_snap_ticks (self);
-  g_warn_if_fail (TRANSPORT->ticks_per_bar > 0);
-  while (tmp.total_ticks < end_pos.total_ticks)
-    {
-      tmp.total_ticks += ticks;
-      add_snap_point (self, &tmp);
-    }
-#if 0
-  while (position_is_before (&tmp, &end_pos))
-    {
-      position_add_ticks (&tmp, ticks);
-      add_snap_point (self, &tmp);
-    }
-#endif
-}
-
 void
 snap_grid_init (
   SnapGrid *   self,
@@ -268,17 +227,12 @@ snap_grid_init (
   NoteLength   note_length)
 {
   self->type = type;
-  self->num_snap_points = 0;
   self->snap_note_length = note_length;
   self->snap_note_type = NOTE_TYPE_NORMAL;
   self->default_note_length = note_length;
   self->default_note_type = NOTE_TYPE_NORMAL;
   self->snap_to_grid = true;
   self->length_type = NOTE_LENGTH_LINK;
-
-  self->snap_points =
-    calloc (1, sizeof (Position));
-  self->snap_points_size = 1;
 }
 
 static const char *
@@ -315,91 +269,231 @@ snap_grid_stringize (
 }
 
 /**
- * Returns the next or previous SnapGrid Point.
+ * Returns the grid point at or before the given
+ * position, or false if there is none.
+ *
+ * Grid points are calculated from the snap length
+ * instead of being looked up.
+ */
+bool
+snap_grid_get_prev_grid_point (
+  const SnapGrid * self,
+  const Position * pos,
+  Position *       prev_pos)
+{
+  if (pos->total_ticks < 0.0)
+    return false;
+
+  double ticks =
+    (double)
+    snap_grid_get_ticks_from_length_and_type (
+      self->snap_note_length, self->snap_note_type);
+  g_return_val_if_fail (ticks > 0.0, false);
+
+  position_from_ticks (
+    prev_pos,
+    floor (pos->total_ticks / ticks) * ticks);
+
+  return true;
+}
+
+/**
+ * Returns the first grid point after the given
+ * position.
+ */
+void
+snap_grid_get_next_grid_point (
+  const SnapGrid * self,
+  const Position * pos,
+  Position *       next_pos)
+{
+  double ticks =
+    (double)
+    snap_grid_get_ticks_from_length_and_type (
+      self->snap_note_length, self->snap_note_type);
+  g_return_if_fail (ticks > 0.0);
+
+  double next_ticks =
+    (floor (pos->total_ticks / ticks) + 1.0) *
+      ticks;
+  position_from_ticks (
+    next_pos, MAX (next_ticks, 0.0));
+}
+
+/**
+ * Returns the next or previous SnapGrid point.
  *
  * @param self Snap grid to search in.
  * @param pos Position to search for.
  * @param return_prev 1 to return the previous
- * element or 0 to return the next.
+ *   point or 0 to return the next. The previous
+ *   point is never before the start.
+ * @param ret_pos Position to fill in.
  */
-Position *
+void
 snap_grid_get_nearby_snap_point (
-  SnapGrid * self,
+  const SnapGrid * self,
   const Position * pos,
-  const int        return_prev)
+  const int        return_prev,
+  Position *       ret_pos)
 {
-  Position * ret_pos = NULL;
-  algorithms_binary_search_nearby (
-    self->snap_points, pos, return_prev, 0,
-    self->num_snap_points, Position *,
-    position_compare, &, ret_pos, NULL);
-
-  return ret_pos;
-
-  // init values
-  /*int first = 0;*/
-  /*int last = self->num_snap_points;*/
-  /*int middle = (first + last) / 2;*/
-  /*int pivot_is_before_pos, pivot_succ_is_before_pos;*/
-  /*Position *pivot, *pivot_succ;*/
-
-  /*// return if SnapGrid has no entries*/
-  /*if (first == last)*/
-  /*{*/
-    /*return NULL;*/
-  /*}*/
-
-  /*// search loops, exit if pos is not in array*/
-  /*while (first <= last)*/
-  /*{*/
-    /*pivot = &self->snap_points[middle];*/
-    /*pivot_succ = NULL;*/
-    /*pivot_succ_is_before_pos = 0;*/
-
-    /*if (middle == 0 && return_prev) {*/
-      /*return &self->snap_points[0];*/
-    /*}*/
-
-    /*// Return next/previous item if pivot is the searched position*/
-    /*if (position_compare(pivot, pos) == 0) {*/
-      /*if (return_prev)*/
-        /*return &self->snap_points[middle - 1];*/
-      /*else*/
-        /*return &self->snap_points[middle + 1];*/
-    /*}*/
-
-    /*// Select pivot successor if possible*/
-    /*if (middle < last)*/
-    /*{*/
-      /*pivot_succ = &self->snap_points[middle + 1];*/
-      /*pivot_succ_is_before_pos =*/
-          /*position_compare(*/
-              /*pivot_succ, pos) <= 0;*/
-    /*}*/
-    /*pivot_is_before_pos =*/
-        /*position_compare(*/
-            /*pivot, pos) <= 0;*/
-
-    /*// if pivot and pivot_succ are before pos, search in the second half on next iteration*/
-    /*if (pivot_is_before_pos && pivot_succ_is_before_pos)*/
-    /*{*/
-      /*first = middle + 1;*/
-    /*}*/
-    /*else if (pivot_is_before_pos) // pos is between pivot and pivot_succ*/
-    /*{*/
-      /*if (return_prev) {*/
-        /*return pivot;*/
-      /*} else {*/
-        /*return pivot_succ;*/
-      /*}*/
-    /*}*/
-    /*else { // if pivot_succ and pivot are behind pos, search in the first half on next iteration*/
-      /*last = middle;*/
-    /*}*/
-
-    /*// recalculate middle position*/
-    /*middle = (first + last) / 2;*/
-  /*}*/
-
-  /*return NULL;*/
+  if (!return_prev)
+    {
+      snap_grid_get_next_grid_point (
+        self, pos, ret_pos);
+      return;
+    }
+
+  /* get the point strictly before pos */
+  double ticks =
+    (double)
+    snap_grid_get_ticks_from_length_and_type (
+      self->snap_note_length, self->snap_note_type);
+  g_return_if_fail (ticks > 0.0);
+
+  double prev_ticks =
+    (ceil (pos->total_ticks / ticks) - 1.0) *
+      ticks;
+  position_from_ticks (
+    ret_pos, MAX (prev_ticks, 0.0));
+}
+
+static int
+cmp_ticks (
+  const void * a,
+  const void * b)
+{
+  double ticks_a = *(const double *) a;
+  double ticks_b = *(const double *) b;
+  return
+    (ticks_a > ticks_b) - (ticks_a < ticks_b);
+}
+
+static void
+add_ticks (
+  SnapObjectIndex * self,
+  double            ticks)
+{
+  array_double_size_if_full (
+    self->ticks, self->num_ticks,
+    self->ticks_size, double);
+  self->ticks[self->num_ticks++] = ticks;
+}
+
+/**
+ * Rebuilds the index for the given track, unless
+ * it was already built for it.
+ */
+void
+snap_object_index_update (
+  SnapObjectIndex * self,
+  Track *           track)
+{
+  if (self->track == track)
+    return;
+
+  self->track = track;
+  self->num_ticks = 0;
+  if (!track)
+    return;
+
+  for (int i = 0; i < track->num_lanes; i++)
+    {
+      TrackLane * lane = track->lanes[i];
+      for (int j = 0; j < lane->num_regions; j++)
+        {
+          ArrangerObject * r_obj =
+            (ArrangerObject *) lane->regions[j];
+          add_ticks (self, r_obj->pos.total_ticks);
+          add_ticks (
+            self, r_obj->end_pos.total_ticks);
+        }
+    }
+
+  qsort (
+    self->ticks, (size_t) self->num_ticks,
+    sizeof (double), cmp_ticks);
+}
+
+/**
+ * Clears the index so that it is rebuilt the next
+ * time it is updated.
+ *
+ * @param free_memory Whether to also free the
+ *   allocated memory.
+ */
+void
+snap_object_index_clear (
+  SnapObjectIndex * self,
+  bool              free_memory)
+{
+  self->track = NULL;
+  self->num_ticks = 0;
+  if (free_memory)
+    {
+      free (self->ticks);
+      self->ticks = NULL;
+      self->ticks_size = 0;
+    }
+}
+
+/**
+ * Returns the index of the first element greater
+ * than the given ticks.
+ */
+static int
+get_upper_bound (
+  const SnapObjectIndex * self,
+  double                  ticks)
+{
+  int lo = 0;
+  int hi = self->num_ticks;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (self->ticks[mid] <= ticks)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/**
+ * Returns the last indexed position at or before
+ * the given position, or false if none.
+ */
+bool
+snap_object_index_get_prev (
+  const SnapObjectIndex * self,
+  const Position *        pos,
+  Position *              prev_pos)
+{
+  int idx =
+    get_upper_bound (self, pos->total_ticks) - 1;
+  if (idx < 0)
+    return false;
+
+  position_from_ticks (prev_pos, self->ticks[idx]);
+  return true;
+}
+
+/**
+ * Returns the first indexed position after the
+ * given position, or false if none.
+ */
+bool
+snap_object_index_get_next (
+  const SnapObjectIndex * self,
+  const Position *        pos,
+  Position *              next_pos)
+{
+  int idx =
+    get_upper_bound (self, pos->total_ticks);
+  if (idx >= self->num_ticks)
+    return false;
+
+  position_from_ticks (next_pos, self->ticks[idx]);
+  return true;
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "audio/clip.h"
+#include "audio/stretch_cache.h"
+#include "audio/stretcher.h"
+#include "utils/math.h"
+#include "utils/object_utils.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+
+/**
+ * Creates a new cache with a single reference.
+ */
+StretchCache *
+stretch_cache_new (void)
+{
+  StretchCache * self = object_new (StretchCache);
+  self->num_refs = 1;
+
+  return self;
+}
+
+void
+stretch_cache_ref (
+  StretchCache * self)
+{
+  g_return_if_fail (self->num_refs > 0);
+  self->num_refs++;
+}
+
+static void
+stretch_cache_free (
+  StretchCache * self)
+{
+  object_free_w_func_and_null (
+    stretch_cache_frames_free, self->frames);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Drops a reference and frees the cache later
+ * if it was the last one.
+ */
+void
+stretch_cache_unref (
+  StretchCache * self)
+{
+  g_return_if_fail (self->num_refs > 0);
+  if (--self->num_refs == 0)
+    {
+      /* the cache may still be in use by the DSP
+       * threads in the current cycle */
+      free_later (self, stretch_cache_free);
+    }
+}
+
+/**
+ * Returns whether frames for the given clip and
+ * BPM need to be requested.
+ *
+ * @note Must be called from the GTK thread.
+ */
+bool
+stretch_cache_needs_request (
+  StretchCache * self,
+  AudioClip *    clip,
+  bpm_t          bpm)
+{
+  return
+    self->requested_clip != clip ||
+    self->requested_clip_num_frames !=
+      clip->num_frames ||
+    !math_floats_equal (self->requested_bpm, bpm);
+}
+
+/**
+ * Returns the frames if they were stretched from
+ * the given clip to the given BPM, otherwise
+ * NULL.
+ *
+ * Real-time safe.
+ */
+const StretchCacheFrames *
+stretch_cache_get_frames_for (
+  StretchCache * self,
+  AudioClip *    clip,
+  bpm_t          bpm)
+{
+  const StretchCacheFrames * frames =
+    stretch_cache_get_frames (self);
+  if (frames &&
+      frames->clip == clip &&
+      frames->clip_num_frames == clip->num_frames &&
+      math_floats_equal (frames->bpm, bpm))
+    {
+      return frames;
+    }
+
+  return NULL;
+}
+
+/**
+ * Publishes the given frames to the engine and
+ * frees the previous ones later.
+ *
+ * @note Must be called from the GTK thread.
+ */
+void
+stretch_cache_set_frames (
+  StretchCache *       self,
+  StretchCacheFrames * frames)
+{
+  StretchCacheFrames * old_frames =
+    stretch_cache_get_frames (self);
+  g_atomic_pointer_set (&self->frames, frames);
+
+  /* the old frames may still be in use by the DSP
+   * threads in the current cycle */
+  if (old_frames)
+    {
+      free_later (
+        old_frames, stretch_cache_frames_free);
+    }
+}
+
+/**
+ * Stretches the given interleaved frames.
+ *
+ * This is not real-time safe and can be called
+ * from any thread.
+ *
+ * @param time_ratio The ratio to multiply time
+ *   by.
+ *
+ * @return The stretched frames, with the clip,
+ *   BPM and tempo map version left for the caller
+ *   to fill in, or NULL if stretching failed.
+ */
+StretchCacheFrames *
+stretch_cache_frames_new_stretched (
+  const float *  frames,
+  long           num_frames,
+  channels_t     channels,
+  sample_rate_t  sample_rate,
+  double         time_ratio)
+{
+  g_return_val_if_fail (
+    frames && num_frames > 0 &&
+    (channels == 1 || channels == 2), NULL);
+
+  Stretcher * stretcher =
+    stretcher_new_rubberband (
+      sample_rate, channels, time_ratio, 1.0,
+      false);
+  float * out_frames = NULL;
+  ssize_t num_out_frames =
+    stretcher_stretch_interleaved (
+      stretcher, (float *) frames,
+      (size_t) num_frames, &out_frames);
+  stretcher_free (stretcher);
+  if (num_out_frames <= 0)
+    {
+      free (out_frames);
+      return NULL;
+    }
+
+  StretchCacheFrames * self =
+    object_new (StretchCacheFrames);
+  self->num_frames = (long) num_out_frames;
+  for (channels_t i = 0; i < channels; i++)
+    {
+      self->ch_frames[i] =
+        malloc (
+          (size_t) num_out_frames * sizeof (float));
+      for (long j = 0; j < num_out_frames; j++)
+        {
+          self->ch_frames[i][j] =
+            out_frames[j * (long) channels + i];
+        }
+    }
+  if (channels == 1)
+    {
+      self->ch_frames[1] = self->ch_frames[0];
+    }
+  free (out_frames);
+
+  return self;
+}
+
+void
+stretch_cache_frames_free (
+  StretchCacheFrames * self)
+{
+  if (self->ch_frames[1] != self->ch_frames[0])
+    {
+      free (self->ch_frames[1]);
+    }
+  free (self->ch_frames[0]);
+
+  object_zero_and_free (self);
+}
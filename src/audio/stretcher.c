@@ -313,10 +313,14 @@ stretcher_stretch_interleaved (
 
   g_message ("input samples: %zu", in_samples_size);
 
-  /* create the de-interleaved array */
+  /* create the de-interleaved array (on the
+   * heap, since the input can be large and this
+   * may run in a worker thread) */
   unsigned int channels = self->channels;
-  float in_buffers_l[in_samples_size];
-  float in_buffers_r[in_samples_size];
+  float * in_buffers_l =
+    malloc (in_samples_size * sizeof (float));
+  float * in_buffers_r =
+    malloc (in_samples_size * sizeof (float));
   for (size_t i = 0; i < in_samples_size; i++)
     {
       in_buffers_l[i] = in_samples[i * channels];
@@ -452,6 +456,13 @@ stretcher_stretch_interleaved (
         }
     }
 
+  for (unsigned int i = 0; i < channels; i++)
+    {
+      free (out_samples[i]);
+    }
+  free (in_buffers_l);
+  free (in_buffers_r);
+
   return (ssize_t) total_out_frames;
 }
 
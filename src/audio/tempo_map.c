@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "audio/automation_track.h"
+#include "audio/position.h"
+#include "audio/tempo_map.h"
+#include "audio/tempo_track.h"
+#include "audio/track.h"
+#include "audio/transport.h"
+#include "gui/backend/arranger_object.h"
+#include "utils/arrays.h"
+#include "utils/math.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+
+static gint tempo_map_version = 0;
+
+static inline double
+get_frames_per_tick (
+  bpm_t         bpm,
+  double        ticks_per_beat,
+  sample_rate_t sample_rate)
+{
+  return
+    ((double) sample_rate * 60.0) /
+      ((double) bpm * ticks_per_beat);
+}
+
+/**
+ * Appends a segment starting at the given ticks,
+ * or does nothing if the BPM is the same as the
+ * BPM of the last segment.
+ */
+static void
+append_segment (
+  TempoMap * self,
+  size_t *   segments_size,
+  double     start_ticks,
+  bpm_t      bpm)
+{
+  if (self->num_segments > 0)
+    {
+      TempoMapSegment * last =
+        &self->segments[self->num_segments - 1];
+      if (math_floats_equal (last->bpm, bpm))
+        return;
+
+      /* replace the last segment if it starts at
+       * the same position */
+      if (math_doubles_equal (
+            last->start_ticks, start_ticks))
+        {
+          last->bpm = bpm;
+          last->frames_per_tick =
+            get_frames_per_tick (
+              bpm, self->ticks_per_beat,
+              self->sample_rate);
+          return;
+        }
+    }
+
+  array_double_size_if_full (
+    self->segments, self->num_segments,
+    *segments_size, TempoMapSegment);
+  TempoMapSegment * seg =
+    &self->segments[self->num_segments];
+  seg->start_ticks = start_ticks;
+  seg->bpm = bpm;
+  seg->frames_per_tick =
+    get_frames_per_tick (
+      bpm, self->ticks_per_beat, self->sample_rate);
+  if (self->num_segments == 0)
+    {
+      seg->start_frames = 0.0;
+    }
+  else
+    {
+      TempoMapSegment * prev =
+        &self->segments[self->num_segments - 1];
+      seg->start_frames =
+        prev->start_frames +
+        (start_ticks - prev->start_ticks) *
+          prev->frames_per_tick;
+    }
+  self->num_segments++;
+}
+
+static TempoMap *
+create_empty (
+  double        ticks_per_beat,
+  sample_rate_t sample_rate)
+{
+  TempoMap * self = object_new (TempoMap);
+
+  self->ticks_per_beat = ticks_per_beat;
+  self->sample_rate = sample_rate;
+  self->version =
+    (unsigned int)
+    g_atomic_int_add (&tempo_map_version, 1) + 1;
+
+  return self;
+}
+
+/**
+ * Creates a tempo map with a single segment of
+ * the given BPM.
+ */
+TempoMap *
+tempo_map_new (
+  bpm_t         bpm,
+  double        ticks_per_beat,
+  sample_rate_t sample_rate)
+{
+  g_return_val_if_fail (
+    bpm > 0.f && ticks_per_beat > 0.0 &&
+    sample_rate > 0, NULL);
+
+  TempoMap * self =
+    create_empty (ticks_per_beat, sample_rate);
+
+  size_t segments_size = 1;
+  self->segments =
+    calloc (
+      segments_size, sizeof (TempoMapSegment));
+  append_segment (self, &segments_size, 0.0, bpm);
+
+  return self;
+}
+
+/**
+ * Creates a tempo map from the BPM automation of
+ * the given tempo track.
+ *
+ * Non-constant automation curves are sampled
+ * every \ref TEMPO_MAP_RESOLUTION_TICKS.
+ *
+ * @note Not real-time safe.
+ */
+TempoMap *
+tempo_map_new_from_tempo_track (
+  Track *       tempo_track,
+  double        ticks_per_beat,
+  sample_rate_t sample_rate)
+{
+  g_return_val_if_fail (
+    tempo_track && tempo_track->bpm_port, NULL);
+
+  bpm_t cur_bpm =
+    tempo_track_get_current_bpm (tempo_track);
+  AutomationTrack * at =
+    automation_track_find_from_port_id (
+      &tempo_track->bpm_port->id, false);
+  if (!at || at->num_regions == 0)
+    {
+      return
+        tempo_map_new (
+          cur_bpm, ticks_per_beat, sample_rate);
+    }
+
+  TempoMap * self =
+    create_empty (ticks_per_beat, sample_rate);
+  size_t segments_size = 16;
+  self->segments =
+    calloc (
+      segments_size, sizeof (TempoMapSegment));
+
+  /* find the end of the automation */
+  double end_ticks = 0.0;
+  for (int i = 0; i < at->num_regions; i++)
+    {
+      ArrangerObject * r_obj =
+        (ArrangerObject *) at->regions[i];
+      end_ticks =
+        MAX (end_ticks, r_obj->end_pos.total_ticks);
+    }
+
+  /* sample the automation and merge consecutive
+   * samples with the same BPM into 1 segment */
+  Position pos;
+  for (double ticks = 0.0; ticks <= end_ticks;
+       ticks += TEMPO_MAP_RESOLUTION_TICKS)
+    {
+      position_from_ticks (&pos, ticks);
+      bpm_t bpm =
+        automation_track_get_val_at_pos (
+          at, &pos, false);
+      if (bpm < TRANSPORT_MIN_BPM)
+        bpm = TRANSPORT_MIN_BPM;
+      else if (bpm > TRANSPORT_MAX_BPM)
+        bpm = TRANSPORT_MAX_BPM;
+      append_segment (
+        self, &segments_size, ticks, bpm);
+    }
+
+  g_return_val_if_fail (
+    self->num_segments > 0, self);
+
+  return self;
+}
+
+/**
+ * Returns the index of the segment that contains
+ * the given tick position.
+ */
+int
+tempo_map_get_segment_idx_at_ticks (
+  const TempoMap * self,
+  double           ticks)
+{
+  /* binary search for the last segment starting
+   * at or before the given ticks */
+  int lo = 0;
+  int hi = self->num_segments - 1;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo + 1) / 2;
+      if (self->segments[mid].start_ticks <= ticks)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/**
+ * Returns the index of the segment that contains
+ * the given frame position.
+ */
+int
+tempo_map_get_segment_idx_at_frames (
+  const TempoMap * self,
+  double           frames)
+{
+  int lo = 0;
+  int hi = self->num_segments - 1;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo + 1) / 2;
+      if (self->segments[mid].start_frames <= frames)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/**
+ * Converts ticks to (non-rounded) frames.
+ */
+double
+tempo_map_ticks_to_frames (
+  const TempoMap * self,
+  double           ticks)
+{
+  const TempoMapSegment * seg =
+    &self->segments[
+      tempo_map_get_segment_idx_at_ticks (
+        self, ticks)];
+  return
+    seg->start_frames +
+      (ticks - seg->start_ticks) *
+        seg->frames_per_tick;
+}
+
+/**
+ * Converts frames to ticks.
+ */
+double
+tempo_map_frames_to_ticks (
+  const TempoMap * self,
+  double           frames)
+{
+  const TempoMapSegment * seg =
+    &self->segments[
+      tempo_map_get_segment_idx_at_frames (
+        self, frames)];
+  return
+    seg->start_ticks +
+      (frames - seg->start_frames) /
+        seg->frames_per_tick;
+}
+
+/**
+ * Returns the BPM at the given tick position.
+ */
+bpm_t
+tempo_map_get_bpm_at_ticks (
+  const TempoMap * self,
+  double           ticks)
+{
+  return
+    self->segments[
+      tempo_map_get_segment_idx_at_ticks (
+        self, ticks)].bpm;
+}
+
+void
+tempo_map_free (
+  TempoMap * self)
+{
+  free (self->segments);
+
+  object_zero_and_free (self);
+}
@@ -20,7 +20,9 @@
 #include <stdlib.h>
 
 #include "audio/automation_track.h"
+#include "audio/engine.h"
 #include "audio/port.h"
+#include "audio/tempo_map.h"
 #include "audio/tempo_track.h"
 #include "audio/track.h"
 #include "gui/backend/event.h"
@@ -102,6 +104,15 @@ tempo_track_get_bpm_at_pos (
   Track *    self,
   Position * pos)
 {
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  if (tempo_map_has_tempo_changes (tempo_map))
+    {
+      return
+        tempo_map_get_bpm_at_ticks (
+          tempo_map, pos->total_ticks);
+    }
+
   AutomationTrack * at =
     automation_track_find_from_port_id (
       &self->bpm_port->id, false);
@@ -23,12 +23,14 @@
 #include "actions/undo_manager.h"
 #include "audio/audio_group_track.h"
 #include "audio/audio_region.h"
+#include "audio/audio_region_index.h"
 #include "audio/audio_track.h"
 #include "audio/automation_point.h"
 #include "audio/automation_track.h"
 #include "audio/audio_bus_track.h"
 #include "audio/channel.h"
 #include "audio/chord_track.h"
+#include "audio/clip.h"
 #include "audio/control_port.h"
 #include "audio/exporter.h"
 #include "audio/group_target_track.h"
@@ -40,8 +42,11 @@
 #include "audio/midi_track.h"
 #include "audio/modulator_track.h"
 #include "audio/instrument_track.h"
+#include "audio/pool.h"
 #include "audio/router.h"
+#include "audio/stretch_cache.h"
 #include "audio/stretcher.h"
+#include "audio/tempo_map.h"
 #include "audio/tempo_track.h"
 #include "audio/track.h"
 #include "gui/backend/event.h"
@@ -58,6 +63,7 @@
 #include "utils/arrays.h"
 #include "utils/flags.h"
 #include "utils/io.h"
+#include "utils/math.h"
 #include "utils/object_utils.h"
 #include "utils/objects.h"
 #include "utils/string.h"
@@ -1264,6 +1270,7 @@ track_insert_region (
             track->lanes[lane_pos], region, idx);
         }
       g_warn_if_fail (region->id.idx >= 0);
+      track_set_region_index_dirty (track);
     }
 
   if (add_at)
@@ -1296,12 +1303,16 @@ track_insert_region (
         }
     }
 
-  /* write clip if audio region */
+  /* write clip if audio region (clips being
+   * decoded are written by the decoder) */
   if (region->id.type == REGION_TYPE_AUDIO)
     {
       AudioClip * clip =
         audio_region_get_clip (region);
-      audio_clip_write_to_pool (clip, false);
+      if (!clip->decoding)
+        {
+          audio_clip_write_to_pool (clip, false);
+        }
     }
 
   if (fire_events)
@@ -1800,6 +1811,7 @@ track_remove_region (
       TrackLane * lane =
         region_get_lane (region);
       track_lane_remove_region (lane, region);
+      track_set_region_index_dirty (self);
     }
   else if (region->id.type == REGION_TYPE_CHORD)
     {
@@ -2088,6 +2100,131 @@ track_update_frames (
 
   automation_tracklist_update_frames (
     &self->automation_tracklist);
+
+  track_set_region_index_dirty (self);
+}
+
+/**
+ * Rebuilds the region index from the regions in
+ * the lanes and publishes it to the DSP threads.
+ *
+ * Does nothing if the track is not an audio
+ * track.
+ *
+ * @note Not real-time safe.
+ */
+void
+track_update_region_index (
+  Track * self)
+{
+  if (self->type != TRACK_TYPE_AUDIO)
+    return;
+
+  g_atomic_int_set (&self->region_index_dirty, 0);
+
+  AudioRegionIndex * new_index =
+    audio_region_index_new_from_track (self);
+  g_return_if_fail (new_index);
+
+  AudioRegionIndex * old_index =
+    track_get_region_index (self);
+  g_atomic_pointer_set (
+    &self->region_index, new_index);
+
+  /* the old index may still be in use by the DSP
+   * threads in the current cycle */
+  if (old_index)
+    {
+      free_later (
+        old_index, audio_region_index_free);
+    }
+
+  track_update_stretch_caches (self);
+}
+
+/**
+ * Requests the stretched frames of the regions in
+ * musical mode that are missing or out of date
+ * with the tempo, and updates
+ * Track.stretch_latency.
+ *
+ * Does nothing if the track is not an audio
+ * track.
+ *
+ * @note Not real-time safe.
+ */
+void
+track_update_stretch_caches (
+  Track * self)
+{
+  if (self->type != TRACK_TYPE_AUDIO)
+    return;
+
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  unsigned int tempo_map_version =
+    tempo_map ? tempo_map->version : 0;
+  self->stretch_tempo_map_version =
+    tempo_map_version;
+
+  /* the clips keep growing while recording, so
+   * they are stretched when recording ends */
+  bool recording =
+    self->recording && TRANSPORT->recording &&
+    TRANSPORT_IS_ROLLING;
+
+  bool needs_stretch = false;
+  for (int i = 0; i < self->num_lanes; i++)
+    {
+      TrackLane * lane = self->lanes[i];
+      for (int j = 0; j < lane->num_regions; j++)
+        {
+          ZRegion * r = lane->regions[j];
+          ArrangerObject * r_obj =
+            (ArrangerObject *) r;
+          if (r->id.type != REGION_TYPE_AUDIO ||
+              r_obj->muted || !r->stretch_cache ||
+              !region_get_musical_mode (r))
+            continue;
+
+          AudioClip * clip =
+            audio_region_get_clip (r);
+          if (!clip || !clip->frames ||
+              clip->num_frames <= 0 ||
+              clip->decoding)
+            continue;
+
+          /* the cached frames are only used while
+           * the BPM at the playhead matches the BPM
+           * at the region start, otherwise the
+           * region is stretched in realtime */
+          bpm_t bpm =
+            tempo_track_get_bpm_at_pos (
+              P_TEMPO_TRACK, &r_obj->pos);
+          if (math_floats_equal (clip->bpm, bpm))
+            continue;
+
+          needs_stretch = true;
+          if (!recording &&
+              stretch_cache_needs_request (
+                r->stretch_cache, clip, bpm))
+            {
+              audio_pool_stretch_async (
+                AUDIO_POOL, r->stretch_cache, clip,
+                bpm, tempo_map_version);
+            }
+        }
+    }
+
+  nframes_t latency =
+    needs_stretch && self->rt_stretcher ?
+      stretcher_get_latency (self->rt_stretcher) :
+      0;
+  if (latency != self->stretch_latency)
+    {
+      self->stretch_latency = latency;
+      EVENTS_PUSH (ET_TRACK_LATENCY_CHANGED, self);
+    }
 }
 
 /**
@@ -2786,6 +2923,9 @@ track_free (Track * self)
         port_free, self->time_sig_port);
     }
 
+  object_free_w_func_and_null (
+    audio_region_index_free, self->region_index);
+
 #undef _FREE_TRACK
 
   if (self->channel)
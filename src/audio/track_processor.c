@@ -34,6 +34,7 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/dsp.h"
 #include "utils/flags.h"
 #include "utils/math.h"
 #include "utils/objects.h"
@@ -704,6 +705,122 @@ handle_recording (
     }
 }
 
+/**
+ * Returns the buffer of the given channel of the
+ * given region group.
+ */
+static inline float *
+get_region_group_buf (
+  TrackProcessor * self,
+  int              group,
+  int              ch)
+{
+  return
+    &self->region_group_bufs[
+      (size_t) (group * 2 + ch) *
+        self->region_group_buf_size];
+}
+
+/**
+ * Returns the number of region groups the lanes
+ * of the track should be split into, or 0 if they
+ * should not be split.
+ */
+int
+track_processor_get_num_region_groups_needed (
+  TrackProcessor * self)
+{
+  Track * tr = track_processor_get_track (self);
+  g_return_val_if_fail (tr, 0);
+
+  if (tr->type != TRACK_TYPE_AUDIO ||
+      tr->num_lanes <=
+        TRACK_PROCESSOR_LANES_PER_REGION_GROUP)
+    return 0;
+
+  int num_groups =
+    (tr->num_lanes +
+       TRACK_PROCESSOR_LANES_PER_REGION_GROUP - 1) /
+    TRACK_PROCESSOR_LANES_PER_REGION_GROUP;
+  return
+    MIN (
+      num_groups,
+      TRACK_PROCESSOR_MAX_REGION_GROUPS);
+}
+
+/**
+ * Sets the number of region groups and
+ * (re)allocates their buffers for the current
+ * block length.
+ *
+ * @note Must not be called while the groups are
+ *   being processed.
+ */
+void
+track_processor_set_num_region_groups (
+  TrackProcessor * self,
+  int              num_groups)
+{
+  g_return_if_fail (
+    num_groups >= 0 &&
+    num_groups <=
+      TRACK_PROCESSOR_MAX_REGION_GROUPS);
+
+  nframes_t buf_size = AUDIO_ENGINE->block_length;
+  if (num_groups == self->num_region_groups &&
+      buf_size == self->region_group_buf_size)
+    return;
+
+  free (self->region_group_bufs);
+  self->region_group_bufs = NULL;
+  self->region_group_buf_size = 0;
+  self->num_region_groups = num_groups;
+  if (num_groups > 0)
+    {
+      self->region_group_bufs =
+        calloc (
+          (size_t) (num_groups * 2) * buf_size,
+          sizeof (float));
+      self->region_group_buf_size = buf_size;
+    }
+}
+
+/**
+ * Renders the regions of the given region group
+ * into its buffer.
+ *
+ * @param group Region group index.
+ * @param g_start_frames The global start frames.
+ * @param local_offset The local start frames.
+ * @param nframes The number of frames to process.
+ */
+void
+track_processor_process_region_group (
+  TrackProcessor * self,
+  const int        group,
+  const long       g_start_frames,
+  const nframes_t  local_offset,
+  const nframes_t  nframes)
+{
+  Track * tr = track_processor_get_track (self);
+  g_return_if_fail (
+    tr && group < self->num_region_groups &&
+    local_offset + nframes <=
+      self->region_group_buf_size);
+
+  float * l = get_region_group_buf (self, group, 0);
+  float * r = get_region_group_buf (self, group, 1);
+  dsp_fill (&l[local_offset], 0.f, nframes);
+  dsp_fill (&r[local_offset], 0.f, nframes);
+
+  if (tr->frozen)
+    return;
+
+  audio_track_fill_bufs_from_clips (
+    tr, l, r, g_start_frames, local_offset,
+    nframes, group, self->num_region_groups);
+}
+
 /**
  * Process the TrackProcessor.
  *
@@ -732,9 +849,33 @@ track_processor_process (
   /* set the audio clip contents to stereo out */
   if (tr->type == TRACK_TYPE_AUDIO)
     {
-      audio_track_fill_stereo_ports_from_clip (
-        tr, self->stereo_out,
-        g_start_frames, nframes);
+      if (self->num_region_groups > 0)
+        {
+          /* sum the region groups, which were
+           * processed in parallel before this */
+          for (int i = 0;
+               i < self->num_region_groups; i++)
+            {
+              dsp_add2 (
+                &self->stereo_out->l->buf[
+                  local_offset],
+                &get_region_group_buf (
+                  self, i, 0)[local_offset],
+                nframes);
+              dsp_add2 (
+                &self->stereo_out->r->buf[
+                  local_offset],
+                &get_region_group_buf (
+                  self, i, 1)[local_offset],
+                nframes);
+            }
+        }
+      else
+        {
+          audio_track_fill_stereo_ports_from_clip (
+            tr, self->stereo_out,
+            g_start_frames, local_offset, nframes);
+        }
     }
 
   /* set the piano roll contents to midi out */
@@ -1215,5 +1356,7 @@ track_processor_free (
         port_free, self->midi_out);
     }
 
+  free (self->region_group_bufs);
+
   object_zero_and_free (self);
 }
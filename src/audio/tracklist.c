@@ -21,7 +21,9 @@
 #include "audio/audio_region.h"
 #include "audio/channel.h"
 #include "audio/chord_track.h"
+#include "audio/pool.h"
 #include "audio/router.h"
+#include "audio/tempo_map.h"
 #include "audio/tracklist.h"
 #include "audio/track.h"
 #include "gui/backend/event.h"
@@ -34,6 +36,7 @@
 #include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/track.h"
 #include "gui/widgets/tracklist.h"
+#include "plugins/plugin.h"
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
@@ -69,6 +72,38 @@ tracklist_init_loaded (
 
       track_init_loaded (track, true);
     }
+
+  /* instantiate the plugins of all tracks at
+   * once so that they can be loaded in parallel */
+  GPtrArray * plugins = g_ptr_array_new ();
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      Track * track = self->tracks[i];
+      if (track->channel)
+        {
+          Plugin * pls[STRIP_SIZE * 2 + 1];
+          int num_pls =
+            channel_get_plugins (
+              track->channel, pls);
+          for (int j = 0; j < num_pls; j++)
+            {
+              g_ptr_array_add (plugins, pls[j]);
+            }
+        }
+      if (track->type == TRACK_TYPE_MODULATOR)
+        {
+          for (int j = 0;
+               j < track->num_modulators; j++)
+            {
+              g_ptr_array_add (
+                plugins, track->modulators[j]);
+            }
+        }
+    }
+  plugin_instantiate_loaded_plugins (
+    (Plugin **) plugins->pdata,
+    (int) plugins->len);
+  g_ptr_array_unref (plugins);
 }
 
 /**
@@ -893,12 +928,213 @@ tracklist_expose_ports_to_backend (
     }
 }
 
+/**
+ * Rebuilds the region indices of the tracks.
+ *
+ * The stretched frames of the regions are also
+ * requested again if the tempo map changed.
+ *
+ * @param force Whether to rebuild all indices,
+ *   instead of only the ones marked as dirty.
+ *
+ * @note Not real-time safe.
+ */
+void
+tracklist_update_region_indices (
+  Tracklist * self,
+  bool        force)
+{
+  g_return_if_fail (self);
+
+  const TempoMap * tempo_map =
+    engine_get_tempo_map (AUDIO_ENGINE);
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      Track * track = self->tracks[i];
+      if (track->type != TRACK_TYPE_AUDIO)
+        continue;
+
+      if (force ||
+          g_atomic_int_get (
+            &track->region_index_dirty))
+        {
+          track_update_region_index (track);
+        }
+      else if (tempo_map &&
+               track->stretch_tempo_map_version !=
+                 tempo_map->version)
+        {
+          track_update_stretch_caches (track);
+        }
+    }
+}
+
+/**
+ * Creates a track or region for a single dropped
+ * local file.
+ *
+ * @param file The file.
+ * @param track Track, if any.
+ * @param lane TrackLane, if any.
+ * @param pos Position the file was dropped at, if
+ *   inside track.
+ * @param perform_actions Whether to perform
+ *   undoable actions in addition to creating the
+ *   regions/tracks.
+ */
+static void
+handle_file_drop (
+  SupportedFile * file,
+  Track *         track,
+  TrackLane *     lane,
+  Position *      pos,
+  bool            perform_actions)
+{
+  TrackType track_type = 0;
+  if (supported_file_type_is_supported (
+        file->type) &&
+      supported_file_type_is_audio (
+        file->type))
+    {
+      track_type = TRACK_TYPE_AUDIO;
+    }
+  else if (supported_file_type_is_midi (
+             file->type))
+    {
+      track_type = TRACK_TYPE_MIDI;
+    }
+  else
+    {
+      char * descr =
+        supported_file_type_get_description (
+          file->type);
+      char * msg =
+        g_strdup_printf (
+          _("Unsupported file type %s"),
+          descr);
+      g_free (descr);
+      ui_show_error_message (
+        MAIN_WINDOW, msg);
+      g_free (msg);
+
+      return;
+    }
+
+  if (!perform_actions)
+    {
+      g_warning ("operation not supported yet");
+      return;
+    }
+
+  /* if current track exists and track type are
+   * incompatible, do nothing */
+  if (track)
+    {
+      if (track_type == TRACK_TYPE_MIDI)
+        {
+          ui_show_error_message (
+            MAIN_WINDOW,
+            _("Cannot drop MIDI files into "
+            "existing tracks"));
+          return;
+        }
+
+      if (track_type == TRACK_TYPE_AUDIO &&
+          track->type != TRACK_TYPE_AUDIO)
+        {
+          ui_show_error_message (
+            MAIN_WINDOW,
+            _("Can only drop audio files on "
+            "audio tracks"));
+          return;
+        }
+
+      g_return_if_fail (pos);
+    }
+
+  /* add the audio clip to the pool and decode it
+   * in the background */
+  int pool_id = -1;
+  if (track_type == TRACK_TYPE_AUDIO)
+    {
+      pool_id =
+        audio_pool_add_clip_from_file_async (
+          AUDIO_POOL, file->abs_path);
+      if (pool_id < 0)
+        {
+          char * msg =
+            g_strdup_printf (
+              _("Failed to open %s"),
+              file->abs_path);
+          ui_show_error_message (
+            MAIN_WINDOW, msg);
+          g_free (msg);
+          return;
+        }
+    }
+
+  if (track)
+    {
+      /* create audio region in audio track */
+      int lane_pos =
+        lane ? lane->pos :
+        (track->num_lanes == 1 ?
+         0 : track->num_lanes - 2);
+      int idx_in_lane =
+        track->lanes[lane_pos]->num_regions;
+      ZRegion * region =
+        audio_region_new (
+          pool_id, NULL, NULL, -1, NULL,
+          0, pos, track->pos, lane_pos,
+          idx_in_lane);
+      track_add_region (
+        track, region, NULL, lane_pos,
+        F_GEN_NAME, F_PUBLISH_EVENTS);
+      arranger_object_select (
+        (ArrangerObject *) region, F_SELECT,
+        F_NO_APPEND);
+
+      UndoableAction * ua =
+        arranger_selections_action_new_create (
+          TL_SELECTIONS);
+      undo_manager_perform (
+        UNDO_MANAGER, ua);
+
+      /* place the next file after this one */
+      position_set_to_pos (
+        pos,
+        &((ArrangerObject *) region)->end_pos);
+    }
+  else
+    {
+      UndoableAction * ua =
+        tracklist_selections_action_new_create (
+          track_type, NULL, file,
+          TRACKLIST->num_tracks,
+          pos, 1);
+      if (pool_id >= 0)
+        {
+          /* use the placeholder clip instead of
+           * decoding the file again */
+          ((TracklistSelectionsAction *) ua)->
+            pool_id = pool_id;
+        }
+      undo_manager_perform (UNDO_MANAGER, ua);
+    }
+}
+
 /**
  * Handles a file drop inside the timeline or in
  * empty space in the tracklist.
  *
+ * Audio files are decoded in the background (see
+ * audio_pool_add_clip_from_file_async()), so
+ * their regions are created immediately and
+ * filled in when decoded.
+ *
  * @param uri_list URI list, if URI list was dropped.
- * @param file File, if SupportedFile was dropped.
+ * @param orig_file File, if SupportedFile was
+ *   dropped.
  * @param track Track, if any.
  * @param lane TrackLane, if any.
  * @param pos Position the file was dropped at, if
@@ -917,17 +1153,20 @@ tracklist_handle_file_drop (
   Position *      pos,
   bool            perform_actions)
 {
-  /* get a local file */
-  SupportedFile * file = NULL;
+  /* get local files */
+  GPtrArray * files =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) supported_file_free);
   if (orig_file)
     {
-      file = supported_file_clone (orig_file);
+      g_ptr_array_add (
+        files, supported_file_clone (orig_file));
     }
   else
     {
       g_return_if_fail (uri_list);
 
-      char * uri, * filepath = NULL;
+      char * uri;
       int i = 0;
       while ((uri = uri_list[i++]) != NULL)
         {
@@ -936,139 +1175,53 @@ tracklist_handle_file_drop (
                 uri, "file://"))
             continue;
 
-          if (filepath)
-            g_free (filepath);
           GError * err = NULL;
-          filepath =
+          char * filepath =
             g_filename_from_uri (
               uri, NULL, &err);
           if (err)
             {
               g_warning (
                 "%s", err->message);
+              g_error_free (err);
+            }
+          if (filepath)
+            {
+              g_ptr_array_add (
+                files,
+                supported_file_new_from_path (
+                  filepath));
+              g_free (filepath);
             }
-
-          /* only accept 1 file for now */
-          break;
-        }
-
-      if (filepath)
-        {
-          file =
-            supported_file_new_from_path (
-              filepath);
-          g_free (filepath);
         }
     }
 
-  if (!file)
+  if (files->len == 0)
     {
       ui_show_error_message (
         MAIN_WINDOW, _("No file was found"));
+      g_ptr_array_unref (files);
 
       return;
     }
 
-  TrackType track_type = 0;
-  if (supported_file_type_is_supported (
-        file->type) &&
-      supported_file_type_is_audio (
-        file->type))
-    {
-      track_type = TRACK_TYPE_AUDIO;
-    }
-  else if (supported_file_type_is_midi (
-             file->type))
+  /* audio files dropped in a track are placed
+   * one after another */
+  Position next_pos;
+  if (pos)
     {
-      track_type = TRACK_TYPE_MIDI;
+      position_set_to_pos (&next_pos, pos);
     }
-  else
+  for (guint i = 0; i < files->len; i++)
     {
-      char * descr =
-        supported_file_type_get_description (
-          file->type);
-      char * msg =
-        g_strdup_printf (
-          _("Unsupported file type %s"),
-          descr);
-      g_free (descr);
-      ui_show_error_message (
-        MAIN_WINDOW, msg);
-
-      goto free_file_and_return;
+      SupportedFile * file =
+        g_ptr_array_index (files, i);
+      handle_file_drop (
+        file, track, lane, pos ? &next_pos : NULL,
+        perform_actions);
     }
 
-  if (perform_actions)
-    {
-      /* if current track exists and track type are
-       * incompatible, do nothing */
-      if (track)
-        {
-          if (track_type == TRACK_TYPE_MIDI)
-            {
-              ui_show_error_message (
-                MAIN_WINDOW,
-                _("Cannot drop MIDI files into "
-                "existing tracks"));
-              goto free_file_and_return;
-            }
-
-          if (track_type == TRACK_TYPE_AUDIO &&
-              track->type != TRACK_TYPE_AUDIO)
-            {
-              ui_show_error_message (
-                MAIN_WINDOW,
-                _("Can only drop audio files on "
-                "audio tracks"));
-              goto free_file_and_return;
-            }
-
-          /* create audio region in audio track */
-          int lane_pos =
-            lane ? lane->pos :
-            (track->num_lanes == 1 ?
-             0 : track->num_lanes - 2);
-          int idx_in_lane =
-            track->lanes[lane_pos]->num_regions;
-          ZRegion * region =
-            audio_region_new (
-              -1, file->abs_path, NULL, -1, NULL,
-              0, pos, track->pos, lane_pos,
-              idx_in_lane);
-          track_add_region (
-            track, region, NULL, lane_pos,
-            F_GEN_NAME, F_PUBLISH_EVENTS);
-          arranger_object_select (
-            (ArrangerObject *) region, F_SELECT,
-            F_NO_APPEND);
-
-          UndoableAction * ua =
-            arranger_selections_action_new_create (
-              TL_SELECTIONS);
-          undo_manager_perform (
-            UNDO_MANAGER, ua);
-
-          goto free_file_and_return;
-        }
-      else
-        {
-          UndoableAction * ua =
-            tracklist_selections_action_new_create (
-              track_type, NULL, file,
-              TRACKLIST->num_tracks,
-              pos, 1);
-          undo_manager_perform (UNDO_MANAGER, ua);
-        }
-    }
-  else
-    {
-      g_warning ("operation not supported yet");
-    }
-
-free_file_and_return:
-  supported_file_free (file);
-
-  return;
+  g_ptr_array_unref (files);
 }
 
 /**
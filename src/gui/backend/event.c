@@ -33,6 +33,26 @@ event_new (void)
   return self;
 }
 
+/**
+ * Sets the area to redraw, or unsets it if
+ * \p rect is NULL.
+ */
+void
+event_set_rect (
+  ZEvent *             self,
+  const GdkRectangle * rect)
+{
+  if (rect)
+    {
+      self->rect = *rect;
+      self->has_rect = true;
+    }
+  else
+    {
+      self->has_rect = false;
+    }
+}
+
 void
 event_free (ZEvent * self)
 {
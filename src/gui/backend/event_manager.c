@@ -20,6 +20,7 @@
 #include "zrythm-config.h"
 
 #include <math.h>
+#include <stdlib.h>
 
 #include "audio/audio_region.h"
 #include "audio/automation_region.h"
@@ -27,11 +28,14 @@
 #include "audio/automation_tracklist.h"
 #include "audio/channel.h"
 #include "audio/clip.h"
+#include "audio/control_change_queue.h"
+#include "audio/engine.h"
 #include "audio/modulator_track.h"
 #include "audio/pool.h"
 #include "audio/router.h"
 #include "audio/stretcher.h"
 #include "audio/track.h"
+#include "audio/tracklist.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "gui/backend/clip_editor.h"
@@ -67,6 +71,7 @@
 #include "gui/widgets/modulator_view.h"
 #include "gui/widgets/midi_editor_space.h"
 #include "gui/widgets/mixer.h"
+#include "gui/widgets/panel_file_browser.h"
 #include "gui/widgets/piano_roll_keys.h"
 #include "gui/widgets/plugin_browser.h"
 #include "gui/widgets/plugin_strip_expander.h"
@@ -92,6 +97,7 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/env.h"
 #include "utils/flags.h"
 #include "utils/gtk.h"
 #include "utils/log.h"
@@ -935,6 +941,47 @@ on_arranger_object_changed (
   /*arranger_widget_redraw_whole (arranger);*/
 }
 
+/**
+ * Marks the region index of the track owning the
+ * given object dirty if the object is a region.
+ */
+static void
+set_region_index_dirty_for_object (
+  ArrangerObject * obj)
+{
+  if (!IS_ARRANGER_OBJECT (obj) ||
+      obj->type != ARRANGER_OBJECT_TYPE_REGION)
+    return;
+
+  Track * track = arranger_object_get_track (obj);
+  if (track)
+    {
+      track_set_region_index_dirty (track);
+    }
+}
+
+/**
+ * Marks the region indices of the tracks owning
+ * the regions in the given selections dirty.
+ */
+static void
+set_region_indices_dirty_for_selections (
+  ArrangerSelections * sel)
+{
+  if (sel->type != ARRANGER_SELECTIONS_TYPE_TIMELINE)
+    return;
+
+  int size = 0;
+  ArrangerObject ** objs =
+    arranger_selections_get_all_objects (
+      sel, &size);
+  for (int i = 0; i < size; i++)
+    {
+      set_region_index_dirty_for_object (objs[i]);
+    }
+  free (objs);
+}
+
 static void
 on_arranger_object_created (
   ArrangerObject * obj)
@@ -1085,42 +1132,208 @@ on_plugin_visibility_changed (Plugin * pl)
   /*return FALSE;*/
 /*}*/
 
-static inline void
-clean_duplicates_and_copy (
-  EventManager * self,
-  ZEvent **      events,
-  int *          num_events)
+/**
+ * Returns whether events of the given type are
+ * handled the same way regardless of their
+ * argument, in which case they are merged by type
+ * only.
+ */
+static bool
+event_type_ignores_arg (
+  EventType type)
 {
-  MPMCQueue * q = self->mqueue;
-  ZEvent * event;
-  *num_events = 0;
-  int i, already_exists = 0;;
+  switch (type)
+    {
+    case ET_ARRANGER_SELECTIONS_ACTION_FINISHED:
+    case ET_AUDIO_SELECTIONS_RANGE_CHANGED:
+    case ET_AUTOMATION_VALUE_VISIBILITY_CHANGED:
+    case ET_BPM_CHANGED:
+    case ET_CHANNEL_REMOVED:
+    case ET_CLIP_EDITOR_REGION_CHANGED:
+    case ET_CLIP_MARKER_POS_CHANGED:
+    case ET_EDITOR_FUNCTION_APPLIED:
+    case ET_ENGINE_ACTIVATE_CHANGED:
+    case ET_FILE_INDEX_UPDATED:
+    case ET_LOOP_TOGGLED:
+    case ET_MIDI_BINDINGS_CHANGED:
+    case ET_MIXER_SELECTIONS_CHANGED:
+    case ET_PLAYHEAD_POS_CHANGED:
+    case ET_PLAYHEAD_POS_CHANGED_MANUALLY:
+    case ET_PLUGIN_LATENCY_CHANGED:
+    case ET_PORT_CONNECTION_CHANGED:
+    case ET_RANGE_SELECTION_CHANGED:
+    case ET_RULER_STATE_CHANGED:
+    case ET_TIMELINE_LOOP_MARKER_POS_CHANGED:
+    case ET_TIMELINE_PUNCH_MARKER_POS_CHANGED:
+    case ET_TIMELINE_SONG_MARKER_POS_CHANGED:
+    case ET_TIMELINE_VIEWPORT_CHANGED:
+    case ET_TIME_SIGNATURE_CHANGED:
+    case ET_TRACKLIST_SELECTIONS_CHANGED:
+    case ET_TRACKS_ADDED:
+    case ET_TRACKS_MOVED:
+    case ET_TRACKS_REMOVED:
+    case ET_TRACK_AUTOMATION_VISIBILITY_CHANGED:
+    case ET_TRACK_LANES_VISIBILITY_CHANGED:
+    case ET_TRACK_LATENCY_CHANGED:
+    case ET_TRACK_VISIBILITY_CHANGED:
+    case ET_TRANSPORT_TOTAL_BARS_CHANGED:
+    case ET_UNDO_REDO_ACTION_DONE:
+      return true;
+    default:
+      break;
+    }
+
+  return false;
+}
 
-  /* only add events once to new array while
-   * popping */
+static inline void *
+get_event_key_arg (
+  const ZEvent * ev)
+{
+  return
+    event_type_ignores_arg (ev->type) ?
+      NULL : ev->arg;
+}
+
+static guint
+event_hash (
+  gconstpointer data)
+{
+  const ZEvent * ev = (const ZEvent *) data;
+  return
+    g_direct_hash (get_event_key_arg (ev)) ^
+    ((guint) ev->type * 2654435761u);
+}
+
+static gboolean
+event_equal (
+  gconstpointer a,
+  gconstpointer b)
+{
+  const ZEvent * ev1 = (const ZEvent *) a;
+  const ZEvent * ev2 = (const ZEvent *) b;
+  return
+    ev1->type == ev2->type &&
+    get_event_key_arg (ev1) ==
+      get_event_key_arg (ev2);
+}
+
+/**
+ * Merges \p src into the pending event \p dest.
+ *
+ * The pending event keeps its place in the queue
+ * and takes the argument and source info of the
+ * newer event (last value wins). The areas to
+ * redraw are unioned, and if either event redraws
+ * the whole widget, so does the merged one.
+ */
+static void
+merge_event (
+  ZEvent * dest,
+  ZEvent * src)
+{
+  if (dest->has_rect && src->has_rect)
+    {
+      gdk_rectangle_union (
+        &dest->rect, &src->rect, &dest->rect);
+    }
+  else
+    {
+      dest->has_rect = false;
+    }
+  dest->arg = src->arg;
+  dest->file = src->file;
+  dest->func = src->func;
+  dest->lineno = src->lineno;
+  if (src->backtrace)
+    {
+      g_free (dest->backtrace);
+      dest->backtrace = src->backtrace;
+      src->backtrace = NULL;
+    }
+}
+
+/**
+ * Moves queued events into the pending events,
+ * merging events that have the same type and
+ * argument.
+ *
+ * Must only be called from the GTK thread.
+ */
+void
+event_manager_drain_queue (
+  EventManager * self)
+{
+  ZEvent * ev;
   while (event_queue_dequeue_event (
-           q, &event))
+           self->mqueue, &ev))
     {
-      already_exists = 0;
+      if (ev->type < 0 ||
+          ev->type >= NUM_EVENT_TYPES)
+        {
+          g_warn_if_reached ();
+          object_pool_return (self->obj_pool, ev);
+          continue;
+        }
 
-      for (i = 0; i < *num_events; i++)
-        if (event->type == events[i]->type &&
-            event->arg == events[i]->arg)
-          already_exists = 1;
+      EventTypeStats * stats =
+        &self->stats[ev->type];
+      stats->num_pushed++;
 
-      if (already_exists)
+      ZEvent * pending =
+        (ZEvent *)
+        g_hash_table_lookup (
+          self->pending_events_ht, ev);
+      if (pending)
         {
-          object_pool_return (
-            self->obj_pool, event);
+          merge_event (pending, ev);
+          stats->num_coalesced++;
+          object_pool_return (self->obj_pool, ev);
         }
       else
         {
-          array_append (
-            events, (*num_events), event);
+          g_ptr_array_add (
+            self->pending_events, ev);
+          g_hash_table_add (
+            self->pending_events_ht, ev);
         }
     }
 }
 
+static void
+update_rates (
+  EventManager * self,
+  gint64         now)
+{
+  gint64 elapsed = now - self->stats_period_start;
+  if (elapsed < G_USEC_PER_SEC)
+    return;
+
+  double secs =
+    (double) elapsed / (double) G_USEC_PER_SEC;
+  for (int i = 0; i < NUM_EVENT_TYPES; i++)
+    {
+      EventTypeStats * stats = &self->stats[i];
+      stats->push_rate =
+        (double)
+        (stats->num_pushed -
+           stats->period_num_pushed) / secs;
+      stats->dispatch_rate =
+        (double)
+        (stats->num_dispatched -
+           stats->period_num_dispatched) / secs;
+      stats->period_num_pushed = stats->num_pushed;
+      stats->period_num_dispatched =
+        stats->num_dispatched;
+    }
+  self->stats_period_start = now;
+
+  if (self->log_stats)
+    {
+      event_manager_log_stats (self);
+    }
+}
+
 static int
 soft_recalc_graph_when_paused (
   void * data)
@@ -1136,36 +1349,51 @@ soft_recalc_graph_when_paused (
 }
 
 /**
- * GSourceFunc to be added using idle add.
+ * Handles pending events in the order they were
+ * pushed until the time budget runs out.
  *
- * This will loop indefinintely.
+ * @param budget_usec Time budget, or 0 to handle
+ *   all pending events.
  */
-static int
-process_events (void * data)
+static void
+dispatch_events (
+  EventManager * self,
+  gint64         budget_usec)
 {
-  EventManager * self = (EventManager *) data;
+  event_manager_drain_queue (self);
 
-  ZEvent * events[60];
-  ZEvent * ev;
-  int num_events = 0, i;
-  clean_duplicates_and_copy (
-    self, events, &num_events);
+  gint64 start_time = g_get_monotonic_time ();
+  self->last_dispatch_time = start_time;
 
-  /*g_message ("starting processing");*/
-  for (i = 0; i < num_events; i++)
+  /* the position in the pending list is kept in
+   * the event manager so that this is safe to
+   * re-enter from nested main loops (eg,
+   * dialogs) */
+  ZEvent * ev;
+  int i = 0;
+  gint64 ev_start_time = start_time;
+  while (self->pending_events_start <
+           self->pending_events->len)
     {
-      if (i > 30)
+      if (budget_usec > 0 && i > 0 &&
+          ev_start_time - start_time > budget_usec)
         {
-          g_message (
-            "more than 30 UI events processed!");
+          g_debug (
+            "%s: frame budget exceeded, deferring "
+            "%u events", __func__,
+            self->pending_events->len -
+              self->pending_events_start);
+          break;
         }
 
-      ev = events[i];
-      if (ev->type < 0)
-        {
-          g_warn_if_reached ();
-          continue;
-        }
+      ev =
+        (ZEvent *)
+        g_ptr_array_index (
+          self->pending_events,
+          self->pending_events_start);
+      self->pending_events_start++;
+      g_hash_table_remove (
+        self->pending_events_ht, ev);
 
       if (!ZRYTHM_HAVE_UI)
         {
@@ -1180,6 +1408,7 @@ process_events (void * data)
       switch (ev->type)
         {
         case ET_PLUGIN_LATENCY_CHANGED:
+        case ET_TRACK_LATENCY_CHANGED:
           if (!self->pending_soft_recalc)
             {
               self->pending_soft_recalc = true;
@@ -1206,10 +1435,14 @@ process_events (void * data)
             MW_MIXER);
           break;
         case ET_ARRANGER_OBJECT_CREATED:
+          set_region_index_dirty_for_object (
+            (ArrangerObject *) ev->arg);
           on_arranger_object_created (
             (ArrangerObject *) ev->arg);
           break;
         case ET_ARRANGER_OBJECT_CHANGED:
+          set_region_index_dirty_for_object (
+            (ArrangerObject *) ev->arg);
           on_arranger_object_changed (
             (ArrangerObject *) ev->arg);
           break;
@@ -1222,6 +1455,8 @@ process_events (void * data)
             ARRANGER_SELECTIONS (ev->arg));
           break;
         case ET_ARRANGER_SELECTIONS_CREATED:
+          set_region_indices_dirty_for_selections (
+            ARRANGER_SELECTIONS (ev->arg));
           on_arranger_selections_created (
             ARRANGER_SELECTIONS (ev->arg));
           break;
@@ -1230,6 +1465,8 @@ process_events (void * data)
             ARRANGER_SELECTIONS (ev->arg));
           break;
         case ET_ARRANGER_SELECTIONS_MOVED:
+          set_region_indices_dirty_for_selections (
+            ARRANGER_SELECTIONS (ev->arg));
           on_arranger_selections_moved (
             ARRANGER_SELECTIONS (ev->arg));
           break;
@@ -1238,6 +1475,8 @@ process_events (void * data)
             ARRANGER_SELECTIONS (ev->arg));
           break;
         case ET_ARRANGER_SELECTIONS_ACTION_FINISHED:
+          /* tempo automation might have changed */
+          engine_set_tempo_map_dirty (AUDIO_ENGINE);
           redraw_all_arranger_bgs ();
           ruler_widget_redraw_whole (
             (RulerWidget *) MW_RULER);
@@ -1328,9 +1567,6 @@ process_events (void * data)
             (Plugin *) ev->arg);
           break;
         case ET_TRANSPORT_TOTAL_BARS_CHANGED:
-          snap_grid_update_snap_points_default (
-            SNAP_GRID_TIMELINE);
-
           ruler_widget_refresh (
             (RulerWidget *) MW_RULER);
           ruler_widget_refresh (
@@ -1362,6 +1598,7 @@ process_events (void * data)
                 MW_MIDI_MODIFIER_ARRANGER));
           break;
         case ET_TIME_SIGNATURE_CHANGED:
+          engine_set_tempo_map_dirty (AUDIO_ENGINE);
           ruler_widget_refresh (
             Z_RULER_WIDGET (MW_RULER));
           ruler_widget_refresh (
@@ -1563,6 +1800,8 @@ process_events (void * data)
             (RulerWidget *) MW_RULER);
           break;
         case ET_ARRANGER_SELECTIONS_IN_TRANSIT:
+          set_region_indices_dirty_for_selections (
+            (ArrangerSelections *) ev->arg);
           on_arranger_selections_in_transit (
             (ArrangerSelections *) ev->arg);
           break;
@@ -1613,16 +1852,6 @@ process_events (void * data)
           gtk_widget_queue_draw (
             GTK_WIDGET (MW_DIGITAL_BPM));
 
-          /* these are only used in the UI so
-           * no need to update them during DSP */
-          snap_grid_update_snap_points_default (
-            &PROJECT->snap_grid_timeline);
-          snap_grid_update_snap_points_default (
-            &PROJECT->snap_grid_midi);
-          quantize_options_update_quantize_points (
-            &PROJECT->quantize_opts_timeline);
-          quantize_options_update_quantize_points (
-            &PROJECT->quantize_opts_editor);
           redraw_all_arranger_bgs ();
           break;
         case ET_CHANNEL_FADER_VAL_CHANGED:
@@ -1754,8 +1983,21 @@ process_events (void * data)
           {
             ArrangerWidget * arranger =
               Z_ARRANGER_WIDGET (ev->arg);
-            arranger_widget_redraw_whole (
-              arranger);
+            if (ev->has_rect)
+              {
+                /* the highlight is drawn over the
+                 * cached layers */
+                gtk_widget_queue_draw_area (
+                  GTK_WIDGET (arranger),
+                  ev->rect.x - 2, ev->rect.y - 2,
+                  ev->rect.width + 4,
+                  ev->rect.height + 4);
+              }
+            else
+              {
+                arranger_widget_redraw_whole (
+                  arranger);
+              }
            }
           break;
         case ET_ENGINE_ACTIVATE_CHANGED:
@@ -1818,6 +2060,10 @@ process_events (void * data)
           arranger_selections_change_redraw_everything (
             (ArrangerSelections *) TL_SELECTIONS);
           break;
+        case ET_FILE_INDEX_UPDATED:
+          panel_file_browser_widget_refresh (
+            MW_PANEL_FILE_BROWSER);
+          break;
         default:
           g_warning (
             "event %d not implemented yet",
@@ -1826,21 +2072,148 @@ process_events (void * data)
         }
 
 return_to_pool:
+      {
+        gint64 end_time = g_get_monotonic_time ();
+        gint64 duration = end_time - ev_start_time;
+        EventTypeStats * stats =
+          &self->stats[ev->type];
+        stats->num_dispatched++;
+        stats->total_dispatch_usec += duration;
+        if (duration > stats->max_dispatch_usec)
+          stats->max_dispatch_usec = duration;
+        ev_start_time = end_time;
+      }
       object_pool_return (
         self->obj_pool, ev);
+      i++;
     }
   /*g_message ("processed %d events", i);*/
 
-  if (num_events > 6)
-    g_message ("More than 6 events processed. "
-               "Optimization needed.");
+  /* remove the dispatched events */
+  g_ptr_array_remove_range (
+    self->pending_events, 0,
+    self->pending_events_start);
+  self->pending_events_start = 0;
+
+  /* rebuild the tempo map if needed */
+  if (PROJECT && AUDIO_ENGINE &&
+      g_atomic_int_get (
+        &AUDIO_ENGINE->tempo_map_dirty))
+    {
+      engine_update_tempo_map (AUDIO_ENGINE);
+    }
+
+  /* rebuild the region indices of the tracks
+   * marked dirty (removed regions and undoable
+   * actions mark their tracks themselves) */
+  if (PROJECT && TRACKLIST)
+    {
+      tracklist_update_region_indices (
+        TRACKLIST, false);
+    }
+
+  update_rates (self, g_get_monotonic_time ());
 
   /*g_usleep (8000);*/
   /*project_sanity_check (PROJECT);*/
+}
+
+static gboolean
+on_frame_clock_tick (
+  GtkWidget *     widget,
+  GdkFrameClock * frame_clock,
+  gpointer        user_data)
+{
+  EventManager * self = (EventManager *) user_data;
+
+  dispatch_events (
+    self, EVENT_MANAGER_FRAME_BUDGET_USEC);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+on_tick_cb_destroyed (
+  gpointer data)
+{
+  EventManager * self = (EventManager *) data;
+
+  self->tick_cb_id = 0;
+  self->tick_widget = NULL;
+}
+
+/**
+ * GSourceFunc to be added using timeout add.
+ *
+ * Once the main window is realized, events are
+ * dispatched from its frame clock and this only
+ * drains the queue, unless the frame clock
+ * stalls.
+ *
+ * This will loop indefinintely.
+ */
+static int
+process_events (void * data)
+{
+  EventManager * self = (EventManager *) data;
+
+  if (!self->tick_cb_id && ZRYTHM_HAVE_UI &&
+      MAIN_WINDOW &&
+      gtk_widget_get_realized (
+        GTK_WIDGET (MAIN_WINDOW)))
+    {
+      self->tick_widget = GTK_WIDGET (MAIN_WINDOW);
+      self->tick_cb_id =
+        gtk_widget_add_tick_callback (
+          self->tick_widget, on_frame_clock_tick,
+          self, on_tick_cb_destroyed);
+    }
+
+  /* turn control changes from the DSP thread
+   * into events */
+  if (PROJECT && AUDIO_ENGINE &&
+      AUDIO_ENGINE->ctrl_out_queue)
+    {
+      ControlChange change;
+      while (control_change_queue_pop (
+               AUDIO_ENGINE->ctrl_out_queue,
+               &change))
+        {
+          port_push_control_change_events (
+            change.port);
+        }
+    }
+
+  /* keep the queue from filling up */
+  event_manager_drain_queue (self);
+
+  if (self->tick_cb_id &&
+      g_get_monotonic_time () -
+        self->last_dispatch_time <
+          EVENT_MANAGER_FRAME_STALL_USEC)
+    {
+      return G_SOURCE_CONTINUE;
+    }
+
+  dispatch_events (
+    self, EVENT_MANAGER_FRAME_BUDGET_USEC);
 
   return G_SOURCE_CONTINUE;
 }
 
+static void
+remove_tick_callback (
+  EventManager * self)
+{
+  if (self->tick_cb_id)
+    {
+      gtk_widget_remove_tick_callback (
+        self->tick_widget, self->tick_cb_id);
+      self->tick_cb_id = 0;
+      self->tick_widget = NULL;
+    }
+}
+
 /**
  * Starts accepting events.
  */
@@ -1887,6 +2260,14 @@ event_manager_new (void)
     (size_t)
     EVENT_MANAGER_MAX_EVENTS * sizeof (ZEvent *));
 
+  self->pending_events = g_ptr_array_new ();
+  self->pending_events_ht =
+    g_hash_table_new (event_hash, event_equal);
+  self->stats_period_start =
+    g_get_monotonic_time ();
+  self->log_stats =
+    env_get_int ("ZRYTHM_EVENT_STATS", 0) != 0;
+
   return self;
 }
 
@@ -1903,10 +2284,11 @@ event_manager_stop_events (
       g_source_remove_and_zero (
         self->process_source_id);
     }
+  remove_tick_callback (self);
 
   /* process any remaining events - clear the
    * queue. */
-  process_events (self);
+  dispatch_events (self, 0);
 }
 
 /**
@@ -1923,7 +2305,7 @@ event_manager_process_now (
   g_message ("processing events now...");
 
   /* process events now */
-  process_events (self);
+  dispatch_events (self, 0);
 
   g_message ("done");
 }
@@ -1939,6 +2321,23 @@ event_manager_remove_events_for_obj (
   EventManager * self,
   void *         obj)
 {
+  for (guint i = self->pending_events->len;
+       i-- > self->pending_events_start;)
+    {
+      ZEvent * event =
+        (ZEvent *)
+        g_ptr_array_index (self->pending_events, i);
+      if (event->arg == obj)
+        {
+          g_hash_table_remove (
+            self->pending_events_ht, event);
+          g_ptr_array_remove_index (
+            self->pending_events, i);
+          object_pool_return (
+            self->obj_pool, event);
+        }
+    }
+
   MPMCQueue * q = self->mqueue;
   ZEvent * event;
   while (event_queue_dequeue_event (q, &event))
@@ -1955,6 +2354,58 @@ event_manager_remove_events_for_obj (
     }
 }
 
+/**
+ * Returns the statistics for the given event
+ * type.
+ *
+ * Must only be called from the GTK thread.
+ */
+const EventTypeStats *
+event_manager_get_type_stats (
+  EventManager * self,
+  EventType      type)
+{
+  g_return_val_if_fail (
+    self && type >= 0 && type < NUM_EVENT_TYPES,
+    NULL);
+
+  return &self->stats[type];
+}
+
+/**
+ * Logs the statistics of all event types that
+ * were pushed at least once.
+ */
+void
+event_manager_log_stats (
+  EventManager * self)
+{
+  g_return_if_fail (self);
+
+  for (int i = 0; i < NUM_EVENT_TYPES; i++)
+    {
+      EventTypeStats * stats = &self->stats[i];
+      if (stats->num_pushed == 0)
+        continue;
+
+      g_message (
+        "event %d: pushed %" G_GUINT64_FORMAT
+        " (%.1f/s), coalesced %" G_GUINT64_FORMAT
+        ", dispatched %" G_GUINT64_FORMAT
+        " (%.1f/s), avg %.1f us, max %"
+        G_GINT64_FORMAT " us",
+        i, stats->num_pushed, stats->push_rate,
+        stats->num_coalesced,
+        stats->num_dispatched,
+        stats->dispatch_rate,
+        stats->num_dispatched > 0 ?
+          (double) stats->total_dispatch_usec /
+            (double) stats->num_dispatched :
+          0.0,
+        stats->max_dispatch_usec);
+    }
+}
+
 void
 event_manager_free (
   EventManager * self)
@@ -1963,6 +2414,13 @@ event_manager_free (
 
   event_manager_stop_events (self);
 
+  object_free_w_func_and_null (
+    g_hash_table_destroy, self->pending_events_ht);
+  if (self->pending_events)
+    {
+      g_ptr_array_free (self->pending_events, true);
+      self->pending_events = NULL;
+    }
   object_free_w_func_and_null (
     object_pool_free, self->obj_pool);
   object_free_w_func_and_null (
@@ -0,0 +1,1697 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/engine.h"
+#include "gui/backend/event.h"
+#include "gui/backend/event_manager.h"
+#include "gui/backend/file_index.h"
+#include "project.h"
+#include "utils/dsp.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
+
+#include <audec/audec.h>
+
+#include <glib.h>
+
+/** GVariant type of a serialized entry. */
+#define ENTRY_VARIANT_TYPE "(ayixxbuuiixdsayb)"
+
+/** GVariant type of the cache file. */
+#define CACHE_VARIANT_TYPE \
+  "(ua" ENTRY_VARIANT_TYPE ")"
+
+#define ENUMERATE_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+/** Min interval between UI notifications. */
+#define NOTIFY_INTERVAL_MS 200
+
+typedef enum FileIndexTaskType
+{
+  /** Enumerate a directory. */
+  TASK_CRAWL_DIR,
+
+  /** Index a single file or directory. */
+  TASK_SCAN_PATH,
+} FileIndexTaskType;
+
+/**
+ * Task priorities (lower runs first).
+ *
+ * Crawling comes before probing so that listings
+ * become available as soon as possible.
+ */
+typedef enum FileIndexTaskPriority
+{
+  PRIORITY_REQUEST,
+  PRIORITY_CRAWL,
+  PRIORITY_SCAN,
+} FileIndexTaskPriority;
+
+typedef struct FileIndexTask
+{
+  FileIndexTaskType     type;
+  FileIndexTaskPriority priority;
+  gint                  seq;
+  char *                path;
+
+  /** Whether the mtime/size below are known. */
+  bool                  have_stat;
+  gint64                mtime;
+  gint64                size;
+} FileIndexTask;
+
+static void
+task_free (
+  FileIndexTask * self)
+{
+  g_free (self->path);
+
+  object_zero_and_free (self);
+}
+
+static gint
+cmp_tasks (
+  gconstpointer a,
+  gconstpointer b,
+  gpointer      user_data)
+{
+  const FileIndexTask * ta =
+    (const FileIndexTask *) a;
+  const FileIndexTask * tb =
+    (const FileIndexTask *) b;
+  if (ta->priority != tb->priority)
+    return (int) ta->priority - (int) tb->priority;
+  return ta->seq - tb->seq;
+}
+
+/**
+ * Returns whether \p path is \p dir or is inside
+ * it.
+ */
+static bool
+path_is_in_dir (
+  const char * path,
+  const char * dir,
+  size_t       dir_len)
+{
+  if (strncmp (path, dir, dir_len) != 0)
+    return false;
+
+  return
+    path[dir_len] == '\0' ||
+    path[dir_len] == G_DIR_SEPARATOR ||
+    (dir_len > 0 &&
+     dir[dir_len - 1] == G_DIR_SEPARATOR);
+}
+
+/**
+ * Returns a copy of the path without trailing
+ * separators.
+ */
+static char *
+normalize_dir (
+  const char * dir)
+{
+  char * ret = g_strdup (dir);
+  size_t len = strlen (ret);
+  while (len > 1 &&
+         ret[len - 1] == G_DIR_SEPARATOR)
+    {
+      ret[--len] = '\0';
+    }
+  return ret;
+}
+
+static gint64
+get_mtime (
+  GFileInfo * info)
+{
+  return
+    (gint64)
+    g_file_info_get_attribute_uint64 (
+      info, G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+      G_USEC_PER_SEC +
+    (gint64)
+    g_file_info_get_attribute_uint32 (
+      info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+static FileIndexEntry *
+entry_new (
+  const char * path,
+  ZFileType    type)
+{
+  FileIndexEntry * self =
+    object_new (FileIndexEntry);
+
+  self->abs_path = g_strdup (path);
+  const char * sep =
+    strrchr (path, G_DIR_SEPARATOR);
+  self->name_offset =
+    sep ? (size_t) (sep - path) + 1 : 0;
+  const char * name = &path[self->name_offset];
+  char * display_name =
+    g_filename_display_name (name);
+  self->search_key =
+    g_utf8_casefold (display_name, -1);
+  g_free (display_name);
+  self->type = type;
+
+  if (type != FILE_TYPE_DIR)
+    {
+      file_index_parse_tags_from_name (
+        name, &self->bpm, self->key,
+        sizeof (self->key));
+    }
+
+  return self;
+}
+
+/**
+ * Returns a human readable summary of the audio
+ * info, BPM and key of the entry.
+ */
+char *
+file_index_entry_get_info_str (
+  const FileIndexEntry * self)
+{
+  GString * str = g_string_new (NULL);
+  if (self->has_info)
+    {
+      g_string_append_printf (
+        str,
+        "Sample rate: %u\nChannels: %u "
+        "Bitrate: %d\nBit depth: %d",
+        self->sample_rate, self->channels,
+        self->bit_rate, self->bit_depth);
+      if (self->sample_rate > 0)
+        {
+          g_string_append_printf (
+            str, "\nLength: %.2f s",
+            (double) self->num_frames /
+              (double) self->sample_rate);
+        }
+    }
+  if (self->bpm > 0.0)
+    {
+      g_string_append_printf (
+        str, "%sBPM: %.1f",
+        str->len > 0 ? "\n" : "", self->bpm);
+    }
+  if (self->key[0] != '\0')
+    {
+      g_string_append_printf (
+        str, "%sKey: %s",
+        str->len > 0 ? "\n" : "", self->key);
+    }
+
+  return g_string_free (str, false);
+}
+
+FileIndexEntry *
+file_index_entry_clone (
+  const FileIndexEntry * src)
+{
+  FileIndexEntry * self =
+    object_new (FileIndexEntry);
+
+  *self = *src;
+  self->abs_path = g_strdup (src->abs_path);
+  self->search_key = g_strdup (src->search_key);
+
+  return self;
+}
+
+void
+file_index_entry_free (
+  FileIndexEntry * self)
+{
+  g_free (self->abs_path);
+  g_free (self->search_key);
+
+  object_zero_and_free (self);
+}
+
+static void
+root_free (
+  FileIndexRoot * self)
+{
+  g_free (self->path);
+
+  object_zero_and_free (self);
+}
+
+static void
+cancel_and_unref_monitor (
+  GFileMonitor * monitor)
+{
+  g_file_monitor_cancel (monitor);
+  g_object_unref (monitor);
+}
+
+static gboolean
+notify_cb (
+  FileIndex * self)
+{
+  g_mutex_lock (&self->mutex);
+  self->notify_source_id = 0;
+  g_mutex_unlock (&self->mutex);
+
+  EVENTS_PUSH (ET_FILE_INDEX_UPDATED, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Schedules a UI notification.
+ *
+ * Notifications are rate-limited so that indexing
+ * large libraries does not flood the event
+ * queue.
+ */
+static void
+notify (
+  FileIndex * self)
+{
+  if (!ZRYTHM || !ZRYTHM_HAVE_UI ||
+      g_atomic_int_get (&self->cancelled))
+    return;
+
+  g_mutex_lock (&self->mutex);
+  if (self->notify_source_id == 0)
+    {
+      self->notify_source_id =
+        g_timeout_add (
+          NOTIFY_INTERVAL_MS,
+          (GSourceFunc) notify_cb, self);
+    }
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+push_task (
+  FileIndex *           self,
+  FileIndexTaskType     type,
+  FileIndexTaskPriority priority,
+  const char *          path,
+  GFileInfo *           info)
+{
+  if (g_atomic_int_get (&self->cancelled))
+    return;
+
+  FileIndexTask * task = object_new (FileIndexTask);
+  task->type = type;
+  task->priority = priority;
+  task->seq =
+    g_atomic_int_add (&self->task_seq, 1);
+  task->path = g_strdup (path);
+  if (info)
+    {
+      task->have_stat = true;
+      task->mtime = get_mtime (info);
+      task->size = g_file_info_get_size (info);
+    }
+
+  g_atomic_int_inc (&self->num_pending);
+  g_thread_pool_push (self->pool, task, NULL);
+}
+
+/**
+ * Adds a placeholder entry if none exists and
+ * marks it as seen.
+ *
+ * Must be called with the mutex held.
+ */
+static FileIndexEntry *
+touch_entry (
+  FileIndex *  self,
+  const char * path,
+  ZFileType    type)
+{
+  FileIndexEntry * e =
+    g_hash_table_lookup (self->entries, path);
+  if (!e || e->type != type)
+    {
+      e = entry_new (path, type);
+      g_hash_table_replace (
+        self->entries, e->abs_path, e);
+      self->dirty = true;
+    }
+  e->seen_gen = self->gen;
+
+  return e;
+}
+
+static void
+remove_path (
+  FileIndex *  self,
+  const char * path)
+{
+  size_t len = strlen (path);
+
+  g_mutex_lock (&self->mutex);
+  FileIndexEntry * e =
+    g_hash_table_lookup (self->entries, path);
+  bool is_dir = e && e->type == FILE_TYPE_DIR;
+  if (e)
+    {
+      g_hash_table_remove (self->entries, path);
+      self->dirty = true;
+    }
+  if (is_dir)
+    {
+      GHashTableIter iter;
+      gpointer key;
+      g_hash_table_iter_init (
+        &iter, self->entries);
+      while (g_hash_table_iter_next (
+               &iter, &key, NULL))
+        {
+          if (path_is_in_dir (key, path, len))
+            g_hash_table_iter_remove (&iter);
+        }
+      g_hash_table_iter_init (
+        &iter, self->monitors);
+      while (g_hash_table_iter_next (
+               &iter, &key, NULL))
+        {
+          if (path_is_in_dir (key, path, len))
+            g_hash_table_iter_remove (&iter);
+        }
+    }
+  g_mutex_unlock (&self->mutex);
+
+  notify (self);
+}
+
+static void
+on_monitor_changed (
+  GFileMonitor *    monitor,
+  GFile *           file,
+  GFile *           other_file,
+  GFileMonitorEvent event_type,
+  FileIndex *       self)
+{
+  char * path = g_file_get_path (file);
+  if (!path)
+    return;
+
+  char * basename = g_path_get_basename (path);
+  bool hidden = basename[0] == '.';
+  g_free (basename);
+
+  if (!hidden)
+    {
+      switch (event_type)
+        {
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+          push_task (
+            self, TASK_SCAN_PATH, PRIORITY_SCAN,
+            path, NULL);
+          break;
+        case G_FILE_MONITOR_EVENT_DELETED:
+          remove_path (self, path);
+          break;
+        default:
+          break;
+        }
+    }
+
+  g_free (path);
+}
+
+/**
+ * Starts watching the given directory.
+ *
+ * Monitors created in the indexer threads deliver
+ * their signals to the default main context.
+ */
+static void
+add_monitor (
+  FileIndex *  self,
+  GFile *      dir,
+  const char * path)
+{
+  g_mutex_lock (&self->mutex);
+  bool skip =
+    g_hash_table_size (self->monitors) >=
+      FILE_INDEX_MAX_MONITORS ||
+    g_hash_table_contains (self->monitors, path);
+  g_mutex_unlock (&self->mutex);
+  if (skip)
+    return;
+
+  GError * err = NULL;
+  GFileMonitor * monitor =
+    g_file_monitor_directory (
+      dir, G_FILE_MONITOR_NONE, NULL, &err);
+  if (!monitor)
+    {
+      g_debug (
+        "%s: cannot watch %s: %s", __func__,
+        path, err->message);
+      g_error_free (err);
+      return;
+    }
+  g_signal_connect (
+    monitor, "changed",
+    G_CALLBACK (on_monitor_changed), self);
+
+  g_mutex_lock (&self->mutex);
+  if (g_hash_table_contains (self->monitors, path))
+    {
+      cancel_and_unref_monitor (monitor);
+    }
+  else
+    {
+      g_hash_table_insert (
+        self->monitors, g_strdup (path), monitor);
+    }
+  g_mutex_unlock (&self->mutex);
+}
+
+static void
+compute_peaks (
+  FileIndexEntry * e,
+  float *          frames,
+  size_t           num_frames,
+  unsigned int     channels)
+{
+  for (size_t i = 0; i < FILE_INDEX_NUM_PEAKS; i++)
+    {
+      size_t start =
+        (num_frames * i) / FILE_INDEX_NUM_PEAKS;
+      size_t end =
+        (num_frames * (i + 1)) /
+          FILE_INDEX_NUM_PEAKS;
+      float peak = 0.f;
+      if (end > start)
+        {
+          dsp_abs_max (
+            &frames[start * channels], &peak,
+            (end - start) * channels);
+        }
+      e->peaks[i] =
+        (guint8)
+        (CLAMP (peak, 0.f, 1.f) * 255.f + 0.5f);
+    }
+  e->num_peaks = FILE_INDEX_NUM_PEAKS;
+}
+
+/**
+ * Reads the audio info and generates the
+ * thumbnail.
+ */
+static void
+probe_audio (
+  FileIndexEntry * e)
+{
+  AudecInfo nfo;
+  memset (&nfo, 0, sizeof (AudecInfo));
+  AudecHandle * handle =
+    audec_open (e->abs_path, &nfo);
+  if (!handle)
+    {
+      g_message (
+        "%s: failed to open %s", __func__,
+        e->abs_path);
+      return;
+    }
+
+  e->sample_rate = nfo.sample_rate;
+  e->channels = nfo.channels;
+  e->bit_rate = nfo.bit_rate;
+  e->bit_depth = nfo.bit_depth;
+  e->num_frames = nfo.frames;
+  e->has_info = true;
+
+  if (nfo.channels > 0 && nfo.frames > 0 &&
+      nfo.frames * (gint64) nfo.channels <=
+        FILE_INDEX_MAX_PEAK_SAMPLES)
+    {
+      float * frames = NULL;
+      ssize_t num_frames =
+        audec_read (
+          handle, &frames, (int) nfo.sample_rate);
+      if (num_frames > 0 && frames)
+        {
+          e->num_frames = num_frames;
+          compute_peaks (
+            e, frames, (size_t) num_frames,
+            nfo.channels);
+        }
+      free (frames);
+    }
+
+  audec_close (handle);
+}
+
+/**
+ * Marks the entry as seen and returns true if it
+ * was indexed with the given mtime and size.
+ *
+ * Must be called with the mutex held.
+ */
+static bool
+mark_seen_if_up_to_date (
+  FileIndex *  self,
+  const char * path,
+  ZFileType    type,
+  gint64       mtime,
+  gint64       size)
+{
+  FileIndexEntry * e =
+    g_hash_table_lookup (self->entries, path);
+  if (e && e->type == type && e->mtime == mtime &&
+      e->size == size)
+    {
+      e->seen_gen = self->gen;
+      return true;
+    }
+  return false;
+}
+
+/**
+ * Indexes a regular file, probing it if it is an
+ * audio file that is new or was modified since it
+ * was last indexed.
+ */
+static void
+scan_file (
+  FileIndex *  self,
+  const char * path,
+  gint64       mtime,
+  gint64       size)
+{
+  ZFileType type = supported_file_get_type (path);
+
+  g_mutex_lock (&self->mutex);
+  bool up_to_date =
+    mark_seen_if_up_to_date (
+      self, path, type, mtime, size);
+  g_mutex_unlock (&self->mutex);
+  if (up_to_date)
+    return;
+
+  FileIndexEntry * e = entry_new (path, type);
+  if (supported_file_type_is_audio (type))
+    {
+      probe_audio (e);
+    }
+  e->mtime = mtime;
+  e->size = size;
+
+  g_mutex_lock (&self->mutex);
+  e->seen_gen = self->gen;
+  g_hash_table_replace (
+    self->entries, e->abs_path, e);
+  self->dirty = true;
+  g_mutex_unlock (&self->mutex);
+
+  notify (self);
+}
+
+static void
+set_root_available (
+  FileIndex *  self,
+  const char * path,
+  bool         available)
+{
+  g_mutex_lock (&self->mutex);
+  for (guint i = 0; i < self->roots->len; i++)
+    {
+      FileIndexRoot * root =
+        g_ptr_array_index (self->roots, i);
+      if (g_str_equal (root->path, path))
+        root->available = available;
+    }
+  g_mutex_unlock (&self->mutex);
+}
+
+/**
+ * Enumerates the given directory, queueing
+ * subdirectories and files that need probing.
+ */
+static void
+crawl_dir (
+  FileIndex *  self,
+  const char * path)
+{
+  GError * err = NULL;
+  GFile * dir = g_file_new_for_path (path);
+
+  /* skip directories already crawled through
+   * another path (symlink loops) */
+  GFileInfo * dir_info =
+    g_file_query_info (
+      dir, G_FILE_ATTRIBUTE_ID_FILE,
+      G_FILE_QUERY_INFO_NONE, NULL, &err);
+  if (!dir_info)
+    {
+      g_message (
+        "%s: cannot open %s: %s", __func__,
+        path, err->message);
+      g_error_free (err);
+      set_root_available (self, path, false);
+      g_object_unref (dir);
+      return;
+    }
+  const char * id =
+    g_file_info_get_attribute_string (
+      dir_info, G_FILE_ATTRIBUTE_ID_FILE);
+  bool visited = false;
+  if (id)
+    {
+      g_mutex_lock (&self->mutex);
+      visited =
+        g_hash_table_contains (
+          self->visited_dirs, id);
+      if (!visited)
+        {
+          g_hash_table_add (
+            self->visited_dirs, g_strdup (id));
+        }
+      g_mutex_unlock (&self->mutex);
+    }
+  g_object_unref (dir_info);
+  if (visited)
+    {
+      g_object_unref (dir);
+      return;
+    }
+
+  GFileEnumerator * enumerator =
+    g_file_enumerate_children (
+      dir, ENUMERATE_ATTRIBUTES,
+      G_FILE_QUERY_INFO_NONE, NULL, &err);
+  if (!enumerator)
+    {
+      g_message (
+        "%s: cannot enumerate %s: %s", __func__,
+        path, err->message);
+      g_error_free (err);
+      set_root_available (self, path, false);
+      g_object_unref (dir);
+      return;
+    }
+
+  GFileInfo * info;
+  while (!g_atomic_int_get (&self->cancelled) &&
+         (info =
+            g_file_enumerator_next_file (
+              enumerator, NULL, &err)))
+    {
+      const char * name =
+        g_file_info_get_name (info);
+      if (name[0] == '.')
+        {
+          g_object_unref (info);
+          continue;
+        }
+
+      char * child_path =
+        g_build_filename (path, name, NULL);
+      switch (g_file_info_get_file_type (info))
+        {
+        case G_FILE_TYPE_DIRECTORY:
+          g_mutex_lock (&self->mutex);
+          touch_entry (
+            self, child_path, FILE_TYPE_DIR);
+          g_mutex_unlock (&self->mutex);
+          push_task (
+            self, TASK_CRAWL_DIR, PRIORITY_CRAWL,
+            child_path, NULL);
+          break;
+        case G_FILE_TYPE_REGULAR:
+          {
+            ZFileType type =
+              supported_file_get_type (name);
+            gint64 mtime = get_mtime (info);
+            gint64 size =
+              g_file_info_get_size (info);
+            if (!supported_file_type_is_audio (
+                  type))
+              {
+                scan_file (
+                  self, child_path, mtime, size);
+                break;
+              }
+
+            /* probe new or modified audio files in
+             * another task, adding a placeholder
+             * so that the file is listed in the
+             * meantime */
+            g_mutex_lock (&self->mutex);
+            bool up_to_date =
+              mark_seen_if_up_to_date (
+                self, child_path, type, mtime,
+                size);
+            if (!up_to_date)
+              {
+                touch_entry (
+                  self, child_path, type);
+              }
+            g_mutex_unlock (&self->mutex);
+            if (!up_to_date)
+              {
+                push_task (
+                  self, TASK_SCAN_PATH,
+                  PRIORITY_SCAN, child_path, info);
+              }
+          }
+          break;
+        default:
+          break;
+        }
+      g_free (child_path);
+      g_object_unref (info);
+    }
+  if (err)
+    {
+      g_message (
+        "%s: error enumerating %s: %s", __func__,
+        path, err->message);
+      g_error_free (err);
+    }
+  g_object_unref (enumerator);
+
+  g_mutex_lock (&self->mutex);
+  FileIndexEntry * e =
+    touch_entry (self, path, FILE_TYPE_DIR);
+  if (!e->listed)
+    {
+      e->listed = true;
+      self->dirty = true;
+    }
+  g_mutex_unlock (&self->mutex);
+
+  add_monitor (self, dir, path);
+  g_object_unref (dir);
+
+  notify (self);
+}
+
+static void
+scan_path (
+  FileIndex *     self,
+  FileIndexTask * task)
+{
+  if (task->have_stat)
+    {
+      scan_file (
+        self, task->path, task->mtime,
+        task->size);
+      return;
+    }
+
+  GFile * file = g_file_new_for_path (task->path);
+  GFileInfo * info =
+    g_file_query_info (
+      file, ENUMERATE_ATTRIBUTES,
+      G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (file);
+  if (!info)
+    {
+      remove_path (self, task->path);
+      return;
+    }
+
+  switch (g_file_info_get_file_type (info))
+    {
+    case G_FILE_TYPE_DIRECTORY:
+      crawl_dir (self, task->path);
+      break;
+    case G_FILE_TYPE_REGULAR:
+      scan_file (
+        self, task->path, get_mtime (info),
+        g_file_info_get_size (info));
+      break;
+    default:
+      break;
+    }
+  g_object_unref (info);
+}
+
+static bool
+is_in_unavailable_root (
+  FileIndex *  self,
+  const char * path)
+{
+  for (guint i = 0; i < self->roots->len; i++)
+    {
+      FileIndexRoot * root =
+        g_ptr_array_index (self->roots, i);
+      if (!root->available &&
+          path_is_in_dir (
+            path, root->path,
+            strlen (root->path)))
+        return true;
+    }
+  return false;
+}
+
+/**
+ * Removes entries that were not seen in the
+ * current generation.
+ *
+ * Must be called with the mutex held.
+ */
+static void
+remove_stale_entries (
+  FileIndex * self)
+{
+  GHashTableIter iter;
+  FileIndexEntry * e;
+  guint num_removed = 0;
+  g_hash_table_iter_init (&iter, self->entries);
+  while (g_hash_table_iter_next (
+           &iter, NULL, (gpointer *) &e))
+    {
+      if (e->seen_gen != self->gen &&
+          !is_in_unavailable_root (
+            self, e->abs_path))
+        {
+          g_hash_table_iter_remove (&iter);
+          num_removed++;
+        }
+    }
+  if (num_removed > 0)
+    {
+      self->dirty = true;
+    }
+
+  g_message (
+    "%s: %u entries indexed, %u removed",
+    __func__, g_hash_table_size (self->entries),
+    num_removed);
+}
+
+/**
+ * Called by the last thread to finish a task.
+ */
+static void
+on_idle (
+  FileIndex * self)
+{
+  g_mutex_lock (&self->mutex);
+
+  /* new work may have been queued in the
+   * meantime */
+  if (g_atomic_int_get (&self->num_pending) > 0)
+    {
+      g_mutex_unlock (&self->mutex);
+      return;
+    }
+
+  if (self->crawling)
+    {
+      remove_stale_entries (self);
+      self->crawling = false;
+    }
+  g_hash_table_remove_all (self->visited_dirs);
+  bool dirty = self->dirty;
+  g_mutex_unlock (&self->mutex);
+
+  if (dirty && self->cache_path)
+    {
+      GError * err = NULL;
+      if (!file_index_save (self, &err))
+        {
+          g_warning (
+            "failed to save file index: %s",
+            err->message);
+          g_error_free (err);
+        }
+    }
+
+  notify (self);
+}
+
+static void
+finish_task (
+  FileIndex * self)
+{
+  if (g_atomic_int_dec_and_test (
+        &self->num_pending) &&
+      !g_atomic_int_get (&self->cancelled))
+    {
+      on_idle (self);
+    }
+}
+
+static void
+process_task (
+  FileIndexTask * task,
+  FileIndex *     self)
+{
+  if (!g_atomic_int_get (&self->cancelled))
+    {
+      switch (task->type)
+        {
+        case TASK_CRAWL_DIR:
+          crawl_dir (self, task->path);
+          break;
+        case TASK_SCAN_PATH:
+          scan_path (self, task);
+          break;
+        }
+    }
+  task_free (task);
+
+  finish_task (self);
+}
+
+static FileIndexEntry *
+entry_from_variant (
+  GVariant * v)
+{
+  const char * path;
+  const char * key;
+  gint32 type;
+  gint64 mtime, size, num_frames;
+  gboolean has_info, listed;
+  guint32 sample_rate, channels;
+  gint32 bit_rate, bit_depth;
+  double bpm;
+  GVariant * peaks_v;
+  g_variant_get (
+    v, "(^&ayixxbuuiixd&s@ayb)", &path, &type,
+    &mtime, &size, &has_info, &sample_rate,
+    &channels, &bit_rate, &bit_depth,
+    &num_frames, &bpm, &key, &peaks_v, &listed);
+
+  FileIndexEntry * e = NULL;
+  if (g_path_is_absolute (path) && type >= 0 &&
+      type < NUM_FILE_TYPES)
+    {
+      e = entry_new (path, (ZFileType) type);
+      e->mtime = mtime;
+      e->size = size;
+      e->has_info = has_info;
+      e->sample_rate = sample_rate;
+      e->channels = channels;
+      e->bit_rate = bit_rate;
+      e->bit_depth = bit_depth;
+      e->num_frames = num_frames;
+      e->bpm = bpm;
+      g_strlcpy (e->key, key, sizeof (e->key));
+      gsize num_peaks;
+      const guint8 * peaks =
+        g_variant_get_fixed_array (
+          peaks_v, &num_peaks, sizeof (guint8));
+      e->num_peaks =
+        (int) MIN (num_peaks, FILE_INDEX_NUM_PEAKS);
+      memcpy (
+        e->peaks, peaks, (size_t) e->num_peaks);
+      e->listed = listed;
+    }
+  g_variant_unref (peaks_v);
+
+  return e;
+}
+
+static GVariant *
+entry_to_variant (
+  const FileIndexEntry * e)
+{
+  return
+    g_variant_new (
+      "(^ayixxbuuiixds@ayb)", e->abs_path,
+      (gint32) e->type, e->mtime, e->size,
+      (gboolean) e->has_info,
+      (guint32) e->sample_rate,
+      (guint32) e->channels,
+      (gint32) e->bit_rate, (gint32) e->bit_depth,
+      e->num_frames, e->bpm, e->key,
+      g_variant_new_fixed_array (
+        G_VARIANT_TYPE_BYTE, e->peaks,
+        (gsize) e->num_peaks, sizeof (guint8)),
+      (gboolean) e->listed);
+}
+
+static void
+load_cache (
+  FileIndex * self)
+{
+  GError * err = NULL;
+  GMappedFile * mapped_file =
+    g_mapped_file_new (
+      self->cache_path, false, &err);
+  if (!mapped_file)
+    {
+      if (!g_error_matches (
+             err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        {
+          g_message (
+            "%s: cannot read %s: %s", __func__,
+            self->cache_path, err->message);
+        }
+      g_error_free (err);
+      return;
+    }
+
+  GBytes * bytes =
+    g_mapped_file_get_bytes (mapped_file);
+  g_mapped_file_unref (mapped_file);
+  GVariant * v =
+    g_variant_new_from_bytes (
+      G_VARIANT_TYPE (CACHE_VARIANT_TYPE), bytes,
+      false);
+  g_variant_ref_sink (v);
+  g_bytes_unref (bytes);
+
+  guint32 version;
+  GVariant * entries_v;
+  g_variant_get (
+    v, "(u@a" ENTRY_VARIANT_TYPE ")", &version,
+    &entries_v);
+  if (version == FILE_INDEX_CACHE_VERSION)
+    {
+      GVariantIter iter;
+      GVariant * child;
+      g_variant_iter_init (&iter, entries_v);
+      while ((child =
+                g_variant_iter_next_value (&iter)))
+        {
+          FileIndexEntry * e =
+            entry_from_variant (child);
+          if (e)
+            {
+              g_hash_table_replace (
+                self->entries, e->abs_path, e);
+            }
+          g_variant_unref (child);
+        }
+      g_message (
+        "%s: loaded %u entries from %s", __func__,
+        g_hash_table_size (self->entries),
+        self->cache_path);
+    }
+  else
+    {
+      g_message (
+        "%s: ignoring %s (version %u)", __func__,
+        self->cache_path, version);
+    }
+  g_variant_unref (entries_v);
+  g_variant_unref (v);
+}
+
+/**
+ * Writes the index to the cache file.
+ *
+ * @return Whether successful.
+ */
+bool
+file_index_save (
+  FileIndex * self,
+  GError **   error)
+{
+  g_return_val_if_fail (
+    self && self->cache_path, false);
+
+  g_mutex_lock (&self->save_mutex);
+
+  GVariantBuilder builder;
+  g_variant_builder_init (
+    &builder,
+    G_VARIANT_TYPE ("a" ENTRY_VARIANT_TYPE));
+  g_mutex_lock (&self->mutex);
+  GHashTableIter iter;
+  FileIndexEntry * e;
+  g_hash_table_iter_init (&iter, self->entries);
+  while (g_hash_table_iter_next (
+           &iter, NULL, (gpointer *) &e))
+    {
+      g_variant_builder_add_value (
+        &builder, entry_to_variant (e));
+    }
+  self->dirty = false;
+  g_mutex_unlock (&self->mutex);
+
+  GVariant * v =
+    g_variant_new (
+      "(u@a" ENTRY_VARIANT_TYPE ")",
+      (guint32) FILE_INDEX_CACHE_VERSION,
+      g_variant_builder_end (&builder));
+  g_variant_ref_sink (v);
+
+  char * dir = g_path_get_dirname (self->cache_path);
+  io_mkdir (dir);
+  g_free (dir);
+  bool ret =
+    g_file_set_contents (
+      self->cache_path, g_variant_get_data (v),
+      (gssize) g_variant_get_size (v), error);
+  g_variant_unref (v);
+
+  if (!ret)
+    {
+      g_mutex_lock (&self->mutex);
+      self->dirty = true;
+      g_mutex_unlock (&self->mutex);
+    }
+
+  g_mutex_unlock (&self->save_mutex);
+
+  return ret;
+}
+
+/**
+ * Creates a new index and loads the cache file,
+ * if any.
+ *
+ * @param cache_path Cache file path, or NULL.
+ */
+FileIndex *
+file_index_new (
+  const char * cache_path)
+{
+  FileIndex * self = object_new (FileIndex);
+
+  g_mutex_init (&self->mutex);
+  g_mutex_init (&self->save_mutex);
+  self->entries =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) file_index_entry_free);
+  self->roots =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) root_free);
+  self->visited_dirs =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free, NULL);
+  self->monitors =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) cancel_and_unref_monitor);
+
+  if (cache_path)
+    {
+      self->cache_path = g_strdup (cache_path);
+      load_cache (self);
+    }
+
+  GError * err = NULL;
+  self->pool =
+    g_thread_pool_new (
+      (GFunc) process_task, self,
+      CLAMP (
+        (int) g_get_num_processors () - 1, 1,
+        FILE_INDEX_MAX_THREADS),
+      false, &err);
+  if (!self->pool)
+    {
+      g_critical (
+        "failed to create indexer threads: %s",
+        err->message);
+      g_error_free (err);
+      file_index_free (self);
+      return NULL;
+    }
+  g_thread_pool_set_sort_function (
+    self->pool, cmp_tasks, NULL);
+
+  return self;
+}
+
+/**
+ * Sets the root directories to index and starts
+ * crawling them.
+ *
+ * Entries outside the roots are dropped when the
+ * crawl finishes, except for entries of roots
+ * that are currently unavailable (eg, unmounted
+ * drives).
+ *
+ * @param paths NULL-terminated array of paths.
+ */
+void
+file_index_set_roots (
+  FileIndex *          self,
+  const char * const * paths)
+{
+  g_return_if_fail (self && paths);
+
+  g_mutex_lock (&self->mutex);
+  g_ptr_array_set_size (self->roots, 0);
+  for (int i = 0; paths[i]; i++)
+    {
+      if (!g_path_is_absolute (paths[i]))
+        continue;
+
+      char * path = normalize_dir (paths[i]);
+      bool exists = false;
+      for (guint j = 0; j < self->roots->len; j++)
+        {
+          FileIndexRoot * root =
+            g_ptr_array_index (self->roots, j);
+          if (g_str_equal (root->path, path))
+            exists = true;
+        }
+      if (exists)
+        {
+          g_free (path);
+          continue;
+        }
+
+      FileIndexRoot * root =
+        object_new (FileIndexRoot);
+      root->path = path;
+      root->available = true;
+      g_ptr_array_add (self->roots, root);
+    }
+  self->gen++;
+  self->crawling = true;
+
+  /* hold a pending count until the roots are
+   * queued so that the crawl is not considered
+   * finished early */
+  g_atomic_int_inc (&self->num_pending);
+
+  /* copy the paths so the tasks can be pushed
+   * without holding the lock */
+  GPtrArray * root_paths =
+    g_ptr_array_new_with_free_func (g_free);
+  for (guint i = 0; i < self->roots->len; i++)
+    {
+      FileIndexRoot * root =
+        g_ptr_array_index (self->roots, i);
+      g_ptr_array_add (
+        root_paths, g_strdup (root->path));
+    }
+  g_mutex_unlock (&self->mutex);
+
+  for (guint i = 0; i < root_paths->len; i++)
+    {
+      push_task (
+        self, TASK_CRAWL_DIR, PRIORITY_CRAWL,
+        g_ptr_array_index (root_paths, i), NULL);
+    }
+  g_ptr_array_unref (root_paths);
+
+  finish_task (self);
+}
+
+/**
+ * Queues the given file or directory to be
+ * (re)indexed before any other pending work.
+ */
+void
+file_index_request_path (
+  FileIndex *  self,
+  const char * path)
+{
+  g_return_if_fail (self && path);
+
+  push_task (
+    self, TASK_SCAN_PATH, PRIORITY_REQUEST, path,
+    NULL);
+}
+
+/**
+ * Returns a copy of the entry for the given path,
+ * or NULL if not indexed.
+ */
+FileIndexEntry *
+file_index_get_entry (
+  FileIndex *  self,
+  const char * path)
+{
+  g_return_val_if_fail (self && path, NULL);
+
+  g_mutex_lock (&self->mutex);
+  FileIndexEntry * e =
+    g_hash_table_lookup (self->entries, path);
+  FileIndexEntry * ret =
+    e ? file_index_entry_clone (e) : NULL;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * Returns whether the children of the given
+ * directory are indexed, so that the directory
+ * can be listed with file_index_query().
+ */
+bool
+file_index_is_dir_listed (
+  FileIndex *  self,
+  const char * dir)
+{
+  g_return_val_if_fail (self && dir, false);
+
+  char * path = normalize_dir (dir);
+  g_mutex_lock (&self->mutex);
+  FileIndexEntry * e =
+    g_hash_table_lookup (self->entries, path);
+  bool ret =
+    e && e->type == FILE_TYPE_DIR && e->listed;
+  g_mutex_unlock (&self->mutex);
+  g_free (path);
+
+  return ret;
+}
+
+static bool
+matches_words (
+  const char *  search_key,
+  char **       words)
+{
+  for (int i = 0; words[i]; i++)
+    {
+      if (words[i][0] != '\0' &&
+          !strstr (search_key, words[i]))
+        return false;
+    }
+  return true;
+}
+
+static gint
+cmp_entries_by_path (
+  gconstpointer a,
+  gconstpointer b)
+{
+  const FileIndexEntry * ea =
+    *(const FileIndexEntry * const *) a;
+  const FileIndexEntry * eb =
+    *(const FileIndexEntry * const *) b;
+  return strcmp (ea->abs_path, eb->abs_path);
+}
+
+/**
+ * Returns copies of the entries matching the
+ * given query, sorted by path.
+ *
+ * @return A GPtrArray of FileIndexEntry that
+ *   frees its elements.
+ */
+GPtrArray *
+file_index_query (
+  FileIndex *            self,
+  const FileIndexQuery * query)
+{
+  g_return_val_if_fail (
+    self && query && query->dir, NULL);
+
+  char * dir = normalize_dir (query->dir);
+  size_t dir_len = strlen (dir);
+  char ** words = NULL;
+  if (query->text && query->text[0] != '\0')
+    {
+      char * folded =
+        g_utf8_casefold (query->text, -1);
+      words = g_strsplit_set (folded, " \t", -1);
+      g_free (folded);
+    }
+
+  GPtrArray * arr =
+    g_ptr_array_new_with_free_func (
+      (GDestroyNotify) file_index_entry_free);
+
+  g_mutex_lock (&self->mutex);
+  GHashTableIter iter;
+  FileIndexEntry * e;
+  g_hash_table_iter_init (&iter, self->entries);
+  while (g_hash_table_iter_next (
+           &iter, NULL, (gpointer *) &e))
+    {
+      /* the parent dir is the path up to the
+       * last separator (or the separator itself
+       * for the filesystem root) */
+      size_t parent_len =
+        e->name_offset > 1 ?
+          e->name_offset - 1 : e->name_offset;
+      if (e->name_offset == 0 ||
+          !path_is_in_dir (
+            e->abs_path, dir, dir_len) ||
+          e->abs_path[dir_len] == '\0' ||
+          (!query->recursive &&
+           parent_len != dir_len))
+        continue;
+
+      if (words &&
+          !matches_words (e->search_key, words))
+        continue;
+
+      g_ptr_array_add (
+        arr, file_index_entry_clone (e));
+    }
+  g_mutex_unlock (&self->mutex);
+
+  g_ptr_array_sort (arr, cmp_entries_by_path);
+
+  g_strfreev (words);
+  g_free (dir);
+
+  return arr;
+}
+
+/**
+ * Returns whether there is pending work.
+ */
+bool
+file_index_is_busy (
+  FileIndex * self)
+{
+  g_mutex_lock (&self->mutex);
+  bool ret =
+    g_atomic_int_get (&self->num_pending) > 0 ||
+    self->crawling;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+/**
+ * Blocks until all pending work is done.
+ *
+ * Used in tests.
+ */
+void
+file_index_wait (
+  FileIndex * self)
+{
+  while (file_index_is_busy (self))
+    {
+      g_usleep (1000);
+    }
+}
+
+/**
+ * Parses a key from the given token.
+ *
+ * Accepts a note name with an accidental and/or
+ * a mode suffix (eg, "C#", "Ebm", "Fmaj"), so
+ * that plain letters in names are not mistaken
+ * for keys. \p next is the following token, for
+ * names like "A minor".
+ */
+static bool
+parse_key (
+  const char * token,
+  const char * next,
+  char *       key,
+  size_t       key_size)
+{
+  if (token[0] < 'A' || token[0] > 'G')
+    return false;
+
+  char note[3] = { token[0], '\0', '\0' };
+  const char * rest = &token[1];
+  if (*rest == '#' || *rest == 'b')
+    {
+      note[1] = *rest;
+      rest++;
+    }
+
+  const char * mode = rest;
+  if (*mode == '\0' && next)
+    {
+      if (g_ascii_strcasecmp (next, "minor") == 0 ||
+          g_ascii_strcasecmp (next, "min") == 0 ||
+          g_ascii_strcasecmp (next, "major") == 0 ||
+          g_ascii_strcasecmp (next, "maj") == 0)
+        {
+          mode = next;
+        }
+    }
+
+  bool minor;
+  if (g_str_equal (mode, "m") ||
+      g_ascii_strcasecmp (mode, "min") == 0 ||
+      g_ascii_strcasecmp (mode, "minor") == 0)
+    {
+      minor = true;
+    }
+  else if (
+    g_ascii_strcasecmp (mode, "maj") == 0 ||
+    g_ascii_strcasecmp (mode, "major") == 0 ||
+    (*mode == '\0' && note[1] != '\0'))
+    {
+      minor = false;
+    }
+  else
+    {
+      return false;
+    }
+
+  g_snprintf (
+    key, key_size, "%s%s", note,
+    minor ? "m" : "");
+  return true;
+}
+
+/**
+ * Parses BPM and key tags from a sample file name,
+ * eg "Loop_Cm_128bpm.wav" or "Pad 90 BPM F# minor".
+ *
+ * @param bpm Set to the BPM, or 0 if not found.
+ * @param key Set to the key (eg, "F#m"), or an
+ *   empty string if not found.
+ */
+void
+file_index_parse_tags_from_name (
+  const char * name,
+  double *     bpm,
+  char *       key,
+  size_t       key_size)
+{
+  *bpm = 0.0;
+  key[0] = '\0';
+
+  /* strip the extension */
+  char * stem = g_strdup (name);
+  char * dot = strrchr (stem, '.');
+  if (dot && dot != stem)
+    *dot = '\0';
+
+  char ** tokens =
+    g_strsplit_set (stem, " _-.,()[]{}", -1);
+  for (int i = 0; tokens[i]; i++)
+    {
+      const char * token = tokens[i];
+      if (token[0] == '\0')
+        continue;
+
+      /* find the next non-empty token */
+      const char * next = NULL;
+      for (int j = i + 1; tokens[j]; j++)
+        {
+          if (tokens[j][0] != '\0')
+            {
+              next = tokens[j];
+              break;
+            }
+        }
+
+      if (*bpm == 0.0 &&
+          g_ascii_isdigit (token[0]))
+        {
+          char * end;
+          double val =
+            g_ascii_strtod (token, &end);
+          bool has_suffix =
+            g_ascii_strcasecmp (end, "bpm") == 0 ||
+            (*end == '\0' && next &&
+             g_ascii_strcasecmp (next, "bpm") == 0);
+          if (has_suffix && val >= 40.0 &&
+              val <= 300.0)
+            {
+              *bpm = val;
+              continue;
+            }
+        }
+
+      if (key[0] == '\0')
+        {
+          parse_key (token, next, key, key_size);
+        }
+    }
+
+  g_strfreev (tokens);
+  g_free (stem);
+}
+
+/**
+ * Stops the indexer threads, saves the index and
+ * frees the instance.
+ */
+void
+file_index_free (
+  FileIndex * self)
+{
+  g_atomic_int_set (&self->cancelled, 1);
+
+  /* remaining tasks return immediately */
+  if (self->pool)
+    {
+      g_thread_pool_free (self->pool, false, true);
+      self->pool = NULL;
+    }
+
+  if (self->notify_source_id)
+    {
+      g_source_remove (self->notify_source_id);
+      self->notify_source_id = 0;
+    }
+
+  object_free_w_func_and_null (
+    g_hash_table_destroy, self->monitors);
+
+  if (self->cache_path && self->dirty)
+    {
+      GError * err = NULL;
+      if (!file_index_save (self, &err))
+        {
+          g_warning (
+            "failed to save file index: %s",
+            err->message);
+          g_error_free (err);
+        }
+    }
+
+  object_free_w_func_and_null (
+    g_hash_table_destroy, self->entries);
+  object_free_w_func_and_null (
+    g_hash_table_destroy, self->visited_dirs);
+  object_free_w_func_and_null (
+    g_ptr_array_unref, self->roots);
+  g_free (self->cache_path);
+
+  g_mutex_clear (&self->mutex);
+  g_mutex_clear (&self->save_mutex);
+
+  object_zero_and_free (self);
+}
@@ -21,13 +21,41 @@
 #include <string.h>
 
 #include "audio/supported_file.h"
+#include "gui/backend/file_index.h"
 #include "gui/backend/file_manager.h"
+#include "settings/settings.h"
+#include "utils/arrays.h"
 #include "utils/io.h"
 #include "utils/objects.h"
 #include "zrythm.h"
 
 #include "gtk/gtk.h"
 
+static char **
+get_sample_library_paths (void)
+{
+  if (ZRYTHM_TESTING)
+    {
+      return g_new0 (char *, 1);
+    }
+
+  return
+    g_settings_get_strv (
+      S_P_GENERAL_PATHS, "sample-library-paths");
+}
+
+static void
+on_sample_library_paths_changed (
+  GSettings *   settings,
+  const char *  key,
+  FileManager * self)
+{
+  char ** paths = get_sample_library_paths ();
+  file_index_set_roots (
+    self->index, (const char * const *) paths);
+  g_strfreev (paths);
+}
+
 /**
  * Creates the file manager.
  */
@@ -47,6 +75,50 @@ file_manager_new (void)
   self->locations[0] = fl;
   self->num_locations = 1;
 
+  /* add sample libraries and start indexing
+   * them */
+  char ** paths = get_sample_library_paths ();
+  for (int i = 0;
+       paths[i] &&
+       self->num_locations <
+         (int) G_N_ELEMENTS (self->locations);
+       i++)
+    {
+      FileBrowserLocation * loc =
+        object_new (FileBrowserLocation);
+      loc->label = g_path_get_basename (paths[i]);
+      loc->path = g_strdup (paths[i]);
+      self->locations[self->num_locations++] = loc;
+    }
+
+  char * cache_path = NULL;
+  if (!ZRYTHM_TESTING)
+    {
+      char * cache_dir =
+        zrythm_get_dir (ZRYTHM_DIR_USER_CACHE);
+      cache_path =
+        g_build_filename (
+          cache_dir, "file_index.bin", NULL);
+      g_free (cache_dir);
+    }
+  self->index = file_index_new (cache_path);
+  g_free (cache_path);
+  if (self->index)
+    {
+      file_index_set_roots (
+        self->index, (const char * const *) paths);
+      if (!ZRYTHM_TESTING)
+        {
+          g_signal_connect (
+            S_P_GENERAL_PATHS,
+            "changed::sample-library-paths",
+            G_CALLBACK (
+              on_sample_library_paths_changed),
+            self);
+        }
+    }
+  g_strfreev (paths);
+
   file_manager_set_selection (
     self, fl, FB_SELECTION_TYPE_LOCATIONS, 0);
 
@@ -67,13 +139,56 @@ alphaBetize (const void * _a,
 }
 
 static void
-load_files_from_location (
+add_file (
+  FileManager *   self,
+  SupportedFile * fd)
+{
+  array_double_size_if_full (
+    self->files, self->num_files,
+    self->files_size, SupportedFile *);
+  self->files[self->num_files++] = fd;
+}
+
+/**
+ * Adds the files from the index, without touching
+ * the filesystem.
+ */
+static void
+load_files_from_index (
+  FileManager *         self,
+  FileBrowserLocation * location)
+{
+  FileIndexQuery query = {
+    .dir = location->path,
+    .recursive = self->search_text != NULL,
+    .text = self->search_text,
+  };
+  GPtrArray * entries =
+    file_index_query (self->index, &query);
+  for (guint i = 0; i < entries->len; i++)
+    {
+      FileIndexEntry * e =
+        g_ptr_array_index (entries, i);
+      SupportedFile * fd =
+        object_new (SupportedFile);
+      fd->abs_path = g_strdup (e->abs_path);
+      fd->label =
+        g_filename_display_name (
+          &e->abs_path[e->name_offset]);
+      fd->type = e->type;
+      fd->hidden = 0;
+      add_file (self, fd);
+    }
+  g_ptr_array_unref (entries);
+}
+
+static void
+load_files_from_dir (
   FileManager *         self,
   FileBrowserLocation * location)
 {
   const gchar * file;
   SupportedFile * fd;
-  self->num_files = 0;
   GDir * dir =
     g_dir_open (
       location->path, 0, NULL);
@@ -84,26 +199,6 @@ load_files_from_location (
       return;
     }
 
-  /* create special parent dir entry */
-  fd = calloc (1, sizeof (SupportedFile));
-  /*g_message ("pre path %s",*/
-             /*location->path);*/
-  fd->abs_path =
-    io_path_get_parent_dir (location->path);
-  /*g_message ("after path %s",*/
-             /*fd->abs_path);*/
-  fd->type = FILE_TYPE_PARENT_DIR;
-  fd->hidden = 0;
-  fd->label = g_strdup ("..");
-  if (strlen (location->path) > 1)
-    {
-      self->files[self->num_files++] = fd;
-    }
-  else
-    {
-      supported_file_free (fd);
-    }
-
   while ((file = g_dir_read_name (dir)))
     {
       fd = calloc (1, sizeof (SupportedFile));
@@ -136,12 +231,60 @@ load_files_from_location (
       else
         fd->hidden = 0;
 
-      self->files[self->num_files++] = fd;
+      add_file (self, fd);
       /*g_message ("File found: %s (%d - %d)",*/
                  /*fd->abs_path,*/
                  /*fd->type,*/
                  /*fd->hidden);*/
     }
+  g_dir_close (dir);
+}
+
+static void
+load_files_from_location (
+  FileManager *         self,
+  FileBrowserLocation * location)
+{
+  SupportedFile * fd;
+  self->num_files = 0;
+
+  /* create special parent dir entry */
+  fd = calloc (1, sizeof (SupportedFile));
+  /*g_message ("pre path %s",*/
+             /*location->path);*/
+  fd->abs_path =
+    io_path_get_parent_dir (location->path);
+  /*g_message ("after path %s",*/
+             /*fd->abs_path);*/
+  fd->type = FILE_TYPE_PARENT_DIR;
+  fd->hidden = 0;
+  fd->label = g_strdup ("..");
+  if (strlen (location->path) > 1)
+    {
+      add_file (self, fd);
+    }
+  else
+    {
+      supported_file_free (fd);
+    }
+
+  /* indexed directories can be listed and
+   * searched without reading the directory (the
+   * existence check avoids listing stale entries
+   * of unmounted drives) */
+  if (self->index &&
+      file_index_is_dir_listed (
+        self->index, location->path) &&
+      g_file_test (
+        location->path, G_FILE_TEST_IS_DIR))
+    {
+      load_files_from_index (self, location);
+    }
+  else
+    {
+      load_files_from_dir (self, location);
+    }
+
   qsort (self->files,
          (size_t) self->num_files,
          sizeof (SupportedFile *),
@@ -187,6 +330,23 @@ file_manager_set_selection (
     }
 }
 
+/**
+ * Sets the text to search for under the current
+ * location, or NULL to clear the search.
+ *
+ * The files must be reloaded afterwards.
+ */
+void
+file_manager_set_search_text (
+  FileManager * self,
+  const char *  text)
+{
+  g_free (self->search_text);
+  self->search_text =
+    text && text[0] != '\0' ?
+      g_strdup (text) : NULL;
+}
+
 /**
  * Frees the file manager.
  */
@@ -194,7 +354,17 @@ void
 file_manager_free (
   FileManager * self)
 {
-  /* TODO */
+  /* TODO free the rest */
+
+  if (SETTINGS && !ZRYTHM_TESTING)
+    {
+      g_signal_handlers_disconnect_by_data (
+        S_P_GENERAL_PATHS, self);
+    }
+  object_free_w_func_and_null (
+    file_index_free, self->index);
+  free (self->files);
+  g_free (self->search_text);
 
   object_zero_and_free (self);
 }
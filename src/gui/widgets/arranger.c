@@ -344,6 +344,27 @@ arranger_widget_get_snap_grid (
   g_return_val_if_reached (NULL);
 }
 
+/**
+ * Returns the index of the objects in the given
+ * track to snap to, or NULL if no track is given.
+ *
+ * The index is built on first use and kept until
+ * the current drag ends.
+ */
+const SnapObjectIndex *
+arranger_widget_get_snap_obj_index (
+  ArrangerWidget * self,
+  Track *          track)
+{
+  if (!track)
+    return NULL;
+
+  snap_object_index_update (
+    &self->snap_obj_index, track);
+
+  return &self->snap_obj_index;
+}
+
 #if 0
 /**
  * Returns the number of regions inside the given
@@ -1759,19 +1780,42 @@ arranger_widget_set_highlight_rect (
   ArrangerWidget * self,
   GdkRectangle *   rect)
 {
+  /* only the previous and new highlights need to
+   * be redrawn */
+  GdkRectangle dirty_rect;
+  bool have_dirty_rect = false;
+  if (self->is_highlighted)
+    {
+      dirty_rect = self->highlight_rect;
+      have_dirty_rect = true;
+    }
+
   if (rect)
     {
       self->is_highlighted = true;
-      /*self->prev_highlight_rect =*/
-        /*self->highlight_rect;*/
       self->highlight_rect = *rect;
+      if (have_dirty_rect)
+        {
+          gdk_rectangle_union (
+            &dirty_rect, rect, &dirty_rect);
+        }
+      else
+        {
+          dirty_rect = *rect;
+          have_dirty_rect = true;
+        }
     }
   else
     {
       self->is_highlighted = false;
     }
 
-  EVENTS_PUSH (ET_ARRANGER_HIGHLIGHT_CHANGED, self);
+  if (have_dirty_rect)
+    {
+      EVENTS_PUSH_RECT (
+        ET_ARRANGER_HIGHLIGHT_CHANGED, self,
+        &dirty_rect);
+    }
 }
 
 /**
@@ -1855,8 +1899,10 @@ create_item (
         }
       position_snap (
         &self->earliest_obj_start_pos,
-        &pos, track_for_snap, NULL,
-        self->snap_grid);
+        &pos,
+        arranger_widget_get_snap_obj_index (
+          self, track_for_snap),
+        NULL, self->snap_grid);
       /*start_x =*/
         /*arranger_widget_pos_to_px (*/
           /*self, &pos, true);*/
@@ -2414,6 +2460,9 @@ drag_begin (
   gdouble            start_y,
   ArrangerWidget *   self)
 {
+  snap_object_index_clear (
+    &self->snap_obj_index, false);
+
   self->start_x = start_x;
   arranger_widget_px_to_pos (
     self, start_x, &self->start_pos, 1);
@@ -2925,7 +2974,9 @@ drag_update (
             }
           position_snap (
             &self->earliest_obj_start_pos,
-            &earliest_obj_new_pos, track_for_snap,
+            &earliest_obj_new_pos,
+            arranger_widget_get_snap_obj_index (
+              self, track_for_snap),
             NULL, self->snap_grid);
         }
       self->adj_ticks_diff =
@@ -4094,6 +4145,9 @@ drag_end (
 {
   g_message ("arranger drag end");
 
+  snap_object_index_clear (
+    &self->snap_obj_index, false);
+
   if (ACTION_IS (SELECTING) ||
       ACTION_IS (DELETE_SELECTING))
     {
@@ -4666,6 +4720,7 @@ arranger_widget_redraw_rectangle (
   ArrangerWidget * self,
   GdkRectangle *   rect)
 {
+  arranger_draw_damage_layers (self, rect);
   gtk_widget_queue_draw_area (
     GTK_WIDGET (self), rect->x, rect->y,
     rect->width, rect->height);
@@ -5925,10 +5980,26 @@ arranger_widget_setup (
   g_debug ("done");
 }
 
+static void
+arranger_widget_finalize (
+  ArrangerWidget * self)
+{
+  arranger_draw_free_layers (self);
+  snap_object_index_clear (
+    &self->snap_obj_index, true);
+
+  G_OBJECT_CLASS (
+    arranger_widget_parent_class)->
+      finalize (G_OBJECT (self));
+}
+
 static void
 arranger_widget_class_init (
   ArrangerWidgetClass * _klass)
 {
+  GObjectClass * oklass = G_OBJECT_CLASS (_klass);
+  oklass->finalize =
+    (GObjectFinalizeFunc) arranger_widget_finalize;
 }
 
 static void
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+
 #include "audio/control_port.h"
 #include "audio/track_lane.h"
 #include "audio/tracklist.h"
@@ -39,6 +41,7 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/cairo.h"
+#include "utils/objects.h"
 #include "zrythm_app.h"
 
 #define TYPE(x) ARRANGER_WIDGET_TYPE_##x
@@ -244,7 +247,7 @@ draw_timeline_bg (
           line_y < rect->y + rect->height)
         {
           cairo_set_source_rgb (
-            self->cached_cr, 0.3, 0.3, 0.3);
+            cr, 0.3, 0.3, 0.3);
           cairo_rectangle (
             cr, 0, (line_y - rect->y) - 1,
             rect->width, 2);
@@ -815,6 +818,402 @@ draw_range (
     }
 }
 
+/**
+ * Draws the background layer in the given
+ * rectangle.
+ *
+ * @param cr Context whose origin is at the
+ *   rectangle's position.
+ */
+static void
+draw_bg_layer (
+  ArrangerWidget * self,
+  RulerWidget *    ruler,
+  cairo_t *        cr,
+  GdkRectangle *   rect)
+{
+  GtkStyleContext *context =
+    gtk_widget_get_style_context (
+      GTK_WIDGET (self));
+
+  gtk_render_background (
+    context, cr, 0, 0,
+    rect->width, rect->height);
+
+  /* draw loop background */
+  if (TRANSPORT->loop)
+    {
+      double start_px = 0, end_px = 0;
+      if (self->type == TYPE (TIMELINE))
+        {
+          start_px =
+            ui_pos_to_px_timeline (
+              &TRANSPORT->loop_start_pos, 1);
+          end_px =
+            ui_pos_to_px_timeline (
+              &TRANSPORT->loop_end_pos, 1);
+        }
+      else
+        {
+          start_px =
+            ui_pos_to_px_editor (
+              &TRANSPORT->loop_start_pos, 1);
+          end_px =
+            ui_pos_to_px_editor (
+              &TRANSPORT->loop_end_pos, 1);
+        }
+      cairo_set_source_rgba (
+        cr, 0, 0.9, 0.7, 0.08);
+      cairo_set_line_width (
+        cr, 2);
+
+      /* if transport loop start is within the
+       * screen */
+      if (start_px > rect->x &&
+          start_px <= rect->x + rect->width)
+        {
+          /* draw the loop start line */
+          double x =
+            (start_px - rect->x) + 1.0;
+          cairo_rectangle (
+            cr,
+            (int) x, 0, 2, rect->height);
+          cairo_fill (cr);
+        }
+      /* if transport loop end is within the
+       * screen */
+      if (end_px > rect->x &&
+          end_px < rect->x + rect->width)
+        {
+          double x =
+            (end_px - rect->x) - 1.0;
+          cairo_rectangle (
+            cr,
+            (int) x, 0, 2, rect->height);
+          cairo_fill (cr);
+        }
+
+      /* draw transport loop area */
+      cairo_set_source_rgba (
+        cr, 0, 0.9, 0.7, 0.02);
+      double loop_start_local_x =
+        MAX (0, start_px - rect->x);
+      cairo_rectangle (
+        cr,
+        (int) loop_start_local_x, 0,
+        (int) (end_px - MAX (rect->x, start_px)),
+        rect->height);
+      cairo_fill (cr);
+    }
+
+  /* --- handle vertical drawing --- */
+
+  draw_vertical_lines (
+    self, ruler, cr, rect);
+
+  /* draw range */
+  int range_first_px, range_second_px;
+  bool have_range = false;
+  if (self->type == TYPE (AUDIO) &&
+      AUDIO_SELECTIONS->has_selection)
+    {
+      Position * range_first_pos,
+               * range_second_pos;
+      if (position_is_before_or_equal (
+            &TRANSPORT->range_1,
+            &TRANSPORT->range_2))
+        {
+          range_first_pos =
+            &AUDIO_SELECTIONS->sel_start;
+          range_second_pos =
+            &AUDIO_SELECTIONS->sel_end;
+        }
+      else
+        {
+          range_first_pos =
+            &AUDIO_SELECTIONS->sel_end;
+          range_second_pos =
+            &AUDIO_SELECTIONS->sel_start;
+        }
+
+      range_first_px =
+        ui_pos_to_px_editor (
+          range_first_pos, 1);
+      range_second_px =
+        ui_pos_to_px_editor (
+          range_second_pos, 1);
+      have_range = true;
+    }
+  else if (self->type == TYPE (TIMELINE) &&
+      TRANSPORT->has_range)
+    {
+      /* in order they appear */
+      Position * range_first_pos,
+               * range_second_pos;
+      if (position_is_before_or_equal (
+            &TRANSPORT->range_1,
+            &TRANSPORT->range_2))
+        {
+          range_first_pos = &TRANSPORT->range_1;
+          range_second_pos =
+            &TRANSPORT->range_2;
+        }
+      else
+        {
+          range_first_pos = &TRANSPORT->range_2;
+          range_second_pos =
+            &TRANSPORT->range_1;
+        }
+
+      range_first_px =
+        ui_pos_to_px_timeline (
+          range_first_pos, 1);
+      range_second_px =
+        ui_pos_to_px_timeline (
+          range_second_pos, 1);
+      have_range = true;
+    }
+
+  if (have_range)
+    {
+      draw_range (
+        self, range_first_px, range_second_px,
+        rect, cr);
+    }
+
+  if (self->type == TYPE (TIMELINE))
+    {
+      draw_timeline_bg (
+        self, cr, rect);
+    }
+  else if (self->type == TYPE (MIDI))
+    {
+      draw_midi_bg (
+        self, cr, rect);
+    }
+  else if (self->type == TYPE (AUDIO))
+    {
+      draw_audio_bg (
+        self, cr, rect);
+    }
+}
+
+/**
+ * Draws the arranger objects hit by the given
+ * rectangle.
+ *
+ * @param cr Context whose origin is at the
+ *   rectangle's position.
+ */
+static void
+draw_obj_layer (
+  ArrangerWidget * self,
+  cairo_t *        cr,
+  GdkRectangle *   rect)
+{
+  ArrangerObject * objs[2000];
+  int num_objs;
+  arranger_widget_get_hit_objects_in_rect (
+    self, ARRANGER_OBJECT_TYPE_ALL, rect,
+    objs, &num_objs);
+
+  /*g_message (*/
+    /*"objects found: %d (is pinned %d)",*/
+    /*num_objs, self->is_pinned);*/
+  /* note: these are only project objects */
+  for (int j = 0; j < num_objs; j++)
+    {
+      draw_arranger_object (
+        self, objs[j], cr, rect);
+    }
+}
+
+/**
+ * Clears and redraws the part of both cached
+ * layers inside the given rectangle (in arranger
+ * coordinates).
+ */
+static void
+redraw_layers_in_rect (
+  ArrangerWidget * self,
+  RulerWidget *    ruler,
+  GdkRectangle *   rect)
+{
+  cairo_t * crs[] = {
+    self->bg_layer_cr, self->obj_layer_cr };
+  for (int i = 0; i < 2; i++)
+    {
+      cairo_t * cr = crs[i];
+      cairo_save (cr);
+      cairo_translate (
+        cr, rect->x - self->layer_rect.x,
+        rect->y - self->layer_rect.y);
+      cairo_rectangle (
+        cr, 0, 0, rect->width, rect->height);
+      cairo_clip (cr);
+      cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+      cairo_paint (cr);
+      cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+      if (i == 0)
+        draw_bg_layer (self, ruler, cr, rect);
+      else
+        draw_obj_layer (self, cr, rect);
+
+      cairo_restore (cr);
+    }
+}
+
+/**
+ * Moves the contents of a cached layer by the
+ * given offset, leaving the uncovered area
+ * transparent.
+ */
+static void
+scroll_layer (
+  cairo_t *         cr,
+  cairo_surface_t * surface,
+  int               dx,
+  int               dy)
+{
+  cairo_save (cr);
+  cairo_push_group (cr);
+  cairo_set_source_surface (cr, surface, -dx, -dy);
+  cairo_paint (cr);
+  cairo_pop_group_to_source (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (cr);
+  cairo_restore (cr);
+}
+
+/**
+ * Brings the cached layers up to date with the
+ * given visible rectangle.
+ *
+ * Layers are only recreated when the size
+ * changes or a full redraw was requested. When
+ * scrolling, the existing content is moved and
+ * only the newly exposed area is drawn. Other
+ * changes only redraw the damaged areas.
+ */
+static void
+update_layers (
+  ArrangerWidget * self,
+  RulerWidget *    ruler,
+  GdkRectangle *   visible_rect,
+  cairo_t *        cr)
+{
+  if (!self->layer_damage)
+    {
+      self->layer_damage = cairo_region_create ();
+    }
+
+  int dx = visible_rect->x - self->layer_rect.x;
+  int dy = visible_rect->y - self->layer_rect.y;
+  bool full_redraw =
+    self->redraw || !self->bg_layer_surface ||
+    visible_rect->width !=
+      self->layer_rect.width ||
+    visible_rect->height !=
+      self->layer_rect.height ||
+    abs (dx) >= visible_rect->width ||
+    abs (dy) >= visible_rect->height;
+  if (full_redraw)
+    {
+      z_cairo_reset_caches (
+        &self->bg_layer_cr,
+        &self->bg_layer_surface,
+        visible_rect->width, visible_rect->height,
+        cr);
+      z_cairo_reset_caches (
+        &self->obj_layer_cr,
+        &self->obj_layer_surface,
+        visible_rect->width, visible_rect->height,
+        cr);
+      self->layer_rect = *visible_rect;
+      cairo_region_destroy (self->layer_damage);
+      self->layer_damage =
+        cairo_region_create_rectangle (
+          visible_rect);
+      self->redraw = 0;
+    }
+  else if (dx != 0 || dy != 0)
+    {
+      scroll_layer (
+        self->bg_layer_cr, self->bg_layer_surface,
+        dx, dy);
+      scroll_layer (
+        self->obj_layer_cr,
+        self->obj_layer_surface, dx, dy);
+
+      /* damage the newly exposed area */
+      cairo_region_t * exposed =
+        cairo_region_create_rectangle (
+          visible_rect);
+      cairo_region_subtract_rectangle (
+        exposed, &self->layer_rect);
+      cairo_region_union (
+        self->layer_damage, exposed);
+      cairo_region_destroy (exposed);
+
+      self->layer_rect = *visible_rect;
+    }
+
+  cairo_region_intersect_rectangle (
+    self->layer_damage, &self->layer_rect);
+  int num_rects =
+    cairo_region_num_rectangles (
+      self->layer_damage);
+  for (int i = 0; i < num_rects; i++)
+    {
+      GdkRectangle damaged_rect;
+      cairo_region_get_rectangle (
+        self->layer_damage, i, &damaged_rect);
+      redraw_layers_in_rect (
+        self, ruler, &damaged_rect);
+    }
+  cairo_region_destroy (self->layer_damage);
+  self->layer_damage = cairo_region_create ();
+}
+
+/**
+ * Marks the given area (in arranger coordinates)
+ * of the cached layers for redrawing.
+ */
+void
+arranger_draw_damage_layers (
+  ArrangerWidget * self,
+  GdkRectangle *   rect)
+{
+  if (!self->layer_damage)
+    {
+      self->layer_damage = cairo_region_create ();
+    }
+  cairo_region_union_rectangle (
+    self->layer_damage, rect);
+}
+
+/**
+ * Frees the cached layers.
+ */
+void
+arranger_draw_free_layers (
+  ArrangerWidget * self)
+{
+  object_free_w_func_and_null (
+    cairo_destroy, self->bg_layer_cr);
+  object_free_w_func_and_null (
+    cairo_surface_destroy,
+    self->bg_layer_surface);
+  object_free_w_func_and_null (
+    cairo_destroy, self->obj_layer_cr);
+  object_free_w_func_and_null (
+    cairo_surface_destroy,
+    self->obj_layer_surface);
+  object_free_w_func_and_null (
+    cairo_region_destroy, self->layer_damage);
+}
+
 gboolean
 arranger_draw_cb (
   GtkWidget *      widget,
@@ -868,219 +1267,39 @@ arranger_draw_cb (
   gdk_cairo_get_clip_rectangle (
     cr, &rect);
 
-  if (self->redraw ||
-      !gdk_rectangle_equal (
-         &rect, &self->last_rect))
-    {
-      /*g_message (*/
-        /*"redrawing arranger in rect: "*/
-        /*"(%d, %d) width: %d height %d)",*/
-        /*rect.x, rect.y, rect.width, rect.height);*/
-      self->last_rect = rect;
-
-      GtkStyleContext *context =
-        gtk_widget_get_style_context (widget);
-
-      z_cairo_reset_caches (
-        &self->cached_cr,
-        &self->cached_surface, rect.width,
-        rect.height, cr);
-
-      gtk_render_background (
-        context, self->cached_cr, 0, 0,
-        rect.width, rect.height);
-
-      /* draw loop background */
-      if (TRANSPORT->loop)
-        {
-          double start_px = 0, end_px = 0;
-          if (self->type == TYPE (TIMELINE))
-            {
-              start_px =
-                ui_pos_to_px_timeline (
-                  &TRANSPORT->loop_start_pos, 1);
-              end_px =
-                ui_pos_to_px_timeline (
-                  &TRANSPORT->loop_end_pos, 1);
-            }
-          else
-            {
-              start_px =
-                ui_pos_to_px_editor (
-                  &TRANSPORT->loop_start_pos, 1);
-              end_px =
-                ui_pos_to_px_editor (
-                  &TRANSPORT->loop_end_pos, 1);
-            }
-          cairo_set_source_rgba (
-            self->cached_cr, 0, 0.9, 0.7, 0.08);
-          cairo_set_line_width (
-            self->cached_cr, 2);
-
-          /* if transport loop start is within the
-           * screen */
-          if (start_px > rect.x &&
-              start_px <= rect.x + rect.width)
-            {
-              /* draw the loop start line */
-              double x =
-                (start_px - rect.x) + 1.0;
-              cairo_rectangle (
-                self->cached_cr,
-                (int) x, 0, 2, rect.height);
-              cairo_fill (self->cached_cr);
-            }
-          /* if transport loop end is within the
-           * screen */
-          if (end_px > rect.x &&
-              end_px < rect.x + rect.width)
-            {
-              double x =
-                (end_px - rect.x) - 1.0;
-              cairo_rectangle (
-                self->cached_cr,
-                (int) x, 0, 2, rect.height);
-              cairo_fill (self->cached_cr);
-            }
-
-          /* draw transport loop area */
-          cairo_set_source_rgba (
-            self->cached_cr, 0, 0.9, 0.7, 0.02);
-          double loop_start_local_x =
-            MAX (0, start_px - rect.x);
-          cairo_rectangle (
-            self->cached_cr,
-            (int) loop_start_local_x, 0,
-            (int) (end_px - MAX (rect.x, start_px)),
-            rect.height);
-          cairo_fill (self->cached_cr);
-        }
-
-      /* --- handle vertical drawing --- */
-
-      draw_vertical_lines (
-        self, ruler, self->cached_cr, &rect);
-
-      /* draw range */
-      int range_first_px, range_second_px;
-      bool have_range = false;
-      if (self->type == TYPE (AUDIO) &&
-          AUDIO_SELECTIONS->has_selection)
-        {
-          Position * range_first_pos,
-                   * range_second_pos;
-          if (position_is_before_or_equal (
-                &TRANSPORT->range_1,
-                &TRANSPORT->range_2))
-            {
-              range_first_pos =
-                &AUDIO_SELECTIONS->sel_start;
-              range_second_pos =
-                &AUDIO_SELECTIONS->sel_end;
-            }
-          else
-            {
-              range_first_pos =
-                &AUDIO_SELECTIONS->sel_end;
-              range_second_pos =
-                &AUDIO_SELECTIONS->sel_start;
-            }
-
-          range_first_px =
-            ui_pos_to_px_editor (
-              range_first_pos, 1);
-          range_second_px =
-            ui_pos_to_px_editor (
-              range_second_pos, 1);
-          have_range = true;
-        }
-      else if (self->type == TYPE (TIMELINE) &&
-          TRANSPORT->has_range)
-        {
-          /* in order they appear */
-          Position * range_first_pos,
-                   * range_second_pos;
-          if (position_is_before_or_equal (
-                &TRANSPORT->range_1,
-                &TRANSPORT->range_2))
-            {
-              range_first_pos = &TRANSPORT->range_1;
-              range_second_pos =
-                &TRANSPORT->range_2;
-            }
-          else
-            {
-              range_first_pos = &TRANSPORT->range_2;
-              range_second_pos =
-                &TRANSPORT->range_1;
-            }
-
-          range_first_px =
-            ui_pos_to_px_timeline (
-              range_first_pos, 1);
-          range_second_px =
-            ui_pos_to_px_timeline (
-              range_second_pos, 1);
-          have_range = true;
-        }
-
-      if (have_range)
-        {
-          draw_range (
-            self, range_first_px, range_second_px,
-            &rect, self->cached_cr);
-        }
+  GdkRectangle visible_rect;
+  arranger_widget_get_visible_rect (
+    self, &visible_rect);
+  if (visible_rect.width < 1 ||
+      visible_rect.height < 1)
+    return FALSE;
 
-      if (self->type == TYPE (TIMELINE))
-        {
-          draw_timeline_bg (
-            self, self->cached_cr, &rect);
-        }
-      else if (self->type == TYPE (MIDI))
-        {
-          draw_midi_bg (
-            self, self->cached_cr, &rect);
-        }
-      else if (self->type == TYPE (AUDIO))
-        {
-          draw_audio_bg (
-            self, self->cached_cr, &rect);
-        }
+  update_layers (self, ruler, &visible_rect, cr);
 
-      /* draw each arranger object */
-      ArrangerObject * objs[2000];
-      int num_objs;
-      arranger_widget_get_hit_objects_in_rect (
-        self, ARRANGER_OBJECT_TYPE_ALL, &rect,
-        objs, &num_objs);
-
-      /*g_message (*/
-        /*"objects found: %d (is pinned %d)",*/
-        /*num_objs, self->is_pinned);*/
-      /* note: these are only project objects */
-      for (int j = 0; j < num_objs; j++)
-        {
-          draw_arranger_object (
-            self, objs[j], self->cached_cr,
-            &rect);
-        }
+  /* composite the cached layers */
+  cairo_set_source_surface (
+    cr, self->bg_layer_surface,
+    self->layer_rect.x, self->layer_rect.y);
+  cairo_paint (cr);
+  cairo_set_source_surface (
+    cr, self->obj_layer_surface,
+    self->layer_rect.x, self->layer_rect.y);
+  cairo_paint (cr);
 
-      /* draw dnd highlight */
-      draw_highlight (
-        self, self->cached_cr, &rect);
+  /* draw the overlay directly, since it changes
+   * often */
+  cairo_save (cr);
+  cairo_translate (cr, rect.x, rect.y);
 
-      /* draw selections */
-      draw_selections (
-        self, self->cached_cr, &rect);
+  /* draw dnd highlight */
+  draw_highlight (self, cr, &rect);
 
-      draw_playhead (self, self->cached_cr, &rect);
+  /* draw selections */
+  draw_selections (self, cr, &rect);
 
-      self->redraw--;
-    }
+  draw_playhead (self, cr, &rect);
 
-  cairo_set_source_surface (
-    cr, self->cached_surface, rect.x, rect.y);
-  cairo_paint (cr);
+  cairo_restore (cr);
 
   return FALSE;
 }
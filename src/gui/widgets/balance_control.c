@@ -47,6 +47,21 @@ G_DEFINE_TYPE (BalanceControlWidget,
 #define TEXT_PADDING 3.0
 #define LINE_WIDTH 3.0
 
+/**
+ * Returns the value being dragged while dragging,
+ * since the setter might only apply it at the start
+ * of the next processing cycle.
+ */
+static float
+get_val (
+  BalanceControlWidget * self)
+{
+  if (self->dragged)
+    return self->balance_during_drag;
+  else
+    return GET_VAL;
+}
+
 static int
 pan_draw_cb (
   GtkWidget * widget,
@@ -68,7 +83,7 @@ pan_draw_cb (
     context, cr, 0, 0, width, height);
 
   /* draw filled in bar */
-  float pan_val = GET_VAL;
+  float pan_val = get_val (self);
   /*float intensity = pan_val;*/
   double value_px =
     (double) pan_val * (double) width;
@@ -184,7 +199,8 @@ get_pan_string (
   BalanceControlWidget * self)
 {
   /* make it from -0.5 to 0.5 */
-  float pan_val = GET_VAL - 0.5f;
+  float cur_val = get_val (self);
+  float pan_val = cur_val - 0.5f;
 
   /* get as percentage */
   pan_val = (fabsf (pan_val) / 0.5f) * 100.f;
@@ -192,7 +208,7 @@ get_pan_string (
   return
     g_strdup_printf (
       "%s%.0f%%",
-      GET_VAL < 0.5f ? "-" : "",
+      cur_val < 0.5f ? "-" : "",
       (double) pan_val);
 }
 
@@ -230,6 +246,8 @@ drag_begin (
   BalanceControlWidget * self)
 {
   self->balance_at_start = GET_VAL;
+  self->balance_during_drag =
+    self->balance_at_start;
 }
 
 static void
@@ -262,11 +280,14 @@ drag_update (
 
   float new_val =
     CLAMP (
-      GET_VAL + (float) diff, 0.0f, 1.0f);
+      self->balance_during_drag + (float) diff,
+      0.0f, 1.0f);
 
   SET_VAL (new_val);
+  self->balance_during_drag = new_val;
   self->last_x = offset_x;
   self->last_y = offset_y;
+  self->dragged = 1;
   gtk_widget_queue_draw (GTK_WIDGET (self));
 
   char * str =
@@ -277,8 +298,6 @@ drag_update (
     GTK_WIDGET (self), str);
   g_free (str);
   gtk_window_present (self->tooltip_win);
-
-  self->dragged = 1;
 }
 
 static void
@@ -295,7 +314,8 @@ drag_end (
 
   if (IS_CHANNEL ((Channel *) self->object) &&
       !math_floats_equal_epsilon (
-        self->balance_at_start, GET_VAL, 0.0001f))
+        self->balance_at_start,
+        self->balance_during_drag, 0.0001f))
     {
       Track * track =
         channel_get_track ((Channel *) self->object);
@@ -304,7 +324,7 @@ drag_end (
             tracklist_selections_action_new_edit_single_float (
               EDIT_TRACK_ACTION_TYPE_PAN,
               track, self->balance_at_start,
-              GET_VAL, true);
+              self->balance_during_drag, true);
           undo_manager_perform (UNDO_MANAGER, ua);
         }
     }
@@ -573,7 +573,7 @@ setup_balance_control (ChannelWidget * self)
   self->balance_control =
     balance_control_widget_new (
       channel_get_balance_control,
-      channel_set_balance_control,
+      channel_queue_balance_control,
       self->channel, 12);
   gtk_box_pack_start (
     self->balance_control_box,
@@ -43,8 +43,8 @@ control_room_widget_setup (
 
   self->listen_dim_slider =
     slider_bar_widget_new_simple (
-      fader_get_amp,
-      fader_set_amp,
+      fader_get_queued_amp,
+      fader_queue_amp,
       &control_room->listen_vol_fader,
       0.f, 2.f, -1, -1, 0.f,
       _("Listen dim level"));
@@ -63,7 +63,7 @@ control_room_widget_setup (
   KnobWidget * knob =
     knob_widget_new_simple (
       fader_get_fader_val,
-      fader_set_fader_val,
+      fader_queue_fader_val,
       MONITOR_FADER,
       0.f, 1.f, 78, 0.f);
   self->volume =
@@ -27,6 +27,7 @@
 #include "audio/engine.h"
 #include "gui/widgets/bot_bar.h"
 #include "gui/widgets/cpu.h"
+#include "gui/widgets/dialogs/dsp_profiler_dialog.h"
 #include "project.h"
 #include "utils/cpu_windows.h"
 #include "utils/cairo.h"
@@ -283,6 +284,22 @@ on_motion (GtkWidget * widget, GdkEvent *event)
   return FALSE;
 }
 
+static void
+on_pressed (
+  GtkGestureMultiPress * gesture,
+  gint                   n_press,
+  gdouble                x,
+  gdouble                y,
+  CpuWidget *            self)
+{
+  if (n_press != 1)
+    return;
+
+  DspProfilerDialogWidget * dialog =
+    dsp_profiler_dialog_widget_new ();
+  gtk_widget_show (GTK_WIDGET (dialog));
+}
+
 /**
  * Creates a new Cpu widget and binds it to the
  * given value.
@@ -333,6 +350,17 @@ cpu_widget_init (CpuWidget * self)
   g_signal_connect (
     G_OBJECT(self), "leave-notify-event",
     G_CALLBACK (on_motion),  self);
+
+  /* show the DSP profiler on click */
+  self->mp =
+    GTK_GESTURE_MULTI_PRESS (
+      gtk_gesture_multi_press_new (
+        GTK_WIDGET (self)));
+  g_signal_connect (
+    G_OBJECT (self->mp), "pressed",
+    G_CALLBACK (on_pressed), self);
+  gtk_widget_add_events (
+    GTK_WIDGET (self), GDK_BUTTON_PRESS_MASK);
 }
 
 static void
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "audio/engine.h"
+#include "audio/graph.h"
+#include "audio/graph_node.h"
+#include "audio/graph_profiler.h"
+#include "audio/graph_thread.h"
+#include "audio/router.h"
+#include "gui/backend/event_manager.h"
+#include "gui/widgets/dialogs/dsp_profiler_dialog.h"
+#include "gui/widgets/main_window.h"
+#include "project.h"
+#include "utils/objects.h"
+#include "utils/ui.h"
+#include "zrythm.h"
+#include "zrythm_app.h"
+
+#include <gtk/gtk.h>
+#include <glib/gi18n.h>
+
+G_DEFINE_TYPE (
+  DspProfilerDialogWidget,
+  dsp_profiler_dialog_widget,
+  GTK_TYPE_DIALOG)
+
+enum
+{
+  RESPONSE_RESET = 1,
+  RESPONSE_EXPORT_TRACE,
+};
+
+enum
+{
+  COL_NAME,
+  COL_DSP_LOAD,
+  COL_AVG,
+  COL_P99,
+  COL_WORST,
+  COL_QUEUE_WAIT,
+  COL_RUNS,
+  NUM_COLS
+};
+
+static Graph *
+get_graph (void)
+{
+  if (!PROJECT || !AUDIO_ENGINE || !ROUTER)
+    return NULL;
+
+  return ROUTER->graph;
+}
+
+static void
+refresh_summary (
+  DspProfilerDialogWidget * self,
+  Graph *                   graph)
+{
+  GString * str = g_string_new (NULL);
+  g_string_append_printf (
+    str,
+    _("Last cycle: %" G_GINT64_FORMAT " µs, "
+      "worst recent cycle: %" G_GINT64_FORMAT
+      " µs"),
+    AUDIO_ENGINE->last_time_taken,
+    AUDIO_ENGINE->max_time_taken);
+
+  g_string_append_printf (
+    str, "\n%s: %.1f%%", _("Main thread"),
+    graph_profiler_get_thread_utilization (
+      graph, -1) * 100.0);
+  for (int i = 0; i < graph->num_threads; i++)
+    {
+      g_string_append (
+        str, i % 4 == 0 ? "\n" : "   ");
+      g_string_append_printf (
+        str, _("Thread %d: %.1f%%"), i,
+        graph_profiler_get_thread_utilization (
+          graph, i) * 100.0);
+    }
+
+  /* UI event rates */
+  if (EVENT_MANAGER)
+    {
+      double push_rate = 0.0;
+      double dispatch_rate = 0.0;
+      int busiest_type = -1;
+      double busiest_rate = 0.0;
+      for (int i = 0; i < NUM_EVENT_TYPES; i++)
+        {
+          const EventTypeStats * stats =
+            event_manager_get_type_stats (
+              EVENT_MANAGER, (EventType) i);
+          push_rate += stats->push_rate;
+          dispatch_rate += stats->dispatch_rate;
+          if (stats->push_rate > busiest_rate)
+            {
+              busiest_rate = stats->push_rate;
+              busiest_type = i;
+            }
+        }
+      g_string_append_printf (
+        str,
+        _("\nUI events: %.1f/s pushed, "
+          "%.1f/s handled"),
+        push_rate, dispatch_rate);
+      if (busiest_type >= 0)
+        {
+          g_string_append_printf (
+            str, _(" (busiest: type %d, %.1f/s)"),
+            busiest_type, busiest_rate);
+        }
+    }
+
+  gtk_label_set_text (self->summary_lbl, str->str);
+  g_string_free (str, true);
+}
+
+static gboolean
+refresh_source (
+  DspProfilerDialogWidget * self)
+{
+  Graph * graph = get_graph ();
+  if (!graph || !graph_profiler_is_enabled (graph))
+    return G_SOURCE_CONTINUE;
+
+  refresh_summary (self, graph);
+
+  gtk_list_store_clear (self->store);
+  for (int i = 0; i < graph->n_graph_nodes; i++)
+    {
+      GraphNode * node = graph->graph_nodes[i];
+      GraphNodeStats * stats = &node->stats;
+
+      /* ports are skipped since they are cheap
+       * and numerous */
+      if (stats->num_runs == 0 ||
+          node->type == ROUTE_NODE_TYPE_PORT)
+        continue;
+
+      char * name = graph_node_get_name (node);
+      GtkTreeIter iter;
+      gtk_list_store_append (self->store, &iter);
+      gtk_list_store_set (
+        self->store, &iter,
+        COL_NAME, name,
+        COL_DSP_LOAD,
+        graph_profiler_get_node_dsp_load (
+          node, AUDIO_ENGINE->block_length,
+          AUDIO_ENGINE->sample_rate),
+        COL_AVG,
+        ((double) stats->total_ns /
+           (double) stats->num_runs) / 1000.0,
+        COL_P99,
+        (double)
+        graph_profiler_get_percentile_ns (
+          stats, 99.0) / 1000.0,
+        COL_WORST, (double) stats->max_ns / 1000.0,
+        COL_QUEUE_WAIT,
+        (double) stats->max_queue_wait_ns / 1000.0,
+        COL_RUNS, (guint64) stats->num_runs,
+        -1);
+      g_free (name);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+export_trace (
+  DspProfilerDialogWidget * self,
+  Graph *                   graph)
+{
+  GtkWidget * dialog =
+    gtk_file_chooser_dialog_new (
+      _("Export DSP Trace"),
+      GTK_WINDOW (self),
+      GTK_FILE_CHOOSER_ACTION_SAVE,
+      _("_Cancel"), GTK_RESPONSE_CANCEL,
+      _("_Save"), GTK_RESPONSE_ACCEPT,
+      NULL);
+  GtkFileChooser * chooser =
+    GTK_FILE_CHOOSER (dialog);
+  gtk_file_chooser_set_do_overwrite_confirmation (
+    chooser, true);
+  gtk_file_chooser_set_current_name (
+    chooser, "zrythm-dsp-trace.json");
+
+  if (gtk_dialog_run (GTK_DIALOG (dialog)) ==
+        GTK_RESPONSE_ACCEPT)
+    {
+      char * filepath =
+        gtk_file_chooser_get_filename (chooser);
+      GError * err = NULL;
+      if (!graph_profiler_export_chrome_trace (
+             graph, filepath, &err))
+        {
+          char * msg =
+            g_strdup_printf (
+              _("Failed to export trace: %s"),
+              err ? err->message : "");
+          ui_show_error_message (self, msg);
+          g_free (msg);
+          if (err)
+            g_error_free (err);
+        }
+      g_free (filepath);
+    }
+
+  gtk_widget_destroy (dialog);
+}
+
+static void
+on_response (
+  GtkDialog *               dialog,
+  gint                      response,
+  DspProfilerDialogWidget * self)
+{
+  Graph * graph = get_graph ();
+  switch (response)
+    {
+    case RESPONSE_RESET:
+      if (graph)
+        {
+          graph_profiler_reset (graph);
+          refresh_source (self);
+        }
+      break;
+    case RESPONSE_EXPORT_TRACE:
+      if (graph)
+        {
+          export_trace (self, graph);
+        }
+      break;
+    default:
+      gtk_widget_destroy (GTK_WIDGET (self));
+      break;
+    }
+}
+
+static void
+on_enable_toggled (
+  GtkToggleButton *         btn,
+  DspProfilerDialogWidget * self)
+{
+  Graph * graph = get_graph ();
+  if (!graph)
+    return;
+
+  graph_profiler_set_enabled (
+    graph, gtk_toggle_button_get_active (btn));
+}
+
+static void
+format_double_cell (
+  GtkTreeViewColumn * col,
+  GtkCellRenderer *   renderer,
+  GtkTreeModel *      model,
+  GtkTreeIter *       iter,
+  gpointer            data)
+{
+  int col_id = GPOINTER_TO_INT (data);
+  double val;
+  gtk_tree_model_get (model, iter, col_id, &val, -1);
+  char str[40];
+  sprintf (
+    str, col_id == COL_DSP_LOAD ? "%.2f%%" : "%.1f",
+    val);
+  g_object_set (renderer, "text", str, NULL);
+}
+
+static void
+add_column (
+  DspProfilerDialogWidget * self,
+  const char *              title,
+  int                       col_id)
+{
+  GtkCellRenderer * renderer =
+    gtk_cell_renderer_text_new ();
+  GtkTreeViewColumn * column =
+    gtk_tree_view_column_new_with_attributes (
+      title, renderer, NULL);
+  if (col_id == COL_NAME)
+    {
+      gtk_tree_view_column_add_attribute (
+        column, renderer, "text", col_id);
+      g_object_set (
+        renderer, "ellipsize", PANGO_ELLIPSIZE_END,
+        NULL);
+      gtk_tree_view_column_set_expand (
+        column, true);
+    }
+  else if (col_id == COL_RUNS)
+    {
+      gtk_tree_view_column_add_attribute (
+        column, renderer, "text", col_id);
+    }
+  else
+    {
+      gtk_tree_view_column_set_cell_data_func (
+        column, renderer, format_double_cell,
+        GINT_TO_POINTER (col_id), NULL);
+    }
+  gtk_tree_view_column_set_sort_column_id (
+    column, col_id);
+  gtk_tree_view_column_set_resizable (
+    column, true);
+  gtk_tree_view_append_column (self->tree, column);
+}
+
+/**
+ * Creates the dialog.
+ */
+DspProfilerDialogWidget *
+dsp_profiler_dialog_widget_new (void)
+{
+  DspProfilerDialogWidget * self =
+    g_object_new (
+      DSP_PROFILER_DIALOG_WIDGET_TYPE,
+      "icon-name", "zrythm",
+      "title", _("DSP Profiler"),
+      NULL);
+
+  gtk_window_set_transient_for (
+    GTK_WINDOW (self), GTK_WINDOW (MAIN_WINDOW));
+
+  Graph * graph = get_graph ();
+  gtk_toggle_button_set_active (
+    GTK_TOGGLE_BUTTON (self->enable_btn),
+    graph && graph_profiler_is_enabled (graph));
+  g_signal_connect (
+    G_OBJECT (self->enable_btn), "toggled",
+    G_CALLBACK (on_enable_toggled), self);
+
+  refresh_source (self);
+
+  return self;
+}
+
+static void
+dispose (
+  DspProfilerDialogWidget * self)
+{
+  if (self->refresh_source_id)
+    {
+      g_source_remove_and_zero (
+        self->refresh_source_id);
+    }
+
+  G_OBJECT_CLASS (
+    dsp_profiler_dialog_widget_parent_class)->
+      dispose (G_OBJECT (self));
+}
+
+static void
+finalize (
+  DspProfilerDialogWidget * self)
+{
+  g_object_unref_and_null (self->store);
+
+  G_OBJECT_CLASS (
+    dsp_profiler_dialog_widget_parent_class)->
+      finalize (G_OBJECT (self));
+}
+
+static void
+dsp_profiler_dialog_widget_class_init (
+  DspProfilerDialogWidgetClass * _klass)
+{
+  GObjectClass * oklass = G_OBJECT_CLASS (_klass);
+  oklass->dispose =
+    (GObjectFinalizeFunc) dispose;
+  oklass->finalize =
+    (GObjectFinalizeFunc) finalize;
+}
+
+static void
+dsp_profiler_dialog_widget_init (
+  DspProfilerDialogWidget * self)
+{
+  gtk_window_set_default_size (
+    GTK_WINDOW (self), 640, 480);
+
+  GtkBox * content_area =
+    GTK_BOX (
+      gtk_dialog_get_content_area (
+        GTK_DIALOG (self)));
+  gtk_box_set_spacing (content_area, 4);
+
+  /* enable toggle */
+  self->enable_btn =
+    GTK_CHECK_BUTTON (
+      gtk_check_button_new_with_label (
+        _("Collect DSP stats")));
+  gtk_widget_set_visible (
+    GTK_WIDGET (self->enable_btn), true);
+  gtk_box_pack_start (
+    content_area, GTK_WIDGET (self->enable_btn),
+    false, false, 0);
+
+  /* summary */
+  self->summary_lbl =
+    GTK_LABEL (gtk_label_new (NULL));
+  gtk_label_set_xalign (self->summary_lbl, 0.f);
+  gtk_widget_set_visible (
+    GTK_WIDGET (self->summary_lbl), true);
+  gtk_box_pack_start (
+    content_area, GTK_WIDGET (self->summary_lbl),
+    false, false, 0);
+
+  /* per-node stats */
+  self->store =
+    gtk_list_store_new (
+      NUM_COLS,
+      G_TYPE_STRING,
+      G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE,
+      G_TYPE_DOUBLE,
+      G_TYPE_UINT64);
+  gtk_tree_sortable_set_sort_column_id (
+    GTK_TREE_SORTABLE (self->store),
+    COL_DSP_LOAD, GTK_SORT_DESCENDING);
+  self->tree =
+    GTK_TREE_VIEW (
+      gtk_tree_view_new_with_model (
+        GTK_TREE_MODEL (self->store)));
+  add_column (self, _("Node"), COL_NAME);
+  add_column (self, _("DSP"), COL_DSP_LOAD);
+  add_column (self, _("Avg (µs)"), COL_AVG);
+  add_column (self, _("99th % (µs)"), COL_P99);
+  add_column (self, _("Worst (µs)"), COL_WORST);
+  add_column (
+    self, _("Queue wait (µs)"), COL_QUEUE_WAIT);
+  add_column (self, _("Runs"), COL_RUNS);
+  GtkWidget * scroll =
+    gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (
+    GTK_CONTAINER (scroll),
+    GTK_WIDGET (self->tree));
+  gtk_widget_set_vexpand (scroll, true);
+  gtk_widget_show_all (scroll);
+  gtk_box_pack_start (
+    content_area, scroll, true, true, 0);
+
+  gtk_dialog_add_buttons (
+    GTK_DIALOG (self),
+    _("_Reset"), RESPONSE_RESET,
+    _("_Export Trace..."), RESPONSE_EXPORT_TRACE,
+    _("_Close"), GTK_RESPONSE_CLOSE,
+    NULL);
+
+  g_signal_connect (
+    G_OBJECT (self), "response",
+    G_CALLBACK (on_response), self);
+
+  self->refresh_source_id =
+    g_timeout_add_seconds (
+      1, (GSourceFunc) refresh_source, self);
+}
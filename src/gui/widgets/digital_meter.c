@@ -624,19 +624,6 @@ on_change_finished (
   self->update_minutes = 0;
   self->update_seconds = 0;
   self->update_ms = 0;
-  /* FIXME super reduntant */
-  if (self->update_note_length ||
-      self->update_note_type)
-    {
-      snap_grid_update_snap_points_default (
-        &PROJECT->snap_grid_timeline);
-      snap_grid_update_snap_points_default (
-        &PROJECT->snap_grid_midi);
-      quantize_options_update_quantize_points (
-        QUANTIZE_OPTIONS_TIMELINE);
-      quantize_options_update_quantize_points (
-        QUANTIZE_OPTIONS_EDITOR);
-    }
   self->update_note_length = 0;
   self->update_note_type = 0;
   self->update_timesig_top = 0;
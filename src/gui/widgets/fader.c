@@ -221,7 +221,7 @@ drag_begin (
   GdkModifierType state_mask;
   gdk_event_get_state (event, &state_mask);
   if (state_mask & GDK_CONTROL_MASK)
-    fader_set_amp ((void *) self->fader, 1.0);
+    fader_queue_amp ((void *) self->fader, 1.0);
 
   char * string =
     g_strdup_printf (
@@ -231,7 +231,8 @@ drag_begin (
   g_free (string);
   gtk_window_present (self->tooltip_win);
 
-  self->amp_at_start = fader_get_amp (self->fader);
+  self->amp_at_start =
+    fader_get_queued_amp (self->fader);
   self->dragging = true;
 }
 
@@ -274,7 +275,7 @@ drag_update (
       (double) self->fader->fader_val +
         adjusted_diff,
       0.0, 1.0);
-  fader_set_fader_val (
+  fader_queue_fader_val (
     self->fader, (float) new_fader_val);
   self->last_x = offset_x;
   self->last_y = offset_y;
@@ -304,10 +305,10 @@ drag_end (
   g_return_if_fail (IS_FADER (self->fader));
 
   Track * track = fader_get_track (self->fader);
-  float cur_amp = fader_get_amp (self->fader);
+  float cur_amp =
+    fader_get_queued_amp (self->fader);
   if (!math_floats_equal_epsilon (
-        self->amp_at_start,
-        fader_get_amp (self->fader),
+        self->amp_at_start, cur_amp,
         0.0001f))
     {
       UndoableAction * ua =
@@ -331,7 +332,7 @@ on_reset_fader (GtkMenuItem *menuitem,
     }
   else
     {
-      fader_set_amp (self->fader, 1.0);
+      fader_queue_amp (self->fader, 1.0);
     }
 }
 
@@ -427,7 +428,7 @@ on_scroll (
     fader_get_fader_val (self->fader);
   float new_val =
     CLAMP (current_val + add_val, 0.0f, 1.0f);
-  fader_set_fader_val (self->fader, new_val);
+  fader_queue_fader_val (self->fader, new_val);
 
   Channel * channel =
     fader_get_channel (self->fader);
@@ -21,6 +21,8 @@
 
 #include "actions/tracklist_selections.h"
 #include "audio/supported_file.h"
+#include "gui/backend/file_index.h"
+#include "gui/backend/file_manager.h"
 #include "gui/widgets/arranger.h"
 #include "gui/widgets/bot_dock_edge.h"
 #include "gui/widgets/center_dock.h"
@@ -39,8 +41,6 @@
 #include "zrythm.h"
 #include "zrythm_app.h"
 
-#include <audec/audec.h>
-
 #include <gtk/gtk.h>
 
 #include <sndfile.h>
@@ -142,24 +142,18 @@ on_file_chooser_selection_changed (
   char * descr =
     supported_file_type_get_description (
       file->type);
-  if (file->type == FILE_TYPE_MP3 ||
-      file->type == FILE_TYPE_FLAC ||
-      file->type == FILE_TYPE_OGG ||
-      file->type == FILE_TYPE_WAV)
+  FileIndexEntry * e =
+    FILE_INDEX ?
+      file_index_get_entry (FILE_INDEX, abs_path) :
+      NULL;
+  if (e && e->has_info)
     {
-      /* open with sndfile */
-      AudecInfo nfo;
-      audec_finfo (abs_path, &nfo);
-      audec_dump_info (3, &nfo);
+      char * info =
+        file_index_entry_get_info_str (e);
       label =
         g_strdup_printf (
-        "%s\nFormat: TODO\nSample rate: %d\n"
-        "Channels:%d Bitrate: %d\nBit depth: %d",
-        descr,
-        nfo.sample_rate,
-        nfo.channels,
-        nfo.bit_rate,
-        nfo.bit_depth);
+        "%s\n%s", descr, info);
+      g_free (info);
     }
   else
     {
@@ -173,6 +167,18 @@ on_file_chooser_selection_changed (
   update_file_info_label (self,
                           label);
 
+  /* probe files that are not indexed yet in the
+   * background instead of reading them here */
+  if (FILE_INDEX &&
+      supported_file_type_is_audio (file->type) &&
+      (!e || e->mtime == 0))
+    {
+      file_index_request_path (
+        FILE_INDEX, abs_path);
+    }
+  if (e)
+    file_index_entry_free (e);
+
   g_free (abs_path);
   supported_file_free (file);
 }
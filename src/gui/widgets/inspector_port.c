@@ -330,7 +330,7 @@ set_port_value (
   InspectorPortWidget * self,
   float                 val)
 {
-  port_set_control_value (
+  port_queue_control_value (
     self->port,
     control_port_normalized_val_to_real (
       self->port, val), false, true);
@@ -357,7 +357,7 @@ val_change_finished (
         val, self->normalized_init_port_val))
     {
       /* set port to previous val */
-      port_set_control_value (
+      port_queue_control_value (
         self->port,
         control_port_normalized_val_to_real (
           self->port,
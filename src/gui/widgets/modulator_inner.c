@@ -77,7 +77,7 @@ set_control_value (
   Port * port,
   float  value)
 {
-  port_set_control_value (
+  port_queue_control_value (
     port, value, F_NOT_NORMALIZED,
     F_NO_PUBLISH_EVENTS);
 }
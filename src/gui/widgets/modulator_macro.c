@@ -283,7 +283,7 @@ set_val (
 {
   Port * port = (Port *) _port;
   g_return_if_fail (IS_PORT (port));
-  port_set_control_value (
+  port_queue_control_value (
     port, val, F_NOT_NORMALIZED, F_PUBLISH_EVENTS);
 }
 
@@ -24,7 +24,9 @@
  */
 
 #include "actions/tracklist_selections.h"
-#include "audio/encoder.h"
+#include "audio/engine.h"
+#include "audio/sample_processor.h"
+#include "gui/backend/file_index.h"
 #include "gui/backend/file_manager.h"
 #include "gui/widgets/arranger.h"
 #include "gui/widgets/bot_dock_edge.h"
@@ -77,15 +79,67 @@ visible_func (GtkTreeModel *model,
   return TRUE;
 }
 
-static int
-update_file_info_label (PanelFileBrowserWidget * self,
-                          gpointer user_data)
+/**
+ * Updates the info label of the selected file.
+ *
+ * Audio info is read from the file index. Files
+ * that are not indexed yet are queued and the
+ * label is updated when the index changes.
+ */
+static void
+update_file_info_label (
+  PanelFileBrowserWidget * self)
 {
-  char * label = (char *) user_data;
+  SupportedFile * descr = self->selected_file_descr;
+  if (!descr)
+    return;
+
+  char * file_type_label =
+    supported_file_type_get_description (
+      descr->type);
+  FileIndexEntry * e =
+    FILE_INDEX ?
+      file_index_get_entry (
+        FILE_INDEX, descr->abs_path) :
+      NULL;
+
+  char * label;
+  if (e && (e->has_info || e->bpm > 0.0 ||
+            e->key[0] != '\0'))
+    {
+      char * info =
+        file_index_entry_get_info_str (e);
+      label =
+        g_strdup_printf (
+          "%s\nFormat: %s\n%s",
+          descr->label, file_type_label, info);
+      g_free (info);
+    }
+  else
+    {
+      label =
+        g_strdup_printf (
+          "%s\nType: %s",
+          descr->label, file_type_label);
+    }
+
+  /* probe audio files that are not indexed
+   * yet (once per selection) */
+  if (FILE_INDEX && !self->file_info_requested &&
+      supported_file_type_is_audio (descr->type) &&
+      (!e || e->mtime == 0))
+    {
+      file_index_request_path (
+        FILE_INDEX, descr->abs_path);
+      self->file_info_requested = true;
+    }
 
   gtk_label_set_text (self->file_info, label);
 
-  return G_SOURCE_REMOVE;
+  g_free (label);
+  g_free (file_type_label);
+  if (e)
+    file_index_entry_free (e);
 }
 
 static void
@@ -129,41 +183,24 @@ on_selection_changed (GtkTreeSelection * ts,
                                     &value);
           SupportedFile * descr =
             g_value_get_pointer (&value);
-          char * file_type_label =
-            supported_file_type_get_description (
-              descr->type);
 
           self->selected_file_descr = descr;
+          self->file_info_requested = false;
+          update_file_info_label (self);
 
-          char * label;
-          if (
-#ifdef HAVE_FFMPEG
-              descr->type == FILE_TYPE_MP3 ||
-#endif
-              descr->type == FILE_TYPE_FLAC ||
-              descr->type == FILE_TYPE_OGG ||
-              descr->type == FILE_TYPE_WAV)
+          if (g_settings_get_boolean (
+                S_UI, "file-browser-autoplay") &&
+              supported_file_type_is_audio (
+                descr->type))
             {
-              AudioEncoder * enc =
-                audio_encoder_new_from_file (
-                  descr->abs_path);
-              label =
-                g_strdup_printf (
-                "%s\nFormat: TODO\nSample rate: %d\n"
-                "Channels:%d Bitrate: %d\nBit depth: %d",
-                descr->label,
-                enc->nfo.sample_rate,
-                enc->nfo.channels,
-                enc->nfo.bit_rate,
-                enc->nfo.bit_depth);
-              audio_encoder_free (enc);
+              sample_processor_queue_sample_from_file (
+                SAMPLE_PROCESSOR, descr->abs_path);
             }
           else
-            label =
-              g_strdup_printf (
-              "%s\nType: %s",
-              descr->label, file_type_label);
-          update_file_info_label (self, label);
+            {
+              sample_processor_stop_file_playback (
+                SAMPLE_PROCESSOR);
+            }
         }
     }
 }
@@ -359,6 +396,22 @@ create_model_for_files (PanelFileBrowserWidget * self)
   return model;
 }
 
+/**
+ * Recreates the files model from the file
+ * manager.
+ */
+static void
+reload_files_model (
+  PanelFileBrowserWidget * self)
+{
+  self->files_tree_model =
+    GTK_TREE_MODEL_FILTER (
+      create_model_for_files (self));
+  gtk_tree_view_set_model (
+    self->files_tree_view,
+    GTK_TREE_MODEL (self->files_tree_model));
+}
+
 static void
 on_row_activated (GtkTreeView       *tree_view,
                GtkTreePath       *tp,
@@ -397,12 +450,7 @@ on_row_activated (GtkTreeView       *tree_view,
       file_manager_set_selection (
         FILE_MANAGER, loc,
         FB_SELECTION_TYPE_LOCATIONS, true);
-      self->files_tree_model =
-        GTK_TREE_MODEL_FILTER (
-          create_model_for_files (self));
-      gtk_tree_view_set_model (
-        self->files_tree_view,
-        GTK_TREE_MODEL (self->files_tree_model));
+      reload_files_model (self);
     }
   else if (descr->type == FILE_TYPE_WAV ||
            descr->type == FILE_TYPE_OGG ||
@@ -557,6 +605,18 @@ add_scroll_window (GtkTreeView * tree_view)
   return scrolled_window;
 }
 
+static void
+on_search_changed (
+  GtkSearchEntry *         entry,
+  PanelFileBrowserWidget * self)
+{
+  file_manager_set_search_text (
+    FILE_MANAGER,
+    gtk_entry_get_text (GTK_ENTRY (entry)));
+  file_manager_load_files (FILE_MANAGER);
+  reload_files_model (self);
+}
+
 static void
 on_position_change (
   GtkStack * stack,
@@ -693,6 +753,10 @@ panel_file_browser_widget_new ()
                       1, 1, 0);
   gtk_widget_show_all (file_scroll_window);
 
+  g_signal_connect (
+    G_OBJECT (self->browser_search),
+    "search-changed",
+    G_CALLBACK (on_search_changed), self);
   g_signal_connect (
     G_OBJECT (self), "draw",
     G_CALLBACK (on_draw), self);
@@ -703,6 +767,17 @@ panel_file_browser_widget_new ()
   return self;
 }
 
+/**
+ * Called when the file index changes to update
+ * the info of the selected file.
+ */
+void
+panel_file_browser_widget_refresh (
+  PanelFileBrowserWidget * self)
+{
+  update_file_info_label (self);
+}
+
 static void
 panel_file_browser_widget_class_init (PanelFileBrowserWidgetClass * _klass)
 {
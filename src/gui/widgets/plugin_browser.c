@@ -33,6 +33,7 @@
 #include "plugins/collections.h"
 #include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
+#include "plugins/plugin_search_index.h"
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/err_codes.h"
@@ -63,6 +64,10 @@ enum
   PL_COLUMN_ICON,
   PL_COLUMN_NAME,
   PL_COLUMN_DESCR,
+
+  /** Position in the plugin manager (sorted by
+   * name). */
+  PL_COLUMN_IDX,
   PL_NUM_COLUMNS
 };
 
@@ -219,7 +224,8 @@ on_row_activated (
 /**
  * Visible function for plugin tree model.
  *
- * Used for filtering based on selected category.
+ * Used for filtering based on the results of the
+ * last search.
  */
 static gboolean
 visible_func (
@@ -227,122 +233,162 @@ visible_func (
   GtkTreeIter  *iter,
   PluginBrowserWidget * self)
 {
-  // Visible if row is non-empty and category
-  // matches selected
-  PluginDescriptor *descr;
+  /* no filter, all visible */
+  if (!self->search_results)
+    return true;
 
+  PluginDescriptor *descr;
   gtk_tree_model_get (
     model, iter, PL_COLUMN_DESCR, &descr, -1);
 
-  int instruments_active, effects_active,
-      modulators_active, midi_modifiers_active;
-  instruments_active =
-    gtk_toggle_tool_button_get_active (
-      self->toggle_instruments);
-  effects_active =
-    gtk_toggle_tool_button_get_active (
-      self->toggle_effects);
-  modulators_active =
-    gtk_toggle_tool_button_get_active (
-      self->toggle_modulators);
-  midi_modifiers_active =
-    gtk_toggle_tool_button_get_active (
-      self->toggle_midi_modifiers);
+  return
+    g_hash_table_contains (
+      self->search_results, descr);
+}
 
-  /* no filter, all visible */
-  if (self->num_selected_categories == 0 &&
-      self->num_selected_protocols == 0 &&
-      !self->selected_collection &&
-      !self->current_search &&
-      !instruments_active &&
-      !effects_active &&
-      !modulators_active &&
-      !midi_modifiers_active)
-    {
-      return true;
-    }
+typedef struct RowOrder
+{
+  /** Current position in the list store. */
+  gint  pos;
 
-  int visible = false;
+  /** Sort key. */
+  guint key;
+} RowOrder;
 
-  /* not visible if category selected and plugin
-   * doesn't match */
-  if (self->num_selected_categories > 0)
-    {
-      for (int i = 0;
-           i < self->num_selected_categories; i++)
-        {
-          if (descr->category ==
-                self->selected_categories[i])
-            {
-              visible = true;
-              break;
-            }
-        }
+static int
+cmp_row_order (
+  const void * a,
+  const void * b)
+{
+  guint key_a = ((const RowOrder *) a)->key;
+  guint key_b = ((const RowOrder *) b)->key;
+  return (key_a > key_b) - (key_a < key_b);
+}
 
-      /* not visible if the category is not one
-       * of the selected categories */
-      if (!visible)
-        return false;
-    }
+/**
+ * Moves the search results to the top of the
+ * list in order of relevance if searching by
+ * text, otherwise restores the alphabetical
+ * order.
+ */
+static void
+reorder_plugins (
+  PluginBrowserWidget * self)
+{
+  GtkListStore * list_store =
+    GTK_LIST_STORE (
+      gtk_tree_model_filter_get_model (
+        self->plugin_tree_model));
+  GtkTreeModel * model =
+    GTK_TREE_MODEL (list_store);
+  gint num_rows =
+    gtk_tree_model_iter_n_children (model, NULL);
+  if (num_rows == 0)
+    return;
 
-  /* not visible if plugin is not part of
-   * selected collection */
-  if (self->selected_collection)
+  bool rank_by_text =
+    self->current_search && self->search_results;
+  RowOrder * order = g_new (RowOrder, num_rows);
+  GtkTreeIter iter;
+  bool has_iter =
+    gtk_tree_model_get_iter_first (model, &iter);
+  bool changed = false;
+  for (gint i = 0; i < num_rows && has_iter; i++)
     {
-      if (plugin_collection_contains_descriptor (
-            self->selected_collection, descr,
-            false))
-        {
-          visible = true;
-        }
-      else
-        {
-          return false;
-        }
+      PluginDescriptor * descr;
+      gint idx;
+      gtk_tree_model_get (
+        model, &iter, PL_COLUMN_DESCR, &descr,
+        PL_COLUMN_IDX, &idx, -1);
+      guint rank =
+        rank_by_text ?
+          GPOINTER_TO_UINT (
+            g_hash_table_lookup (
+              self->search_results, descr)) : 0;
+
+      order[i].pos = i;
+      order[i].key =
+        rank > 0 ?
+          rank - 1 :
+          (guint) num_rows + (guint) idx;
+      if (i > 0 && order[i].key < order[i - 1].key)
+        changed = true;
+
+      has_iter =
+        gtk_tree_model_iter_next (model, &iter);
     }
 
-  /* not visible if plugin protocol is not one of
-   * selected protocols */
-  if (self->num_selected_protocols > 0)
+  if (changed)
     {
-      visible = false;
-      for (int i = 0;
-           i < self->num_selected_protocols; i++)
+      qsort (
+        order, (size_t) num_rows, sizeof (RowOrder),
+        cmp_row_order);
+      gint * new_order = g_new (gint, num_rows);
+      for (gint i = 0; i < num_rows; i++)
         {
-          if (descr->protocol ==
-                self->selected_protocols[i])
-            {
-              visible = true;
-              break;
-            }
+          new_order[i] = order[i].pos;
         }
-
-      if (!visible)
-        return false;
+      gtk_list_store_reorder (list_store, new_order);
+      g_free (new_order);
     }
+  g_free (order);
+}
 
-  /* not visibile if plugin type doesn't match */
-  if (instruments_active &&
-      !plugin_descriptor_is_instrument (descr))
-    return false;
-  if (effects_active &&
-      !plugin_descriptor_is_effect (descr))
-    return false;
-  if (modulators_active &&
-      !plugin_descriptor_is_modulator (descr))
-    return false;
-  if (midi_modifiers_active &&
-      !plugin_descriptor_is_midi_modifier (descr))
-    return false;
-
-  if (self->current_search &&
-      !string_contains_substr_case_insensitive (
-        descr->name, self->current_search))
+/**
+ * Runs the search for the current filters and
+ * refilters the plugin list.
+ */
+static void
+update_search_results (
+  PluginBrowserWidget * self)
+{
+  PluginSearchQuery query;
+  memset (&query, 0, sizeof (query));
+  query.text = self->current_search;
+  query.categories = self->selected_categories;
+  query.num_categories =
+    self->num_selected_categories;
+  query.protocols = self->selected_protocols;
+  query.num_protocols =
+    self->num_selected_protocols;
+  query.collection = self->selected_collection;
+  query.types[PLUGIN_SEARCH_TYPE_INSTRUMENT] =
+    gtk_toggle_tool_button_get_active (
+      self->toggle_instruments);
+  query.types[PLUGIN_SEARCH_TYPE_EFFECT] =
+    gtk_toggle_tool_button_get_active (
+      self->toggle_effects);
+  query.types[PLUGIN_SEARCH_TYPE_MODULATOR] =
+    gtk_toggle_tool_button_get_active (
+      self->toggle_modulators);
+  query.types[PLUGIN_SEARCH_TYPE_MIDI_MODIFIER] =
+    gtk_toggle_tool_button_get_active (
+      self->toggle_midi_modifiers);
+
+  object_free_w_func_and_null (
+    g_hash_table_unref, self->search_results);
+  if (!plugin_search_query_is_empty (&query))
     {
-      return false;
+      GArray * results =
+        plugin_search_index_query (
+          PLUGIN_SEARCH_INDEX, &query);
+      self->search_results =
+        g_hash_table_new (NULL, NULL);
+      for (guint i = 0; i < results->len; i++)
+        {
+          PluginSearchResult * res =
+            &g_array_index (
+              results, PluginSearchResult, i);
+          g_hash_table_insert (
+            self->search_results, res->descr,
+            GUINT_TO_POINTER (i + 1));
+        }
+      g_array_unref (results);
     }
 
-  return true;
+  reorder_plugins (self);
+  gtk_tree_model_filter_refilter (
+    self->plugin_tree_model);
 }
 
 static void
@@ -995,8 +1041,7 @@ on_selection_changed (
           cat_selected_foreach,
         self);
 
-      gtk_tree_model_filter_refilter (
-        self->plugin_tree_model);
+      update_search_results (self);
     }
   else if (model ==
              GTK_TREE_MODEL (
@@ -1010,8 +1055,7 @@ on_selection_changed (
           protocol_selected_foreach,
         self);
 
-      gtk_tree_model_filter_refilter (
-        self->plugin_tree_model);
+      update_search_results (self);
     }
   else if (model ==
              GTK_TREE_MODEL (
@@ -1077,8 +1121,7 @@ on_selection_changed (
           self->selected_collection->name :
           "none");
 
-      gtk_tree_model_filter_refilter (
-        self->plugin_tree_model);
+      update_search_results (self);
     }
 
   g_list_free_full (
@@ -1234,7 +1277,14 @@ create_model_for_plugins (
   list_store =
     gtk_list_store_new (
       PL_NUM_COLUMNS, G_TYPE_STRING,
-      G_TYPE_STRING, G_TYPE_POINTER);
+      G_TYPE_STRING, G_TYPE_POINTER, G_TYPE_INT);
+
+  /* make sure the search index is up to date */
+  plugin_search_index_sync (
+    PLUGIN_SEARCH_INDEX,
+    (PluginDescriptor * const *)
+      PLUGIN_MANAGER->plugin_descriptors,
+    PLUGIN_MANAGER->num_plugins);
 
   for (i = 0; i < PLUGIN_MANAGER->num_plugins; i++)
     {
@@ -1275,6 +1325,7 @@ create_model_for_plugins (
         PL_COLUMN_ICON, icon_name,
         PL_COLUMN_NAME, descr->name,
         PL_COLUMN_DESCR, descr,
+        PL_COLUMN_IDX, i,
         -1);
     }
 
@@ -1291,11 +1342,10 @@ create_model_for_plugins (
 }
 
 static bool
-refilter_source (
+update_search_results_source (
   PluginBrowserWidget * self)
 {
-  gtk_tree_model_filter_refilter (
-    self->plugin_tree_model);
+  update_search_results (self);
 
   return G_SOURCE_REMOVE;
 }
@@ -1308,37 +1358,25 @@ plugin_search_equal_func (
   GtkTreeIter *iter,
   PluginBrowserWidget * self)
 {
-  char * str;
-  gtk_tree_model_get (
-    model, iter, column, &str, -1);
-
-  char * down_key =
-    g_utf8_strdown (key, -1);
-  char * down_str =
-    g_utf8_strdown (str, -1);
-  /*g_debug ("key '%s' str '%s'", key, str);*/
-
-  g_free_and_null (self->current_search);
-  self->current_search = g_strdup (key);
-
-  bool match =
-    string_contains_substr_case_insensitive (
-      down_str, down_key);
-
-  /* refilter treeview if this is the last
-   * iteration of this func */
-  GtkTreeIter next_iter = *iter;
-  bool has_next =
-    gtk_tree_model_iter_next (model, &next_iter);
-  if (match || !has_next)
+  /* search again if the key changed */
+  if (!string_is_equal (self->current_search, key))
     {
+      g_free_and_null (self->current_search);
+      self->current_search = g_strdup (key);
       g_idle_add (
-        (GSourceFunc) refilter_source, self);
+        (GSourceFunc) update_search_results_source,
+        self);
     }
 
-  g_free (str);
-  g_free (down_key);
-  g_free (down_str);
+  /* the visible rows are the results, ordered by
+   * relevance */
+  PluginDescriptor * descr;
+  gtk_tree_model_get (
+    model, iter, PL_COLUMN_DESCR, &descr, -1);
+  bool match =
+    self->search_results &&
+    g_hash_table_contains (
+      self->search_results, descr);
 
   return !match;
 }
@@ -1624,8 +1662,7 @@ toggles_changed (
         "plugin-browser-filter",
         PLUGIN_BROWSER_FILTER_NONE);
     }
-  gtk_tree_model_filter_refilter (
-    self->plugin_tree_model);
+  update_search_results (self);
 }
 
 static int
@@ -1705,10 +1742,11 @@ on_key_release (
   GdkEvent *            event,
   PluginBrowserWidget * self)
 {
-  g_free_and_null (self->current_search);
-
-  gtk_tree_model_filter_refilter (
-    self->plugin_tree_model);
+  if (self->current_search)
+    {
+      g_free_and_null (self->current_search);
+      update_search_results (self);
+    }
 
   g_message ("key release");
 
@@ -1845,6 +1883,7 @@ plugin_browser_widget_new ()
         self->toggle_midi_modifiers, 1);
       break;
     }
+  update_search_results (self);
 
   /* set divider position */
   int divider_pos =
@@ -1879,6 +1918,19 @@ plugin_browser_widget_new ()
   return self;
 }
 
+static void
+plugin_browser_widget_finalize (
+  PluginBrowserWidget * self)
+{
+  g_free_and_null (self->current_search);
+  object_free_w_func_and_null (
+    g_hash_table_unref, self->search_results);
+
+  G_OBJECT_CLASS (
+    plugin_browser_widget_parent_class)->
+      finalize (G_OBJECT (self));
+}
+
 static void
 plugin_browser_widget_class_init (
   PluginBrowserWidgetClass * _klass)
@@ -1924,6 +1976,12 @@ plugin_browser_widget_class_init (
   BIND_SIGNAL (toggles_changed);
 
 #undef BIND_SIGNAL
+
+  GObjectClass * oklass =
+    G_OBJECT_CLASS (_klass);
+  oklass->finalize =
+    (GObjectFinalizeFunc)
+    plugin_browser_widget_finalize;
 }
 
 static void
@@ -243,7 +243,9 @@ get_path_type (
     KEY_IS (
       "Plugins", "Paths", "sfz-search-paths") ||
     KEY_IS (
-      "Plugins", "Paths", "sf2-search-paths"))
+      "Plugins", "Paths", "sf2-search-paths") ||
+    KEY_IS (
+      "General", "Paths", "sample-library-paths"))
     {
       return PATH_TYPE_ENTRY;
     }
@@ -274,6 +276,13 @@ should_be_hidden (
      KEY_IS (
        "General", "Engine",
        "sdl-audio-device-name")) ||
+    (AUDIO_ENGINE->audio_backend !=
+       AUDIO_BACKEND_ALSA &&
+     (KEY_IS (
+        "General", "Engine",
+        "alsa-audio-device-name") ||
+      KEY_IS (
+        "General", "Engine", "alsa-periods"))) ||
     (!audio_backend_is_rtaudio (
        AUDIO_ENGINE->audio_backend) &&
      KEY_IS (
@@ -328,7 +337,10 @@ make_control (
         "rtaudio-audio-device-name") ||
       KEY_IS (
         "General", "Engine",
-        "sdl-audio-device-name"))
+        "sdl-audio-device-name") ||
+      KEY_IS (
+        "General", "Engine",
+        "alsa-audio-device-name"))
     {
       widget = gtk_combo_box_text_new ();
       ui_setup_device_name_combo_box (
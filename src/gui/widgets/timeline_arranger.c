@@ -609,7 +609,9 @@ snap_region_l (
           (ArrangerObject *) region);
       position_snap (
         &self->earliest_obj_start_pos,
-        new_pos, track,
+        new_pos,
+        arranger_widget_get_snap_obj_index (
+          self, track),
         NULL, self->snap_grid);
     }
 
@@ -785,7 +787,9 @@ snap_region_r (
           (ArrangerObject *) region);
       position_snap (
         &self->earliest_obj_start_pos,
-        new_pos, track,
+        new_pos,
+        arranger_widget_get_snap_obj_index (
+          self, track),
         NULL, self->snap_grid);
     }
 
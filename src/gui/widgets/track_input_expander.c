@@ -511,7 +511,7 @@ set_gain (
 {
   Port * port = (Port *) _port;
   g_return_if_fail (IS_PORT (port));
-  port_set_control_value (
+  port_queue_control_value (
     port, gain, F_NOT_NORMALIZED, F_PUBLISH_EVENTS);
 }
 
@@ -525,8 +525,10 @@ on_mono_toggled (
     return;
 
   bool new_val = gtk_toggle_button_get_active (btn);
-  control_port_set_val_from_normalized (
-    self->track->processor->mono, new_val, false);
+  port_queue_control_value (
+    self->track->processor->mono,
+    new_val ? 1.f : 0.f, F_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
   gtk_widget_set_sensitive (
     GTK_WIDGET (self->stereo_r_input), !new_val);
 }
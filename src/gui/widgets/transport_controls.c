@@ -91,24 +91,24 @@ static void
 forward_clicked_cb (GtkButton * forward,
                     gpointer          user_data)
 {
-  Position *pos =
-    snap_grid_get_nearby_snap_point (
-      &PROJECT->snap_grid_timeline,
-      &TRANSPORT->playhead_pos, 0);
+  Position pos;
+  snap_grid_get_nearby_snap_point (
+    &PROJECT->snap_grid_timeline,
+    &TRANSPORT->playhead_pos, 0, &pos);
   transport_move_playhead (
-    TRANSPORT, pos, F_PANIC, F_SET_CUE_POINT);
+    TRANSPORT, &pos, F_PANIC, F_SET_CUE_POINT);
 }
 
 static void
 backward_clicked_cb (GtkButton * backward,
                      gpointer    user_data)
 {
-  Position * pos =
-    snap_grid_get_nearby_snap_point (
-      &PROJECT->snap_grid_timeline,
-      &TRANSPORT->playhead_pos, 1);
+  Position pos;
+  snap_grid_get_nearby_snap_point (
+    &PROJECT->snap_grid_timeline,
+    &TRANSPORT->playhead_pos, 1, &pos);
   transport_move_playhead (
-    TRANSPORT, pos, F_PANIC, F_SET_CUE_POINT);
+    TRANSPORT, &pos, F_PANIC, F_SET_CUE_POINT);
 }
 
 static void
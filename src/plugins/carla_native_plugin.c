@@ -80,6 +80,21 @@ carla_plugin_tick_cb (
     return G_SOURCE_REMOVE;
 }
 
+/**
+ * A port reported by the host patchbay.
+ */
+typedef struct PatchbayPort
+{
+  /** Patchbay group (client) ID. */
+  unsigned int group;
+
+  /** Port ID in the group. */
+  unsigned int id;
+
+  /** PatchbayPortHints. */
+  int          hints;
+} PatchbayPort;
+
 static uint32_t
 host_get_buffer_size (
   NativeHostHandle handle)
@@ -280,11 +295,144 @@ engine_callback (
         ET_PLUGIN_VISIBILITY_CHANGED,
         self->plugin);
       break;
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_ADDED:
+      /* val2 is the plugin ID, or -1 */
+      if (self->patchbay_ports &&
+          val2 == (int) self->carla_plugin_id)
+        {
+          self->patchbay_plugin_group =
+            (int) plugin_id;
+        }
+      break;
+    case ENGINE_CALLBACK_PATCHBAY_PORT_ADDED:
+      if (self->patchbay_ports)
+        {
+          PatchbayPort port = {
+            .group = plugin_id,
+            .id = (unsigned int) val1,
+            .hints = val2,
+          };
+          g_array_append_val (
+            self->patchbay_ports, port);
+        }
+      break;
     default:
       break;
     }
 }
 
+/**
+ * Connects the ports of the given type of the
+ * host patchbay to the plugin, in order.
+ *
+ * @param type PATCHBAY_PORT_TYPE_AUDIO or
+ *   PATCHBAY_PORT_TYPE_MIDI.
+ */
+static void
+connect_patchbay_ports (
+  CarlaNativePlugin * self,
+  int                 type)
+{
+  /* [0]: host sources (patchbay inputs),
+   * [1]: plugin inputs,
+   * [2]: plugin outputs,
+   * [3]: host sinks (patchbay outputs) */
+  GArray * ports[4];
+  for (int i = 0; i < 4; i++)
+    {
+      ports[i] =
+        g_array_new (
+          false, false, sizeof (PatchbayPort));
+    }
+  for (guint i = 0; i < self->patchbay_ports->len;
+       i++)
+    {
+      PatchbayPort * port =
+        &g_array_index (
+          self->patchbay_ports, PatchbayPort, i);
+      if (!(port->hints & type))
+        continue;
+
+      bool is_plugin =
+        (int) port->group ==
+          self->patchbay_plugin_group;
+      bool is_input =
+        port->hints & PATCHBAY_PORT_IS_INPUT;
+      int idx =
+        is_plugin ?
+          (is_input ? 1 : 2) :
+          (is_input ? 3 : 0);
+      g_array_append_val (ports[idx], *port);
+    }
+
+  for (int i = 0; i < 4; i += 2)
+    {
+      guint num_connections =
+        MIN (ports[i]->len, ports[i + 1]->len);
+      for (guint j = 0; j < num_connections; j++)
+        {
+          PatchbayPort * src =
+            &g_array_index (
+              ports[i], PatchbayPort, j);
+          PatchbayPort * dest =
+            &g_array_index (
+              ports[i + 1], PatchbayPort, j);
+          if (!carla_patchbay_connect (
+                 self->host_handle, false,
+                 src->group, src->id,
+                 dest->group, dest->id))
+            {
+              g_warning (
+                "failed to connect patchbay ports: "
+                "%s",
+                carla_get_last_error (
+                  self->host_handle));
+            }
+        }
+    }
+
+  for (int i = 0; i < 4; i++)
+    {
+      g_array_free (ports[i], true);
+    }
+}
+
+/**
+ * Connects the plugin to the ins and outs of the
+ * host patchbay.
+ *
+ * Plugins in the rack are connected
+ * automatically.
+ */
+static void
+connect_patchbay (
+  CarlaNativePlugin * self)
+{
+  /* collect the ports */
+  self->patchbay_ports =
+    g_array_new (
+      false, false, sizeof (PatchbayPort));
+  self->patchbay_plugin_group = -1;
+  carla_patchbay_refresh (
+    self->host_handle, false);
+
+  if (self->patchbay_plugin_group < 0)
+    {
+      g_warning (
+        "plugin not found in the patchbay");
+    }
+  else
+    {
+      connect_patchbay_ports (
+        self, PATCHBAY_PORT_TYPE_AUDIO);
+      connect_patchbay_ports (
+        self, PATCHBAY_PORT_TYPE_MIDI);
+    }
+
+  g_array_free (self->patchbay_ports, true);
+  self->patchbay_ports = NULL;
+}
+
 
 static CarlaNativePlugin *
 _create ()
@@ -338,6 +486,11 @@ _create ()
 
   self->time_info.bbt.valid = 1;
 
+  self->midi_events =
+    calloc (
+      MAX_MIDI_EVENTS, sizeof (NativeMidiEvent));
+  self->patchbay_plugin_group = -1;
+
   return self;
 }
 
@@ -351,9 +504,53 @@ create_plugin (
 {
   CarlaNativePlugin * self = _create ();
 
+  /* the rack has 2 ins and 2 outs, so use a
+   * patchbay with enough channels for plugins that
+   * need more */
+  int max_channels =
+    MAX (descr->num_audio_ins, descr->num_audio_outs);
+  if (max_channels <= 2)
+    {
+      self->host_type = CARLA_PLUGIN_RACK;
+      self->native_plugin_descriptor =
+        carla_get_native_rack_plugin ();
+      self->num_host_audio_ins = 2;
+    }
+  else if (max_channels <= 16)
+    {
+      self->host_type = CARLA_PLUGIN_PATCHBAY16;
+      self->native_plugin_descriptor =
+        carla_get_native_patchbay16_plugin ();
+      self->num_host_audio_ins = 16;
+    }
+  else if (max_channels <= 32)
+    {
+      self->host_type = CARLA_PLUGIN_PATCHBAY32;
+      self->native_plugin_descriptor =
+        carla_get_native_patchbay32_plugin ();
+      self->num_host_audio_ins = 32;
+    }
+  else
+    {
+      if (max_channels >
+            CARLA_NATIVE_PLUGIN_MAX_CHANNELS)
+        {
+          g_warning (
+            "%s has %d channels, only the first %d "
+            "will be used", descr->name,
+            max_channels,
+            CARLA_NATIVE_PLUGIN_MAX_CHANNELS);
+        }
+      self->host_type = CARLA_PLUGIN_PATCHBAY64;
+      self->native_plugin_descriptor =
+        carla_get_native_patchbay64_plugin ();
+      self->num_host_audio_ins =
+        CARLA_NATIVE_PLUGIN_MAX_CHANNELS;
+    }
+  self->num_host_audio_outs =
+    self->num_host_audio_ins;
+
   /* instantiate the plugin to get its info */
-  self->native_plugin_descriptor =
-    carla_get_native_rack_plugin ();
   self->native_plugin_handle =
     self->native_plugin_descriptor->instantiate (
       &self->native_host_descriptor);
@@ -493,6 +690,11 @@ create_plugin (
   carla_set_engine_callback (
     self->host_handle, engine_callback, self);
 
+  if (self->host_type != CARLA_PLUGIN_RACK)
+    {
+      connect_patchbay (self);
+    }
+
   if (ZRYTHM_TESTING)
     {
       return self;
@@ -593,6 +795,43 @@ carla_native_plugin_populate_banks (
   g_free (str);
 }
 
+/**
+ * Allocates the dummy buffers for the given block
+ * length and notifies the host plugin.
+ *
+ * Must not be called while processing.
+ */
+void
+carla_native_plugin_update_buffer_size (
+  CarlaNativePlugin * self,
+  nframes_t           nframes)
+{
+  g_return_if_fail (nframes > 0);
+
+  if (nframes != self->bufs_size)
+    {
+      self->zero_buf =
+        realloc (
+          self->zero_buf, nframes * sizeof (float));
+      memset (
+        self->zero_buf, 0,
+        nframes * sizeof (float));
+      self->discard_buf =
+        realloc (
+          self->discard_buf,
+          nframes * sizeof (float));
+      self->bufs_size = nframes;
+    }
+
+  if (self->native_plugin_handle)
+    {
+      self->native_plugin_descriptor->dispatcher (
+        self->native_plugin_handle,
+        NATIVE_PLUGIN_OPCODE_BUFFER_SIZE_CHANGED,
+        0, (intptr_t) nframes, NULL, 0.f);
+    }
+}
+
 /**
  * Processes the plugin for this cycle.
  */
@@ -645,92 +884,68 @@ carla_native_plugin_proces (
     case PROT_SFZ:
     case PROT_SF2:
     {
-      float * inbuf[2];
-      float dummy_inbuf1[nframes];
-      memset (
-        dummy_inbuf1, 0, nframes * sizeof (float));
-      float dummy_inbuf2[nframes];
-      memset (
-        dummy_inbuf2, 0, nframes * sizeof (float));
-      float * outbuf[2];
-      float dummy_outbuf1[nframes];
-      memset (
-        dummy_outbuf1, 0, nframes * sizeof (float));
-      float dummy_outbuf2[nframes];
-      memset (
-        dummy_outbuf2, 0, nframes * sizeof (float));
-      int i = 0;
-      int audio_ports = 0;
-      while (i < self->plugin->num_in_ports)
+      g_return_if_fail (
+        nframes <= self->bufs_size);
+
+      /* pass the port buffers from the start of
+       * this split directly, and the dummy buffers
+       * for host channels without a port */
+      Plugin * pl = self->plugin;
+      int num_ins = 0;
+      for (int i = 0;
+           i < pl->num_in_ports &&
+             num_ins < self->num_host_audio_ins;
+           i++)
         {
-          Port * port = self->plugin->in_ports[i];
+          Port * port = pl->in_ports[i];
           if (port->id.type == TYPE_AUDIO)
             {
-              inbuf[audio_ports++] =
-                self->plugin->in_ports[i]->buf;
+              self->inbufs[num_ins++] =
+                &port->buf[local_offset];
             }
-          if (audio_ports == 2)
-            break;
-          i++;
         }
-      switch (audio_ports)
+      while (num_ins < self->num_host_audio_ins)
         {
-        case 0:
-          inbuf[0] = dummy_inbuf1;
-          inbuf[1] = dummy_inbuf2;
-          break;
-        case 1:
-          inbuf[1] = dummy_inbuf2;
-          break;
-        default:
-          break;
+          self->inbufs[num_ins++] = self->zero_buf;
         }
 
-      i = 0;
-      audio_ports = 0;
-      while (i < self->plugin->num_out_ports)
+      int num_outs = 0;
+      for (int i = 0;
+           i < pl->num_out_ports &&
+             num_outs < self->num_host_audio_outs;
+           i++)
         {
-          Port * port = self->plugin->out_ports[i];
+          Port * port = pl->out_ports[i];
           if (port->id.type == TYPE_AUDIO)
             {
-              outbuf[audio_ports++] =
-                self->plugin->out_ports[i]->buf;
+              self->outbufs[num_outs++] =
+                &port->buf[local_offset];
             }
-          if (audio_ports == 2)
-            break;
-          i++;
         }
-      switch (audio_ports)
+      while (num_outs < self->num_host_audio_outs)
         {
-        case 0:
-          outbuf[0] = dummy_outbuf1;
-          outbuf[1] = dummy_outbuf2;
-          break;
-        case 1:
-          outbuf[1] = dummy_outbuf2;
-          break;
-        default:
-          break;
+          self->outbufs[num_outs++] =
+            self->discard_buf;
         }
 
       /* get main midi port */
       Port * port = NULL;
-      for (i = 0;
-           i < self->plugin->num_in_ports; i++)
+      for (int i = 0; i < pl->num_in_ports; i++)
         {
-          port = self->plugin->in_ports[i];
-          if (port->id.type == TYPE_EVENT)
+          if (pl->in_ports[i]->id.type ==
+                TYPE_EVENT)
             {
+              port = pl->in_ports[i];
               break;
             }
-          else
-            port = NULL;
         }
 
-      int num_events =
+      /* translate the events of this split, with
+       * times relative to its start */
+      uint32_t num_events = 0;
+      int num_port_events =
         port ? port->midi_events->num_events : 0;
-      NativeMidiEvent events[4000];
-      for (i = 0; i < num_events; i++)
+      for (int i = 0; i < num_port_events; i++)
         {
           MidiEvent * ev =
             &port->midi_events->events[i];
@@ -742,25 +957,20 @@ carla_native_plugin_proces (
                * the processing cycle */
               continue;
             }
-          events[i].time = ev->time;
-          events[i].size = 3;
-          events[i].data[0] = ev->raw_buffer[0];
-          events[i].data[1] = ev->raw_buffer[1];
-          events[i].data[2] = ev->raw_buffer[2];
-          /*midi_event_print (ev);*/
-        }
-      if (num_events > 0)
-        {
-          g_message (
-            "Carla plugin %s has %d MIDI events",
-            self->plugin->descr->name,
-            num_events);
+          NativeMidiEvent * native_ev =
+            &self->midi_events[num_events++];
+          native_ev->port = 0;
+          native_ev->time = ev->time - local_offset;
+          native_ev->size = 3;
+          native_ev->data[0] = ev->raw_buffer[0];
+          native_ev->data[1] = ev->raw_buffer[1];
+          native_ev->data[2] = ev->raw_buffer[2];
         }
 
-      /*g_warn_if_reached ();*/
       self->native_plugin_descriptor->process (
-        self->native_plugin_handle, inbuf, outbuf,
-        nframes, events, (uint32_t) num_events);
+        self->native_plugin_handle, self->inbufs,
+        self->outbufs, nframes, self->midi_events,
+        num_events);
       }
       break;
     default:
@@ -1163,6 +1373,9 @@ carla_native_plugin_instantiate (
       create_ports (self, false);
     }
 
+  carla_native_plugin_update_buffer_size (
+    self, host_get_buffer_size (self));
+
   g_message ("activating carla plugin...");
   self->native_plugin_descriptor->activate (
     self->native_plugin_handle);
@@ -1469,6 +1682,10 @@ carla_native_plugin_free (
 {
   carla_native_plugin_close (self);
 
+  free (self->midi_events);
+  free (self->zero_buf);
+  free (self->discard_buf);
+
   free (self);
 }
 #endif
@@ -130,6 +130,7 @@ lv2_state_save_to_file (
       PROJECT, PROJECT_PATH_PLUGIN_EXT_LINKS,
       false);
 
+  g_rec_mutex_lock (&PM_LILV_LOCK);
   LilvState* const state =
     lilv_state_new_from_instance (
       pl->lilv_plugin, pl->instance,
@@ -144,6 +145,7 @@ lv2_state_save_to_file (
     lilv_state_save (
       LILV_WORLD, &pl->map, &pl->unmap,
       state, NULL, abs_state_dir, STATE_FILENAME);
+  g_rec_mutex_unlock (&PM_LILV_LOCK);
   if (rc)
     {
       g_critical ("Lilv save state failed");
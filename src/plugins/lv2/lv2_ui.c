@@ -32,11 +32,13 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "audio/port.h"
 #include "plugins/lv2_plugin.h"
 #include "plugins/lv2/lv2_gtk.h"
 #include "plugins/lv2/lv2_ui.h"
 #include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
+#include "utils/flags.h"
 #include "zrythm.h"
 #include "zrythm_app.h"
 
@@ -101,8 +103,12 @@ get_port_index (
 }
 
 /**
- * Read and apply control change events from UI,
- * for plugins that have their own UIs.
+ * Read and apply atom events from UI, for plugins
+ * that have their own UIs.
+ *
+ * Float control changes do not go through here,
+ * they are queued by
+ * lv2_ui_send_event_from_ui_to_plugin().
  *
  * Called in the real-time audio thread during
  * plugin processing.
@@ -146,29 +152,8 @@ lv2_ui_read_and_apply_events (
       Lv2Port* const port =
         &plugin->ports[ev.index];
 
-      /* float control change - this is only for
-       * plugins with custom UIs */
-      if (ev.protocol == 0 &&
-          plugin_has_custom_ui (plugin->plugin))
-        {
-          assert (ev.size == sizeof (float));
-          g_return_if_fail (port->port);
-          port_set_control_value (
-            port->port, * (float *) body, 0, 0);
-          port->received_ui_event = 1;
-
-          /* note: should not be printing in the
-           * realtime thread */
-          g_debug (
-            "plugin %s float control '%s' change: "
-            "%f - has custom UI %d",
-            plugin->plugin->descr->name,
-            port->port->id.label,
-            (double) * (float *) body,
-            plugin_has_custom_ui (plugin->plugin));
-        }
-      else if (ev.protocol ==
-                 PM_URIDS.atom_eventTransfer)
+      if (ev.protocol ==
+            PM_URIDS.atom_eventTransfer)
         {
           LV2_Evbuf_Iterator e =
             lv2_evbuf_end (port->evbuf);
@@ -359,6 +344,21 @@ lv2_ui_send_event_from_ui_to_plugin (
       free(str);
     }
 
+  /* float control changes are applied at the start
+   * of the next cycle, like the other control
+   * changes made from the GTK thread */
+  if (protocol == 0)
+    {
+      g_return_if_fail (
+        buffer_size == sizeof (float) &&
+        lv2_port->port);
+      lv2_port->received_ui_event = 1;
+      port_queue_control_value (
+        lv2_port->port, * (const float *) buffer,
+        F_NOT_NORMALIZED, F_NO_PUBLISH_EVENTS);
+      return;
+    }
+
   char buf[sizeof(Lv2ControlChange) + buffer_size];
   Lv2ControlChange* ev = (Lv2ControlChange*)buf;
   ev->index    = port_index;
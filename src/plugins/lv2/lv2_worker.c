@@ -34,10 +34,17 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <stdlib.h>
+
 #include "audio/engine.h"
 #include "plugins/lv2_plugin.h"
 #include "plugins/lv2/lv2_worker.h"
+#include "plugins/plugin_manager.h"
 #include "project.h"
+#include "utils/audio.h"
+#include "utils/mpmc_queue.h"
+#include "utils/objects.h"
+#include "zrythm.h"
 #include "zrythm_app.h"
 
 static LV2_Worker_Status
@@ -47,6 +54,12 @@ lv2_worker_respond (
   const void*               data)
 {
   LV2_Worker* worker = (LV2_Worker*)handle;
+  if (zix_ring_write_space (worker->responses) <
+        sizeof (size) + size)
+    {
+      return LV2_WORKER_ERR_NO_SPACE;
+    }
+
   zix_ring_write (
     worker->responses, (const char*)&size,
     sizeof(size));
@@ -55,39 +68,214 @@ lv2_worker_respond (
   return LV2_WORKER_SUCCESS;
 }
 
-static void*
-worker_func (void* data)
+/**
+ * Queues the worker in the pool, unless it is
+ * already queued.
+ *
+ * Realtime safe.
+ */
+static void
+enqueue (
+  LV2_Worker * worker)
 {
-  LV2_Worker* worker = (LV2_Worker*)data;
-  Lv2Plugin*       plugin   = worker->plugin;
-  void*       buf    = NULL;
-  while (true) {
-    zix_sem_wait(&worker->sem);
-    if (plugin->exit) {
-      break;
+  Lv2WorkerPool * pool = worker->pool;
+  if (!g_atomic_int_compare_and_exchange (
+         &worker->queued, 0, 1))
+    return;
+
+  if (mpmc_queue_push_back (pool->ready, worker))
+    {
+      zix_sem_post (&pool->sem);
+    }
+  else
+    {
+      /* the queue is full - the requests will be
+       * picked up on the next schedule */
+      g_atomic_int_set (&worker->queued, 0);
     }
+}
 
-    uint32_t size = 0;
-    zix_ring_read(worker->requests, (char*)&size, sizeof(size));
+/**
+ * Runs the next request of the given worker.
+ *
+ * The worker is owned by the calling thread until
+ * it is put back to the queue or released.
+ */
+static void
+run_next_request (
+  LV2_Worker * worker,
+  void **      buf,
+  uint32_t *   buf_size)
+{
+  Lv2Plugin * plugin = worker->plugin;
 
-    if (!(buf = realloc(buf, size))) {
-      fprintf(stderr, "error: realloc() failed\n");
-      free(buf);
-      return NULL;
+  uint32_t size = 0;
+  zix_ring_read (
+    worker->requests, (char *) &size,
+    sizeof (size));
+  if (size > *buf_size)
+    {
+      void * new_buf = realloc (*buf, size);
+      if (new_buf)
+        {
+          *buf = new_buf;
+          *buf_size = size;
+        }
     }
 
-    zix_ring_read(worker->requests, (char*)buf, size);
+  if (size > *buf_size)
+    {
+      g_critical ("failed to allocate %u bytes", size);
+      zix_ring_skip (worker->requests, size);
+    }
+  else
+    {
+      zix_ring_read (
+        worker->requests, (char *) *buf, size);
 
-    zix_sem_wait(&plugin->work_lock);
-    worker->iface->work(
-      plugin->instance->lv2_handle, lv2_worker_respond, worker, size, buf);
-    zix_sem_post(&plugin->work_lock);
-  }
+      /* drop the requests of instances being
+       * freed */
+      if (!plugin->exit)
+        {
+          zix_sem_wait (&plugin->work_lock);
+          worker->iface->work (
+            plugin->instance->lv2_handle,
+            lv2_worker_respond, worker, size, *buf);
+          zix_sem_post (&plugin->work_lock);
+        }
+    }
+
+  if (g_atomic_int_dec_and_test (
+        &worker->num_pending))
+    {
+      /* release the worker and check again for a
+       * request scheduled while it was still
+       * marked as queued */
+      g_atomic_int_set (&worker->queued, 0);
+      if (g_atomic_int_get (&worker->num_pending) > 0)
+        {
+          enqueue (worker);
+        }
+    }
+  else
+    {
+      /* go to the back of the queue so that other
+       * instances get a turn */
+      if (mpmc_queue_push_back (
+            worker->pool->ready, worker))
+        {
+          zix_sem_post (&worker->pool->sem);
+        }
+      else
+        {
+          g_atomic_int_set (&worker->queued, 0);
+        }
+    }
+}
+
+static void *
+pool_thread_func (
+  void * data)
+{
+  Lv2WorkerPool * self = (Lv2WorkerPool *) data;
+  void * buf = NULL;
+  uint32_t buf_size = 0;
+  while (true)
+    {
+      zix_sem_wait (&self->sem);
+      if (g_atomic_int_get (&self->exit))
+        break;
 
-  free(buf);
+      LV2_Worker * worker = NULL;
+      if (!mpmc_queue_dequeue (
+             self->ready, (void **) &worker))
+        continue;
+
+      run_next_request (worker, &buf, &buf_size);
+    }
+
+  free (buf);
   return NULL;
 }
 
+/**
+ * Creates the shared worker pool and starts its
+ * threads.
+ */
+Lv2WorkerPool *
+lv2_worker_pool_new (void)
+{
+  Lv2WorkerPool * self =
+    object_new (Lv2WorkerPool);
+
+  self->ready = mpmc_queue_new ();
+  mpmc_queue_reserve (
+    self->ready, LV2_WORKER_POOL_MAX_QUEUED);
+  zix_sem_init (&self->sem, 0);
+
+  int num_threads =
+    CLAMP (
+      audio_get_num_cores () / 2, 1,
+      LV2_WORKER_POOL_MAX_THREADS);
+  for (int i = 0; i < num_threads; i++)
+    {
+      if (zix_thread_create (
+            &self->threads[i], 4096 * 8,
+            pool_thread_func, self))
+        {
+          g_warning (
+            "failed to create LV2 worker thread");
+          break;
+        }
+      self->num_threads++;
+    }
+
+  g_message (
+    "created LV2 worker pool with %d threads",
+    self->num_threads);
+
+  return self;
+}
+
+/**
+ * Stops the threads and frees the pool.
+ *
+ * Workers still queued are dropped.
+ */
+void
+lv2_worker_pool_free (
+  Lv2WorkerPool * self)
+{
+  g_atomic_int_set (&self->exit, 1);
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      zix_sem_post (&self->sem);
+    }
+  for (int i = 0; i < self->num_threads; i++)
+    {
+      zix_thread_join (self->threads[i], NULL);
+    }
+
+  LV2_Worker * worker = NULL;
+  while (mpmc_queue_dequeue (
+           self->ready, (void **) &worker))
+    {
+      g_atomic_int_set (&worker->queued, 0);
+    }
+
+  mpmc_queue_free (self->ready);
+  zix_sem_destroy (&self->sem);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Inits the worker.
+ *
+ * @param threaded Whether to run the requests in
+ *   @ref LV2_WORKER_POOL instead of the calling
+ *   thread.
+ */
 void
 lv2_worker_init (
   Lv2Plugin*                   plugin,
@@ -95,16 +283,24 @@ lv2_worker_init (
   const LV2_Worker_Interface * iface,
   bool                         threaded)
 {
+  g_return_if_fail (plugin && worker && iface);
   g_message (
     "initializing worker for LV2 plugin %s",
     plugin->plugin->descr->name);
-  g_return_if_fail (plugin && worker && iface);
   worker->iface = iface;
+  if (threaded &&
+      (!LV2_WORKER_POOL ||
+       LV2_WORKER_POOL->num_threads == 0))
+    {
+      g_warning (
+        "no LV2 worker pool, running work in the "
+        "calling thread");
+      threaded = false;
+    }
   worker->threaded = threaded;
   if (threaded)
     {
-      zix_thread_create (
-        &worker->thread, 4096, worker_func, worker);
+      worker->pool = LV2_WORKER_POOL;
       worker->requests = zix_ring_new (4096);
       zix_ring_mlock (worker->requests);
     }
@@ -113,18 +309,34 @@ lv2_worker_init (
   zix_ring_mlock (worker->responses);
 }
 
+/**
+ * Waits for the pool to finish with the worker
+ * and frees its resources.
+ *
+ * Lv2Plugin.exit must be set before calling this
+ * so that pending requests are dropped.
+ */
 void
 lv2_worker_finish(LV2_Worker* worker)
 {
-  if (worker->requests) {
-    if (worker->threaded) {
-      zix_sem_post(&worker->sem);
-      zix_thread_join(worker->thread, NULL);
-      zix_ring_free(worker->requests);
-    }
-    zix_ring_free(worker->responses);
-    free(worker->response);
-  }
+  if (worker->requests)
+    {
+      /* wait for the pool to drop the remaining
+       * requests */
+      while (g_atomic_int_get (&worker->queued))
+        {
+          g_usleep (100);
+        }
+      zix_ring_free (worker->requests);
+      worker->requests = NULL;
+    }
+  if (worker->responses)
+    {
+      zix_ring_free (worker->responses);
+      worker->responses = NULL;
+      free (worker->response);
+      worker->response = NULL;
+    }
 }
 
 LV2_Worker_Status
@@ -139,12 +351,12 @@ lv2_worker_schedule (
       AUDIO_ENGINE->exporting)
     {
       /* Execute work immediately in this thread */
-      zix_sem_wait (&plugin->work_lock);
       if (!worker->iface)
         {
           g_warning ("Worker interface is NULL");
           return LV2_WORKER_ERR_UNKNOWN;
         }
+      zix_sem_wait (&plugin->work_lock);
       worker->iface->work (
         plugin->instance->lv2_handle,
         lv2_worker_respond, worker, size, data);
@@ -153,17 +365,38 @@ lv2_worker_schedule (
   else
     {
       /* Schedule a request to be executed by the
-       * worker thread */
+       * worker pool */
+      if (zix_ring_write_space (worker->requests) <
+            sizeof (size) + size)
+        {
+          return LV2_WORKER_ERR_NO_SPACE;
+        }
       zix_ring_write (
         worker->requests, (const char*)&size,
         sizeof(size));
       zix_ring_write (
         worker->requests, (const char*)data, size);
-      zix_sem_post (&worker->sem);
+
+      /* only count the request after it is fully
+       * written so that the pool never reads a
+       * partial one */
+      g_atomic_int_inc (&worker->num_pending);
+      enqueue (worker);
     }
   return LV2_WORKER_SUCCESS;
 }
 
+/**
+ * Returns the number of requests scheduled by
+ * the plugin instance that have not run yet.
+ */
+int
+lv2_worker_get_queue_depth (
+  LV2_Worker * worker)
+{
+  return g_atomic_int_get (&worker->num_pending);
+}
+
 void
 lv2_worker_emit_responses (
   LV2_Worker* worker,
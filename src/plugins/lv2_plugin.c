@@ -1402,8 +1402,9 @@ lv2_plugin_free (
   zix_sem_wait(&lv2_plugin->exit_sem);
   lv2_plugin->exit = true;
 
-  /* Terminate the worker */
+  /* Terminate the workers */
   lv2_worker_finish(&lv2_plugin->worker);
+  lv2_worker_finish(&lv2_plugin->state_worker);
 
   /* Deactivate audio */
   for (int i = 0; i < lv2_plugin->num_ports; ++i)
@@ -1689,26 +1690,41 @@ lv2_plugin_get_abs_state_file_path (
 }
 
 /**
- * Instantiate the plugin.
- *
- * All of the actual initialization is done here.
- * If this is a new plugin, preset_uri should be
- * empty. If the project is being loaded, preset
- * uri should be the state file path.
- *
- * @param self Plugin to instantiate.
- * @param use_state_file Whether to use the plugin's
- *   state file to instantiate the plugin.
- * @param preset_uri URI of preset to load.
- * @param state State to load, if loading from
- *   a state. This is used when cloning plugins
- *   for example. The state of the original plugin
- *   is passed here.
- *
- * @return 0 if OK, non-zero if error.
+ * Shows the given message to the user, or saves
+ * it in Plugin.instantiation_msg to be shown later
+ * if not called from the GTK thread.
  */
-int
-lv2_plugin_instantiate (
+static void
+report_instantiation_msg (
+  Lv2Plugin *  self,
+  const char * msg)
+{
+  g_warning ("%s", msg);
+  if (!ZRYTHM_HAVE_UI)
+    return;
+
+  if (ZRYTHM_APP_IS_GTK_THREAD)
+    {
+      ui_show_error_message (MAIN_WINDOW, msg);
+      return;
+    }
+
+  Plugin * pl = self->plugin;
+  g_return_if_fail (pl);
+  char * prev_msg = pl->instantiation_msg;
+  pl->instantiation_msg =
+    prev_msg ?
+      g_strdup_printf ("%s\n\n%s", prev_msg, msg) :
+      g_strdup (msg);
+  g_free (prev_msg);
+}
+
+/**
+ * Does the actual instantiation, called with
+ * PM_LILV_LOCK held.
+ */
+static int
+instantiate (
   Lv2Plugin *  self,
   bool         project,
   bool         use_state_file,
@@ -1800,8 +1816,6 @@ lv2_plugin_instantiate (
   zix_sem_init (&self->exit_sem, 0);
   self->done = &self->exit_sem;
 
-  zix_sem_init(&self->worker.sem, 0);
-
   /* Load preset, if specified */
   if (!state)
     {
@@ -1870,21 +1884,13 @@ lv2_plugin_instantiate (
               lv2_uri);
           if (!self->lilv_plugin)
             {
-              if (ZRYTHM_HAVE_UI)
-                {
-                  char * msg =
-                    g_strdup_printf (
-                      _("Failed to find plugin "
-                      "with URI: %s"),
-                      lv2_uri_str);
-                  g_warning ("%s", msg);
-                  if (ZRYTHM_HAVE_UI)
-                    {
-                      ui_show_error_message (
-                        MAIN_WINDOW, msg);
-                    }
-                  g_free (msg);
-                }
+              char * msg =
+                g_strdup_printf (
+                  _("Failed to find plugin "
+                  "with URI: %s"),
+                  lv2_uri_str);
+              report_instantiation_msg (self, msg);
+              g_free (msg);
               lilv_node_free (lv2_uri);
               return -1;
             }
@@ -1931,8 +1937,7 @@ lv2_plugin_instantiate (
             descr->name, descr->uri,
             basename, descr->author,
             descr->website);
-          ui_show_error_message (
-            MAIN_WINDOW, msg);
+          report_instantiation_msg (self, msg);
           g_free (basename);
         }
 
@@ -2102,6 +2107,12 @@ lv2_plugin_instantiate (
   static int blocklength = 0;
   static int midi_buf_size = 0;
 
+  /* cycles are split at loop points and plugins
+   * with automated parameters are processed in
+   * sub-blocks, so any length may be passed to
+   * run() */
+  static const int min_blocklength = 1;
+
   samplerate =
     (float) AUDIO_ENGINE->sample_rate;
   blocklength =
@@ -2121,7 +2132,7 @@ lv2_plugin_instantiate (
         PM_URIDS.bufsz_minBlockLength,
         sizeof(int32_t),
         PM_URIDS.atom_Int,
-        &blocklength },
+        &min_blocklength },
       { LV2_OPTIONS_INSTANCE, 0,
         PM_URIDS.bufsz_maxBlockLength,
         sizeof(int32_t),
@@ -2156,7 +2167,10 @@ lv2_plugin_instantiate (
   zix_ring_mlock (self->ui_to_plugin_events);
   zix_ring_mlock (self->plugin_to_ui_events);
 
-  /* Instantiate the plugin */
+  /* Instantiate the plugin (this opens the plugin
+   * library and registers it in the lilv world,
+   * which is not thread-safe, so keep the lock
+   * held) */
   self->instance =
     lilv_plugin_instantiate (
       self->lilv_plugin,
@@ -2206,7 +2220,9 @@ lv2_plugin_instantiate (
   if (state)
     {
       g_message ("applying state");
+      g_rec_mutex_unlock (&PM_LILV_LOCK);
       lv2_state_apply_state (self, state);
+      g_rec_mutex_lock (&PM_LILV_LOCK);
     }
   else
     {
@@ -2247,6 +2263,46 @@ lv2_plugin_instantiate (
   return 0;
 }
 
+/**
+ * Instantiate the plugin.
+ *
+ * All of the actual initialization is done here.
+ * If this is a new plugin, preset_uri should be
+ * empty. If the project is being loaded, preset
+ * uri should be the state file path.
+ *
+ * @param self Plugin to instantiate.
+ * @param use_state_file Whether to use the plugin's
+ *   state file to instantiate the plugin.
+ * @param preset_uri URI of preset to load.
+ * @param state State to load, if loading from
+ *   a state. This is used when cloning plugins
+ *   for example. The state of the original plugin
+ *   is passed here.
+ *
+ * @return 0 if OK, non-zero if error.
+ */
+int
+lv2_plugin_instantiate (
+  Lv2Plugin *  self,
+  bool         project,
+  bool         use_state_file,
+  char *       preset_uri,
+  LilvState *  state)
+{
+  /* plugins may be instantiated in parallel when
+   * loading projects, so access to the lilv world
+   * is serialized */
+  g_rec_mutex_lock (&PM_LILV_LOCK);
+  int ret =
+    instantiate (
+      self, project, use_state_file, preset_uri,
+      state);
+  g_rec_mutex_unlock (&PM_LILV_LOCK);
+
+  return ret;
+}
+
 int
 lv2_plugin_activate (
   Lv2Plugin * self,
@@ -2426,10 +2482,11 @@ lv2_plugin_process (
       if (id->type == TYPE_AUDIO)
         {
           /* connect lv2 ports to plugin port
-           * buffers */
+           * buffers from the start of this
+           * split */
           lilv_instance_connect_port (
             self->instance,
-            (uint32_t) p, port->buf);
+            (uint32_t) p, &port->buf[local_offset]);
         }
       else if (id->type == TYPE_CV)
         {
@@ -2439,7 +2496,7 @@ lv2_plugin_process (
            * audio port. */
           lilv_instance_connect_port (
             self->instance,
-            (uint32_t) p, port->buf);
+            (uint32_t) p, &port->buf[local_offset]);
         }
       else if (id->type == TYPE_EVENT &&
                id->flow == FLOW_INPUT)
@@ -2499,7 +2556,7 @@ lv2_plugin_process (
                     i);
                   midi_event_print (ev);
                   lv2_evbuf_write (
-                    &iter, ev->time, 0,
+                    &iter, ev->time - local_offset, 0,
                     PM_URIDS.midi_MidiEvent,
                     3, ev->raw_buffer);
                 }
@@ -2644,7 +2701,8 @@ lv2_plugin_process (
                           midi_events_add_event_from_buf (
                             lv2_port->port->
                               midi_events,
-                            frames, body,
+                            frames + local_offset,
+                            body,
                             (int) size, 0);
                         }
                     }
@@ -52,6 +52,7 @@
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/audio.h"
 #include "utils/dialogs.h"
 #include "utils/dsp.h"
 #include "utils/err_codes.h"
@@ -66,6 +67,12 @@
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 
+/**
+ * Inits the plugin after loading.
+ *
+ * Project plugins are not instantiated here, see
+ * plugin_instantiate_loaded_plugins().
+ */
 void
 plugin_init_loaded (
   Plugin * self,
@@ -122,33 +129,6 @@ plugin_init_loaded (
     }
 #endif
 
-  if (project)
-    {
-      int ret =
-        plugin_instantiate (self, project, NULL);
-      if (ret == 0)
-        {
-          plugin_activate (self, true);
-        }
-      else
-        {
-          /* disable plugin, instantiation failed */
-          char * msg =
-            g_strdup_printf (
-              _("Instantiation failed for "
-              "plugin '%s'. Disabling..."),
-              self->descr->name);
-          g_warning ("%s", msg);
-          if (ZRYTHM_HAVE_UI)
-            {
-              ui_show_error_message (
-                MAIN_WINDOW, msg);
-            }
-          g_free (msg);
-          self->instantiation_failed = true;
-        }
-    }
-
   /*Track * track = plugin_get_track (self);*/
   /*plugin_generate_automation_tracks (self, track);*/
 }
@@ -1314,14 +1294,11 @@ plugin_set_track_pos (
 }
 
 /**
- * Instantiates the plugin (e.g. when adding to a
- * channel)
- *
- * @param project Whether this is a project plugin
- *   (as opposed to a clone used in actions).
+ * Instantiates the plugin without touching the
+ * UI, so it can be called from other threads.
  */
-int
-plugin_instantiate (
+static int
+instantiate (
   Plugin *    pl,
   bool        project,
   LilvState * state)
@@ -1329,8 +1306,6 @@ plugin_instantiate (
   g_message ("Instantiating %s...",
              pl->descr->name);
 
-  plugin_set_ui_refresh_rate (pl);
-
   if (!PROJECT->loaded)
     {
       g_return_val_if_fail (pl->state_dir, -1);
@@ -1390,6 +1365,251 @@ plugin_instantiate (
   return 0;
 }
 
+/**
+ * Instantiates the plugin (e.g. when adding to a
+ * channel)
+ *
+ * @param project Whether this is a project plugin
+ *   (as opposed to a clone used in actions).
+ */
+int
+plugin_instantiate (
+  Plugin *    pl,
+  bool        project,
+  LilvState * state)
+{
+  plugin_set_ui_refresh_rate (pl);
+
+  return instantiate (pl, project, state);
+}
+
+/**
+ * Plugins sharing a binary, to be instantiated
+ * one after the other in a worker thread.
+ */
+typedef struct InstantiateGroup
+{
+  GPtrArray *   plugins;
+
+  /** Queue to push each plugin to after it is
+   * instantiated. */
+  GAsyncQueue * done_queue;
+} InstantiateGroup;
+
+static void
+instantiate_group (
+  InstantiateGroup * group,
+  gpointer           user_data)
+{
+  for (guint i = 0; i < group->plugins->len; i++)
+    {
+      Plugin * pl =
+        (Plugin *)
+        g_ptr_array_index (group->plugins, i);
+      pl->instantiation_failed =
+        instantiate (pl, true, NULL) != 0;
+      g_async_queue_push (group->done_queue, pl);
+    }
+}
+
+/**
+ * Instantiates and activates the given plugins of
+ * a project being loaded.
+ *
+ * Plugins whose descriptors allow it are
+ * instantiated (and their state restored) in
+ * parallel, with plugins sharing a binary
+ * instantiated one after the other. The rest are
+ * instantiated in the calling thread.
+ *
+ * Opening the plugin libraries touches the lilv
+ * world, so lilv_plugin_instantiate() itself is
+ * serialized by \ref PM_LILV_LOCK.
+ *
+ * Returns after all plugins are instantiated.
+ * Plugins that fail are disabled.
+ */
+void
+plugin_instantiate_loaded_plugins (
+  Plugin ** plugins,
+  int       num_plugins)
+{
+  if (num_plugins == 0)
+    return;
+
+  g_message (
+    "instantiating %d plugins...", num_plugins);
+
+  /* LV2 forbids calling into the same binary
+   * concurrently, so group the plugins by bundle
+   * (or URI if unknown) */
+  GHashTable * groups =
+    g_hash_table_new (g_str_hash, g_str_equal);
+  GPtrArray * group_arr = g_ptr_array_new ();
+  GPtrArray * serial = g_ptr_array_new ();
+  GAsyncQueue * done_queue = g_async_queue_new ();
+  for (int i = 0; i < num_plugins; i++)
+    {
+      Plugin * pl = plugins[i];
+
+      /* uses GDK so must be done here */
+      plugin_set_ui_refresh_rate (pl);
+
+      if (!plugin_descriptor_is_instantiation_thread_safe (
+             pl->descr))
+        {
+          g_ptr_array_add (serial, pl);
+          continue;
+        }
+
+      const char * key =
+        pl->descr->path ?
+          pl->descr->path : pl->descr->uri;
+      InstantiateGroup * group =
+        g_hash_table_lookup (groups, key);
+      if (!group)
+        {
+          group = object_new (InstantiateGroup);
+          group->plugins = g_ptr_array_new ();
+          group->done_queue = done_queue;
+          g_hash_table_insert (
+            groups, (char *) key, group);
+          g_ptr_array_add (group_arr, group);
+        }
+      g_ptr_array_add (group->plugins, pl);
+    }
+
+  GThreadPool * thread_pool = NULL;
+  if (group_arr->len > 0)
+    {
+      GError * err = NULL;
+      thread_pool =
+        g_thread_pool_new (
+          (GFunc) instantiate_group, NULL,
+          CLAMP (
+            audio_get_num_cores (), 1,
+            PLUGIN_MAX_INSTANTIATION_THREADS),
+          F_NOT_EXCLUSIVE, &err);
+      if (!thread_pool)
+        {
+          g_warning (
+            "failed to create thread pool, "
+            "instantiating plugins serially: %s",
+            err->message);
+          g_error_free (err);
+        }
+    }
+
+  int num_parallel = 0;
+  for (guint i = 0; i < group_arr->len; i++)
+    {
+      InstantiateGroup * group =
+        (InstantiateGroup *)
+        g_ptr_array_index (group_arr, i);
+      if (thread_pool)
+        {
+          num_parallel += (int) group->plugins->len;
+          g_thread_pool_push (
+            thread_pool, group, NULL);
+        }
+      else
+        {
+          for (guint j = 0;
+               j < group->plugins->len; j++)
+            {
+              g_ptr_array_add (
+                serial,
+                g_ptr_array_index (
+                  group->plugins, j));
+            }
+        }
+    }
+
+  /* instantiate the rest in this thread while
+   * the others are being instantiated */
+  for (guint i = 0; i < serial->len; i++)
+    {
+      Plugin * pl =
+        (Plugin *) g_ptr_array_index (serial, i);
+      pl->instantiation_failed =
+        instantiate (pl, true, NULL) != 0;
+    }
+
+  /* report progress as plugins are
+   * instantiated */
+  for (int i = 0; i < num_parallel; i++)
+    {
+      Plugin * pl =
+        (Plugin *)
+        g_async_queue_pop (done_queue);
+      char msg[200];
+      sprintf (
+        msg, _("Loading plugins (%d/%d)"),
+        (int) serial->len + i + 1, num_plugins);
+      if (zrythm_app && ZRYTHM)
+        {
+          zrythm_app_set_progress_status (
+            zrythm_app, msg, ZRYTHM->progress);
+        }
+      g_debug ("instantiated %s", pl->descr->name);
+    }
+
+  if (thread_pool)
+    {
+      g_thread_pool_free (thread_pool, false, true);
+    }
+
+  /* activate in order once all are ready */
+  for (int i = 0; i < num_plugins; i++)
+    {
+      Plugin * pl = plugins[i];
+
+      /* show messages from the worker threads */
+      if (pl->instantiation_msg)
+        {
+          if (ZRYTHM_HAVE_UI)
+            {
+              ui_show_error_message (
+                MAIN_WINDOW, pl->instantiation_msg);
+            }
+          g_free_and_null (pl->instantiation_msg);
+        }
+
+      if (!pl->instantiation_failed)
+        {
+          plugin_activate (pl, true);
+          continue;
+        }
+
+      /* disable plugin, instantiation failed */
+      char * msg =
+        g_strdup_printf (
+          _("Instantiation failed for "
+          "plugin '%s'. Disabling..."),
+          pl->descr->name);
+      g_warning ("%s", msg);
+      if (ZRYTHM_HAVE_UI)
+        {
+          ui_show_error_message (
+            MAIN_WINDOW, msg);
+        }
+      g_free (msg);
+    }
+
+  for (guint i = 0; i < group_arr->len; i++)
+    {
+      InstantiateGroup * group =
+        (InstantiateGroup *)
+        g_ptr_array_index (group_arr, i);
+      g_ptr_array_unref (group->plugins);
+      object_zero_and_free (group);
+    }
+  g_ptr_array_unref (group_arr);
+  g_ptr_array_unref (serial);
+  g_hash_table_destroy (groups);
+  g_async_queue_unref (done_queue);
+}
+
 /**
  * Prepare plugin for processing.
  */
@@ -1407,6 +1627,73 @@ plugin_prepare_process (
     }
 }
 
+/**
+ * Sets the automated parameters to their values
+ * at the given timeline frames.
+ *
+ * The UI is not notified since it is updated
+ * with the value at the start of each split.
+ */
+static void
+update_automated_params (
+  Plugin * self,
+  long     g_frames)
+{
+  for (int i = 0; i < self->num_in_ports; i++)
+    {
+      Port * port = self->in_ports[i];
+      if (port->id.type != TYPE_CONTROL ||
+          !port->automation_read)
+        continue;
+
+      port->control =
+        control_port_get_automation_val_at_frames (
+          port, g_frames);
+#ifdef HAVE_CARLA
+      if (self->descr->open_with_carla &&
+          port->carla_param_id >= 0)
+        {
+          carla_native_plugin_set_param_value (
+            self->carla,
+            (uint32_t) port->carla_param_id,
+            port->control);
+        }
+#endif
+    }
+}
+
+static void
+process_sub_block (
+  Plugin *        self,
+  const long      g_start_frames,
+  const nframes_t local_offset,
+  const nframes_t nframes)
+{
+#ifdef HAVE_CARLA
+  if (self->descr->open_with_carla)
+    {
+      carla_native_plugin_proces (
+        self->carla, g_start_frames,
+        local_offset, nframes);
+    }
+  else
+    {
+#endif
+      switch (self->descr->protocol)
+        {
+        case PROT_LV2:
+          lv2_plugin_process (
+            self->lv2, g_start_frames,
+            local_offset, nframes);
+          break;
+        default:
+          break;
+        }
+#ifdef HAVE_CARLA
+    }
+#endif
+}
+
 /**
  * Process plugin.
  *
@@ -1439,29 +1726,42 @@ plugin_process (
         /* add midi events to input port */
     }
 
-#ifdef HAVE_CARLA
-  if (plugin->descr->open_with_carla)
+  /* if any parameter is automated, process in
+   * sub-blocks and update the automated
+   * parameters before each one */
+  bool has_automation = false;
+  for (int i = 0; i < plugin->num_in_ports; i++)
     {
-      carla_native_plugin_proces (
-        plugin->carla, g_start_frames,
-        local_offset, nframes);
+      Port * port = plugin->in_ports[i];
+      if (port->id.type == TYPE_CONTROL &&
+          port->automation_read)
+        {
+          has_automation = true;
+          break;
+        }
     }
-  else
+  nframes_t granularity =
+    has_automation ?
+      MAX (AUDIO_ENGINE->automation_granularity, 1) :
+      nframes;
+  for (nframes_t offset = 0; offset < nframes;)
     {
-#endif
-      switch (plugin->descr->protocol)
+      nframes_t len =
+        MIN (granularity, nframes - offset);
+
+      /* the values at the start of the split were
+       * already set when processing the ports */
+      if (offset > 0)
         {
-        case PROT_LV2:
-          lv2_plugin_process (
-            plugin->lv2, g_start_frames,
-            local_offset, nframes);
-          break;
-        default:
-          break;
+          update_automated_params (
+            plugin, g_start_frames + offset);
         }
-#ifdef HAVE_CARLA
+
+      process_sub_block (
+        plugin, g_start_frames + offset,
+        local_offset + offset, len);
+      offset += len;
     }
-#endif
 
   /* turn off any trigger input controls */
   for (int i = 0; i < plugin->num_in_ports; i++)
@@ -2789,6 +3089,8 @@ plugin_free (
   ports_remove (
     self->out_ports, &self->num_out_ports);
 
+  g_free_and_null (self->instantiation_msg);
+
   object_zero_and_free (self);
 }
 
@@ -427,6 +427,27 @@ plugin_descriptor_has_custom_ui (
   g_return_val_if_reached (false);
 }
 
+/**
+ * Returns whether instances of the plugin can be
+ * instantiated in a thread other than the GTK
+ * thread, concurrently with instances of other
+ * plugins.
+ */
+bool
+plugin_descriptor_is_instantiation_thread_safe (
+  const PluginDescriptor * self)
+{
+  /* Carla keeps global state (eg, its own lilv
+   * world) and VST/AU plugins often expect to be
+   * created in the main thread. LV2 only forbids
+   * concurrent calls into the same binary, which
+   * is handled by the caller */
+  if (self->open_with_carla)
+    return false;
+
+  return self->protocol == PROT_LV2;
+}
+
 void
 plugin_descriptor_free (
   PluginDescriptor * self)
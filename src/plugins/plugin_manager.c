@@ -45,8 +45,10 @@
 #include "plugins/cached_plugin_descriptors.h"
 #include "plugins/carla/carla_discovery.h"
 #include "plugins/collections.h"
+#include "plugins/lv2/lv2_worker.h"
 #include "plugins/plugin.h"
 #include "plugins/plugin_manager.h"
+#include "plugins/plugin_search_index.h"
 #include "plugins/lv2_plugin.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
@@ -539,6 +541,7 @@ plugin_manager_new (void)
 
   self->symap = symap_new();
   zix_sem_init(&self->symap_lock, 1);
+  g_rec_mutex_init (&self->lilv_lock);
 
   /* init lv2 */
   create_and_load_lilv_word (self);
@@ -553,6 +556,10 @@ plugin_manager_new (void)
   /* fetch/create collections */
   self->collections = plugin_collections_new ();
 
+  self->search_index = plugin_search_index_new ();
+
+  self->lv2_worker_pool = lv2_worker_pool_new ();
+
   return self;
 }
 
@@ -1475,6 +1482,12 @@ plugin_manager_scan_plugins (
          sizeof (char *),
          sort_category_func);
 
+  plugin_search_index_sync (
+    self->search_index,
+    (PluginDescriptor * const *)
+      self->plugin_descriptors,
+    self->num_plugins);
+
   g_message (
     "%s: %d Plugins scanned.",
     __func__, self->num_plugins);
@@ -1541,6 +1554,12 @@ void
 plugin_manager_clear_plugins (
   PluginManager * self)
 {
+  if (self->search_index)
+    {
+      plugin_search_index_sync (
+        self->search_index, NULL, 0);
+    }
+
   for (int i = 0; i < self->num_plugins; i++)
     {
       object_free_w_func_and_null (
@@ -1563,8 +1582,12 @@ plugin_manager_free (
 {
   g_message ("%s: Freeing...", __func__);
 
+  object_free_w_func_and_null (
+    lv2_worker_pool_free, self->lv2_worker_pool);
+
   symap_free (self->symap);
   zix_sem_destroy (&self->symap_lock);
+  g_rec_mutex_clear (&self->lilv_lock);
   lilv_world_free (self->lv2_nodes.lilv_world);
 
   plugin_manager_clear_plugins (self);
@@ -1572,6 +1595,9 @@ plugin_manager_free (
   object_free_w_func_and_null (
     cached_plugin_descriptors_free,
     self->cached_plugin_descriptors);
+  object_free_w_func_and_null (
+    plugin_search_index_free,
+    self->search_index);
 
   object_zero_and_free (self);
 
@@ -0,0 +1,964 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "plugins/collection.h"
+#include "plugins/plugin_search_index.h"
+#include "utils/objects.h"
+
+/** Field a token was found in. */
+typedef enum TokenField
+{
+  TOKEN_FIELD_NAME,
+  TOKEN_FIELD_AUTHOR,
+  TOKEN_FIELD_CATEGORY,
+} TokenField;
+
+/* match scores, multiplied by the field weight */
+#define SCORE_EXACT 4.0
+#define SCORE_PREFIX 3.0
+#define SCORE_TYPO 2.0
+#define SCORE_SUBSTR 1.0
+#define SCORE_SUBSEQ 0.25
+
+/** Bonus when the name starts with the whole
+ * search text. */
+#define SCORE_NAME_PREFIX_BONUS 2.0
+
+/** Min word length to tolerate typos. */
+#define MIN_TYPO_LEN 4
+
+/** Min word length to match non-contiguous
+ * characters. */
+#define MIN_SUBSEQ_LEN 4
+
+static inline bool
+bitmap_get (
+  const guint64 * bitmap,
+  size_t          idx)
+{
+  return (bitmap[idx / 64] >> (idx % 64)) & 1;
+}
+
+static inline void
+bitmap_set (
+  guint64 * bitmap,
+  size_t    idx,
+  bool      val)
+{
+  if (val)
+    bitmap[idx / 64] |= (guint64) 1 << (idx % 64);
+  else
+    bitmap[idx / 64] &= ~((guint64) 1 << (idx % 64));
+}
+
+static void
+resize_bitmap (
+  guint64 ** bitmap,
+  size_t     old_words,
+  size_t     new_words)
+{
+  *bitmap = g_renew (guint64, *bitmap, new_words);
+  memset (
+    &(*bitmap)[old_words], 0,
+    (new_words - old_words) * sizeof (guint64));
+}
+
+/**
+ * Makes room for \p num_entries entries in the
+ * bitmaps.
+ */
+static void
+ensure_capacity (
+  PluginSearchIndex * self,
+  size_t              num_entries)
+{
+  size_t words = (num_entries + 63) / 64;
+  if (words <= self->num_words)
+    return;
+
+  words = MAX (words, self->num_words * 2);
+  resize_bitmap (
+    &self->live, self->num_words, words);
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_PROTOCOLS;
+       i++)
+    {
+      resize_bitmap (
+        &self->protocols[i], self->num_words, words);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_CATEGORIES;
+       i++)
+    {
+      resize_bitmap (
+        &self->categories[i], self->num_words,
+        words);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_TYPES; i++)
+    {
+      resize_bitmap (
+        &self->types[i], self->num_words, words);
+    }
+  self->num_words = words;
+}
+
+static char *
+get_id_key (
+  const PluginDescriptor * descr)
+{
+  return
+    g_strdup_printf (
+      "%d|%d|%s|%s|%" G_GINT64_FORMAT "|%u",
+      descr->arch, descr->protocol,
+      descr->path ? descr->path : "",
+      descr->uri ? descr->uri : "",
+      (gint64) descr->unique_id, descr->ghash);
+}
+
+static void
+add_posting (
+  PluginSearchIndex * self,
+  const char *        token,
+  guint               idx,
+  TokenField          field)
+{
+  GArray * postings =
+    g_hash_table_lookup (self->tokens, token);
+  if (!postings)
+    {
+      postings =
+        g_array_new (false, false, sizeof (guint));
+      g_hash_table_insert (
+        self->tokens, g_strdup (token), postings);
+      self->sorted_tokens_dirty = true;
+    }
+
+  /* keep one posting per entry (the first field,
+   * which has the highest weight) */
+  if (postings->len > 0 &&
+      g_array_index (
+        postings, guint, postings->len - 1) >> 2 ==
+          idx)
+    {
+      return;
+    }
+
+  guint posting = (idx << 2) | (guint) field;
+  g_array_append_val (postings, posting);
+}
+
+/**
+ * Splits the given string into lowercase
+ * alphanumeric words and calls \p func on each.
+ *
+ * @param camel_case Whether to also call \p func
+ *   on the camel case and letter/digit parts of
+ *   each word.
+ */
+static void
+foreach_word (
+  const char * str,
+  bool         camel_case,
+  void (*func) (const char * word, void * data),
+  void *       data)
+{
+  if (!str)
+    return;
+
+  GString * word = g_string_new (NULL);
+  GString * part = g_string_new (NULL);
+  int num_parts = 0;
+  gunichar prev = 0;
+  for (const char * p = str;; p = g_utf8_next_char (p))
+    {
+      gunichar c = g_utf8_get_char (p);
+      bool alnum = c != 0 && g_unichar_isalnum (c);
+      bool boundary =
+        camel_case && alnum && prev != 0 &&
+        ((g_unichar_isupper (c) &&
+          g_unichar_islower (prev)) ||
+         (g_unichar_isdigit (c) !=
+            g_unichar_isdigit (prev)));
+      if ((!alnum || boundary) && part->len > 0)
+        {
+          /* only add parts if the word has more
+           * than one */
+          if (boundary || num_parts > 0)
+            {
+              func (part->str, data);
+            }
+          num_parts++;
+          g_string_truncate (part, 0);
+        }
+      if (!alnum && word->len > 0)
+        {
+          func (word->str, data);
+          g_string_truncate (word, 0);
+          num_parts = 0;
+        }
+      if (c == 0)
+        break;
+
+      if (alnum)
+        {
+          gunichar lower = g_unichar_tolower (c);
+          g_string_append_unichar (word, lower);
+          g_string_append_unichar (part, lower);
+        }
+      prev = alnum ? c : 0;
+    }
+
+  g_string_free (word, true);
+  g_string_free (part, true);
+}
+
+typedef struct AddTokensData
+{
+  PluginSearchIndex * index;
+  guint               idx;
+  TokenField          field;
+} AddTokensData;
+
+static void
+add_token_cb (
+  const char * token,
+  void *       data)
+{
+  AddTokensData * d = (AddTokensData *) data;
+  add_posting (d->index, token, d->idx, d->field);
+}
+
+static void
+add_tokens (
+  PluginSearchIndex * self,
+  const char *        str,
+  guint               idx,
+  TokenField          field)
+{
+  AddTokensData data = {
+    .index = self, .idx = idx, .field = field };
+  foreach_word (str, true, add_token_cb, &data);
+}
+
+static void
+entry_free_members (
+  PluginSearchEntry * entry)
+{
+  g_free_and_null (entry->name_key);
+  g_free_and_null (entry->text_key);
+  g_free_and_null (entry->id_key);
+}
+
+/**
+ * Clears all the entries.
+ */
+static void
+clear (
+  PluginSearchIndex * self)
+{
+  for (guint i = 0; i < self->entries->len; i++)
+    {
+      entry_free_members (
+        &g_array_index (
+          self->entries, PluginSearchEntry, i));
+    }
+  g_array_set_size (self->entries, 0);
+  self->num_live = 0;
+  g_hash_table_remove_all (self->descr_to_idx);
+  g_hash_table_remove_all (self->id_to_idx);
+  g_hash_table_remove_all (self->tokens);
+  g_ptr_array_set_size (self->sorted_tokens, 0);
+  self->sorted_tokens_dirty = false;
+
+  size_t size = self->num_words * sizeof (guint64);
+  if (size == 0)
+    return;
+  memset (self->live, 0, size);
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_PROTOCOLS;
+       i++)
+    {
+      memset (self->protocols[i], 0, size);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_CATEGORIES;
+       i++)
+    {
+      memset (self->categories[i], 0, size);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_TYPES; i++)
+    {
+      memset (self->types[i], 0, size);
+    }
+}
+
+PluginSearchIndex *
+plugin_search_index_new (void)
+{
+  PluginSearchIndex * self =
+    object_new (PluginSearchIndex);
+
+  self->entries =
+    g_array_new (
+      false, true, sizeof (PluginSearchEntry));
+  self->descr_to_idx =
+    g_hash_table_new (NULL, NULL);
+  self->id_to_idx =
+    g_hash_table_new (g_str_hash, g_str_equal);
+  self->tokens =
+    g_hash_table_new_full (
+      g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) g_array_unref);
+  self->sorted_tokens = g_ptr_array_new ();
+
+  return self;
+}
+
+/**
+ * Adds the given descriptor to the index.
+ *
+ * Does nothing if already added.
+ */
+void
+plugin_search_index_add (
+  PluginSearchIndex * self,
+  PluginDescriptor *  descr)
+{
+  g_return_if_fail (self && descr);
+
+  if (g_hash_table_contains (
+        self->descr_to_idx, descr))
+    return;
+
+  guint idx = self->entries->len;
+  ensure_capacity (self, idx + 1);
+
+  PluginSearchEntry entry;
+  memset (&entry, 0, sizeof (entry));
+  entry.descr = descr;
+  entry.name_key =
+    g_utf8_strdown (descr->name ? descr->name : "", -1);
+  char * text =
+    g_strdup_printf (
+      "%s %s %s",
+      descr->name ? descr->name : "",
+      descr->author ? descr->author : "",
+      descr->category_str ?
+        descr->category_str : "");
+  entry.text_key = g_utf8_strdown (text, -1);
+  g_free (text);
+  entry.id_key = get_id_key (descr);
+  g_array_append_val (self->entries, entry);
+  self->num_live++;
+
+  g_hash_table_insert (
+    self->descr_to_idx, descr,
+    GUINT_TO_POINTER (idx + 1));
+  g_hash_table_insert (
+    self->id_to_idx, entry.id_key,
+    GUINT_TO_POINTER (idx + 1));
+
+  add_tokens (
+    self, descr->name, idx, TOKEN_FIELD_NAME);
+  add_tokens (
+    self, descr->author, idx, TOKEN_FIELD_AUTHOR);
+  add_tokens (
+    self, descr->category_str, idx,
+    TOKEN_FIELD_CATEGORY);
+
+  bitmap_set (self->live, idx, true);
+  if (descr->protocol >= 0 &&
+      descr->protocol < PLUGIN_SEARCH_NUM_PROTOCOLS)
+    {
+      bitmap_set (
+        self->protocols[descr->protocol], idx, true);
+    }
+  if (descr->category >= 0 &&
+      descr->category < PLUGIN_SEARCH_NUM_CATEGORIES)
+    {
+      bitmap_set (
+        self->categories[descr->category], idx, true);
+    }
+  bitmap_set (
+    self->types[PLUGIN_SEARCH_TYPE_INSTRUMENT], idx,
+    plugin_descriptor_is_instrument (descr));
+  bitmap_set (
+    self->types[PLUGIN_SEARCH_TYPE_EFFECT], idx,
+    plugin_descriptor_is_effect (descr));
+  bitmap_set (
+    self->types[PLUGIN_SEARCH_TYPE_MODULATOR], idx,
+    plugin_descriptor_is_modulator (descr));
+  bitmap_set (
+    self->types[PLUGIN_SEARCH_TYPE_MIDI_MODIFIER],
+    idx, plugin_descriptor_is_midi_modifier (descr));
+}
+
+/**
+ * Removes the given descriptor from the index.
+ */
+void
+plugin_search_index_remove (
+  PluginSearchIndex * self,
+  PluginDescriptor *  descr)
+{
+  g_return_if_fail (self && descr);
+
+  guint idx =
+    GPOINTER_TO_UINT (
+      g_hash_table_lookup (
+        self->descr_to_idx, descr));
+  if (idx == 0)
+    return;
+  idx--;
+
+  PluginSearchEntry * entry =
+    &g_array_index (
+      self->entries, PluginSearchEntry, idx);
+  g_hash_table_remove (self->descr_to_idx, descr);
+  if (GPOINTER_TO_UINT (
+        g_hash_table_lookup (
+          self->id_to_idx, entry->id_key)) ==
+        idx + 1)
+    {
+      g_hash_table_remove (
+        self->id_to_idx, entry->id_key);
+    }
+
+  /* postings of removed entries are skipped
+   * using the live bitmap */
+  bitmap_set (self->live, idx, false);
+  entry_free_members (entry);
+  entry->descr = NULL;
+  entry->removed = true;
+  self->num_live--;
+}
+
+/**
+ * Updates the index to contain exactly the given
+ * descriptors, adding and removing only the ones
+ * that changed.
+ */
+void
+plugin_search_index_sync (
+  PluginSearchIndex *        self,
+  PluginDescriptor * const * descrs,
+  int                        num_descrs)
+{
+  g_return_if_fail (self);
+
+  GHashTable * present =
+    g_hash_table_new (NULL, NULL);
+  for (int i = 0; i < num_descrs; i++)
+    {
+      g_hash_table_add (present, descrs[i]);
+    }
+
+  for (guint i = 0; i < self->entries->len; i++)
+    {
+      PluginSearchEntry * entry =
+        &g_array_index (
+          self->entries, PluginSearchEntry, i);
+      if (!entry->removed &&
+          !g_hash_table_contains (
+            present, entry->descr))
+        {
+          plugin_search_index_remove (
+            self, entry->descr);
+        }
+    }
+  g_hash_table_unref (present);
+
+  /* rebuild if mostly removed entries */
+  int num_removed =
+    (int) self->entries->len - self->num_live;
+  if (num_removed > MAX (64, self->num_live))
+    {
+      clear (self);
+    }
+
+  for (int i = 0; i < num_descrs; i++)
+    {
+      plugin_search_index_add (self, descrs[i]);
+    }
+}
+
+static int
+cmp_str_ptr (
+  const void * a,
+  const void * b)
+{
+  return
+    strcmp (
+      *(const char * const *) a,
+      *(const char * const *) b);
+}
+
+static void
+update_sorted_tokens (
+  PluginSearchIndex * self)
+{
+  if (!self->sorted_tokens_dirty)
+    return;
+
+  g_ptr_array_set_size (self->sorted_tokens, 0);
+  GHashTableIter iter;
+  gpointer key;
+  g_hash_table_iter_init (&iter, self->tokens);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      g_ptr_array_add (self->sorted_tokens, key);
+    }
+  qsort (
+    self->sorted_tokens->pdata,
+    self->sorted_tokens->len, sizeof (char *),
+    cmp_str_ptr);
+  self->sorted_tokens_dirty = false;
+}
+
+/**
+ * Returns the index of the first token not less
+ * than \p word.
+ */
+static guint
+lower_bound (
+  GPtrArray *  tokens,
+  const char * word)
+{
+  guint lo = 0, hi = tokens->len;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (strcmp (
+            g_ptr_array_index (tokens, mid),
+            word) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/**
+ * Returns whether \p a can be turned into \p b
+ * with at most one insertion, deletion,
+ * substitution or transposition.
+ */
+static bool
+is_one_edit_away (
+  const char * a,
+  size_t       len_a,
+  const char * b,
+  size_t       len_b)
+{
+  if (len_a > len_b + 1 || len_b > len_a + 1)
+    return false;
+
+  size_t i = 0;
+  while (i < len_a && i < len_b && a[i] == b[i])
+    i++;
+  if (i == len_a && i == len_b)
+    return true;
+
+  if (len_a == len_b)
+    {
+      /* substitution */
+      if (strcmp (&a[i + 1], &b[i + 1]) == 0)
+        return true;
+
+      /* transposition */
+      return
+        i + 1 < len_a && a[i] == b[i + 1] &&
+        a[i + 1] == b[i] &&
+        strcmp (&a[i + 2], &b[i + 2]) == 0;
+    }
+  else if (len_a > len_b)
+    {
+      return strcmp (&a[i + 1], &b[i]) == 0;
+    }
+  else
+    {
+      return strcmp (&a[i], &b[i + 1]) == 0;
+    }
+}
+
+/**
+ * Returns whether all the characters of \p word
+ * appear in \p str in order, starting at the
+ * beginning of a word in \p str (eg, "dfrev"
+ * matches "dragonfly reverb").
+ */
+static bool
+is_subsequence (
+  const char * word,
+  const char * str)
+{
+  for (const char * start = str; *start; start++)
+    {
+      if (*start != word[0] ||
+          (start > str &&
+           g_ascii_isalnum (start[-1])))
+        continue;
+
+      const char * w = &word[1];
+      for (const char * c = &start[1]; *c && *w; c++)
+        {
+          if (*c == *w)
+            w++;
+        }
+      if (*w == '\0')
+        return true;
+    }
+  return false;
+}
+
+static void
+apply_postings (
+  PluginSearchIndex * self,
+  GArray *            postings,
+  const guint64 *     mask,
+  double              score,
+  double *            word_scores)
+{
+  for (guint i = 0; i < postings->len; i++)
+    {
+      guint posting =
+        g_array_index (postings, guint, i);
+      guint idx = posting >> 2;
+      if (!bitmap_get (mask, idx))
+        continue;
+
+      double s =
+        (posting & 3) == TOKEN_FIELD_NAME ?
+          score : score / 2.0;
+      word_scores[idx] = MAX (word_scores[idx], s);
+    }
+}
+
+static void
+add_word_cb (
+  const char * word,
+  void *       data)
+{
+  g_ptr_array_add (
+    (GPtrArray *) data, g_strdup (word));
+}
+
+/**
+ * Scores the entries in \p mask against the given
+ * word and clears the ones that don't match.
+ */
+static void
+match_word (
+  PluginSearchIndex * self,
+  const char *        word,
+  guint64 *           mask,
+  double *            scores,
+  double *            word_scores)
+{
+  guint num_entries = self->entries->len;
+  size_t len = strlen (word);
+  memset (
+    word_scores, 0, num_entries * sizeof (double));
+
+  /* exact and prefix token matches */
+  GPtrArray * tokens = self->sorted_tokens;
+  for (guint i = lower_bound (tokens, word);
+       i < tokens->len; i++)
+    {
+      const char * token =
+        g_ptr_array_index (tokens, i);
+      if (strncmp (token, word, len) != 0)
+        break;
+
+      apply_postings (
+        self,
+        g_hash_table_lookup (self->tokens, token),
+        mask,
+        token[len] == '\0' ?
+          SCORE_EXACT : SCORE_PREFIX,
+        word_scores);
+    }
+
+  /* tokens with a typo */
+  if (len >= MIN_TYPO_LEN)
+    {
+      for (guint i = 0; i < tokens->len; i++)
+        {
+          const char * token =
+            g_ptr_array_index (tokens, i);
+          size_t token_len = strlen (token);
+          if (is_one_edit_away (
+                word, len, token, token_len))
+            {
+              apply_postings (
+                self,
+                g_hash_table_lookup (
+                  self->tokens, token),
+                mask, SCORE_TYPO, word_scores);
+            }
+        }
+    }
+
+  for (guint i = 0; i < num_entries; i++)
+    {
+      if (!bitmap_get (mask, i))
+        continue;
+
+      if (word_scores[i] == 0.0)
+        {
+          PluginSearchEntry * entry =
+            &g_array_index (
+              self->entries, PluginSearchEntry, i);
+          if (strstr (entry->text_key, word))
+            {
+              word_scores[i] = SCORE_SUBSTR;
+            }
+          else if (len >= MIN_SUBSEQ_LEN &&
+                   is_subsequence (
+                     word, entry->name_key))
+            {
+              word_scores[i] = SCORE_SUBSEQ;
+            }
+        }
+
+      if (word_scores[i] == 0.0)
+        bitmap_set (mask, i, false);
+      else
+        scores[i] += word_scores[i];
+    }
+}
+
+/**
+ * Returns whether the query has any conditions.
+ */
+bool
+plugin_search_query_is_empty (
+  const PluginSearchQuery * query)
+{
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_TYPES; i++)
+    {
+      if (query->types[i])
+        return false;
+    }
+
+  return
+    (!query->text || query->text[0] == '\0') &&
+    query->num_categories == 0 &&
+    query->num_protocols == 0 &&
+    !query->collection;
+}
+
+static int
+cmp_results (
+  const void * _a,
+  const void * _b)
+{
+  const PluginSearchResult * a =
+    (const PluginSearchResult *) _a;
+  const PluginSearchResult * b =
+    (const PluginSearchResult *) _b;
+  if (a->score != b->score)
+    return a->score > b->score ? -1 : 1;
+
+  return
+    g_strcmp0 (a->descr->name, b->descr->name);
+}
+
+/**
+ * ANDs \p mask with the union of the given
+ * bitmaps.
+ */
+static void
+and_any (
+  PluginSearchIndex * self,
+  guint64 *           mask,
+  guint64 **          bitmaps,
+  const int *         idxs,
+  int                 num_idxs,
+  int                 max_idx)
+{
+  for (size_t w = 0; w < self->num_words; w++)
+    {
+      guint64 any = 0;
+      for (int i = 0; i < num_idxs; i++)
+        {
+          if (idxs[i] >= 0 && idxs[i] < max_idx)
+            any |= bitmaps[idxs[i]][w];
+        }
+      mask[w] &= any;
+    }
+}
+
+/**
+ * Runs the given query.
+ *
+ * @return A GArray of PluginSearchResult sorted
+ *   by descending score, then by name.
+ */
+GArray *
+plugin_search_index_query (
+  PluginSearchIndex *       self,
+  const PluginSearchQuery * query)
+{
+  g_return_val_if_fail (self && query, NULL);
+
+  GArray * results =
+    g_array_new (
+      false, false, sizeof (PluginSearchResult));
+  guint num_entries = self->entries->len;
+  if (num_entries == 0)
+    return results;
+
+  /* filters */
+  guint64 * mask =
+    g_new (guint64, self->num_words);
+  memcpy (
+    mask, self->live,
+    self->num_words * sizeof (guint64));
+  if (query->num_categories > 0)
+    {
+      and_any (
+        self, mask, self->categories,
+        (const int *) query->categories,
+        query->num_categories,
+        PLUGIN_SEARCH_NUM_CATEGORIES);
+    }
+  if (query->num_protocols > 0)
+    {
+      and_any (
+        self, mask, self->protocols,
+        (const int *) query->protocols,
+        query->num_protocols,
+        PLUGIN_SEARCH_NUM_PROTOCOLS);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_TYPES; i++)
+    {
+      if (!query->types[i])
+        continue;
+
+      for (size_t w = 0; w < self->num_words; w++)
+        mask[w] &= self->types[i][w];
+    }
+  if (query->collection)
+    {
+      guint64 * coll =
+        g_new0 (guint64, self->num_words);
+      PluginCollection * c = query->collection;
+      for (int i = 0; i < c->num_descriptors; i++)
+        {
+          char * id_key =
+            get_id_key (c->descriptors[i]);
+          guint idx =
+            GPOINTER_TO_UINT (
+              g_hash_table_lookup (
+                self->id_to_idx, id_key));
+          if (idx > 0)
+            bitmap_set (coll, idx - 1, true);
+          g_free (id_key);
+        }
+      for (size_t w = 0; w < self->num_words; w++)
+        mask[w] &= coll[w];
+      g_free (coll);
+    }
+
+  /* text */
+  double * scores =
+    g_new0 (double, num_entries);
+  char * text_key = NULL;
+  if (query->text && query->text[0] != '\0')
+    {
+      update_sorted_tokens (self);
+
+      GPtrArray * words =
+        g_ptr_array_new_with_free_func (g_free);
+      foreach_word (
+        query->text, false, add_word_cb, words);
+      double * word_scores =
+        g_new (double, num_entries);
+      for (guint i = 0; i < words->len; i++)
+        {
+          match_word (
+            self, g_ptr_array_index (words, i),
+            mask, scores, word_scores);
+        }
+      g_free (word_scores);
+      g_ptr_array_unref (words);
+
+      text_key = g_utf8_strdown (query->text, -1);
+    }
+
+  for (guint i = 0; i < num_entries; i++)
+    {
+      if (!bitmap_get (mask, i))
+        continue;
+
+      PluginSearchEntry * entry =
+        &g_array_index (
+          self->entries, PluginSearchEntry, i);
+      PluginSearchResult res = {
+        .descr = entry->descr,
+        .score = scores[i],
+      };
+      if (text_key &&
+          g_str_has_prefix (
+            entry->name_key, text_key))
+        {
+          res.score += SCORE_NAME_PREFIX_BONUS;
+        }
+      g_array_append_val (results, res);
+    }
+  g_array_sort (results, cmp_results);
+
+  g_free (text_key);
+  g_free (scores);
+  g_free (mask);
+
+  return results;
+}
+
+void
+plugin_search_index_free (
+  PluginSearchIndex * self)
+{
+  clear (self);
+  g_array_unref (self->entries);
+  g_hash_table_unref (self->descr_to_idx);
+  g_hash_table_unref (self->id_to_idx);
+  g_hash_table_unref (self->tokens);
+  g_ptr_array_unref (self->sorted_tokens);
+
+  g_free (self->live);
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_PROTOCOLS;
+       i++)
+    {
+      g_free (self->protocols[i]);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_CATEGORIES;
+       i++)
+    {
+      g_free (self->categories[i]);
+    }
+  for (int i = 0; i < PLUGIN_SEARCH_NUM_TYPES; i++)
+    {
+      g_free (self->types[i]);
+    }
+
+  object_zero_and_free (self);
+}
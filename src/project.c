@@ -39,6 +39,7 @@
 #include "audio/marker_track.h"
 #include "audio/midi_note.h"
 #include "audio/modulator_track.h"
+#include "audio/pool.h"
 #include "audio/router.h"
 #include "audio/tempo_track.h"
 #include "audio/track.h"
@@ -734,6 +735,7 @@ project_create_default (
     AUDIO_ENGINE, TRANSPORT_BEATS_PER_BAR,
     tempo_track_get_current_bpm (P_TEMPO_TRACK),
     AUDIO_ENGINE->sample_rate);
+  engine_update_tempo_map (AUDIO_ENGINE);
 
   /* create untitled project */
   create_and_set_dir_and_title (
@@ -769,14 +771,6 @@ project_create_default (
     NOTE_LENGTH_1_8);
   clip_editor_init (self->clip_editor);
   timeline_init (self->timeline);
-  snap_grid_update_snap_points_default (
-    &self->snap_grid_timeline);
-  snap_grid_update_snap_points_default (
-    &self->snap_grid_midi);
-  quantize_options_update_quantize_points (
-    &self->quantize_opts_timeline);
-  quantize_options_update_quantize_points (
-    &self->quantize_opts_editor);
 
   region_link_group_manager_init (
     &self->region_link_group_manager);
@@ -1041,6 +1035,9 @@ load (
     AUDIO_ENGINE, TRANSPORT_BEATS_PER_BAR,
     tempo_track_get_current_bpm (P_TEMPO_TRACK),
     AUDIO_ENGINE->sample_rate);
+  engine_update_tempo_map (AUDIO_ENGINE);
+  tracklist_update_region_indices (
+    self->tracklist, true);
 
   /* init ports */
   int max_size = 20;
@@ -1078,15 +1075,6 @@ load (
   tracklist_selections_init_loaded (
     self->tracklist_selections);
 
-  snap_grid_update_snap_points_default (
-    &self->snap_grid_timeline);
-  snap_grid_update_snap_points_default (
-    &self->snap_grid_midi);
-  quantize_options_update_quantize_points (
-    &self->quantize_opts_timeline);
-  quantize_options_update_quantize_points (
-    &self->quantize_opts_editor);
-
   region_link_group_manager_init_loaded (
     REGION_LINK_GROUP_MANAGER);
 
@@ -1555,6 +1543,10 @@ project_save (
 {
   int i, j;
 
+  /* make sure clips being imported are written to
+   * the pool */
+  audio_pool_wait_for_decodes (AUDIO_POOL);
+
   char * dir = g_strdup (_dir);
 
   /* set the dir and create it if it doesn't
@@ -1593,6 +1585,12 @@ project_save (
   MK_PROJECT_DIR (PLUGIN_EXT_COPIES);
   MK_PROJECT_DIR (PLUGIN_EXT_LINKS);
 
+  /* remove files no longer used by the pool */
+  if (!is_backup)
+    {
+      audio_pool_remove_orphan_files (AUDIO_POOL);
+    }
+
   /* write plugin states, prepare channels for
    * serialization, */
   Track * track;
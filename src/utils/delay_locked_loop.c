@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "utils/delay_locked_loop.h"
+
+/**
+ * Inits the loop with the given bandwidth in Hz.
+ *
+ * Lower values filter more jitter but take longer
+ * to lock.
+ */
+void
+delay_locked_loop_init (
+  DelayLockedLoop * self,
+  double            bandwidth)
+{
+  memset (self, 0, sizeof (DelayLockedLoop));
+  self->bandwidth = bandwidth;
+}
+
+/**
+ * Restarts the loop at the given time.
+ */
+void
+delay_locked_loop_reset (
+  DelayLockedLoop * self,
+  gint64            time,
+  nframes_t         nframes,
+  sample_rate_t     sample_rate)
+{
+  g_return_if_fail (nframes > 0 && sample_rate > 0);
+
+  double period =
+    ((double) nframes * 1000000.0) /
+      (double) sample_rate;
+  double omega =
+    2.0 * G_PI * self->bandwidth *
+      ((double) nframes / (double) sample_rate);
+  self->b = G_SQRT2 * omega;
+  self->c = omega * omega;
+  self->e2 = period;
+  self->t0 = (double) time;
+  self->t1 = self->t0 + period;
+  self->nframes = nframes;
+  self->sample_rate = sample_rate;
+  self->running = true;
+}
+
+/**
+ * Updates the loop with the system time at the
+ * start of a cycle.
+ *
+ * The loop is restarted if the cycle size or
+ * sample rate changed or if the time is too far
+ * off (eg, after an xrun).
+ */
+void
+delay_locked_loop_update (
+  DelayLockedLoop * self,
+  gint64            time,
+  nframes_t         nframes,
+  sample_rate_t     sample_rate)
+{
+  if (!self->running ||
+      nframes != self->nframes ||
+      sample_rate != self->sample_rate)
+    {
+      delay_locked_loop_reset (
+        self, time, nframes, sample_rate);
+      return;
+    }
+
+  double err = (double) time - self->t1;
+  if (fabs (err) > self->e2)
+    {
+      delay_locked_loop_reset (
+        self, time, nframes, sample_rate);
+      return;
+    }
+
+  self->t0 = self->t1;
+  self->t1 += self->b * err + self->e2;
+  self->e2 += self->c * err;
+}
+
+/**
+ * Converts the given system time to frames
+ * relative to the start of the current cycle.
+ *
+ * The result is negative for times before the
+ * start of the current cycle.
+ */
+double
+delay_locked_loop_time_to_frames (
+  const DelayLockedLoop * self,
+  gint64                  time)
+{
+  if (!self->running)
+    return 0.0;
+
+  return
+    (((double) time - self->t0) /
+       (self->t1 - self->t0)) *
+    (double) self->nframes;
+}
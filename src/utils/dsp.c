@@ -22,6 +22,7 @@
 #include <math.h>
 
 #include "utils/dsp.h"
+#include "utils/env.h"
 #include "utils/math.h"
 #include "zrythm.h"
 
@@ -31,6 +32,67 @@
 #include <lsp-plug.in/dsp/dsp.h>
 #endif
 
+/** Built-in kernels, or NULL to use plain C
+ * loops. */
+static const DspSimdFuncs * simd_funcs = NULL;
+
+static DspSimdLevel simd_level =
+  DSP_SIMD_LEVEL_NONE;
+
+/**
+ * Selects the built-in SIMD kernels to use based
+ * on the CPU.
+ *
+ * The level can be capped with the
+ * ZRYTHM_DSP_SIMD environment variable (0 for
+ * none, 1 for SSE2, 2 for AVX2, 3 for AVX-512).
+ */
+void
+dsp_init (void)
+{
+  DspSimdLevel level = dsp_simd_detect_level ();
+  int max_level =
+    env_get_int (
+      "ZRYTHM_DSP_SIMD", DSP_SIMD_LEVEL_AVX512);
+  if (max_level < (int) level)
+    {
+      level =
+        (DspSimdLevel)
+        CLAMP (max_level, DSP_SIMD_LEVEL_NONE,
+          DSP_SIMD_LEVEL_AVX512);
+    }
+
+  dsp_set_simd_level (level);
+}
+
+/**
+ * Sets the built-in SIMD kernels to use.
+ *
+ * @note Must not be called while the engine is
+ *   processing.
+ */
+void
+dsp_set_simd_level (
+  DspSimdLevel level)
+{
+  simd_funcs = dsp_simd_get_funcs (level);
+  simd_level =
+    simd_funcs ? level : DSP_SIMD_LEVEL_NONE;
+
+  g_message (
+    "%s: using %s DSP kernels", __func__,
+    dsp_simd_level_to_string (simd_level));
+}
+
+/**
+ * Returns the built-in SIMD kernels in use.
+ */
+DspSimdLevel
+dsp_get_simd_level (void)
+{
+  return simd_level;
+}
+
 /**
  * Fill the buffer with the given value.
  */
@@ -46,15 +108,18 @@ dsp_fill (
       lsp_dsp_fill (buf, val, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->fill (buf, val, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           buf[i] = val;
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 }
 
 /**
@@ -75,15 +140,18 @@ dsp_limit1 (
     }
   else
 #endif
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->limit1 (buf, minf, maxf, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           buf[i] = CLAMP (buf[i], minf, maxf);
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 }
 
 /**
@@ -106,8 +174,16 @@ dsp_abs_max (
         lsp_dsp_abs_max (buf, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      new_peak =
+        MAX (
+          new_peak,
+          simd_funcs->abs_max (buf, size));
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           float val = fabsf (buf[i]);
@@ -116,9 +192,7 @@ dsp_abs_max (
               new_peak = val;
             }
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 
   bool changed =
     !math_floats_equal (new_peak, *cur_peak);
@@ -142,8 +216,13 @@ dsp_min (
       min = lsp_dsp_min (buf, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      min = simd_funcs->min (buf, min, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           if (buf[i] < min)
@@ -151,9 +230,7 @@ dsp_min (
               min = buf[i];
             }
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 
   return min;
 }
@@ -173,8 +250,13 @@ dsp_max (
       max = lsp_dsp_max (buf, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      max = simd_funcs->max (buf, max, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           if (buf[i] > max)
@@ -182,9 +264,7 @@ dsp_max (
               max = buf[i];
             }
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 
   return max;
 }
@@ -204,15 +284,18 @@ dsp_copy (
       lsp_dsp_copy (dest, src, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->copy (dest, src, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           dest[i] = src[i];
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 }
 
 /**
@@ -230,15 +313,18 @@ dsp_add2 (
       lsp_dsp_add2 (dest, src, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->add2 (dest, src, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           dest[i] = dest[i] + src[i];
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 }
 
 /**
@@ -256,15 +342,18 @@ dsp_mul_k2 (
       lsp_dsp_mul_k2 (dest, k, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->mul_k2 (dest, k, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           dest[i] *= k;
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
 }
 
 /**
@@ -284,15 +373,57 @@ dsp_mix2 (
       lsp_dsp_mix2 (dest, src, k1, k2, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->mix2 (dest, src, k1, k2, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           dest[i] = dest[i] * k1 + src[i] * k2;
         }
-#ifdef HAVE_LSP_DSP
     }
-#endif
+}
+
+/**
+ * Calculate dest[i] = dest[i] * k1 + src[i] * k2,
+ * where k2 goes linearly from \p k2_start at the
+ * first sample to \p k2_end at the sample after
+ * the last one.
+ *
+ * Used for gain changes within a block so that
+ * consecutive ramps join without steps.
+ */
+void
+dsp_mix2_ramp (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2_start,
+  float         k2_end,
+  size_t        size)
+{
+  if (size == 0)
+    return;
+
+  float k2_step =
+    (k2_end - k2_start) / (float) size;
+  if (simd_funcs)
+    {
+      simd_funcs->mix2_ramp (
+        dest, src, k1, k2_start, k2_step, size);
+    }
+  else
+    {
+      for (size_t i = 0; i < size; i++)
+        {
+          dest[i] =
+            dest[i] * k1 +
+            src[i] * (k2_start + k2_step * (float) i);
+        }
+    }
 }
 
 /**
@@ -315,16 +446,108 @@ dsp_mix_add2 (
         dest, src1, src2, k1, k2, size);
     }
   else
-    {
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->mix_add2 (
+        dest, src1, src2, k1, k2, size);
+    }
+  else
+    {
       for (size_t i = 0; i < size; i++)
         {
           dest[i] =
             dest[i] + src1[i] * k1 + src2[i] * k2;
         }
+    }
+}
+
+/**
+ * Calculate
+ * dest[i] = CLAMP (dest[i] * k1 + src[i] * k2)
+ * in a single pass.
+ */
+void
+dsp_mix2_limit1 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  float         minf,
+  float         maxf,
+  size_t        size)
+{
 #ifdef HAVE_LSP_DSP
+  if (ZRYTHM_USE_OPTIMIZED_DSP)
+    {
+      lsp_dsp_mix2 (dest, src, k1, k2, size);
+      dsp_limit1 (dest, minf, maxf, size);
     }
+  else
 #endif
+  if (simd_funcs)
+    {
+      simd_funcs->mix2_limit1 (
+        dest, src, k1, k2, minf, maxf, size);
+    }
+  else
+    {
+      for (size_t i = 0; i < size; i++)
+        {
+          float val = dest[i] * k1 + src[i] * k2;
+          dest[i] = CLAMP (val, minf, maxf);
+        }
+    }
+}
+
+/**
+ * Calculate
+ * dest[i] = CLAMP (dest[i] + sum (srcs[j][i] * ks[j]))
+ * in a single pass over all the buffers.
+ *
+ * The destination is read and written once
+ * regardless of the number of sources.
+ */
+void
+dsp_gather_sum_limit1 (
+  float *               dest,
+  const float * const * srcs,
+  const float *         ks,
+  size_t                num_srcs,
+  float                 minf,
+  float                 maxf,
+  size_t                size)
+{
+#ifdef HAVE_LSP_DSP
+  if (ZRYTHM_USE_OPTIMIZED_DSP)
+    {
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          lsp_dsp_mix2 (
+            dest, srcs[j], 1.f, ks[j], size);
+        }
+      dsp_limit1 (dest, minf, maxf, size);
+    }
+  else
+#endif
+  if (simd_funcs)
+    {
+      simd_funcs->gather_sum_limit1 (
+        dest, srcs, ks, num_srcs, minf, maxf,
+        size);
+    }
+  else
+    {
+      for (size_t i = 0; i < size; i++)
+        {
+          float val = dest[i];
+          for (size_t j = 0; j < num_srcs; j++)
+            {
+              val += srcs[j][i] * ks[j];
+            }
+          dest[i] = CLAMP (val, minf, maxf);
+        }
+    }
 }
 
 /**
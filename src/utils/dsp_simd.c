@@ -0,0 +1,1289 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * SSE2/AVX2/AVX-512 DSP kernels.
+ *
+ * Each kernel is compiled for its instruction set
+ * with a target attribute, so the rest of the
+ * program does not need to be built with these
+ * instruction sets enabled.
+ */
+
+#include "zrythm-config.h"
+
+#include <math.h>
+
+#include "utils/dsp_simd.h"
+
+#include <glib.h>
+
+#if (defined (__x86_64__) || defined (__i386__)) && \
+  defined (__GNUC__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#ifdef HAVE_X86_SIMD
+
+#define TARGET_SSE2 __attribute__ ((target ("sse2")))
+#define TARGET_AVX2 __attribute__ ((target ("avx2")))
+#define TARGET_AVX512 \
+  __attribute__ ((target ("avx512f")))
+
+/* ---- SSE2 ---- */
+
+static inline TARGET_SSE2 float
+sse2_hmax (
+  __m128 v)
+{
+  v = _mm_max_ps (v, _mm_movehl_ps (v, v));
+  v =
+    _mm_max_ss (
+      v, _mm_shuffle_ps (v, v, 1));
+  return _mm_cvtss_f32 (v);
+}
+
+static inline TARGET_SSE2 float
+sse2_hmin (
+  __m128 v)
+{
+  v = _mm_min_ps (v, _mm_movehl_ps (v, v));
+  v =
+    _mm_min_ss (
+      v, _mm_shuffle_ps (v, v, 1));
+  return _mm_cvtss_f32 (v);
+}
+
+static TARGET_SSE2 void
+sse2_fill (
+  float * buf,
+  float   val,
+  size_t  size)
+{
+  const __m128 v = _mm_set1_ps (val);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      _mm_storeu_ps (&buf[i], v);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = val;
+    }
+}
+
+static TARGET_SSE2 void
+sse2_limit1 (
+  float * buf,
+  float   minf,
+  float   maxf,
+  size_t  size)
+{
+  const __m128 lo = _mm_set1_ps (minf);
+  const __m128 hi = _mm_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 x = _mm_loadu_ps (&buf[i]);
+      x = _mm_min_ps (_mm_max_ps (x, lo), hi);
+      _mm_storeu_ps (&buf[i], x);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = CLAMP (buf[i], minf, maxf);
+    }
+}
+
+static TARGET_SSE2 float
+sse2_abs_max (
+  const float * buf,
+  size_t        size)
+{
+  const __m128 sign = _mm_set1_ps (-0.f);
+  __m128 acc = _mm_setzero_ps ();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 x = _mm_loadu_ps (&buf[i]);
+      acc = _mm_max_ps (acc, _mm_andnot_ps (sign, x));
+    }
+  float ret = sse2_hmax (acc);
+  for (; i < size; i++)
+    {
+      float val = fabsf (buf[i]);
+      if (val > ret)
+        ret = val;
+    }
+  return ret;
+}
+
+static TARGET_SSE2 float
+sse2_min (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m128 acc = _mm_set1_ps (init);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      acc =
+        _mm_min_ps (acc, _mm_loadu_ps (&buf[i]));
+    }
+  float ret = sse2_hmin (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] < ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_SSE2 float
+sse2_max (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m128 acc = _mm_set1_ps (init);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      acc =
+        _mm_max_ps (acc, _mm_loadu_ps (&buf[i]));
+    }
+  float ret = sse2_hmax (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] > ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_SSE2 void
+sse2_copy (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      _mm_storeu_ps (
+        &dest[i], _mm_loadu_ps (&src[i]));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = src[i];
+    }
+}
+
+static TARGET_SSE2 void
+sse2_add2 (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      _mm_storeu_ps (
+        &dest[i],
+        _mm_add_ps (
+          _mm_loadu_ps (&dest[i]),
+          _mm_loadu_ps (&src[i])));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] + src[i];
+    }
+}
+
+static TARGET_SSE2 void
+sse2_mul_k2 (
+  float * dest,
+  float   k,
+  size_t  size)
+{
+  const __m128 vk = _mm_set1_ps (k);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      _mm_storeu_ps (
+        &dest[i],
+        _mm_mul_ps (_mm_loadu_ps (&dest[i]), vk));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] *= k;
+    }
+}
+
+static TARGET_SSE2 void
+sse2_mix2 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m128 vk1 = _mm_set1_ps (k1);
+  const __m128 vk2 = _mm_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 x =
+        _mm_add_ps (
+          _mm_mul_ps (_mm_loadu_ps (&dest[i]), vk1),
+          _mm_mul_ps (_mm_loadu_ps (&src[i]), vk2));
+      _mm_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] * k1 + src[i] * k2;
+    }
+}
+
+static TARGET_SSE2 void
+sse2_mix2_ramp (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2_start,
+  float         k2_step,
+  size_t        size)
+{
+  const __m128 vk1 = _mm_set1_ps (k1);
+  const __m128 vstart = _mm_set1_ps (k2_start);
+  const __m128 vstep = _mm_set1_ps (k2_step);
+  const __m128 lanes =
+    _mm_setr_ps (0.f, 1.f, 2.f, 3.f);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      /* compute the gain from the index so that
+       * errors don't accumulate */
+      __m128 k2 =
+        _mm_add_ps (
+          vstart,
+          _mm_mul_ps (
+            vstep,
+            _mm_add_ps (_mm_set1_ps ((float) i), lanes)));
+      __m128 x =
+        _mm_add_ps (
+          _mm_mul_ps (_mm_loadu_ps (&dest[i]), vk1),
+          _mm_mul_ps (_mm_loadu_ps (&src[i]), k2));
+      _mm_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] * k1 +
+        src[i] * (k2_start + k2_step * (float) i);
+    }
+}
+
+static TARGET_SSE2 void
+sse2_mix_add2 (
+  float *       dest,
+  const float * src1,
+  const float * src2,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m128 vk1 = _mm_set1_ps (k1);
+  const __m128 vk2 = _mm_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 x =
+        _mm_add_ps (
+          _mm_loadu_ps (&dest[i]),
+          _mm_add_ps (
+            _mm_mul_ps (
+              _mm_loadu_ps (&src1[i]), vk1),
+            _mm_mul_ps (
+              _mm_loadu_ps (&src2[i]), vk2)));
+      _mm_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] + src1[i] * k1 + src2[i] * k2;
+    }
+}
+
+static TARGET_SSE2 void
+sse2_mix2_limit1 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  float         minf,
+  float         maxf,
+  size_t        size)
+{
+  const __m128 vk1 = _mm_set1_ps (k1);
+  const __m128 vk2 = _mm_set1_ps (k2);
+  const __m128 lo = _mm_set1_ps (minf);
+  const __m128 hi = _mm_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 x =
+        _mm_add_ps (
+          _mm_mul_ps (_mm_loadu_ps (&dest[i]), vk1),
+          _mm_mul_ps (_mm_loadu_ps (&src[i]), vk2));
+      x = _mm_min_ps (_mm_max_ps (x, lo), hi);
+      _mm_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i] * k1 + src[i] * k2;
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static TARGET_SSE2 void
+sse2_gather_sum_limit1 (
+  float *              dest,
+  const float * const * srcs,
+  const float *        ks,
+  size_t               num_srcs,
+  float                minf,
+  float                maxf,
+  size_t               size)
+{
+  const __m128 lo = _mm_set1_ps (minf);
+  const __m128 hi = _mm_set1_ps (maxf);
+  size_t i = 0;
+
+  /* 2 independent accumulators per iteration to
+   * hide the latency of the additions */
+  for (; i + 8 <= size; i += 8)
+    {
+      __m128 acc0 = _mm_loadu_ps (&dest[i]);
+      __m128 acc1 = _mm_loadu_ps (&dest[i + 4]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          const __m128 k = _mm_set1_ps (ks[j]);
+          acc0 =
+            _mm_add_ps (
+              acc0,
+              _mm_mul_ps (
+                _mm_loadu_ps (&srcs[j][i]), k));
+          acc1 =
+            _mm_add_ps (
+              acc1,
+              _mm_mul_ps (
+                _mm_loadu_ps (&srcs[j][i + 4]), k));
+        }
+      acc0 = _mm_min_ps (_mm_max_ps (acc0, lo), hi);
+      acc1 = _mm_min_ps (_mm_max_ps (acc1, lo), hi);
+      _mm_storeu_ps (&dest[i], acc0);
+      _mm_storeu_ps (&dest[i + 4], acc1);
+    }
+  for (; i + 4 <= size; i += 4)
+    {
+      __m128 acc = _mm_loadu_ps (&dest[i]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          acc =
+            _mm_add_ps (
+              acc,
+              _mm_mul_ps (
+                _mm_loadu_ps (&srcs[j][i]),
+                _mm_set1_ps (ks[j])));
+        }
+      acc = _mm_min_ps (_mm_max_ps (acc, lo), hi);
+      _mm_storeu_ps (&dest[i], acc);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i];
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          val += srcs[j][i] * ks[j];
+        }
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static const DspSimdFuncs sse2_funcs = {
+  .fill = sse2_fill,
+  .limit1 = sse2_limit1,
+  .abs_max = sse2_abs_max,
+  .min = sse2_min,
+  .max = sse2_max,
+  .copy = sse2_copy,
+  .add2 = sse2_add2,
+  .mul_k2 = sse2_mul_k2,
+  .mix2 = sse2_mix2,
+  .mix2_ramp = sse2_mix2_ramp,
+  .mix_add2 = sse2_mix_add2,
+  .mix2_limit1 = sse2_mix2_limit1,
+  .gather_sum_limit1 = sse2_gather_sum_limit1,
+};
+
+/* ---- AVX2 ---- */
+
+static inline TARGET_AVX2 float
+avx2_hmax (
+  __m256 v)
+{
+  __m128 v4 =
+    _mm_max_ps (
+      _mm256_castps256_ps128 (v),
+      _mm256_extractf128_ps (v, 1));
+  v4 = _mm_max_ps (v4, _mm_movehl_ps (v4, v4));
+  v4 =
+    _mm_max_ss (
+      v4, _mm_shuffle_ps (v4, v4, 1));
+  return _mm_cvtss_f32 (v4);
+}
+
+static inline TARGET_AVX2 float
+avx2_hmin (
+  __m256 v)
+{
+  __m128 v4 =
+    _mm_min_ps (
+      _mm256_castps256_ps128 (v),
+      _mm256_extractf128_ps (v, 1));
+  v4 = _mm_min_ps (v4, _mm_movehl_ps (v4, v4));
+  v4 =
+    _mm_min_ss (
+      v4, _mm_shuffle_ps (v4, v4, 1));
+  return _mm_cvtss_f32 (v4);
+}
+
+static TARGET_AVX2 void
+avx2_fill (
+  float * buf,
+  float   val,
+  size_t  size)
+{
+  const __m256 v = _mm256_set1_ps (val);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      _mm256_storeu_ps (&buf[i], v);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = val;
+    }
+}
+
+static TARGET_AVX2 void
+avx2_limit1 (
+  float * buf,
+  float   minf,
+  float   maxf,
+  size_t  size)
+{
+  const __m256 lo = _mm256_set1_ps (minf);
+  const __m256 hi = _mm256_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 x = _mm256_loadu_ps (&buf[i]);
+      x = _mm256_min_ps (_mm256_max_ps (x, lo), hi);
+      _mm256_storeu_ps (&buf[i], x);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = CLAMP (buf[i], minf, maxf);
+    }
+}
+
+static TARGET_AVX2 float
+avx2_abs_max (
+  const float * buf,
+  size_t        size)
+{
+  const __m256 sign = _mm256_set1_ps (-0.f);
+  __m256 acc = _mm256_setzero_ps ();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 x = _mm256_loadu_ps (&buf[i]);
+      acc = _mm256_max_ps (acc, _mm256_andnot_ps (sign, x));
+    }
+  float ret = avx2_hmax (acc);
+  for (; i < size; i++)
+    {
+      float val = fabsf (buf[i]);
+      if (val > ret)
+        ret = val;
+    }
+  return ret;
+}
+
+static TARGET_AVX2 float
+avx2_min (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m256 acc = _mm256_set1_ps (init);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      acc =
+        _mm256_min_ps (acc, _mm256_loadu_ps (&buf[i]));
+    }
+  float ret = avx2_hmin (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] < ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_AVX2 float
+avx2_max (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m256 acc = _mm256_set1_ps (init);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      acc =
+        _mm256_max_ps (acc, _mm256_loadu_ps (&buf[i]));
+    }
+  float ret = avx2_hmax (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] > ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_AVX2 void
+avx2_copy (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      _mm256_storeu_ps (
+        &dest[i], _mm256_loadu_ps (&src[i]));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = src[i];
+    }
+}
+
+static TARGET_AVX2 void
+avx2_add2 (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      _mm256_storeu_ps (
+        &dest[i],
+        _mm256_add_ps (
+          _mm256_loadu_ps (&dest[i]),
+          _mm256_loadu_ps (&src[i])));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] + src[i];
+    }
+}
+
+static TARGET_AVX2 void
+avx2_mul_k2 (
+  float * dest,
+  float   k,
+  size_t  size)
+{
+  const __m256 vk = _mm256_set1_ps (k);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      _mm256_storeu_ps (
+        &dest[i],
+        _mm256_mul_ps (_mm256_loadu_ps (&dest[i]), vk));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] *= k;
+    }
+}
+
+static TARGET_AVX2 void
+avx2_mix2 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m256 vk1 = _mm256_set1_ps (k1);
+  const __m256 vk2 = _mm256_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 x =
+        _mm256_add_ps (
+          _mm256_mul_ps (_mm256_loadu_ps (&dest[i]), vk1),
+          _mm256_mul_ps (_mm256_loadu_ps (&src[i]), vk2));
+      _mm256_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] * k1 + src[i] * k2;
+    }
+}
+
+static TARGET_AVX2 void
+avx2_mix2_ramp (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2_start,
+  float         k2_step,
+  size_t        size)
+{
+  const __m256 vk1 = _mm256_set1_ps (k1);
+  const __m256 vstart = _mm256_set1_ps (k2_start);
+  const __m256 vstep = _mm256_set1_ps (k2_step);
+  const __m256 lanes =
+    _mm256_setr_ps (
+      0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      /* compute the gain from the index so that
+       * errors don't accumulate */
+      __m256 k2 =
+        _mm256_add_ps (
+          vstart,
+          _mm256_mul_ps (
+            vstep,
+            _mm256_add_ps (_mm256_set1_ps ((float) i), lanes)));
+      __m256 x =
+        _mm256_add_ps (
+          _mm256_mul_ps (_mm256_loadu_ps (&dest[i]), vk1),
+          _mm256_mul_ps (_mm256_loadu_ps (&src[i]), k2));
+      _mm256_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] * k1 +
+        src[i] * (k2_start + k2_step * (float) i);
+    }
+}
+
+static TARGET_AVX2 void
+avx2_mix_add2 (
+  float *       dest,
+  const float * src1,
+  const float * src2,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m256 vk1 = _mm256_set1_ps (k1);
+  const __m256 vk2 = _mm256_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 x =
+        _mm256_add_ps (
+          _mm256_loadu_ps (&dest[i]),
+          _mm256_add_ps (
+            _mm256_mul_ps (
+              _mm256_loadu_ps (&src1[i]), vk1),
+            _mm256_mul_ps (
+              _mm256_loadu_ps (&src2[i]), vk2)));
+      _mm256_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] + src1[i] * k1 + src2[i] * k2;
+    }
+}
+
+static TARGET_AVX2 void
+avx2_mix2_limit1 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  float         minf,
+  float         maxf,
+  size_t        size)
+{
+  const __m256 vk1 = _mm256_set1_ps (k1);
+  const __m256 vk2 = _mm256_set1_ps (k2);
+  const __m256 lo = _mm256_set1_ps (minf);
+  const __m256 hi = _mm256_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 x =
+        _mm256_add_ps (
+          _mm256_mul_ps (_mm256_loadu_ps (&dest[i]), vk1),
+          _mm256_mul_ps (_mm256_loadu_ps (&src[i]), vk2));
+      x = _mm256_min_ps (_mm256_max_ps (x, lo), hi);
+      _mm256_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i] * k1 + src[i] * k2;
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static TARGET_AVX2 void
+avx2_gather_sum_limit1 (
+  float *              dest,
+  const float * const * srcs,
+  const float *        ks,
+  size_t               num_srcs,
+  float                minf,
+  float                maxf,
+  size_t               size)
+{
+  const __m256 lo = _mm256_set1_ps (minf);
+  const __m256 hi = _mm256_set1_ps (maxf);
+  size_t i = 0;
+
+  /* 2 independent accumulators per iteration to
+   * hide the latency of the additions */
+  for (; i + 16 <= size; i += 16)
+    {
+      __m256 acc0 = _mm256_loadu_ps (&dest[i]);
+      __m256 acc1 = _mm256_loadu_ps (&dest[i + 8]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          const __m256 k = _mm256_set1_ps (ks[j]);
+          acc0 =
+            _mm256_add_ps (
+              acc0,
+              _mm256_mul_ps (
+                _mm256_loadu_ps (&srcs[j][i]), k));
+          acc1 =
+            _mm256_add_ps (
+              acc1,
+              _mm256_mul_ps (
+                _mm256_loadu_ps (&srcs[j][i + 8]), k));
+        }
+      acc0 = _mm256_min_ps (_mm256_max_ps (acc0, lo), hi);
+      acc1 = _mm256_min_ps (_mm256_max_ps (acc1, lo), hi);
+      _mm256_storeu_ps (&dest[i], acc0);
+      _mm256_storeu_ps (&dest[i + 8], acc1);
+    }
+  for (; i + 8 <= size; i += 8)
+    {
+      __m256 acc = _mm256_loadu_ps (&dest[i]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          acc =
+            _mm256_add_ps (
+              acc,
+              _mm256_mul_ps (
+                _mm256_loadu_ps (&srcs[j][i]),
+                _mm256_set1_ps (ks[j])));
+        }
+      acc = _mm256_min_ps (_mm256_max_ps (acc, lo), hi);
+      _mm256_storeu_ps (&dest[i], acc);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i];
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          val += srcs[j][i] * ks[j];
+        }
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static const DspSimdFuncs avx2_funcs = {
+  .fill = avx2_fill,
+  .limit1 = avx2_limit1,
+  .abs_max = avx2_abs_max,
+  .min = avx2_min,
+  .max = avx2_max,
+  .copy = avx2_copy,
+  .add2 = avx2_add2,
+  .mul_k2 = avx2_mul_k2,
+  .mix2 = avx2_mix2,
+  .mix2_ramp = avx2_mix2_ramp,
+  .mix_add2 = avx2_mix_add2,
+  .mix2_limit1 = avx2_mix2_limit1,
+  .gather_sum_limit1 = avx2_gather_sum_limit1,
+};
+
+/* ---- AVX-512 ---- */
+
+static TARGET_AVX512 void
+avx512_fill (
+  float * buf,
+  float   val,
+  size_t  size)
+{
+  const __m512 v = _mm512_set1_ps (val);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      _mm512_storeu_ps (&buf[i], v);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = val;
+    }
+}
+
+static TARGET_AVX512 void
+avx512_limit1 (
+  float * buf,
+  float   minf,
+  float   maxf,
+  size_t  size)
+{
+  const __m512 lo = _mm512_set1_ps (minf);
+  const __m512 hi = _mm512_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 x = _mm512_loadu_ps (&buf[i]);
+      x = _mm512_min_ps (_mm512_max_ps (x, lo), hi);
+      _mm512_storeu_ps (&buf[i], x);
+    }
+  for (; i < size; i++)
+    {
+      buf[i] = CLAMP (buf[i], minf, maxf);
+    }
+}
+
+static TARGET_AVX512 float
+avx512_abs_max (
+  const float * buf,
+  size_t        size)
+{
+  __m512 acc = _mm512_setzero_ps ();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 x = _mm512_loadu_ps (&buf[i]);
+      acc = _mm512_max_ps (acc, _mm512_abs_ps (x));
+    }
+  float ret = _mm512_reduce_max_ps (acc);
+  for (; i < size; i++)
+    {
+      float val = fabsf (buf[i]);
+      if (val > ret)
+        ret = val;
+    }
+  return ret;
+}
+
+static TARGET_AVX512 float
+avx512_min (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m512 acc = _mm512_set1_ps (init);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      acc =
+        _mm512_min_ps (acc, _mm512_loadu_ps (&buf[i]));
+    }
+  float ret = _mm512_reduce_min_ps (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] < ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_AVX512 float
+avx512_max (
+  const float * buf,
+  float         init,
+  size_t        size)
+{
+  __m512 acc = _mm512_set1_ps (init);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      acc =
+        _mm512_max_ps (acc, _mm512_loadu_ps (&buf[i]));
+    }
+  float ret = _mm512_reduce_max_ps (acc);
+  for (; i < size; i++)
+    {
+      if (buf[i] > ret)
+        ret = buf[i];
+    }
+  return ret;
+}
+
+static TARGET_AVX512 void
+avx512_copy (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      _mm512_storeu_ps (
+        &dest[i], _mm512_loadu_ps (&src[i]));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = src[i];
+    }
+}
+
+static TARGET_AVX512 void
+avx512_add2 (
+  float *       dest,
+  const float * src,
+  size_t        size)
+{
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      _mm512_storeu_ps (
+        &dest[i],
+        _mm512_add_ps (
+          _mm512_loadu_ps (&dest[i]),
+          _mm512_loadu_ps (&src[i])));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] + src[i];
+    }
+}
+
+static TARGET_AVX512 void
+avx512_mul_k2 (
+  float * dest,
+  float   k,
+  size_t  size)
+{
+  const __m512 vk = _mm512_set1_ps (k);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      _mm512_storeu_ps (
+        &dest[i],
+        _mm512_mul_ps (_mm512_loadu_ps (&dest[i]), vk));
+    }
+  for (; i < size; i++)
+    {
+      dest[i] *= k;
+    }
+}
+
+static TARGET_AVX512 void
+avx512_mix2 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m512 vk1 = _mm512_set1_ps (k1);
+  const __m512 vk2 = _mm512_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 x =
+        _mm512_add_ps (
+          _mm512_mul_ps (_mm512_loadu_ps (&dest[i]), vk1),
+          _mm512_mul_ps (_mm512_loadu_ps (&src[i]), vk2));
+      _mm512_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] = dest[i] * k1 + src[i] * k2;
+    }
+}
+
+static TARGET_AVX512 void
+avx512_mix2_ramp (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2_start,
+  float         k2_step,
+  size_t        size)
+{
+  const __m512 vk1 = _mm512_set1_ps (k1);
+  const __m512 vstart = _mm512_set1_ps (k2_start);
+  const __m512 vstep = _mm512_set1_ps (k2_step);
+  const __m512 lanes =
+    _mm512_setr_ps (
+      0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f,
+      8.f, 9.f, 10.f, 11.f, 12.f, 13.f, 14.f,
+      15.f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      /* compute the gain from the index so that
+       * errors don't accumulate */
+      __m512 k2 =
+        _mm512_add_ps (
+          vstart,
+          _mm512_mul_ps (
+            vstep,
+            _mm512_add_ps (_mm512_set1_ps ((float) i), lanes)));
+      __m512 x =
+        _mm512_add_ps (
+          _mm512_mul_ps (_mm512_loadu_ps (&dest[i]), vk1),
+          _mm512_mul_ps (_mm512_loadu_ps (&src[i]), k2));
+      _mm512_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] * k1 +
+        src[i] * (k2_start + k2_step * (float) i);
+    }
+}
+
+static TARGET_AVX512 void
+avx512_mix_add2 (
+  float *       dest,
+  const float * src1,
+  const float * src2,
+  float         k1,
+  float         k2,
+  size_t        size)
+{
+  const __m512 vk1 = _mm512_set1_ps (k1);
+  const __m512 vk2 = _mm512_set1_ps (k2);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 x =
+        _mm512_add_ps (
+          _mm512_loadu_ps (&dest[i]),
+          _mm512_add_ps (
+            _mm512_mul_ps (
+              _mm512_loadu_ps (&src1[i]), vk1),
+            _mm512_mul_ps (
+              _mm512_loadu_ps (&src2[i]), vk2)));
+      _mm512_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      dest[i] =
+        dest[i] + src1[i] * k1 + src2[i] * k2;
+    }
+}
+
+static TARGET_AVX512 void
+avx512_mix2_limit1 (
+  float *       dest,
+  const float * src,
+  float         k1,
+  float         k2,
+  float         minf,
+  float         maxf,
+  size_t        size)
+{
+  const __m512 vk1 = _mm512_set1_ps (k1);
+  const __m512 vk2 = _mm512_set1_ps (k2);
+  const __m512 lo = _mm512_set1_ps (minf);
+  const __m512 hi = _mm512_set1_ps (maxf);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 x =
+        _mm512_add_ps (
+          _mm512_mul_ps (_mm512_loadu_ps (&dest[i]), vk1),
+          _mm512_mul_ps (_mm512_loadu_ps (&src[i]), vk2));
+      x = _mm512_min_ps (_mm512_max_ps (x, lo), hi);
+      _mm512_storeu_ps (&dest[i], x);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i] * k1 + src[i] * k2;
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static TARGET_AVX512 void
+avx512_gather_sum_limit1 (
+  float *              dest,
+  const float * const * srcs,
+  const float *        ks,
+  size_t               num_srcs,
+  float                minf,
+  float                maxf,
+  size_t               size)
+{
+  const __m512 lo = _mm512_set1_ps (minf);
+  const __m512 hi = _mm512_set1_ps (maxf);
+  size_t i = 0;
+
+  /* 2 independent accumulators per iteration to
+   * hide the latency of the additions */
+  for (; i + 32 <= size; i += 32)
+    {
+      __m512 acc0 = _mm512_loadu_ps (&dest[i]);
+      __m512 acc1 = _mm512_loadu_ps (&dest[i + 16]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          const __m512 k = _mm512_set1_ps (ks[j]);
+          acc0 =
+            _mm512_add_ps (
+              acc0,
+              _mm512_mul_ps (
+                _mm512_loadu_ps (&srcs[j][i]), k));
+          acc1 =
+            _mm512_add_ps (
+              acc1,
+              _mm512_mul_ps (
+                _mm512_loadu_ps (&srcs[j][i + 16]), k));
+        }
+      acc0 = _mm512_min_ps (_mm512_max_ps (acc0, lo), hi);
+      acc1 = _mm512_min_ps (_mm512_max_ps (acc1, lo), hi);
+      _mm512_storeu_ps (&dest[i], acc0);
+      _mm512_storeu_ps (&dest[i + 16], acc1);
+    }
+  for (; i + 16 <= size; i += 16)
+    {
+      __m512 acc = _mm512_loadu_ps (&dest[i]);
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          acc =
+            _mm512_add_ps (
+              acc,
+              _mm512_mul_ps (
+                _mm512_loadu_ps (&srcs[j][i]),
+                _mm512_set1_ps (ks[j])));
+        }
+      acc = _mm512_min_ps (_mm512_max_ps (acc, lo), hi);
+      _mm512_storeu_ps (&dest[i], acc);
+    }
+  for (; i < size; i++)
+    {
+      float val = dest[i];
+      for (size_t j = 0; j < num_srcs; j++)
+        {
+          val += srcs[j][i] * ks[j];
+        }
+      dest[i] = CLAMP (val, minf, maxf);
+    }
+}
+
+static const DspSimdFuncs avx512_funcs = {
+  .fill = avx512_fill,
+  .limit1 = avx512_limit1,
+  .abs_max = avx512_abs_max,
+  .min = avx512_min,
+  .max = avx512_max,
+  .copy = avx512_copy,
+  .add2 = avx512_add2,
+  .mul_k2 = avx512_mul_k2,
+  .mix2 = avx512_mix2,
+  .mix2_ramp = avx512_mix2_ramp,
+  .mix_add2 = avx512_mix_add2,
+  .mix2_limit1 = avx512_mix2_limit1,
+  .gather_sum_limit1 = avx512_gather_sum_limit1,
+};
+
+#endif /* HAVE_X86_SIMD */
+
+/**
+ * Returns the best instruction set supported by
+ * both the CPU and the compiler.
+ */
+DspSimdLevel
+dsp_simd_detect_level (void)
+{
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx512f"))
+    return DSP_SIMD_LEVEL_AVX512;
+  if (__builtin_cpu_supports ("avx2"))
+    return DSP_SIMD_LEVEL_AVX2;
+  if (__builtin_cpu_supports ("sse2"))
+    return DSP_SIMD_LEVEL_SSE2;
+#endif
+
+  return DSP_SIMD_LEVEL_NONE;
+}
+
+/**
+ * Returns the kernels for the given level, or NULL
+ * for \ref DSP_SIMD_LEVEL_NONE or if the level
+ * was not compiled in.
+ */
+const DspSimdFuncs *
+dsp_simd_get_funcs (
+  DspSimdLevel level)
+{
+  switch (level)
+    {
+#ifdef HAVE_X86_SIMD
+    case DSP_SIMD_LEVEL_SSE2:
+      return &sse2_funcs;
+    case DSP_SIMD_LEVEL_AVX2:
+      return &avx2_funcs;
+    case DSP_SIMD_LEVEL_AVX512:
+      return &avx512_funcs;
+#endif
+    default:
+      break;
+    }
+
+  return NULL;
+}
+
+const char *
+dsp_simd_level_to_string (
+  DspSimdLevel level)
+{
+  static const char * level_strs[] = {
+    "none", "SSE2", "AVX2", "AVX-512",
+  };
+
+  return level_strs[level];
+}
@@ -22,6 +22,7 @@
 #include <math.h>
 
 #include "audio/engine.h"
+#include "audio/engine_alsa.h"
 #include "audio/engine_rtaudio.h"
 #include "audio/engine_sdl.h"
 #include "audio/pan.h"
@@ -1114,6 +1115,11 @@ ui_setup_device_name_combo_box (
 
   switch (backend)
     {
+#ifdef HAVE_ALSA
+    case AUDIO_BACKEND_ALSA:
+      SETUP_DEVICES (alsa);
+      break;
+#endif
 #ifdef HAVE_SDL
     case AUDIO_BACKEND_SDL:
       SETUP_DEVICES (sdl);
@@ -43,6 +43,7 @@
 #include "settings/settings.h"
 #include "utils/arrays.h"
 #include "utils/cairo.h"
+#include "utils/dsp.h"
 #include "utils/env.h"
 #include "utils/gtk.h"
 #include "utils/localization.h"
@@ -431,6 +432,11 @@ zrythm_get_dir (
             g_build_filename (
               user_dir, "gdb", NULL);
           break;
+        case ZRYTHM_DIR_USER_CACHE:
+          res =
+            g_build_filename (
+              user_dir, "cache", NULL);
+          break;
         default:
           break;
         }
@@ -504,6 +510,7 @@ zrythm_new (
   self->have_ui = have_ui;
   self->testing = testing;
   self->use_optimized_dsp = optimized_dsp;
+  dsp_init ();
   self->settings = settings_new ();
   self->object_utils = object_utils_new ();
   self->recording_manager =
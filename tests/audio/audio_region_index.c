@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "actions/tracklist_selections.h"
+#include "audio/audio_region.h"
+#include "audio/audio_region_index.h"
+#include "audio/audio_track.h"
+#include "audio/track_processor.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+#define NUM_LANES 20
+
+#define NUM_GROUPS 3
+
+/**
+ * Creates an audio track from test.wav with a
+ * region in each of NUM_LANES lanes, where the
+ * region in lane 3 is muted.
+ */
+static Track *
+create_track_with_lanes (void)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file =
+    supported_file_new_from_path (filepath);
+  int track_pos = TRACKLIST->num_tracks;
+  UndoableAction * ua =
+    tracklist_selections_action_new_create (
+      TRACK_TYPE_AUDIO, NULL, file, track_pos,
+      PLAYHEAD, 1);
+  undo_manager_perform (UNDO_MANAGER, ua);
+  g_free (filepath);
+
+  Track * track = TRACKLIST->tracks[track_pos];
+  g_assert_cmpint (
+    track->lanes[0]->num_regions, ==, 1);
+  int pool_id = track->lanes[0]->regions[0]->pool_id;
+
+  /* add regions at staggered positions in the
+   * other lanes */
+  for (int i = 1; i < NUM_LANES; i++)
+    {
+      Position pos;
+      position_set_to_bar (&pos, 1 + (i % 4));
+      position_add_frames (&pos, i * 100);
+      ZRegion * r =
+        audio_region_new (
+          pool_id, NULL, NULL, -1, NULL, 0, &pos,
+          track->pos, i, 0);
+      track_add_region (
+        track, r, NULL, i, F_GEN_NAME,
+        F_NO_PUBLISH_EVENTS);
+    }
+  g_assert_cmpint (track->num_lanes, >=, NUM_LANES);
+
+  ArrangerObject * r_obj =
+    (ArrangerObject *) track->lanes[3]->regions[0];
+  r_obj->muted = true;
+
+  track_update_region_index (track);
+
+  return track;
+}
+
+static void
+test_index (void)
+{
+  test_helper_zrythm_init ();
+
+  Track * track = create_track_with_lanes ();
+  const AudioRegionIndex * index =
+    track_get_region_index (track);
+  g_assert_nonnull (index);
+
+  /* the muted region is skipped */
+  g_assert_cmpint (
+    index->num_entries, ==, NUM_LANES - 1);
+
+  /* entries are sorted by start position */
+  for (int i = 1; i < index->num_entries; i++)
+    {
+      g_assert_cmpint (
+        index->entries[i - 1].start_frames, <=,
+        index->entries[i].start_frames);
+      g_assert_cmpint (
+        index->entries[i].lane_pos, !=, 3);
+    }
+
+  /* the first entry found is the first one
+   * overlapping each position */
+  for (long frames = 0;
+       frames <
+         index->entries[
+           index->num_entries - 1].end_frames + 10;
+       frames += 997)
+    {
+      int expected = index->num_entries;
+      for (int i = 0; i < index->num_entries; i++)
+        {
+          if (index->entries[i].end_frames >= frames)
+            {
+              expected = i;
+              break;
+            }
+        }
+      int first =
+        audio_region_index_find_first (
+          index, frames);
+      g_assert_cmpint (first, ==, expected);
+    }
+
+  /* changing a region marks the index dirty and
+   * it is rebuilt */
+  ArrangerObject * r_obj =
+    (ArrangerObject *) track->lanes[3]->regions[0];
+  r_obj->muted = false;
+  track_set_region_index_dirty (track);
+  tracklist_update_region_indices (
+    TRACKLIST, false);
+  index = track_get_region_index (track);
+  g_assert_cmpint (
+    index->num_entries, ==, NUM_LANES);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_fill_region_groups (void)
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+
+  Track * track = create_track_with_lanes ();
+
+  g_assert_cmpint (
+    track_processor_get_num_region_groups_needed (
+      track->processor), ==,
+    (NUM_LANES +
+       TRACK_PROCESSOR_LANES_PER_REGION_GROUP - 1) /
+    TRACK_PROCESSOR_LANES_PER_REGION_GROUP);
+
+  nframes_t nframes = AUDIO_ENGINE->block_length;
+  nframes_t local_offset = 13;
+  float all_l[nframes], all_r[nframes];
+  float sum_l[nframes], sum_r[nframes];
+
+  Position pos;
+  position_set_to_bar (&pos, 2);
+  for (int cycle = 0; cycle < 20; cycle++)
+    {
+      long g_start_frames =
+        pos.frames + cycle * (long) nframes;
+
+      /* fill everything at once */
+      for (nframes_t i = 0; i < nframes; i++)
+        {
+          all_l[i] = 1.f;
+          all_r[i] = 1.f;
+          sum_l[i] = 1.f;
+          sum_r[i] = 1.f;
+        }
+      audio_track_fill_bufs_from_clips (
+        track, all_l, all_r, g_start_frames,
+        local_offset, nframes - local_offset,
+        -1, 0);
+
+      /* fill each group separately */
+      for (int i = 0; i < NUM_GROUPS; i++)
+        {
+          audio_track_fill_bufs_from_clips (
+            track, sum_l, sum_r, g_start_frames,
+            local_offset, nframes - local_offset,
+            i, NUM_GROUPS);
+        }
+
+      /* frames are added to the existing ones
+       * after the local offset only */
+      for (nframes_t i = 0; i < local_offset; i++)
+        {
+          g_assert_cmpfloat (all_l[i], ==, 1.f);
+          g_assert_cmpfloat (sum_l[i], ==, 1.f);
+        }
+      for (nframes_t i = local_offset;
+           i < nframes; i++)
+        {
+          g_assert_cmpfloat_with_epsilon (
+            all_l[i], sum_l[i], 0.0001f);
+          g_assert_cmpfloat_with_epsilon (
+            all_r[i], sum_r[i], 0.0001f);
+        }
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/audio_region_index/"
+
+  g_test_add_func (
+    TEST_PREFIX "test index",
+    (GTestFunc) test_index);
+  g_test_add_func (
+    TEST_PREFIX "test fill region groups",
+    (GTestFunc) test_fill_region_groups);
+
+  return g_test_run ();
+}
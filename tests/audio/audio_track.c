@@ -86,7 +86,8 @@ test_fill_when_region_starts_on_loop_end ()
   position_set_to_bar (&pos, LOOP_BAR);
   position_add_frames (&pos, - nframes);
   audio_track_fill_stereo_ports_from_clip (
-    track, ports, pos.frames, (nframes_t) nframes);
+    track, ports, pos.frames, 0,
+    (nframes_t) nframes);
   for (int j = 0; j < nframes; j++)
     {
       g_assert_cmpfloat_with_epsilon (
@@ -99,7 +100,8 @@ test_fill_when_region_starts_on_loop_end ()
    * played */
   position_set_to_bar (&pos, LOOP_BAR);
   audio_track_fill_stereo_ports_from_clip (
-    track, ports, pos.frames, (nframes_t) nframes);
+    track, ports, pos.frames, 0,
+    (nframes_t) nframes);
   for (int j = 0; j < nframes; j++)
     {
       g_assert_true (
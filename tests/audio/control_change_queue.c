@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "audio/control_change_queue.h"
+#include "audio/master_track.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "zrythm.h"
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+static void
+test_push_and_pop (void)
+{
+  ControlChangeQueue * queue =
+    control_change_queue_new ();
+  Port * amp = P_MASTER_TRACK->channel->fader->amp;
+
+  /* fill the queue */
+  for (int i = 0; i < CONTROL_CHANGE_QUEUE_SIZE; i++)
+    {
+      g_assert_true (
+        control_change_queue_push (
+          queue, amp, (float) i, F_NOT_NORMALIZED,
+          F_NO_PUBLISH_EVENTS));
+    }
+  g_assert_false (
+    control_change_queue_push (
+      queue, amp, 0.f, F_NOT_NORMALIZED,
+      F_NO_PUBLISH_EVENTS));
+
+  /* changes come out in order */
+  ControlChange change;
+  for (int i = 0; i < CONTROL_CHANGE_QUEUE_SIZE; i++)
+    {
+      g_assert_true (
+        control_change_queue_pop (queue, &change));
+      g_assert_true (change.port == amp);
+      g_assert_cmpfloat (change.val, ==, (float) i);
+    }
+  g_assert_false (
+    control_change_queue_pop (queue, &change));
+
+  /* slots are reused */
+  g_assert_true (
+    control_change_queue_push (
+      queue, amp, 0.f, F_NOT_NORMALIZED,
+      F_NO_PUBLISH_EVENTS));
+  control_change_queue_clear (queue);
+  g_assert_false (
+    control_change_queue_pop (queue, &change));
+
+  control_change_queue_free (queue);
+}
+
+static void
+test_apply (void)
+{
+  ControlChangeQueue * queue =
+    control_change_queue_new ();
+  Port * amp = P_MASTER_TRACK->channel->fader->amp;
+  Port * balance =
+    P_MASTER_TRACK->channel->fader->balance;
+
+  control_change_queue_push (
+    queue, amp, 0.5f, F_NOT_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
+  control_change_queue_push (
+    queue, balance, 0.2f, F_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
+  control_change_queue_push (
+    queue, amp, 0.7f, F_NOT_NORMALIZED,
+    F_NO_PUBLISH_EVENTS);
+  control_change_queue_apply (queue);
+
+  /* last value wins */
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (amp, false), 0.7f,
+    0.0001f);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (balance, true), 0.2f,
+    0.0001f);
+
+  control_change_queue_free (queue);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  test_helper_zrythm_init ();
+
+#define TEST_PREFIX "/audio/control_change_queue/"
+
+  g_test_add_func (
+    TEST_PREFIX "test push and pop",
+    (GTestFunc) test_push_and_pop);
+  g_test_add_func (
+    TEST_PREFIX "test apply",
+    (GTestFunc) test_apply);
+
+  return g_test_run ();
+}
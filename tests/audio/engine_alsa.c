@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "audio/engine.h"
+#include "audio/engine_alsa.h"
+#include "audio/transport.h"
+#include "project.h"
+#include "settings/settings.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+#ifdef HAVE_ALSA
+
+#include <alsa/asoundlib.h>
+
+static bool
+device_exists (
+  const char * device)
+{
+  snd_pcm_t * handle;
+  int err =
+    snd_pcm_open (
+      &handle, device, SND_PCM_STREAM_PLAYBACK,
+      SND_PCM_NONBLOCK);
+  if (err < 0)
+    return false;
+
+  snd_pcm_close (handle);
+  return true;
+}
+
+/**
+ * Runs the ALSA backend on the given device for a
+ * while and checks that the engine was processed.
+ */
+static void
+run_on_device (
+  const char * device)
+{
+  test_helper_zrythm_init ();
+
+  if (!device_exists (device))
+    {
+      char * msg =
+        g_strdup_printf (
+          "ALSA device %s not available", device);
+      g_test_skip (msg);
+      g_free (msg);
+      test_helper_zrythm_cleanup ();
+      return;
+    }
+
+  /* stop dummy audio engine processing so only
+   * the ALSA thread processes */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  char * prev_device =
+    g_settings_get_string (
+      S_P_GENERAL_ENGINE, "alsa-audio-device-name");
+  int prev_buf_size =
+    g_settings_get_enum (
+      S_P_GENERAL_ENGINE, "buffer-size");
+  int prev_samplerate =
+    g_settings_get_enum (
+      S_P_GENERAL_ENGINE, "sample-rate");
+
+  /* use the settings the dummy engine was set up
+   * with so the buffers stay valid */
+  g_settings_set_string (
+    S_P_GENERAL_ENGINE, "alsa-audio-device-name",
+    device);
+  g_settings_set_enum (
+    S_P_GENERAL_ENGINE, "buffer-size",
+    AUDIO_ENGINE_BUFFER_SIZE_256);
+  g_settings_set_enum (
+    S_P_GENERAL_ENGINE, "sample-rate",
+    AUDIO_ENGINE_SAMPLERATE_44100);
+
+  int ret = engine_alsa_setup (AUDIO_ENGINE);
+  g_assert_cmpint (ret, ==, 0);
+  g_assert_nonnull (AUDIO_ENGINE->playback_handle);
+  g_assert_cmpuint (
+    AUDIO_ENGINE->block_length, ==, 256);
+  g_assert_cmpuint (
+    AUDIO_ENGINE->sample_rate, ==, 44100);
+
+  /* deactivating without a running thread does
+   * not join */
+  g_assert_false (AUDIO_ENGINE->alsa_thread_started);
+  engine_alsa_activate (AUDIO_ENGINE, false);
+  g_assert_false (AUDIO_ENGINE->alsa_thread_started);
+
+  /* the playhead moves while the ALSA thread
+   * processes the engine */
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+  long start_frames = PLAYHEAD->frames;
+  engine_alsa_activate (AUDIO_ENGINE, true);
+  g_assert_true (AUDIO_ENGINE->alsa_thread_started);
+  g_usleep (500000);
+  engine_alsa_activate (AUDIO_ENGINE, false);
+  g_assert_false (AUDIO_ENGINE->alsa_thread_started);
+  g_assert_cmpint (
+    PLAYHEAD->frames, >, start_frames);
+  TRANSPORT->play_state = PLAYSTATE_PAUSED;
+
+  /* deactivating twice is harmless */
+  engine_alsa_activate (AUDIO_ENGINE, false);
+
+  engine_alsa_tear_down (AUDIO_ENGINE);
+  g_assert_null (AUDIO_ENGINE->playback_handle);
+  g_assert_null (AUDIO_ENGINE->capture_handle);
+
+  g_settings_set_string (
+    S_P_GENERAL_ENGINE, "alsa-audio-device-name",
+    prev_device);
+  g_settings_set_enum (
+    S_P_GENERAL_ENGINE, "buffer-size",
+    prev_buf_size);
+  g_settings_set_enum (
+    S_P_GENERAL_ENGINE, "sample-rate",
+    prev_samplerate);
+  g_free (prev_device);
+
+  test_helper_zrythm_cleanup ();
+}
+#endif
+
+static void
+test_null_device (void)
+{
+#ifdef HAVE_ALSA
+  run_on_device ("null");
+#else
+  g_test_skip ("ALSA not available");
+#endif
+}
+
+static void
+test_loopback_device (void)
+{
+#ifdef HAVE_ALSA
+  /* requires the snd-aloop kernel module */
+  run_on_device ("hw:Loopback");
+#else
+  g_test_skip ("ALSA not available");
+#endif
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/engine_alsa/"
+
+  g_test_add_func (
+    TEST_PREFIX "test null device",
+    (GTestFunc) test_null_device);
+  g_test_add_func (
+    TEST_PREFIX "test loopback device",
+    (GTestFunc) test_loopback_device);
+
+  return g_test_run ();
+}
@@ -20,6 +20,9 @@
 #include "zrythm-test-config.h"
 
 #include "actions/tracklist_selections.h"
+#include "audio/automation_region.h"
+#include "audio/balance_control.h"
+#include "audio/control_port.h"
 #include "audio/fader.h"
 #include "audio/midi_event.h"
 #include "audio/router.h"
@@ -90,6 +93,88 @@ test_fader_process ()
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_automated_gain_ramp (void)
+{
+  test_helper_zrythm_init ();
+
+  Fader * fader = P_MASTER_TRACK->channel->fader;
+  AutomationTrack * at =
+    channel_get_automation_track (
+      P_MASTER_TRACK->channel,
+      PORT_FLAG_CHANNEL_FADER);
+  g_assert_nonnull (at);
+
+  /* ramp the fader from silence to full over
+   * the first bar */
+  Position start_pos, end_pos;
+  position_set_to_bar (&start_pos, 1);
+  position_set_to_bar (&end_pos, 2);
+  ZRegion * r =
+    automation_region_new (
+      &start_pos, &end_pos, P_MASTER_TRACK->pos,
+      at->index, 0);
+  track_add_region (
+    P_MASTER_TRACK, r, at, 0, 1, 0);
+  AutomationPoint * ap =
+    automation_point_new_float (
+      0.f, 0.f, &start_pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+  ap =
+    automation_point_new_float (
+      1.f, 1.f, &end_pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+
+  nframes_t nframes = AUDIO_ENGINE->block_length;
+  nframes_t granularity =
+    AUDIO_ENGINE->automation_granularity;
+  g_assert_cmpuint (granularity, <, nframes);
+  long g_start_frames = end_pos.frames / 2;
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      fader->stereo_in->l->buf[i] = 1.f;
+      fader->stereo_in->r->buf[i] = 1.f;
+      fader->stereo_out->l->buf[i] = 0.f;
+      fader->stereo_out->r->buf[i] = 0.f;
+    }
+
+  /* process as if the amp was read from
+   * automation this cycle */
+  fader->amp->automation_read = true;
+  fader_process (
+    fader, g_start_frames, 0, nframes);
+  fader->amp->automation_read = false;
+
+  float calc_l, calc_r;
+  balance_control_get_calc_lr (
+    BALANCE_CONTROL_ALGORITHM_LINEAR,
+    fader->balance->control, &calc_l, &calc_r);
+
+  /* the gain must change within the cycle and
+   * match the automation at each sub-block
+   * boundary */
+  float * out = fader->stereo_out->l->buf;
+  g_assert_cmpfloat (out[nframes - 1], >, out[0]);
+  for (nframes_t i = 1; i < nframes; i++)
+    {
+      g_assert_cmpfloat (out[i], >=, out[i - 1]);
+    }
+  for (nframes_t i = 0; i < nframes;
+       i += granularity)
+    {
+      float expected =
+        control_port_get_automation_val_at_frames (
+          fader->amp, g_start_frames + (long) i) *
+        calc_l;
+      g_assert_cmpfloat_with_epsilon (
+        out[i], expected, 0.0001f);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -100,6 +185,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test fader process",
     (GTestFunc) test_fader_process);
+  g_test_add_func (
+    TEST_PREFIX "test automated gain ramp",
+    (GTestFunc) test_automated_gain_ramp);
 
   return g_test_run ();
 }
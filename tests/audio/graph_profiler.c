@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <string.h>
+
+#include "audio/graph.h"
+#include "audio/graph_node.h"
+#include "audio/graph_profiler.h"
+#include "audio/graph_thread.h"
+#include "audio/router.h"
+#include "project.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+#define TRACE_PREFIX "{\"traceEvents\":["
+#define TRACE_SUFFIX "\n],\"displayTimeUnit\":\"ns\"}\n"
+
+static void
+record_runs (
+  GraphNodeStats * stats,
+  int              num_runs,
+  gint64           duration_ns)
+{
+  for (int i = 0; i < num_runs; i++)
+    {
+      graph_profiler_record_node (
+        stats, NULL, 0, 1000, 1000 + duration_ns);
+    }
+}
+
+static void
+test_percentiles (void)
+{
+  GraphNodeStats stats;
+  memset (&stats, 0, sizeof (GraphNodeStats));
+
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 99.0), ==, 0);
+
+  /* 90 fast runs, 9 slow runs and 1 very slow
+   * run */
+  record_runs (&stats, 90, 3000);
+  record_runs (&stats, 9, 100000);
+  record_runs (&stats, 1, 5000000);
+  g_assert_cmpuint (stats.num_runs, ==, 100);
+  g_assert_cmpint (stats.max_ns, ==, 5000000);
+  g_assert_cmpint (stats.last_ns, ==, 5000000);
+  g_assert_cmpuint (stats.hist[2], ==, 90);
+  g_assert_cmpuint (stats.hist[7], ==, 9);
+  g_assert_cmpuint (stats.hist[13], ==, 1);
+
+  /* percentiles are the upper bounds of the
+   * bins, capped at the worst time */
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 50.0), ==, 4000);
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 90.0), ==, 4000);
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 95.0), ==, 128000);
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 99.0), ==, 128000);
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 100.0), ==, 5000000);
+
+  /* durations above the last bin */
+  record_runs (
+    &stats, 1000, G_GINT64_CONSTANT (600000000000));
+  g_assert_cmpuint (
+    stats.hist[GRAPH_PROFILER_NUM_HIST_BINS - 1],
+    ==, 1000);
+  g_assert_cmpint (
+    graph_profiler_get_percentile_ns (
+      &stats, 99.0), ==, stats.max_ns);
+}
+
+static char *
+export_trace (
+  Graph *      graph,
+  const char * tmp_dir)
+{
+  char * filepath =
+    g_build_filename (tmp_dir, "trace.json", NULL);
+  GError * err = NULL;
+  bool ret =
+    graph_profiler_export_chrome_trace (
+      graph, filepath, &err);
+  g_assert_no_error (err);
+  g_assert_true (ret);
+
+  char * content = NULL;
+  g_file_get_contents (
+    filepath, &content, NULL, &err);
+  g_assert_no_error (err);
+  g_free (filepath);
+
+  return content;
+}
+
+static int
+count_occurrences (
+  const char * str,
+  const char * needle)
+{
+  int count = 0;
+  const char * cur = str;
+  while ((cur = strstr (cur, needle)))
+    {
+      count++;
+      cur += strlen (needle);
+    }
+  return count;
+}
+
+static void
+test_reset_and_trace (void)
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so the
+   * stats are only written here */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  Graph * graph = ROUTER->graph;
+  g_assert_nonnull (graph);
+  g_assert_nonnull (graph->main_thread);
+
+  /* enabling requests a reset that is performed
+   * by the DSP side */
+  graph_profiler_set_enabled (graph, true);
+  g_assert_true (
+    g_atomic_int_get (
+      &graph->profiling_reset_requested));
+  graph_profiler_reset_if_requested (graph);
+  g_assert_false (
+    g_atomic_int_get (
+      &graph->profiling_reset_requested));
+
+  GraphNode * node = graph->graph_nodes[0];
+  GraphThreadStats * thread_stats =
+    &graph->main_thread->stats;
+  gint64 start_ns = graph->profiling_start_ns;
+  for (int i = 0; i < 3; i++)
+    {
+      start_ns += 10000;
+      graph_profiler_record_node (
+        &node->stats, thread_stats, node->id,
+        start_ns, start_ns + 2000);
+    }
+  g_assert_cmpuint (node->stats.num_runs, ==, 3);
+
+  char * tmp_dir =
+    g_dir_make_tmp ("zrythm_dsp_trace_XXXXXX", NULL);
+  char * content = export_trace (graph, tmp_dir);
+  g_assert_true (
+    g_str_has_prefix (content, TRACE_PREFIX));
+  g_assert_true (
+    g_str_has_suffix (content, TRACE_SUFFIX));
+  g_assert_cmpint (
+    count_occurrences (content, "\"ph\":\"X\""),
+    ==, 3);
+  g_assert_cmpint (
+    count_occurrences (content, "\"dur\":2.000}"),
+    ==, 3);
+  g_assert_cmpint (
+    count_occurrences (content, "},\n{"), ==, 2);
+  char * name = graph_node_get_name (node);
+  char * escaped = g_strescape (name, NULL);
+  char * name_str =
+    g_strdup_printf ("\"name\":\"%s\"", escaped);
+  g_assert_cmpint (
+    count_occurrences (content, name_str), ==, 3);
+  g_free (name_str);
+  g_free (escaped);
+  g_free (name);
+  g_free (content);
+
+  /* the reset only happens on the DSP side */
+  graph_profiler_reset (graph);
+  g_assert_cmpuint (node->stats.num_runs, ==, 3);
+  graph_profiler_reset_if_requested (graph);
+  g_assert_cmpuint (node->stats.num_runs, ==, 0);
+  g_assert_cmpuint (thread_stats->trace_head, ==, 0);
+
+  content = export_trace (graph, tmp_dir);
+  g_assert_cmpstr (
+    content, ==, TRACE_PREFIX TRACE_SUFFIX);
+  g_free (content);
+
+  io_rmdir (tmp_dir, true);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/graph_profiler/"
+
+  g_test_add_func (
+    TEST_PREFIX "test percentiles",
+    (GTestFunc) test_percentiles);
+  g_test_add_func (
+    TEST_PREFIX "test reset and trace",
+    (GTestFunc) test_reset_and_trace);
+
+  return g_test_run ();
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "audio/midi_file.h"
+#include "audio/midi_region.h"
+#include "audio/region.h"
+#include "audio/transport.h"
+#include "gui/backend/arranger_object.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+static void
+test_parse ()
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "1_track_with_data.mid", NULL);
+  MidiFile * mf =
+    midi_file_new (
+      filepath, transport_get_ppqn (TRANSPORT));
+  g_assert_nonnull (mf);
+
+  /* find the track with the notes */
+  MidiFileTrack * track = NULL;
+  for (int i = 0; i < mf->num_tracks; i++)
+    {
+      if (mf->tracks[i].num_notes > 0)
+        {
+          g_assert_null (track);
+          track = &mf->tracks[i];
+        }
+    }
+  g_assert_nonnull (track);
+  g_assert_cmpint (track->num_notes, ==, 3);
+  for (int i = 0; i < track->num_notes; i++)
+    {
+      MidiFileNote * note = &track->notes[i];
+      g_assert_cmpfloat (
+        note->end_ticks, >, note->start_ticks);
+      if (i > 0)
+        {
+          g_assert_cmpfloat (
+            note->start_ticks, >=,
+            track->notes[i - 1].start_ticks);
+        }
+    }
+
+  /* create a region from it */
+  Position pos;
+  position_init (&pos);
+  ZRegion * r =
+    midi_region_new_from_midi_file_track (
+      &pos, track, 0, 0, 0);
+  g_assert_nonnull (r);
+  g_assert_cmpint (r->num_midi_notes, ==, 3);
+  for (int i = 0; i < r->num_midi_notes; i++)
+    {
+      g_assert_cmpint (
+        r->midi_notes[i]->pos, ==, i);
+      g_assert_cmpint (
+        r->midi_notes[i]->val, ==,
+        track->notes[i].pitch);
+    }
+  arranger_object_free ((ArrangerObject *) r);
+
+  midi_file_free (mf);
+  g_free (filepath);
+}
+
+static void
+test_num_tracks ()
+{
+  const int max_files = 20;
+
+  char ** midi_files =
+    io_get_files_in_dir_ending_in (
+      MIDILIB_TEST_MIDI_FILES_PATH,
+      F_RECURSIVE, ".MID");
+  g_assert_nonnull (midi_files);
+
+  char * midi_file;
+  int iter = 0;
+  while ((midi_file = midi_files[iter++]))
+    {
+      MidiFile * mf =
+        midi_file_new (
+          midi_file,
+          transport_get_ppqn (TRANSPORT));
+      g_assert_nonnull (mf);
+      g_assert_cmpint (
+        mf->num_tracks, ==,
+        midi_file_get_num_tracks (midi_file));
+      midi_file_free (mf);
+
+      if (iter == max_files)
+        break;
+    }
+  g_strfreev (midi_files);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  test_helper_zrythm_init ();
+
+#define TEST_PREFIX "/audio/midi_file/"
+
+  g_test_add_func (
+    TEST_PREFIX "test parse",
+    (GTestFunc) test_parse);
+  g_test_add_func (
+    TEST_PREFIX "test num tracks",
+    (GTestFunc) test_num_tracks);
+
+  return g_test_run ();
+}
@@ -63,6 +63,84 @@ test_midi_mappping ()
       MIDI_MAPPINGS->mappings[0].dest);
 }
 
+static void
+test_apply_from_events ()
+{
+  test_helper_zrythm_init ();
+
+  Port * amp = P_MASTER_TRACK->channel->fader->amp;
+  Port * balance =
+    P_MASTER_TRACK->channel->fader->balance;
+
+  /* 2 ports on the same key and another key on
+   * one of them */
+  midi_byte_t buf[3] = { 0xB0, 0x07, 0 };
+  midi_mappings_bind (
+    MIDI_MAPPINGS, buf, NULL, amp,
+    F_NO_PUBLISH_EVENTS);
+  midi_mappings_bind (
+    MIDI_MAPPINGS, buf, NULL, balance,
+    F_NO_PUBLISH_EVENTS);
+  buf[1] = 0x08;
+  midi_mappings_bind (
+    MIDI_MAPPINGS, buf, NULL, balance,
+    F_NO_PUBLISH_EVENTS);
+  g_assert_cmpint (
+    MIDI_MAPPINGS->table->num_targets, ==, 3);
+
+  MidiEvents * events = midi_events_new (NULL);
+  midi_events_add_control_change (
+    events, 1, 0x07, 0, 0, F_NOT_QUEUED);
+  midi_events_add_control_change (
+    events, 1, 0x07, 127, 1, F_NOT_QUEUED);
+  midi_events_add_control_change (
+    events, 1, 0x08, 64, 2, F_NOT_QUEUED);
+  midi_mappings_apply_from_events (
+    MIDI_MAPPINGS, events);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (amp, true), 1.f,
+    0.01f);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (balance, true),
+    64.f / 127.f, 0.01f);
+
+  /* the last event wins for ports mapped to
+   * several keys */
+  midi_events_clear (events, F_NOT_QUEUED);
+  midi_events_add_control_change (
+    events, 1, 0x08, 0, 0, F_NOT_QUEUED);
+  midi_events_add_control_change (
+    events, 1, 0x07, 127, 1, F_NOT_QUEUED);
+  midi_mappings_apply_from_events (
+    MIDI_MAPPINGS, events);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (balance, true), 1.f,
+    0.01f);
+
+  /* disabled mappings are skipped */
+  midi_mapping_set_enabled (
+    &MIDI_MAPPINGS->mappings[0], false);
+  midi_events_clear (events, F_NOT_QUEUED);
+  midi_events_add_control_change (
+    events, 1, 0x07, 0, 0, F_NOT_QUEUED);
+  midi_mappings_apply_from_events (
+    MIDI_MAPPINGS, events);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (amp, true), 1.f,
+    0.01f);
+  g_assert_cmpfloat_with_epsilon (
+    port_get_control_value (balance, true), 0.f,
+    0.01f);
+
+  /* unbinding updates the table */
+  midi_mappings_unbind (
+    MIDI_MAPPINGS, 2, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpint (
+    MIDI_MAPPINGS->table->num_targets, ==, 2);
+
+  midi_events_free (events);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -75,6 +153,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test midi mapping",
     (GTestFunc) test_midi_mappping);
+  g_test_add_func (
+    TEST_PREFIX "test apply from events",
+    (GTestFunc) test_apply_from_events);
 
   return g_test_run ();
 }
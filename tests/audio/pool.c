@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <string.h>
+
+#include "actions/tracklist_selections.h"
+#include "audio/audio_region.h"
+#include "audio/clip.h"
+#include "audio/pool.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+/**
+ * Creates an audio track with a region from
+ * test.wav and returns the region's clip.
+ */
+static AudioClip *
+create_audio_track (void)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file =
+    supported_file_new_from_path (filepath);
+  int track_pos = TRACKLIST->num_tracks;
+  UndoableAction * ua =
+    tracklist_selections_action_new_create (
+      TRACK_TYPE_AUDIO, NULL, file, track_pos,
+      PLAYHEAD, 1);
+  undo_manager_perform (UNDO_MANAGER, ua);
+  g_free (filepath);
+
+  Track * track = TRACKLIST->tracks[track_pos];
+  g_assert_cmpint (
+    track->lanes[0]->num_regions, ==, 1);
+  ZRegion * r = track->lanes[0]->regions[0];
+  AudioClip * clip =
+    audio_pool_get_clip (AUDIO_POOL, r->pool_id);
+  g_assert_nonnull (clip);
+
+  return clip;
+}
+
+static void
+test_unload_unused_clips (void)
+{
+  test_helper_zrythm_init ();
+
+  AudioClip * clip = create_audio_track ();
+  Track * track =
+    TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  g_assert_cmpint (clip->num_refs, ==, 1);
+
+  long num_frames = clip->num_frames;
+  channels_t channels = clip->channels;
+  g_assert_cmpint (num_frames, >, 0);
+  size_t num_samples =
+    (size_t) num_frames * (size_t) channels;
+  float * frames = g_new (float, num_samples);
+  memcpy (
+    frames, clip->frames,
+    num_samples * sizeof (float));
+
+  /* don't keep unused clips in memory */
+  AUDIO_POOL->memory_budget = 0;
+
+  /* delete the track */
+  track_select (
+    track, F_SELECT, F_EXCLUSIVE,
+    F_NO_PUBLISH_EVENTS);
+  UndoableAction * ua =
+    tracklist_selections_action_new_delete (
+      TRACKLIST_SELECTIONS);
+  undo_manager_perform (UNDO_MANAGER, ua);
+
+  /* the clip is only in the undo history and
+   * unloaded */
+  g_assert_cmpint (clip->num_refs, ==, 0);
+  g_assert_cmpint (clip->num_frames, ==, 0);
+  g_assert_null (clip->frames);
+  g_assert_null (clip->ch_frames[0]);
+
+  /* undo and check that it was reloaded */
+  undo_manager_undo (UNDO_MANAGER);
+  g_assert_cmpint (clip->num_refs, ==, 1);
+  g_assert_cmpint (clip->num_frames, ==, num_frames);
+  g_assert_cmpint (clip->channels, ==, channels);
+  for (size_t i = 0; i < num_samples; i++)
+    {
+      g_assert_cmpfloat_with_epsilon (
+        clip->frames[i], frames[i], 0.0001f);
+    }
+  g_assert_nonnull (clip->ch_frames[0]);
+
+  /* unused clips are kept within the budget */
+  AUDIO_POOL->memory_budget =
+    AUDIO_POOL_DEFAULT_MEMORY_BUDGET * 1024 * 1024;
+  undo_manager_redo (UNDO_MANAGER);
+  g_assert_cmpint (clip->num_refs, ==, 0);
+  g_assert_cmpint (clip->num_frames, ==, num_frames);
+  g_assert_nonnull (clip->frames);
+
+  g_free (frames);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_remove_orphan_files (void)
+{
+  test_helper_zrythm_init ();
+
+  create_audio_track ();
+
+  char * pool_dir =
+    project_get_path (
+      PROJECT, PROJECT_PATH_POOL, false);
+  io_mkdir (pool_dir);
+  char * orphan_path =
+    g_build_filename (
+      pool_dir, "orphan.wav", NULL);
+  g_assert_true (
+    g_file_set_contents (
+      orphan_path, "RIFF", -1, NULL));
+
+  test_project_save_and_reload ();
+
+  /* the orphan is removed and the clip file is
+   * kept */
+  g_assert_false (
+    g_file_test (orphan_path, G_FILE_TEST_EXISTS));
+  g_assert_cmpint (AUDIO_POOL->num_clips, ==, 1);
+  char * clip_path =
+    audio_clip_get_path_in_pool (
+      AUDIO_POOL->clips[0]);
+  g_assert_true (
+    g_file_test (clip_path, G_FILE_TEST_EXISTS));
+  g_assert_nonnull (AUDIO_POOL->clips[0]->frames);
+
+  g_free (clip_path);
+  g_free (orphan_path);
+  g_free (pool_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/pool/"
+
+  g_test_add_func (
+    TEST_PREFIX "test unload unused clips",
+    (GTestFunc) test_unload_unused_clips);
+  g_test_add_func (
+    TEST_PREFIX "test remove orphan files",
+    (GTestFunc) test_remove_orphan_files);
+
+  return g_test_run ();
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/sample_stream.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <sndfile.h>
+
+/**
+ * Reads the whole stream in blocks and returns
+ * the number of frames read.
+ */
+static long
+read_all (
+  SampleStream * stream,
+  float *        max_abs)
+{
+  float l[256], r[256];
+  long total = 0;
+  *max_abs = 0.f;
+  while (!sample_stream_is_finished (stream))
+    {
+      memset (l, 0, sizeof (l));
+      memset (r, 0, sizeof (r));
+      nframes_t read =
+        sample_stream_read (stream, l, r, 256, 1.f);
+      for (nframes_t i = 0; i < read; i++)
+        {
+          *max_abs = MAX (*max_abs, fabsf (l[i]));
+          *max_abs = MAX (*max_abs, fabsf (r[i]));
+        }
+      /* frames past the ones read must be
+       * untouched */
+      if (read < 256)
+        {
+          g_assert_cmpfloat (l[read], ==, 0.f);
+          g_usleep (100);
+        }
+      total += (long) read;
+    }
+  return total;
+}
+
+static void
+test_stream (
+  bool resample)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+
+  SF_INFO info;
+  memset (&info, 0, sizeof (info));
+  SNDFILE * sndfile =
+    sf_open (filepath, SFM_READ, &info);
+  g_assert_nonnull (sndfile);
+  sf_close (sndfile);
+
+  sample_rate_t samplerate =
+    resample ?
+      (sample_rate_t) info.samplerate * 2 :
+      (sample_rate_t) info.samplerate;
+
+  GError * err = NULL;
+  SampleStream * stream =
+    sample_stream_new (
+      filepath, samplerate, 4096, &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (stream);
+
+  /* the head is available immediately */
+  g_assert_cmpuint (
+    zix_ring_read_space (stream->ring), >=,
+    MIN (4096, (uint32_t) info.frames) *
+      2 * sizeof (float));
+
+  float max_abs;
+  long total = read_all (stream, &max_abs);
+  g_assert_cmpfloat (max_abs, >, 0.f);
+  if (resample)
+    {
+      g_assert_cmpint (
+        labs (total - (long) info.frames * 2), <,
+        256);
+    }
+  else
+    {
+      g_assert_cmpint (
+        total, ==, (long) info.frames);
+    }
+
+  sample_stream_release (stream);
+  g_free (filepath);
+}
+
+static void
+test_stream_native_rate (void)
+{
+  test_stream (false);
+}
+
+static void
+test_stream_resampled (void)
+{
+  test_stream (true);
+}
+
+static void
+test_invalid_file (void)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "1_track_with_data.mid", NULL);
+
+  GError * err = NULL;
+  SampleStream * stream =
+    sample_stream_new (
+      filepath, 44100, 4096, &err);
+  g_assert_null (stream);
+  g_assert_nonnull (err);
+  g_error_free (err);
+  g_free (filepath);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  test_helper_zrythm_init ();
+
+#define TEST_PREFIX "/audio/sample_stream/"
+
+  g_test_add_func (
+    TEST_PREFIX "test stream native rate",
+    (GTestFunc) test_stream_native_rate);
+  g_test_add_func (
+    TEST_PREFIX "test stream resampled",
+    (GTestFunc) test_stream_resampled);
+  g_test_add_func (
+    TEST_PREFIX "test invalid file",
+    (GTestFunc) test_invalid_file);
+
+  return g_test_run ();
+}
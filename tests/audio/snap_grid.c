@@ -21,8 +21,13 @@
 
 #include <math.h>
 
+#include "actions/tracklist_selections.h"
+#include "actions/undo_manager.h"
 #include "audio/engine_dummy.h"
 #include "audio/audio_track.h"
+#include "audio/midi_region.h"
+#include "audio/quantize_options.h"
+#include "audio/snap_grid.h"
 #include "project.h"
 #include "utils/flags.h"
 #include "zrythm.h"
@@ -33,30 +38,171 @@
 #include <locale.h>
 
 static void
-test_update_snap_points ()
+test_grid_points ()
 {
   test_helper_zrythm_init ();
 
   SnapGrid sg;
-  gint64 before, after;
-
   snap_grid_init (
     &sg, SNAP_GRID_TYPE_TIMELINE,
     NOTE_LENGTH_1_128);
+  double ticks =
+    (double) snap_grid_get_snap_ticks (&sg);
+
+  Position pos, prev_pos, next_pos;
+  position_from_ticks (&pos, ticks * 3.5);
+  g_assert_true (
+    snap_grid_get_prev_grid_point (
+      &sg, &pos, &prev_pos));
+  snap_grid_get_next_grid_point (
+    &sg, &pos, &next_pos);
+  g_assert_cmpfloat_with_epsilon (
+    prev_pos.total_ticks, ticks * 3, 0.0001);
+  g_assert_cmpfloat_with_epsilon (
+    next_pos.total_ticks, ticks * 4, 0.0001);
+
+  /* points on the grid */
+  position_from_ticks (&pos, ticks * 4);
+  snap_grid_get_prev_grid_point (
+    &sg, &pos, &prev_pos);
+  snap_grid_get_next_grid_point (
+    &sg, &pos, &next_pos);
+  g_assert_cmpfloat_with_epsilon (
+    prev_pos.total_ticks, ticks * 4, 0.0001);
+  g_assert_cmpfloat_with_epsilon (
+    next_pos.total_ticks, ticks * 5, 0.0001);
+  snap_grid_get_nearby_snap_point (
+    &sg, &pos, true, &prev_pos);
+  g_assert_cmpfloat_with_epsilon (
+    prev_pos.total_ticks, ticks * 3, 0.0001);
+
+  /* far into the song */
+  position_set_to_bar (&pos, 100000);
+  position_add_ticks (&pos, 1.0);
+  snap_grid_get_prev_grid_point (
+    &sg, &pos, &prev_pos);
+  g_assert_cmpfloat_with_epsilon (
+    prev_pos.total_ticks, pos.total_ticks - 1.0,
+    0.0001);
+
+  /* snap to the closest point */
+  position_from_ticks (&pos, ticks * 7.75);
+  position_snap_simple (&pos, &sg);
+  g_assert_cmpfloat_with_epsilon (
+    pos.total_ticks, ticks * 8, 0.0001);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_quantize_swing ()
+{
+  test_helper_zrythm_init ();
+
+  QuantizeOptions qo;
+  quantize_options_init (&qo, NOTE_LENGTH_1_16);
+  qo.swing = 50.f;
+  double ticks =
+    (double)
+    snap_grid_get_ticks_from_length_and_type (
+      NOTE_LENGTH_1_16, NOTE_TYPE_NORMAL);
+  double swing_offset = ticks / 4.0;
+
+  /* odd points are delayed by the swing */
+  Position pos;
+  position_from_ticks (
+    &pos, ticks + swing_offset + 1.0);
+  double diff =
+    quantize_options_quantize_position (&qo, &pos);
+  g_assert_cmpfloat_with_epsilon (
+    diff, -1.0, 0.0001);
+  g_assert_cmpfloat_with_epsilon (
+    pos.total_ticks, ticks + swing_offset, 0.0001);
+
+  /* even points are not, and the offset does not
+   * accumulate */
+  position_set_to_bar (&pos, 500);
+  double even_ticks = pos.total_ticks;
+  position_add_ticks (&pos, 2.0);
+  quantize_options_quantize_position (&qo, &pos);
+  g_assert_cmpfloat_with_epsilon (
+    pos.total_ticks, even_ticks, 0.0001);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_object_index ()
+{
+  test_helper_zrythm_init ();
+
+  UndoableAction * ua =
+    tracklist_selections_action_new_create_midi (
+      TRACKLIST->num_tracks, 1);
+  undo_manager_perform (UNDO_MANAGER, ua);
+  Track * track =
+    TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+
+  /* add regions out of order */
+  int bars[][2] = { { 20, 24 }, { 3, 5 }, { 9, 10 } };
+  for (int i = 0; i < 3; i++)
+    {
+      Position p1, p2;
+      position_set_to_bar (&p1, bars[i][0]);
+      position_set_to_bar (&p2, bars[i][1]);
+      ZRegion * r =
+        midi_region_new (
+          &p1, &p2, track->pos, 0, i);
+      track_add_region (
+        track, r, NULL, 0, F_GEN_NAME,
+        F_NO_PUBLISH_EVENTS);
+    }
 
-#define TEST_WITH_MAX_BARS(x) \
-  before = g_get_monotonic_time (); \
-  snap_grid_update_snap_points ( \
-    &sg, x); \
-  after = g_get_monotonic_time (); \
-  g_message ("time %ld", after - before)
+  SnapObjectIndex index = { 0 };
+  snap_object_index_update (&index, track);
+  g_assert_cmpint (index.num_ticks, ==, 6);
 
-  TEST_WITH_MAX_BARS (100);
-  TEST_WITH_MAX_BARS (1000);
-#if 0
-  TEST_WITH_MAX_BARS (10000);
-  TEST_WITH_MAX_BARS (100000);
-#endif
+  Position pos, bar_pos, ret_pos;
+  position_set_to_bar (&pos, 8);
+  g_assert_true (
+    snap_object_index_get_prev (
+      &index, &pos, &ret_pos));
+  position_set_to_bar (&bar_pos, 5);
+  g_assert_cmpfloat_with_epsilon (
+    ret_pos.total_ticks, bar_pos.total_ticks,
+    0.0001);
+  g_assert_true (
+    snap_object_index_get_next (
+      &index, &pos, &ret_pos));
+  position_set_to_bar (&bar_pos, 9);
+  g_assert_cmpfloat_with_epsilon (
+    ret_pos.total_ticks, bar_pos.total_ticks,
+    0.0001);
+
+  position_set_to_bar (&pos, 2);
+  g_assert_false (
+    snap_object_index_get_prev (
+      &index, &pos, &ret_pos));
+  position_set_to_bar (&pos, 30);
+  g_assert_false (
+    snap_object_index_get_next (
+      &index, &pos, &ret_pos));
+
+  /* snap to events only */
+  SnapGrid sg;
+  snap_grid_init (
+    &sg, SNAP_GRID_TYPE_TIMELINE,
+    NOTE_LENGTH_1_1);
+  sg.snap_to_grid = false;
+  sg.snap_to_events = true;
+  position_set_to_bar (&pos, 10);
+  position_add_ticks (&pos, 20.0);
+  position_snap (NULL, &pos, &index, NULL, &sg);
+  position_set_to_bar (&bar_pos, 10);
+  g_assert_cmpfloat_with_epsilon (
+    pos.total_ticks, bar_pos.total_ticks, 0.0001);
+
+  snap_object_index_clear (&index, true);
 
   test_helper_zrythm_cleanup ();
 }
@@ -69,8 +215,14 @@ main (int argc, char *argv[])
 #define TEST_PREFIX "/audio/snap grid/"
 
   g_test_add_func (
-    TEST_PREFIX "test update snap points",
-    (GTestFunc) test_update_snap_points);
+    TEST_PREFIX "test grid points",
+    (GTestFunc) test_grid_points);
+  g_test_add_func (
+    TEST_PREFIX "test quantize swing",
+    (GTestFunc) test_quantize_swing);
+  g_test_add_func (
+    TEST_PREFIX "test object index",
+    (GTestFunc) test_object_index);
 
   return g_test_run ();
 }
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <stdlib.h>
+
+#include "actions/tracklist_selections.h"
+#include "audio/audio_region.h"
+#include "audio/audio_track.h"
+#include "audio/clip.h"
+#include "audio/pool.h"
+#include "audio/stretch_cache.h"
+#include "audio/stretcher.h"
+#include "audio/tempo_track.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+/**
+ * Creates an audio track with a region from
+ * test.wav.
+ */
+static Track *
+create_audio_track (void)
+{
+  char * filepath =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file =
+    supported_file_new_from_path (filepath);
+  int track_pos = TRACKLIST->num_tracks;
+  UndoableAction * ua =
+    tracklist_selections_action_new_create (
+      TRACK_TYPE_AUDIO, NULL, file, track_pos,
+      PLAYHEAD, 1);
+  undo_manager_perform (UNDO_MANAGER, ua);
+  g_free (filepath);
+
+  Track * track = TRACKLIST->tracks[track_pos];
+  g_assert_cmpint (
+    track->lanes[0]->num_regions, ==, 1);
+
+  return track;
+}
+
+/**
+ * Changes the BPM the way the event manager
+ * applies a tempo change during playback.
+ */
+static void
+change_bpm (
+  bpm_t bpm)
+{
+  tempo_track_set_bpm (
+    P_TEMPO_TRACK, bpm,
+    tempo_track_get_current_bpm (P_TEMPO_TRACK),
+    true, F_NO_PUBLISH_EVENTS);
+  engine_update_frames_per_tick (
+    AUDIO_ENGINE, TRANSPORT->time_sig.beats_per_bar,
+    bpm, AUDIO_ENGINE->sample_rate);
+  engine_update_tempo_map (AUDIO_ENGINE);
+  tracklist_update_region_indices (
+    TRACKLIST, false);
+}
+
+static void
+test_stretch_in_background (void)
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+
+  Track * track = create_audio_track ();
+  ZRegion * r = track->lanes[0]->regions[0];
+  AudioClip * clip = audio_region_get_clip (r);
+  StretchCache * cache = r->stretch_cache;
+
+  /* nothing to stretch at the clip's BPM */
+  g_assert_nonnull (cache);
+  g_assert_null (cache->requested_clip);
+  g_assert_null (stretch_cache_get_frames (cache));
+  g_assert_cmpuint (track->stretch_latency, ==, 0);
+
+  /* request 2 BPMs, only the last one is kept */
+  bpm_t clip_bpm = clip->bpm;
+  change_bpm (clip_bpm * 1.5f);
+  change_bpm (clip_bpm * 1.25f);
+  g_assert_cmpint (
+    g_atomic_int_get (&cache->request_generation),
+    ==, 2);
+  audio_pool_wait_for_stretches (AUDIO_POOL);
+  g_assert_cmpint (
+    AUDIO_POOL->num_pending_stretches, ==, 0);
+
+  bpm_t bpm = clip_bpm * 1.25f;
+  const StretchCacheFrames * frames =
+    stretch_cache_get_frames_for (cache, clip, bpm);
+  g_assert_nonnull (frames);
+  g_assert_true (frames == r->stretch_cache->frames);
+  g_assert_cmpuint (
+    frames->tempo_map_version, ==,
+    engine_get_tempo_map (AUDIO_ENGINE)->version);
+  long expected_frames =
+    (long)
+    ((double) clip->num_frames *
+       ((double) clip_bpm / (double) bpm));
+  g_assert_cmpint (
+    labs (frames->num_frames - expected_frames),
+    <=, 1);
+
+  /* the stretcher latency is reported */
+  g_assert_cmpuint (
+    track->stretch_latency, ==,
+    stretcher_get_latency (track->rt_stretcher));
+
+  /* the cached frames are played */
+  track->processor->playback_latency = 0;
+  nframes_t nframes = AUDIO_ENGINE->block_length;
+  float l[nframes], r_buf[nframes];
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      l[i] = 0.f;
+      r_buf[i] = 0.f;
+    }
+  ArrangerObject * r_obj = (ArrangerObject *) r;
+  long local_frames = frames->num_frames / 2;
+  long g_start_frames =
+    r_obj->pos.frames + local_frames;
+  audio_track_fill_bufs_from_clips (
+    track, l, r_buf, g_start_frames, 0, nframes,
+    -1, 0);
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      g_assert_cmpfloat_with_epsilon (
+        l[i],
+        frames->ch_frames[0][local_frames + i],
+        0.00001f);
+      g_assert_cmpfloat_with_epsilon (
+        r_buf[i],
+        frames->ch_frames[1][local_frames + i],
+        0.00001f);
+    }
+  g_assert_false (cache->used_rt);
+  g_assert_cmpuint (cache->xfade_frames_left, ==, 0);
+
+  /* continuing from realtime stretching
+   * crossfades */
+  cache->used_rt = true;
+  cache->next_frames = g_start_frames;
+  audio_track_fill_bufs_from_clips (
+    track, l, r_buf, g_start_frames, 0, nframes,
+    -1, 0);
+  g_assert_false (cache->used_rt);
+  g_assert_cmpuint (
+    cache->xfade_frames_left, ==,
+    STRETCH_CACHE_XFADE_FRAMES - nframes);
+
+  /* jumping does not */
+  cache->used_rt = true;
+  cache->next_frames = g_start_frames - 1;
+  audio_track_fill_bufs_from_clips (
+    track, l, r_buf, g_start_frames, 0, nframes,
+    -1, 0);
+  g_assert_cmpuint (cache->xfade_frames_left, ==, 0);
+
+  /* back to the clip's BPM */
+  change_bpm (clip_bpm);
+  g_assert_cmpuint (track->stretch_latency, ==, 0);
+  g_assert_null (
+    stretch_cache_get_frames_for (
+      cache, clip, clip_bpm));
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/audio/stretch_cache/"
+
+  g_test_add_func (
+    TEST_PREFIX "test stretch in background",
+    (GTestFunc) test_stretch_in_background);
+
+  return g_test_run ();
+}
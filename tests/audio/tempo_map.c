@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <math.h>
+
+#include "audio/automation_point.h"
+#include "audio/automation_region.h"
+#include "audio/automation_track.h"
+#include "audio/control_port.h"
+#include "audio/engine.h"
+#include "audio/position.h"
+#include "audio/tempo_map.h"
+#include "audio/tempo_track.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/math.h"
+
+#include "tests/helpers/zrythm.h"
+
+static void
+test_constant_tempo ()
+{
+  TempoMap * map =
+    tempo_map_new_from_tempo_track (
+      P_TEMPO_TRACK, TRANSPORT->ticks_per_beat,
+      AUDIO_ENGINE->sample_rate);
+  g_assert_nonnull (map);
+  g_assert_cmpint (map->num_segments, ==, 1);
+  g_assert_false (
+    tempo_map_has_tempo_changes (map));
+
+  /* conversions must match the engine */
+  Position pos;
+  for (double ticks = 0.0; ticks < 200000.0;
+       ticks += 1234.5)
+    {
+      position_from_ticks (&pos, ticks);
+      g_assert_cmpint (
+        math_round_double_to_long (
+          tempo_map_ticks_to_frames (
+            map, pos.total_ticks)),
+        ==, position_to_frames (&pos));
+    }
+
+  tempo_map_free (map);
+}
+
+static void
+test_tempo_changes ()
+{
+  TempoMap * map =
+    tempo_map_new (
+      120.f, TRANSPORT->ticks_per_beat, 48000);
+  g_assert_cmpint (map->num_segments, ==, 1);
+
+  /* add a segment at 140 BPM after 1 bar */
+  map->segments =
+    realloc (
+      map->segments, 2 * sizeof (TempoMapSegment));
+  TempoMapSegment * first = &map->segments[0];
+  TempoMapSegment * second = &map->segments[1];
+  second->start_ticks = TRANSPORT->ticks_per_bar;
+  second->bpm = 140.f;
+  second->frames_per_tick =
+    (48000.0 * 60.0) /
+      (140.0 * TRANSPORT->ticks_per_beat);
+  second->start_frames =
+    second->start_ticks * first->frames_per_tick;
+  map->num_segments = 2;
+
+  g_assert_true (
+    tempo_map_has_tempo_changes (map));
+  g_assert_cmpint (
+    tempo_map_get_segment_idx_at_ticks (
+      map, second->start_ticks - 1.0), ==, 0);
+  g_assert_cmpint (
+    tempo_map_get_segment_idx_at_ticks (
+      map, second->start_ticks), ==, 1);
+  g_assert_cmpfloat_with_epsilon (
+    tempo_map_get_bpm_at_ticks (
+      map, second->start_ticks * 2), 140.f,
+    0.0001f);
+
+  /* round-trip */
+  for (double ticks = 0.0; ticks < 20000.0;
+       ticks += 333.3)
+    {
+      double frames =
+        tempo_map_ticks_to_frames (map, ticks);
+      g_assert_cmpfloat_with_epsilon (
+        tempo_map_frames_to_ticks (map, frames),
+        ticks, 0.0001);
+    }
+
+  tempo_map_free (map);
+}
+
+static void
+add_bpm_point (
+  ZRegion *  r,
+  Port *     bpm_port,
+  float      bpm,
+  Position * pos)
+{
+  AutomationPoint * ap =
+    automation_point_new_float (
+      bpm,
+      control_port_real_val_to_normalized (
+        bpm_port, bpm),
+      pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+}
+
+static void
+test_bpm_automation ()
+{
+  Port * bpm_port = P_TEMPO_TRACK->bpm_port;
+  AutomationTrack * at =
+    automation_track_find_from_port_id (
+      &bpm_port->id, false);
+  g_assert_nonnull (at);
+
+  /* ramp from 100 to 160 BPM over 2 bars, then
+   * stay at 160 BPM */
+  Position start_pos, mid_pos, end_pos;
+  position_set_to_bar (&start_pos, 1);
+  position_set_to_bar (&mid_pos, 3);
+  position_set_to_bar (&end_pos, 5);
+  ZRegion * r =
+    automation_region_new (
+      &start_pos, &end_pos, P_TEMPO_TRACK->pos,
+      at->index, 0);
+  track_add_region (
+    P_TEMPO_TRACK, r, at, 0, F_GEN_NAME,
+    F_NO_PUBLISH_EVENTS);
+
+  /* the region starts at the beginning so local
+   * positions are the same as global ones */
+  add_bpm_point (r, bpm_port, 100.f, &start_pos);
+  add_bpm_point (r, bpm_port, 160.f, &mid_pos);
+  add_bpm_point (r, bpm_port, 160.f, &end_pos);
+
+  TempoMap * map =
+    tempo_map_new_from_tempo_track (
+      P_TEMPO_TRACK, TRANSPORT->ticks_per_beat,
+      AUDIO_ENGINE->sample_rate);
+  g_assert_nonnull (map);
+  g_assert_true (
+    tempo_map_has_tempo_changes (map));
+
+  /* the constant part is merged into a single
+   * segment */
+  TempoMapSegment * last =
+    &map->segments[map->num_segments - 1];
+  g_assert_cmpfloat_with_epsilon (
+    last->bpm, 160.f, 0.01f);
+  g_assert_cmpfloat (
+    last->start_ticks, <=, mid_pos.total_ticks);
+
+  /* the BPM at each position matches the
+   * automation sampled at the resolution */
+  Position pos;
+  for (double ticks = 0.0;
+       ticks < end_pos.total_ticks;
+       ticks += 97.0)
+    {
+      double sampled_ticks =
+        floor (ticks / TEMPO_MAP_RESOLUTION_TICKS) *
+          TEMPO_MAP_RESOLUTION_TICKS;
+      position_from_ticks (&pos, sampled_ticks);
+      float expected =
+        automation_track_get_val_at_pos (
+          at, &pos, false);
+      g_assert_cmpfloat_with_epsilon (
+        tempo_map_get_bpm_at_ticks (map, ticks),
+        expected, 0.01f);
+    }
+
+  /* segments are contiguous in frames */
+  for (int i = 1; i < map->num_segments; i++)
+    {
+      TempoMapSegment * prev = &map->segments[i - 1];
+      TempoMapSegment * seg = &map->segments[i];
+      g_assert_cmpfloat (
+        seg->start_ticks, >, prev->start_ticks);
+      g_assert_cmpfloat_with_epsilon (
+        seg->start_frames,
+        prev->start_frames +
+          (seg->start_ticks - prev->start_ticks) *
+            prev->frames_per_tick,
+        0.0001);
+    }
+
+  tempo_map_free (map);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  test_helper_zrythm_init ();
+
+#define TEST_PREFIX "/audio/tempo_map/"
+
+  g_test_add_func (
+    TEST_PREFIX "test constant tempo",
+    (GTestFunc) test_constant_tempo);
+  g_test_add_func (
+    TEST_PREFIX "test tempo changes",
+    (GTestFunc) test_tempo_changes);
+  g_test_add_func (
+    TEST_PREFIX "test bpm automation",
+    (GTestFunc) test_bpm_automation);
+
+  return g_test_run ();
+}
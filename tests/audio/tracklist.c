@@ -20,8 +20,12 @@
 #include "zrythm-test-config.h"
 
 #include <math.h>
+#include <stdlib.h>
 
+#include "audio/audio_region.h"
 #include "audio/automation_region.h"
+#include "audio/clip.h"
+#include "audio/pool.h"
 #include "audio/tracklist.h"
 #include "project.h"
 #include "utils/flags.h"
@@ -127,6 +131,106 @@ test_swap_with_automation_regions ()
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_multi_file_drop ()
+{
+  test_helper_zrythm_init ();
+
+  char * wav_path =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  char * mp3_path =
+    g_build_filename (
+      TESTS_SRCDIR, "test.mp3", NULL);
+  char * wav_uri =
+    g_filename_to_uri (wav_path, NULL, NULL);
+  char * mp3_uri =
+    g_filename_to_uri (mp3_path, NULL, NULL);
+  char * uris[] = {
+    wav_uri, mp3_uri, wav_uri, NULL };
+
+  int num_tracks_before = TRACKLIST->num_tracks;
+  Position pos;
+  position_set_to_bar (&pos, 2);
+  tracklist_handle_file_drop (
+    TRACKLIST, uris, NULL, NULL, NULL, &pos, true);
+
+  /* tracks and regions are created before the
+   * files are decoded */
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==,
+    num_tracks_before + 3);
+  AudioClip * clips[3];
+  for (int i = 0; i < 3; i++)
+    {
+      Track * track =
+        TRACKLIST->tracks[num_tracks_before + i];
+      g_assert_cmpint (
+        track->type, ==, TRACK_TYPE_AUDIO);
+      g_assert_cmpint (
+        track->lanes[0]->num_regions, ==, 1);
+      ZRegion * r = track->lanes[0]->regions[0];
+      clips[i] = audio_region_get_clip (r);
+      g_assert_nonnull (clips[i]);
+    }
+
+  audio_pool_wait_for_decodes (AUDIO_POOL);
+
+  /* compare with decoding synchronously */
+  AudioClip * expected =
+    audio_clip_new_from_file (wav_path);
+  for (int i = 0; i < 3; i += 2)
+    {
+      AudioClip * clip = clips[i];
+      g_assert_false (clip->decoding);
+      g_assert_cmpint (
+        clip->channels, ==, expected->channels);
+      long num_frames =
+        MIN (clip->num_frames, expected->num_frames);
+      g_assert_cmpint (
+        labs (clip->num_frames - expected->num_frames),
+        <, 64);
+      for (long j = 0;
+           j < num_frames * (long) clip->channels;
+           j++)
+        {
+          g_assert_cmpfloat_with_epsilon (
+            clip->frames[j], expected->frames[j],
+            0.0001f);
+        }
+      for (long j = 0; j < num_frames; j++)
+        {
+          g_assert_cmpfloat_with_epsilon (
+            clip->ch_frames[0][j],
+            expected->frames[j * (long) clip->channels],
+            0.0001f);
+        }
+
+      /* the decoded file is written to the pool */
+      char * pool_path =
+        audio_clip_get_path_in_pool (clip);
+      g_assert_true (
+        g_file_test (pool_path, G_FILE_TEST_EXISTS));
+      g_free (pool_path);
+    }
+  g_assert_false (clips[1]->decoding);
+  audio_clip_free (expected);
+
+  /* the clips have unique names and
+   * generations */
+  g_assert_cmpstr (
+    clips[0]->name, !=, clips[2]->name);
+  g_assert_cmpuint (
+    clips[0]->generation, !=, clips[2]->generation);
+
+  g_free (wav_uri);
+  g_free (mp3_uri);
+  g_free (wav_path);
+  g_free (mp3_path);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -137,6 +241,9 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test swap with automation regions",
     (GTestFunc) test_swap_with_automation_regions);
+  g_test_add_func (
+    TEST_PREFIX "test multi file drop",
+    (GTestFunc) test_multi_file_drop);
 
   return g_test_run ();
 }
@@ -36,21 +36,40 @@
 #define NUM_ITERATIONS_ENGINE 1000
 #define NUM_ITERATIONS_MANY 30000
 
-#define F_OPTIMIZED 1
-#define F_NOT_OPTIMIZED 0
-
 #define F_LARGE_BUF 1
 #define F_NOT_LARGE_BUF 0
 
 #define NUM_TRACKS 100
 
+/** Number of sources to sum in the gather-sum
+ * benchmark. */
+#define NUM_SUM_SRCS 16
+
+/**
+ * Implementation being benchmarked.
+ */
+typedef enum DspBenchmarkMode
+{
+  /** Plain C loops. */
+  MODE_SCALAR,
+  /** Built-in SIMD kernels. */
+  MODE_SIMD,
+  /** LSP DSP. */
+  MODE_LSP,
+  NUM_MODES,
+} DspBenchmarkMode;
+
+static const char * mode_strs[] = {
+  "scalar", "built-in SIMD", "LSP",
+};
+
 typedef struct DspBenchmark
 {
   /* function called */
   const char * func_name;
-  /* microseconds taken */
-  long         unoptimized_usec;
-  long         optimized_usec;
+  /* microseconds taken for each mode, or 0 if
+   * not run */
+  long         usec[NUM_MODES];
 } DspBenchmark;
 
 static DspBenchmark benchmarks[400];
@@ -73,11 +92,10 @@ benchmark_find (
 }
 
 static void
-_test_dsp_fill (
-  bool optimized,
-  bool large_buff)
+init_for_mode (
+  DspBenchmarkMode mode)
 {
-  if (optimized)
+  if (mode == MODE_LSP)
     {
       test_helper_zrythm_init_optimized ();
     }
@@ -86,6 +104,19 @@ _test_dsp_fill (
       test_helper_zrythm_init ();
     }
 
+  dsp_set_simd_level (
+    mode == MODE_SIMD ?
+      dsp_simd_detect_level () :
+      DSP_SIMD_LEVEL_NONE);
+}
+
+static void
+_test_dsp_fill (
+  DspBenchmarkMode mode,
+  bool             large_buff)
+{
+  init_for_mode (mode);
+
   gint64 start, end;
   float buf[LARGE_BUFFER_SIZE];
   float src[LARGE_BUFFER_SIZE];
@@ -101,7 +132,7 @@ _test_dsp_fill (
   for (int i = 0; i < NUM_ITERATIONS_MANY; i++) \
     {
 
-#define LOOP_END(fname,is_optimized) \
+#define LOOP_END(fname,_mode) \
     } \
   end = g_get_monotonic_time (); \
   benchmark = benchmark_find (fname); \
@@ -111,55 +142,87 @@ _test_dsp_fill (
       num_benchmarks++; \
     } \
   benchmark->func_name = fname; \
-  if (is_optimized) \
-    { \
-      benchmark->optimized_usec = end - start; \
-    } \
-  else \
-    { \
-      benchmark->unoptimized_usec = end - start; \
-    }
+  benchmark->usec[_mode] = end - start;
 
   LOOP_START
   dsp_fill (buf, val, buf_size);
-  LOOP_END ("fill", optimized);
+  LOOP_END ("fill", mode);
 
   LOOP_START
   dsp_limit1 (buf, -1.0f, 1.1f, buf_size);
-  LOOP_END ("limit1", optimized);
+  LOOP_END ("limit1", mode);
 
   LOOP_START
   dsp_add2 (buf, src, buf_size);
-  LOOP_END ("add2", optimized);
+  LOOP_END ("add2", mode);
 
   float cur_peak = 0.3f;
   LOOP_START
   dsp_abs_max (buf, &cur_peak, buf_size);
-  LOOP_END ("abs_max", optimized);
+  LOOP_END ("abs_max", mode);
 
   LOOP_START
   dsp_min (buf, buf_size);
-  LOOP_END ("min", optimized);
+  LOOP_END ("min", mode);
 
   LOOP_START
   dsp_max (buf, buf_size);
-  LOOP_END ("max", optimized);
+  LOOP_END ("max", mode);
 
   LOOP_START
   dsp_mul_k2 (buf, 0.99f, buf_size);
-  LOOP_END ("mul_k2", optimized);
+  LOOP_END ("mul_k2", mode);
 
   LOOP_START
   dsp_copy (buf, src, buf_size);
-  LOOP_END ("copy", optimized);
+  LOOP_END ("copy", mode);
 
   LOOP_START
   dsp_mix2 (buf, src, 0.1f, 0.2f, buf_size);
-  LOOP_END ("mix2", optimized);
+  LOOP_END ("mix2", mode);
+
+  LOOP_START
+  dsp_mix2_ramp (
+    buf, src, 1.f, 0.2f, 0.3f, buf_size);
+  LOOP_END ("mix2_ramp", mode);
 
   LOOP_START
   dsp_mix_add2 (buf, src, src, 0.1f, 0.2f, buf_size);
-  LOOP_END ("mix_add2", optimized);
+  LOOP_END ("mix_add2", mode);
+
+  LOOP_START
+  dsp_mix2 (buf, src, 0.1f, 0.2f, buf_size);
+  dsp_limit1 (buf, -1.0f, 1.1f, buf_size);
+  LOOP_END ("mix2 + limit1", mode);
+
+  LOOP_START
+  dsp_mix2_limit1 (
+    buf, src, 0.1f, 0.2f, -1.0f, 1.1f, buf_size);
+  LOOP_END ("mix2_limit1", mode);
+
+  /* summing many sources into 1 port */
+  const float * srcs[NUM_SUM_SRCS];
+  float ks[NUM_SUM_SRCS];
+  for (int j = 0; j < NUM_SUM_SRCS; j++)
+    {
+      srcs[j] = src;
+      ks[j] = 0.01f;
+    }
+
+  LOOP_START
+  for (int j = 0; j < NUM_SUM_SRCS; j++)
+    {
+      dsp_mix2_limit1 (
+        buf, srcs[j], 1.f, ks[j], -2.0f, 2.0f,
+        buf_size);
+    }
+  LOOP_END ("sum sources with mix2_limit1", mode);
+
+  LOOP_START
+  dsp_gather_sum_limit1 (
+    buf, srcs, ks, NUM_SUM_SRCS, -2.0f, 2.0f,
+    buf_size);
+  LOOP_END ("gather_sum_limit1", mode);
 
   test_helper_zrythm_cleanup ();
 }
@@ -167,26 +230,19 @@ _test_dsp_fill (
 static void
 test_dsp_fill ()
 {
-  _test_dsp_fill (
-    F_NOT_OPTIMIZED, F_LARGE_BUF);
+  _test_dsp_fill (MODE_SCALAR, F_LARGE_BUF);
+  _test_dsp_fill (MODE_SIMD, F_LARGE_BUF);
 #ifdef HAVE_LSP_DSP
-  _test_dsp_fill (
-    F_OPTIMIZED, F_LARGE_BUF);
+  _test_dsp_fill (MODE_LSP, F_LARGE_BUF);
 #endif
 }
 
 static void
 _test_run_engine (
-  bool optimized)
+  DspBenchmarkMode mode)
 {
-  if (optimized)
-    {
-      test_helper_zrythm_init_optimized ();
-    }
-  else
-    {
-      test_helper_zrythm_init ();
-    }
+  bool optimized = mode == MODE_LSP;
+  init_for_mode (mode);
 
   AUDIO_ENGINE->stop_dummy_audio_thread = true;
   g_usleep (20000);
@@ -214,11 +270,10 @@ _test_run_engine (
     {
       engine_process (
         AUDIO_ENGINE, AUDIO_ENGINE->block_length);
-  LOOP_END ("engine cycles", optimized);
+  LOOP_END ("engine cycles", mode);
 
   g_message (
-    "%soptimized time: %ld",
-    optimized ? "" : "un", end - start);
+    "%s time: %ld", mode_strs[mode], end - start);
   /*g_warn_if_reached ();*/
 
 #ifdef HAVE_LSP_DSP
@@ -235,25 +290,34 @@ static void
 test_run_engine ()
 {
 #ifdef HAVE_LSP_DSP
-  _test_run_engine (F_OPTIMIZED);
+  _test_run_engine (MODE_LSP);
 #endif
-  _test_run_engine (F_NOT_OPTIMIZED);
+  _test_run_engine (MODE_SIMD);
+  _test_run_engine (MODE_SCALAR);
 }
 
 static void
 print_benchmark_results ()
 {
+  fprintf (
+    stderr, "built-in SIMD level: %s\n",
+    dsp_simd_level_to_string (
+      dsp_simd_detect_level ()));
   for (int i = 0; i < num_benchmarks; i++)
     {
       DspBenchmark * benchmark = &benchmarks[i];
       fprintf (
-        stderr,
-        "---- %s ----\n"
-        "unoptimized: %ldms\n"
-        "optimized: %ldms\n",
-        benchmark->func_name,
-        benchmark->unoptimized_usec / 1000,
-        benchmark->optimized_usec / 1000);
+        stderr, "---- %s ----\n",
+        benchmark->func_name);
+      for (int j = 0; j < NUM_MODES; j++)
+        {
+          if (benchmark->usec[j] == 0)
+            continue;
+
+          fprintf (
+            stderr, "%s: %ldms\n", mode_strs[j],
+            benchmark->usec[j] / 1000);
+        }
     }
 }
 
@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Headless engine throughput benchmarks.
+ *
+ * Synthetic projects are processed on the dummy
+ * backend at various buffer sizes and DSP thread
+ * counts and the results are written as JSON to
+ * the path given in ZRYTHM_BENCHMARK_OUTPUT (or
+ * to benchmark_engine.json in the test build
+ * dir).
+ */
+
+#include "zrythm-test-config.h"
+
+#include <stdlib.h>
+
+#include "actions/mixer_selections_action.h"
+#include "actions/tracklist_selections.h"
+#include "audio/automation_region.h"
+#include "audio/channel_send.h"
+#include "audio/control_port.h"
+#include "audio/engine_dummy.h"
+#include "audio/graph.h"
+#include "audio/graph_profiler.h"
+#include "audio/midi_region.h"
+#include "audio/router.h"
+#include "audio/transport.h"
+#include "zrythm.h"
+
+#include "tests/helpers/plugin_manager.h"
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+/** Cycles to run before measuring. */
+#define NUM_WARMUP_CYCLES 50
+
+/** Cycles to measure. */
+#define NUM_CYCLES 1000
+
+/** Number of graph rebuilds to measure. */
+#define NUM_GRAPH_REBUILDS 10
+
+/** Time to let the dummy backend freewheel
+ * for, in microseconds. */
+#define FREEWHEEL_USEC 1000000
+
+/** Bars to loop over. */
+#define LOOP_BARS 4
+
+typedef struct EngineBenchmarkProject
+{
+  /** Number of instrument tracks. */
+  int          num_tracks;
+
+  /** Number of effect plugins per track. */
+  int          num_plugins;
+} EngineBenchmarkProject;
+
+typedef struct EngineBenchmarkResult
+{
+  int          num_tracks;
+  int          num_plugins;
+  int          num_threads;
+  nframes_t    block_length;
+  int          num_graph_nodes;
+
+  /** Cycle times in nanoseconds. */
+  gint64       p50_ns;
+  gint64       p99_ns;
+  gint64       max_ns;
+
+  /** Cycles per second when calling
+   * engine_process() directly. */
+  double       cycles_per_sec;
+
+  /** Cycles per second when freewheeling the
+   * dummy backend. */
+  double       freewheel_cycles_per_sec;
+
+  /** Average graph rebuild time. */
+  gint64       graph_rebuild_ns;
+} EngineBenchmarkResult;
+
+static const EngineBenchmarkProject projects[] = {
+  { 8, 2 },
+  { 32, 4 },
+};
+
+static const nframes_t block_lengths[] = {
+  64, 256, 1024,
+};
+
+/* worker threads besides the main one */
+static const int thread_counts[] = {
+  0, 1, 3,
+};
+
+static EngineBenchmarkResult results[
+  G_N_ELEMENTS (projects) *
+  G_N_ELEMENTS (block_lengths) *
+  G_N_ELEMENTS (thread_counts)];
+static int num_results = 0;
+
+static int
+cmp_gint64 (
+  const void * a,
+  const void * b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Adds a region with a note every sixteenth to
+ * the given track.
+ */
+static void
+add_dense_midi (
+  Track * track)
+{
+  Position start, end;
+  position_set_to_bar (&start, 1);
+  position_set_to_bar (&end, LOOP_BARS + 1);
+  ZRegion * r =
+    midi_region_new (
+      &start, &end, track->pos, 0,
+      track->lanes[0]->num_regions);
+  track_add_region (
+    track, r, NULL, 0, F_GEN_NAME,
+    F_NO_PUBLISH_EVENTS);
+
+  int num_notes = LOOP_BARS * 16;
+  for (int i = 0; i < num_notes; i++)
+    {
+      Position note_start, note_end;
+      position_init (&note_start);
+      position_add_ticks (
+        &note_start,
+        i * TICKS_PER_SIXTEENTH_NOTE);
+      position_set_to_pos (&note_end, &note_start);
+      position_add_ticks (
+        &note_end, TICKS_PER_SIXTEENTH_NOTE / 2);
+      MidiNote * mn =
+        midi_note_new (
+          &r->id, &note_start, &note_end,
+          (uint8_t) (48 + (i % 24)), 90);
+      midi_region_add_midi_note (
+        r, mn, F_NO_PUBLISH_EVENTS);
+    }
+}
+
+/**
+ * Adds a fader automation ramp to the given
+ * track.
+ */
+static void
+add_fader_automation (
+  Track * track)
+{
+  AutomationTrack * at =
+    channel_get_automation_track (
+      track->channel, PORT_FLAG_CHANNEL_FADER);
+  g_return_if_fail (at);
+  Port * port = automation_track_get_port (at);
+
+  Position start, end;
+  position_set_to_bar (&start, 1);
+  position_set_to_bar (&end, LOOP_BARS + 1);
+  ZRegion * r =
+    automation_region_new (
+      &start, &end, track->pos, at->index,
+      at->num_regions);
+  track_add_region (
+    track, r, at, -1, F_GEN_NAME,
+    F_NO_PUBLISH_EVENTS);
+
+  Position pos;
+  position_init (&pos);
+  AutomationPoint * ap =
+    automation_point_new_float (
+      control_port_normalized_val_to_real (
+        port, 0.2f),
+      0.2f, &pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+  position_set_to_bar (&pos, LOOP_BARS);
+  ap =
+    automation_point_new_float (
+      control_port_normalized_val_to_real (
+        port, 0.8f),
+      0.8f, &pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+}
+
+/**
+ * Creates N instrument tracks with M effects
+ * each, dense MIDI and fader automation, all
+ * sending to an FX bus.
+ */
+static void
+create_project (
+  const EngineBenchmarkProject * project)
+{
+  PluginDescriptor * amp_descr =
+    test_plugin_manager_get_plugin_descriptor (
+      EG_AMP_BUNDLE_URI, EG_AMP_URI, false);
+  g_assert_nonnull (amp_descr);
+
+  /* the FX bus */
+  UndoableAction * ua =
+    tracklist_selections_action_new_create (
+      TRACK_TYPE_AUDIO_BUS, NULL, NULL,
+      TRACKLIST->num_tracks, NULL, 1);
+  undo_manager_perform (UNDO_MANAGER, ua);
+  Track * fx_track =
+    TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+
+  int first_track_pos = TRACKLIST->num_tracks;
+  test_plugin_manager_create_tracks_from_plugin (
+    TEST_INSTRUMENT_BUNDLE_URI, TEST_INSTRUMENT_URI,
+    true, false, project->num_tracks);
+
+  for (int i = 0; i < project->num_tracks; i++)
+    {
+      Track * track =
+        TRACKLIST->tracks[first_track_pos + i];
+      g_assert_true (
+        track->type == TRACK_TYPE_INSTRUMENT);
+
+      if (project->num_plugins > 0)
+        {
+          ua =
+            mixer_selections_action_new_create (
+              PLUGIN_SLOT_INSERT, track->pos, 0,
+              amp_descr, project->num_plugins);
+          undo_manager_perform (UNDO_MANAGER, ua);
+        }
+
+      add_dense_midi (track);
+      add_fader_automation (track);
+
+      channel_send_connect_stereo (
+        &track->channel->sends[0],
+        fx_track->processor->stereo_in, NULL,
+        NULL);
+    }
+
+  plugin_descriptor_free (amp_descr);
+
+  router_recalc_graph (ROUTER, F_NOT_SOFT);
+
+  /* loop over the content */
+  transport_set_loop (TRANSPORT, true);
+  position_set_to_bar (
+    &TRANSPORT->loop_start_pos, 1);
+  position_set_to_bar (
+    &TRANSPORT->loop_end_pos, LOOP_BARS + 1);
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+}
+
+static void
+run_block_length (
+  const EngineBenchmarkProject * project,
+  int                            num_threads,
+  nframes_t                      block_length)
+{
+  engine_realloc_port_buffers (
+    AUDIO_ENGINE, block_length);
+
+  for (int i = 0; i < NUM_WARMUP_CYCLES; i++)
+    {
+      engine_process (AUDIO_ENGINE, block_length);
+    }
+
+  /* time each cycle */
+  gint64 * times = calloc (NUM_CYCLES, sizeof (gint64));
+  gint64 total = 0;
+  for (int i = 0; i < NUM_CYCLES; i++)
+    {
+      gint64 start = graph_profiler_get_time_ns ();
+      engine_process (AUDIO_ENGINE, block_length);
+      times[i] = graph_profiler_get_time_ns () - start;
+      total += times[i];
+    }
+  qsort (
+    times, NUM_CYCLES, sizeof (gint64), cmp_gint64);
+
+  /* run the dummy backend freewheeling */
+  g_atomic_int_set (&AUDIO_ENGINE->dummy_freewheel, 1);
+  g_atomic_int_set (&AUDIO_ENGINE->dummy_num_cycles, 0);
+  gint64 fw_start = g_get_monotonic_time ();
+  engine_dummy_activate (AUDIO_ENGINE, true);
+  g_usleep (FREEWHEEL_USEC);
+  engine_dummy_activate (AUDIO_ENGINE, false);
+  gint64 fw_usec = g_get_monotonic_time () - fw_start;
+  g_atomic_int_set (&AUDIO_ENGINE->dummy_freewheel, 0);
+
+  /* time graph rebuilds */
+  gint64 rebuild_total = 0;
+  for (int i = 0; i < NUM_GRAPH_REBUILDS; i++)
+    {
+      gint64 start = graph_profiler_get_time_ns ();
+      router_recalc_graph (ROUTER, F_NOT_SOFT);
+      rebuild_total +=
+        graph_profiler_get_time_ns () - start;
+    }
+
+  EngineBenchmarkResult * res =
+    &results[num_results++];
+  res->num_tracks = project->num_tracks;
+  res->num_plugins = project->num_plugins;
+  res->num_threads = num_threads;
+  res->block_length = block_length;
+  res->num_graph_nodes = ROUTER->graph->n_graph_nodes;
+  res->p50_ns = times[(NUM_CYCLES - 1) / 2];
+  res->p99_ns = times[((NUM_CYCLES - 1) * 99) / 100];
+  res->max_ns = times[NUM_CYCLES - 1];
+  res->cycles_per_sec =
+    (NUM_CYCLES * 1000000000.0) / (double) total;
+  res->freewheel_cycles_per_sec =
+    (g_atomic_int_get (
+       &AUDIO_ENGINE->dummy_num_cycles) *
+     1000000.0) / (double) fw_usec;
+  res->graph_rebuild_ns =
+    rebuild_total / NUM_GRAPH_REBUILDS;
+
+  g_message (
+    "%d tracks x %d plugins, %d threads, "
+    "%u frames: %.0f cycles/sec (%.0f "
+    "freewheeling), p50 %" G_GINT64_FORMAT
+    "ns, p99 %" G_GINT64_FORMAT "ns, "
+    "graph rebuild %" G_GINT64_FORMAT "ns",
+    res->num_tracks, res->num_plugins,
+    res->num_threads, res->block_length,
+    res->cycles_per_sec,
+    res->freewheel_cycles_per_sec,
+    res->p50_ns, res->p99_ns,
+    res->graph_rebuild_ns);
+
+  free (times);
+}
+
+static void
+run_project (
+  const EngineBenchmarkProject * project,
+  int                            num_threads)
+{
+  /* the number of threads is read when the
+   * graph is started */
+  char * num_threads_str =
+    g_strdup_printf ("%d", num_threads);
+  g_setenv (
+    "ZRYTHM_DSP_THREADS", num_threads_str, true);
+  g_free (num_threads_str);
+
+  test_helper_zrythm_init ();
+
+  /* process manually */
+  engine_dummy_activate (AUDIO_ENGINE, false);
+
+  create_project (project);
+
+  for (size_t i = 0;
+       i < G_N_ELEMENTS (block_lengths); i++)
+    {
+      run_block_length (
+        project, num_threads, block_lengths[i]);
+    }
+
+  engine_dummy_activate (AUDIO_ENGINE, true);
+
+  test_helper_zrythm_cleanup ();
+
+  g_unsetenv ("ZRYTHM_DSP_THREADS");
+}
+
+static void
+test_run_engine ()
+{
+  for (size_t i = 0; i < G_N_ELEMENTS (projects); i++)
+    {
+      for (size_t j = 0;
+           j < G_N_ELEMENTS (thread_counts); j++)
+        {
+          run_project (
+            &projects[i], thread_counts[j]);
+        }
+    }
+}
+
+static void
+write_benchmark_results ()
+{
+  GString * str = g_string_new ("{\"results\":[");
+  for (int i = 0; i < num_results; i++)
+    {
+      EngineBenchmarkResult * res = &results[i];
+      g_string_append_printf (
+        str,
+        "%s\n{\"tracks\":%d,\"plugins_per_track\":%d,"
+        "\"threads\":%d,\"block_length\":%u,"
+        "\"graph_nodes\":%d,"
+        "\"cycles_per_sec\":%.3f,"
+        "\"freewheel_cycles_per_sec\":%.3f,"
+        "\"p50_ns\":%" G_GINT64_FORMAT ","
+        "\"p99_ns\":%" G_GINT64_FORMAT ","
+        "\"max_ns\":%" G_GINT64_FORMAT ","
+        "\"graph_rebuild_ns\":%" G_GINT64_FORMAT
+        "}",
+        i == 0 ? "" : ",",
+        res->num_tracks, res->num_plugins,
+        res->num_threads, res->block_length,
+        res->num_graph_nodes,
+        res->cycles_per_sec,
+        res->freewheel_cycles_per_sec,
+        res->p50_ns, res->p99_ns, res->max_ns,
+        res->graph_rebuild_ns);
+    }
+  g_string_append (str, "\n]}\n");
+
+  const char * env_path =
+    g_getenv ("ZRYTHM_BENCHMARK_OUTPUT");
+  char * filepath =
+    env_path ?
+      g_strdup (env_path) :
+      g_build_filename (
+        TESTS_BUILDDIR, "benchmark_engine.json",
+        NULL);
+  char * content = g_string_free (str, false);
+  GError * err = NULL;
+  bool ret =
+    g_file_set_contents (
+      filepath, content, -1, &err);
+  if (!ret)
+    {
+      g_warning (
+        "failed to write %s: %s",
+        filepath, err->message);
+      g_error_free (err);
+    }
+  g_assert_true (ret);
+
+  fprintf (
+    stderr, "wrote engine benchmark results to %s\n",
+    filepath);
+
+  g_free (content);
+  g_free (filepath);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/engine/"
+
+  g_test_add_func (
+    TEST_PREFIX "test run engine",
+    (GTestFunc) test_run_engine);
+  g_test_add_func (
+    TEST_PREFIX "write benchmark results",
+    (GTestFunc) write_benchmark_results);
+
+  return g_test_run ();
+}
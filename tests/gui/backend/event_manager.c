@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "gui/backend/event.h"
+#include "gui/backend/event_manager.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+static void
+push_event (
+  EventManager *       self,
+  EventType            type,
+  void *               arg,
+  const GdkRectangle * rect)
+{
+  ZEvent * ev =
+    (ZEvent *) object_pool_get (self->obj_pool);
+  ev->type = type;
+  ev->arg = arg;
+  event_set_rect (ev, rect);
+  event_queue_push_back_event (self->mqueue, ev);
+}
+
+static ZEvent *
+get_pending (
+  EventManager * self,
+  guint          idx)
+{
+  g_assert_cmpuint (
+    idx, <, self->pending_events->len);
+  return
+    (ZEvent *)
+    g_ptr_array_index (self->pending_events, idx);
+}
+
+static void
+test_last_value_wins (void)
+{
+  test_helper_zrythm_init ();
+
+  EventManager * self = event_manager_new ();
+  void * a = GINT_TO_POINTER (1);
+  void * b = GINT_TO_POINTER (2);
+
+  /* events that ignore the argument are merged by
+   * type and keep their place */
+  push_event (self, ET_PLAYHEAD_POS_CHANGED, a, NULL);
+  push_event (self, ET_TRACK_STATE_CHANGED, a, NULL);
+  push_event (self, ET_PLAYHEAD_POS_CHANGED, b, NULL);
+  event_manager_drain_queue (self);
+  g_assert_cmpuint (self->pending_events->len, ==, 2);
+  ZEvent * ev = get_pending (self, 0);
+  g_assert_cmpint (
+    ev->type, ==, ET_PLAYHEAD_POS_CHANGED);
+  g_assert_true (ev->arg == b);
+  g_assert_cmpint (
+    get_pending (self, 1)->type, ==,
+    ET_TRACK_STATE_CHANGED);
+
+  /* other events are merged by type and
+   * argument */
+  push_event (self, ET_TRACK_STATE_CHANGED, b, NULL);
+  push_event (self, ET_TRACK_STATE_CHANGED, a, NULL);
+  event_manager_drain_queue (self);
+  g_assert_cmpuint (self->pending_events->len, ==, 3);
+  g_assert_true (get_pending (self, 1)->arg == a);
+  g_assert_true (get_pending (self, 2)->arg == b);
+
+  const EventTypeStats * stats =
+    event_manager_get_type_stats (
+      self, ET_PLAYHEAD_POS_CHANGED);
+  g_assert_cmpuint (stats->num_pushed, ==, 2);
+  g_assert_cmpuint (stats->num_coalesced, ==, 1);
+  stats =
+    event_manager_get_type_stats (
+      self, ET_TRACK_STATE_CHANGED);
+  g_assert_cmpuint (stats->num_pushed, ==, 3);
+  g_assert_cmpuint (stats->num_coalesced, ==, 1);
+
+  event_manager_free (self);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_rect_union (void)
+{
+  test_helper_zrythm_init ();
+
+  EventManager * self = event_manager_new ();
+  void * a = GINT_TO_POINTER (1);
+  void * b = GINT_TO_POINTER (2);
+
+  GdkRectangle rect1 = { 0, 0, 10, 10 };
+  GdkRectangle rect2 = { 20, 5, 10, 10 };
+  push_event (
+    self, ET_ARRANGER_HIGHLIGHT_CHANGED, a, &rect1);
+  push_event (
+    self, ET_ARRANGER_HIGHLIGHT_CHANGED, b, &rect1);
+  push_event (
+    self, ET_ARRANGER_HIGHLIGHT_CHANGED, a, &rect2);
+  event_manager_drain_queue (self);
+  g_assert_cmpuint (self->pending_events->len, ==, 2);
+
+  /* the areas are unioned */
+  ZEvent * ev = get_pending (self, 0);
+  g_assert_true (ev->has_rect);
+  g_assert_cmpint (ev->rect.x, ==, 0);
+  g_assert_cmpint (ev->rect.y, ==, 0);
+  g_assert_cmpint (ev->rect.width, ==, 30);
+  g_assert_cmpint (ev->rect.height, ==, 15);
+
+  /* events of other args are unaffected */
+  ev = get_pending (self, 1);
+  g_assert_true (ev->has_rect);
+  g_assert_cmpint (ev->rect.width, ==, 10);
+
+  /* a whole redraw absorbs any area */
+  push_event (
+    self, ET_ARRANGER_HIGHLIGHT_CHANGED, a, NULL);
+  push_event (
+    self, ET_ARRANGER_HIGHLIGHT_CHANGED, a, &rect1);
+  event_manager_drain_queue (self);
+  g_assert_cmpuint (self->pending_events->len, ==, 2);
+  g_assert_false (get_pending (self, 0)->has_rect);
+
+  event_manager_free (self);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_dispatch_all (void)
+{
+  test_helper_zrythm_init ();
+
+  EventManager * self = event_manager_new ();
+
+  for (int i = 1; i <= 100; i++)
+    {
+      push_event (
+        self, ET_TRACK_STATE_CHANGED,
+        GINT_TO_POINTER (i), NULL);
+    }
+  event_manager_drain_queue (self);
+  g_assert_cmpuint (
+    self->pending_events->len, ==, 100);
+
+  /* the dispatched events are removed */
+  event_manager_process_now (self);
+  g_assert_cmpuint (self->pending_events->len, ==, 0);
+  g_assert_cmpuint (self->pending_events_start, ==, 0);
+  g_assert_cmpuint (
+    g_hash_table_size (self->pending_events_ht),
+    ==, 0);
+
+  event_manager_free (self);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/gui/backend/event_manager/"
+
+  g_test_add_func (
+    TEST_PREFIX "test last value wins",
+    (GTestFunc) test_last_value_wins);
+  g_test_add_func (
+    TEST_PREFIX "test rect union",
+    (GTestFunc) test_rect_union);
+  g_test_add_func (
+    TEST_PREFIX "test dispatch all",
+    (GTestFunc) test_dispatch_all);
+
+  return g_test_run ();
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "gui/backend/file_index.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+
+static void
+test_parse_tags (void)
+{
+  double bpm;
+  char key[8];
+
+#define ASSERT_TAGS(name,_bpm,_key) \
+  file_index_parse_tags_from_name ( \
+    name, &bpm, key, sizeof (key)); \
+  g_assert_cmpfloat_with_epsilon ( \
+    bpm, _bpm, 0.0001); \
+  g_assert_cmpstr (key, ==, _key)
+
+  ASSERT_TAGS ("Loop_Cm_128bpm.wav", 128.0, "Cm");
+  ASSERT_TAGS (
+    "Pad 90 BPM F# minor.flac", 90.0, "F#m");
+  ASSERT_TAGS ("Bass-Eb-120BPM.ogg", 120.0, "Eb");
+  ASSERT_TAGS ("Chord (A major).wav", 0.0, "A");
+  ASSERT_TAGS ("Kick 808.wav", 0.0, "");
+  ASSERT_TAGS ("Snare_B.wav", 0.0, "");
+  ASSERT_TAGS ("Brass 500bpm.wav", 0.0, "");
+
+#undef ASSERT_TAGS
+}
+
+static void
+copy_test_wav (
+  const char * dest)
+{
+  char * src =
+    g_build_filename (
+      TESTS_SRCDIR, "test.wav", NULL);
+  GFile * src_file = g_file_new_for_path (src);
+  GFile * dest_file = g_file_new_for_path (dest);
+  g_assert_true (
+    g_file_copy (
+      src_file, dest_file, G_FILE_COPY_NONE,
+      NULL, NULL, NULL, NULL));
+  g_object_unref (src_file);
+  g_object_unref (dest_file);
+  g_free (src);
+}
+
+static int
+query_count (
+  FileIndex *  index,
+  const char * dir,
+  bool         recursive,
+  const char * text)
+{
+  FileIndexQuery query = {
+    .dir = dir,
+    .recursive = recursive,
+    .text = text,
+  };
+  GPtrArray * arr = file_index_query (index, &query);
+  int ret = (int) arr->len;
+  g_ptr_array_unref (arr);
+  return ret;
+}
+
+static void
+test_index_and_query (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir =
+    g_dir_make_tmp ("zrythm_file_index_XXXXXX", NULL);
+  char * lib = g_build_filename (tmp_dir, "lib", NULL);
+  char * sub = g_build_filename (lib, "sub", NULL);
+  g_assert_cmpint (
+    g_mkdir_with_parents (sub, 0700), ==, 0);
+
+  char * loop =
+    g_build_filename (
+      lib, "Loop_Cm_128bpm.wav", NULL);
+  char * kick =
+    g_build_filename (sub, "Kick.wav", NULL);
+  char * hidden =
+    g_build_filename (lib, ".hidden.wav", NULL);
+  char * notes =
+    g_build_filename (lib, "notes.txt", NULL);
+  copy_test_wav (loop);
+  copy_test_wav (kick);
+  copy_test_wav (hidden);
+  g_assert_true (
+    g_file_set_contents (notes, "abc", -1, NULL));
+
+  char * cache_path =
+    g_build_filename (tmp_dir, "index.bin", NULL);
+  FileIndex * index = file_index_new (cache_path);
+  g_assert_nonnull (index);
+  const char * roots[] = { lib, NULL };
+  file_index_set_roots (index, roots);
+  file_index_wait (index);
+
+  g_assert_true (
+    file_index_is_dir_listed (index, lib));
+  g_assert_true (
+    file_index_is_dir_listed (index, sub));
+
+  /* loop, notes and sub (hidden files are
+   * skipped) */
+  g_assert_cmpint (
+    query_count (index, lib, false, NULL), ==, 3);
+  g_assert_cmpint (
+    query_count (index, lib, true, NULL), ==, 4);
+  g_assert_cmpint (
+    query_count (index, lib, true, "kick"), ==, 1);
+  g_assert_cmpint (
+    query_count (index, lib, true, "LOOP cm"),
+    ==, 1);
+  g_assert_cmpint (
+    query_count (index, lib, true, "loop kick"),
+    ==, 0);
+
+  FileIndexEntry * e =
+    file_index_get_entry (index, loop);
+  g_assert_nonnull (e);
+  g_assert_cmpint (e->type, ==, FILE_TYPE_WAV);
+  g_assert_true (e->has_info);
+  g_assert_cmpuint (e->sample_rate, >, 0);
+  g_assert_cmpuint (e->channels, >, 0);
+  g_assert_cmpint (e->num_frames, >, 0);
+  g_assert_cmpint (
+    e->num_peaks, ==, FILE_INDEX_NUM_PEAKS);
+  g_assert_cmpfloat_with_epsilon (
+    e->bpm, 128.0, 0.0001);
+  g_assert_cmpstr (e->key, ==, "Cm");
+  unsigned int sample_rate = e->sample_rate;
+  file_index_entry_free (e);
+
+  /* reload from the cache */
+  file_index_free (index);
+  index = file_index_new (cache_path);
+  e = file_index_get_entry (index, loop);
+  g_assert_nonnull (e);
+  g_assert_true (e->has_info);
+  g_assert_cmpuint (e->sample_rate, ==, sample_rate);
+  g_assert_cmpint (
+    e->num_peaks, ==, FILE_INDEX_NUM_PEAKS);
+  file_index_entry_free (e);
+  g_assert_true (
+    file_index_is_dir_listed (index, sub));
+
+  /* removed files are dropped on the next crawl */
+  io_remove (kick);
+  file_index_set_roots (index, roots);
+  file_index_wait (index);
+  e = file_index_get_entry (index, kick);
+  g_assert_null (e);
+  g_assert_cmpint (
+    query_count (index, lib, true, NULL), ==, 3);
+
+  /* clearing the roots drops everything */
+  const char * no_roots[] = { NULL };
+  file_index_set_roots (index, no_roots);
+  file_index_wait (index);
+  g_assert_cmpint (
+    query_count (index, lib, true, NULL), ==, 0);
+
+  file_index_free (index);
+
+  io_rmdir (tmp_dir, true);
+  g_free (cache_path);
+  g_free (loop);
+  g_free (kick);
+  g_free (hidden);
+  g_free (notes);
+  g_free (sub);
+  g_free (lib);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/gui/backend/file index/"
+
+  g_test_add_func (
+    TEST_PREFIX "test parse tags",
+    (GTestFunc) test_parse_tags);
+  g_test_add_func (
+    TEST_PREFIX "test index and query",
+    (GTestFunc) test_index_and_query);
+
+  return g_test_run ();
+}
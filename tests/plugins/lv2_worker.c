@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include "plugins/lv2_plugin.h"
+#include "plugins/lv2/lv2_worker.h"
+#include "plugins/plugin.h"
+#include "plugins/plugin_manager.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+#define NUM_REQUESTS 200
+
+/**
+ * Fake plugin instance recording the work and
+ * responses it receives.
+ */
+typedef struct FakeInstance
+{
+  Lv2Plugin            lv2_plugin;
+  Plugin               plugin;
+  PluginDescriptor     descr;
+  struct LilvInstanceImpl instance;
+  LV2_Worker_Interface iface;
+  int                  work[NUM_REQUESTS];
+  int                  num_work;
+  int                  responses[NUM_REQUESTS];
+  int                  num_responses;
+} FakeInstance;
+
+static LV2_Worker_Status
+work (
+  LV2_Handle                  instance,
+  LV2_Worker_Respond_Function respond,
+  LV2_Worker_Respond_Handle   handle,
+  uint32_t                    size,
+  const void *                data)
+{
+  FakeInstance * self = (FakeInstance *) instance;
+  g_assert_cmpuint (size, ==, sizeof (int));
+  self->work[self->num_work++] = *(const int *) data;
+  return respond (handle, size, data);
+}
+
+static LV2_Worker_Status
+work_response (
+  LV2_Handle   instance,
+  uint32_t     size,
+  const void * body)
+{
+  FakeInstance * self = (FakeInstance *) instance;
+  g_assert_cmpuint (size, ==, sizeof (int));
+  self->responses[self->num_responses++] =
+    *(const int *) body;
+  return LV2_WORKER_SUCCESS;
+}
+
+static FakeInstance *
+fake_instance_new (void)
+{
+  FakeInstance * self = g_new0 (FakeInstance, 1);
+  self->descr.name = (char *) "fake";
+  self->plugin.descr = &self->descr;
+  self->instance.lv2_handle = self;
+  self->iface.work = work;
+  self->iface.work_response = work_response;
+  self->lv2_plugin.plugin = &self->plugin;
+  self->lv2_plugin.instance = &self->instance;
+  self->lv2_plugin.worker.plugin = &self->lv2_plugin;
+  zix_sem_init (&self->lv2_plugin.work_lock, 1);
+  lv2_worker_init (
+    &self->lv2_plugin, &self->lv2_plugin.worker,
+    &self->iface, true);
+  return self;
+}
+
+static void
+fake_instance_free (
+  FakeInstance * self)
+{
+  self->lv2_plugin.exit = true;
+  lv2_worker_finish (&self->lv2_plugin.worker);
+  zix_sem_destroy (&self->lv2_plugin.work_lock);
+  g_free (self);
+}
+
+static void
+wait_for_work (
+  FakeInstance ** instances,
+  int             num_instances)
+{
+  gint64 start = g_get_monotonic_time ();
+  for (int i = 0; i < num_instances; i++)
+    {
+      while (
+        lv2_worker_get_queue_depth (
+          &instances[i]->lv2_plugin.worker) > 0 ||
+        instances[i]->lv2_plugin.worker.queued)
+        {
+          g_assert_cmpint (
+            g_get_monotonic_time () - start, <,
+            10 * 1000 * 1000);
+          g_usleep (100);
+        }
+    }
+}
+
+static void
+test_shared_pool (void)
+{
+  test_helper_zrythm_init ();
+
+  g_assert_nonnull (LV2_WORKER_POOL);
+  g_assert_cmpint (
+    LV2_WORKER_POOL->num_threads, >, 0);
+  g_assert_cmpint (
+    LV2_WORKER_POOL->num_threads, <=,
+    LV2_WORKER_POOL_MAX_THREADS);
+
+  FakeInstance * instances[3];
+  for (int i = 0; i < 3; i++)
+    {
+      instances[i] = fake_instance_new ();
+    }
+
+  /* interleave requests from all instances */
+  for (int j = 0; j < NUM_REQUESTS; j++)
+    {
+      for (int i = 0; i < 3; i++)
+        {
+          int val = j * 10 + i;
+          LV2_Worker_Status status =
+            lv2_worker_schedule (
+              &instances[i]->lv2_plugin.worker,
+              sizeof (int), &val);
+          g_assert_cmpint (
+            status, ==, LV2_WORKER_SUCCESS);
+        }
+
+      /* let responses out so the rings don't
+       * fill up */
+      if (j % 50 == 49)
+        {
+          wait_for_work (instances, 3);
+          for (int i = 0; i < 3; i++)
+            {
+              lv2_worker_emit_responses (
+                &instances[i]->lv2_plugin.worker,
+                &instances[i]->instance);
+            }
+        }
+    }
+  wait_for_work (instances, 3);
+
+  /* each instance's work and responses are
+   * in order */
+  for (int i = 0; i < 3; i++)
+    {
+      FakeInstance * inst = instances[i];
+      lv2_worker_emit_responses (
+        &inst->lv2_plugin.worker, &inst->instance);
+      g_assert_cmpint (
+        inst->num_work, ==, NUM_REQUESTS);
+      g_assert_cmpint (
+        inst->num_responses, ==, NUM_REQUESTS);
+      for (int j = 0; j < NUM_REQUESTS; j++)
+        {
+          g_assert_cmpint (
+            inst->work[j], ==, j * 10 + i);
+          g_assert_cmpint (
+            inst->responses[j], ==, j * 10 + i);
+        }
+      g_assert_cmpint (
+        lv2_worker_get_queue_depth (
+          &inst->lv2_plugin.worker), ==, 0);
+    }
+
+  for (int i = 0; i < 3; i++)
+    {
+      fake_instance_free (instances[i]);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_drop_requests_on_exit (void)
+{
+  test_helper_zrythm_init ();
+
+  FakeInstance * inst = fake_instance_new ();
+
+  /* hold the work lock so requests pile up */
+  zix_sem_wait (&inst->lv2_plugin.work_lock);
+  for (int j = 0; j < 10; j++)
+    {
+      lv2_worker_schedule (
+        &inst->lv2_plugin.worker, sizeof (int), &j);
+    }
+  g_assert_cmpint (
+    lv2_worker_get_queue_depth (
+      &inst->lv2_plugin.worker), >, 0);
+  inst->lv2_plugin.exit = true;
+  zix_sem_post (&inst->lv2_plugin.work_lock);
+
+  /* finishing waits for the pool and the
+   * remaining requests are not run */
+  lv2_worker_finish (&inst->lv2_plugin.worker);
+  g_assert_cmpint (inst->num_work, <=, 1);
+  g_assert_false (inst->lv2_plugin.worker.queued);
+
+  zix_sem_destroy (&inst->lv2_plugin.work_lock);
+  g_free (inst);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/plugins/lv2_worker/"
+
+  g_test_add_func (
+    TEST_PREFIX "test shared pool",
+    (GTestFunc) test_shared_pool);
+  g_test_add_func (
+    TEST_PREFIX "test drop requests on exit",
+    (GTestFunc) test_drop_requests_on_exit);
+
+  return g_test_run ();
+}
@@ -19,8 +19,12 @@
 
 #include "zrythm-test-config.h"
 
+#include <math.h>
+
 #include <lilv/lilv.h>
 
+#include "audio/automation_region.h"
+#include "audio/control_port.h"
 #include "audio/fader.h"
 #include "audio/midi_event.h"
 #include "audio/router.h"
@@ -144,6 +148,148 @@ test_loading_fully_bridged_plugin (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_loading_plugins_in_parallel (void)
+{
+  test_helper_zrythm_init ();
+
+  /* plugins from different bundles are
+   * instantiated in parallel and plugins from the
+   * same bundle one after the other */
+  test_plugin_manager_create_tracks_from_plugin (
+    TEST_INSTRUMENT_BUNDLE_URI, TEST_INSTRUMENT_URI,
+    true, false, 2);
+  test_plugin_manager_create_tracks_from_plugin (
+    EG_AMP_BUNDLE_URI, EG_AMP_URI, false, false, 2);
+  int num_tracks = TRACKLIST->num_tracks;
+
+  test_project_save_and_reload ();
+
+  g_assert_cmpint (
+    TRACKLIST->num_tracks, ==, num_tracks);
+  for (int i = num_tracks - 4; i < num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      Plugin * pl =
+        i < num_tracks - 2 ?
+          track->channel->instrument :
+          track->channel->inserts[0];
+      g_assert_nonnull (pl);
+      g_assert_false (pl->instantiation_failed);
+      g_assert_true (pl->instantiated);
+      g_assert_true (pl->activated);
+      g_assert_nonnull (pl->lv2->instance);
+    }
+
+  /* let engine run */
+  g_usleep (100000);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_sub_block_processing (void)
+{
+  test_helper_zrythm_init ();
+
+  /* stop dummy audio engine processing so we can
+   * process manually */
+  AUDIO_ENGINE->stop_dummy_audio_thread = true;
+  g_usleep (1000000);
+
+  test_plugin_manager_create_tracks_from_plugin (
+    EG_AMP_BUNDLE_URI, EG_AMP_URI, false, false, 1);
+  Track * track =
+    TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  Plugin * pl = track->channel->inserts[0];
+  g_assert_nonnull (pl);
+
+  Port * gain = NULL;
+  Port * in = NULL;
+  for (int i = 0; i < pl->num_in_ports; i++)
+    {
+      Port * port = pl->in_ports[i];
+      if (port->id.type == TYPE_CONTROL &&
+          string_is_equal (port->id.label, "Gain"))
+        gain = port;
+      else if (port->id.type == TYPE_AUDIO)
+        in = port;
+    }
+  g_assert_nonnull (gain);
+  g_assert_nonnull (gain->at);
+  g_assert_nonnull (in);
+  g_assert_cmpint (pl->num_out_ports, ==, 1);
+  Port * out = pl->out_ports[0];
+
+  /* ramp the gain from -60 dB to 0 dB over the
+   * first bar */
+  AutomationTrack * at = gain->at;
+  Position start_pos, end_pos;
+  position_set_to_bar (&start_pos, 1);
+  position_set_to_bar (&end_pos, 2);
+  ZRegion * r =
+    automation_region_new (
+      &start_pos, &end_pos, track->pos,
+      at->index, 0);
+  track_add_region (
+    track, r, at, 0, 1, 0);
+  AutomationPoint * ap =
+    automation_point_new_float (
+      -60.f,
+      control_port_real_val_to_normalized (
+        gain, -60.f),
+      &start_pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+  ap =
+    automation_point_new_float (
+      0.f,
+      control_port_real_val_to_normalized (
+        gain, 0.f),
+      &end_pos);
+  automation_region_add_ap (
+    r, ap, F_NO_PUBLISH_EVENTS);
+
+  nframes_t nframes = AUDIO_ENGINE->block_length;
+  nframes_t granularity =
+    AUDIO_ENGINE->automation_granularity;
+  g_assert_cmpuint (granularity, <, nframes);
+  long g_start_frames = end_pos.frames / 2;
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      in->buf[i] = 1.f;
+      out->buf[i] = 0.f;
+    }
+
+  /* process as if the gain was read from
+   * automation this cycle */
+  gain->automation_read = true;
+  gain->control =
+    control_port_get_automation_val_at_frames (
+      gain, g_start_frames);
+  plugin_process (pl, g_start_frames, 0, nframes);
+  gain->automation_read = false;
+
+  /* the plugin must run once per sub-block with
+   * the gain at the start of it */
+  for (nframes_t i = 0; i < nframes; i++)
+    {
+      nframes_t sub_block_start =
+        (i / granularity) * granularity;
+      float gain_db =
+        control_port_get_automation_val_at_frames (
+          gain, g_start_frames + sub_block_start);
+      float expected =
+        powf (10.f, gain_db * 0.05f);
+      g_assert_cmpfloat_with_epsilon (
+        out->buf[i], expected, 0.0001f);
+    }
+  g_assert_cmpfloat (
+    out->buf[nframes - 1], >, out->buf[0]);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -159,6 +305,12 @@ main (int argc, char *argv[])
   g_test_add_func (
     TEST_PREFIX "test loading fully bridged plugin",
     (GTestFunc) test_loading_fully_bridged_plugin);
+  g_test_add_func (
+    TEST_PREFIX "test loading plugins in parallel",
+    (GTestFunc) test_loading_plugins_in_parallel);
+  g_test_add_func (
+    TEST_PREFIX "test sub-block processing",
+    (GTestFunc) test_sub_block_processing);
 
   return g_test_run ();
 }
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <string.h>
+
+#include "plugins/collection.h"
+#include "plugins/plugin_search_index.h"
+#include "utils/objects.h"
+
+#include "tests/helpers/zrythm.h"
+
+#define NUM_DESCRS 4
+
+static PluginDescriptor * descrs[NUM_DESCRS];
+
+static PluginDescriptor *
+create_descr (
+  const char *    name,
+  const char *    author,
+  ZPluginCategory category,
+  PluginProtocol  protocol)
+{
+  PluginDescriptor * descr =
+    object_new (PluginDescriptor);
+  descr->name = g_strdup (name);
+  descr->author = g_strdup (author);
+  descr->category = category;
+  descr->category_str =
+    g_strdup (
+      plugin_descriptor_category_strings[
+        category].str);
+  descr->protocol = protocol;
+  descr->uri = g_strdup_printf ("urn:test:%s", name);
+  return descr;
+}
+
+static PluginSearchIndex *
+create_index (void)
+{
+  descrs[0] =
+    create_descr (
+      "ZynAddSubFX", "Zyn", PC_INSTRUMENT,
+      PROT_LV2);
+  descrs[1] =
+    create_descr (
+      "Dragonfly Hall Reverb", "Michael Willis",
+      PC_REVERB, PROT_LV2);
+  descrs[2] =
+    create_descr (
+      "Dragonfly Room Reverb", "Michael Willis",
+      PC_REVERB, PROT_VST);
+  descrs[3] =
+    create_descr (
+      "x42 Digital Peak Meter", "Robin Gareus",
+      PC_ANALYZER, PROT_LV2);
+
+  PluginSearchIndex * index =
+    plugin_search_index_new ();
+  plugin_search_index_sync (
+    index, (PluginDescriptor * const *) descrs,
+    NUM_DESCRS);
+
+  return index;
+}
+
+static void
+free_index (
+  PluginSearchIndex * index)
+{
+  plugin_search_index_free (index);
+  for (int i = 0; i < NUM_DESCRS; i++)
+    {
+      object_free_w_func_and_null (
+        plugin_descriptor_free, descrs[i]);
+    }
+}
+
+static GArray *
+search (
+  PluginSearchIndex * index,
+  const char *        text)
+{
+  PluginSearchQuery query;
+  memset (&query, 0, sizeof (query));
+  query.text = text;
+  return plugin_search_index_query (index, &query);
+}
+
+static PluginDescriptor *
+result_descr (
+  GArray * results,
+  guint    i)
+{
+  return
+    g_array_index (
+      results, PluginSearchResult, i).descr;
+}
+
+static void
+test_text_search (void)
+{
+  PluginSearchIndex * index = create_index ();
+
+  /* camel case token */
+  GArray * results = search (index, "sub");
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[0]);
+  g_array_unref (results);
+
+  /* prefix of author token */
+  results = search (index, "rob");
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[3]);
+  g_array_unref (results);
+
+  /* all words must match, in any order */
+  results = search (index, "reverb drag room");
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[2]);
+  g_array_unref (results);
+
+  /* typo */
+  results = search (index, "dragnofly");
+  g_assert_cmpuint (results->len, ==, 2);
+  g_array_unref (results);
+
+  /* category */
+  results = search (index, "reverb");
+  g_assert_cmpuint (results->len, ==, 2);
+  g_array_unref (results);
+
+  /* name prefix ranked first */
+  results = search (index, "x42");
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[3]);
+  g_array_unref (results);
+
+  /* same score sorted by name */
+  results = search (index, "drag");
+  g_assert_cmpuint (results->len, ==, 2);
+  g_assert_true (result_descr (results, 0) == descrs[1]);
+  g_assert_true (result_descr (results, 1) == descrs[2]);
+  g_array_unref (results);
+
+  results = search (index, "nothing");
+  g_assert_cmpuint (results->len, ==, 0);
+  g_array_unref (results);
+
+  free_index (index);
+}
+
+static void
+test_filters (void)
+{
+  PluginSearchIndex * index = create_index ();
+
+  PluginSearchQuery query;
+  memset (&query, 0, sizeof (query));
+  g_assert_true (
+    plugin_search_query_is_empty (&query));
+
+  PluginProtocol prot = PROT_LV2;
+  query.protocols = &prot;
+  query.num_protocols = 1;
+  GArray * results =
+    plugin_search_index_query (index, &query);
+  g_assert_cmpuint (results->len, ==, 3);
+  g_array_unref (results);
+
+  query.text = "dragonfly";
+  results =
+    plugin_search_index_query (index, &query);
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[1]);
+  g_array_unref (results);
+
+  query.text = NULL;
+  query.num_protocols = 0;
+  query.types[PLUGIN_SEARCH_TYPE_INSTRUMENT] = true;
+  results =
+    plugin_search_index_query (index, &query);
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[0]);
+  g_array_unref (results);
+
+  /* collections match by plugin, not by
+   * pointer */
+  query.types[PLUGIN_SEARCH_TYPE_INSTRUMENT] = false;
+  PluginCollection * collection =
+    plugin_collection_new ();
+  PluginDescriptor * copy =
+    create_descr (
+      "Dragonfly Room Reverb", "Michael Willis",
+      PC_REVERB, PROT_VST);
+  plugin_collection_add_descriptor (
+    collection, copy);
+  query.collection = collection;
+  results =
+    plugin_search_index_query (index, &query);
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[2]);
+  g_array_unref (results);
+  plugin_descriptor_free (copy);
+  plugin_collection_free (collection);
+
+  free_index (index);
+}
+
+static void
+test_sync (void)
+{
+  PluginSearchIndex * index = create_index ();
+
+  /* remove the first 2 */
+  plugin_search_index_sync (
+    index,
+    (PluginDescriptor * const *) &descrs[2],
+    NUM_DESCRS - 2);
+  g_assert_cmpint (
+    index->num_live, ==, NUM_DESCRS - 2);
+  GArray * results = search (index, "dragonfly");
+  g_assert_cmpuint (results->len, ==, 1);
+  g_assert_true (result_descr (results, 0) == descrs[2]);
+  g_array_unref (results);
+
+  /* add them back */
+  plugin_search_index_sync (
+    index, (PluginDescriptor * const *) descrs,
+    NUM_DESCRS);
+  g_assert_cmpint (
+    index->num_live, ==, NUM_DESCRS);
+  results = search (index, "dragonfly");
+  g_assert_cmpuint (results->len, ==, 2);
+  g_array_unref (results);
+
+  free_index (index);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  test_helper_zrythm_init ();
+
+#define TEST_PREFIX "/plugins/plugin_search_index/"
+
+  g_test_add_func (
+    TEST_PREFIX "test text search",
+    (GTestFunc) test_text_search);
+  g_test_add_func (
+    TEST_PREFIX "test filters",
+    (GTestFunc) test_filters);
+  g_test_add_func (
+    TEST_PREFIX "test sync",
+    (GTestFunc) test_sync);
+
+  return g_test_run ();
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <math.h>
+
+#include "utils/delay_locked_loop.h"
+
+#include <glib.h>
+
+static double
+get_stddev (
+  const double * vals,
+  int            num_vals)
+{
+  double mean = 0.0;
+  for (int i = 0; i < num_vals; i++)
+    mean += vals[i];
+  mean /= num_vals;
+  double var = 0.0;
+  for (int i = 0; i < num_vals; i++)
+    var += (vals[i] - mean) * (vals[i] - mean);
+  return sqrt (var / num_vals);
+}
+
+/**
+ * Feeds cycle start times that are late by up to
+ * 2 ms and checks that an event at a fixed
+ * position inside each cycle maps to a much more
+ * stable frame than with the raw times.
+ */
+static void
+test_filter_jitter (void)
+{
+  const nframes_t nframes = 512;
+  const sample_rate_t sample_rate = 48000;
+  const double period =
+    (nframes * 1000000.0) / sample_rate;
+  const gint64 base = 1000000000;
+  const int num_cycles = 3000;
+  const int settle_cycles = 1500;
+
+  DelayLockedLoop dll;
+  delay_locked_loop_init (
+    &dll, DELAY_LOCKED_LOOP_DEFAULT_BANDWIDTH);
+  GRand * rand = g_rand_new_with_seed (1);
+
+  int num_vals = num_cycles - settle_cycles;
+  double filtered[num_vals];
+  double raw[num_vals];
+  for (int i = 0; i < num_cycles; i++)
+    {
+      double start = (double) base + i * period;
+      gint64 observed =
+        (gint64)
+        (start + g_rand_double_range (rand, 0, 2000));
+      delay_locked_loop_update (
+        &dll, observed, nframes, sample_rate);
+      g_assert_true (dll.running);
+
+      if (i < settle_cycles)
+        continue;
+
+      gint64 ev_time = (gint64) (start + period / 2);
+      int idx = i - settle_cycles;
+      filtered[idx] =
+        delay_locked_loop_time_to_frames (
+          &dll, ev_time);
+      raw[idx] =
+        ((double) (ev_time - observed) / period) *
+        nframes;
+      g_assert_cmpfloat (filtered[idx], >=, 0.0);
+      g_assert_cmpfloat (filtered[idx], <, nframes);
+    }
+
+  /* the period is tracked */
+  g_assert_cmpfloat_with_epsilon (
+    dll.e2, period, period * 0.001);
+
+  /* jitter is filtered */
+  g_assert_cmpfloat (
+    get_stddev (filtered, num_vals), <,
+    get_stddev (raw, num_vals) / 2);
+
+  g_rand_free (rand);
+}
+
+static void
+test_reset (void)
+{
+  DelayLockedLoop dll;
+  delay_locked_loop_init (
+    &dll, DELAY_LOCKED_LOOP_DEFAULT_BANDWIDTH);
+  g_assert_false (dll.running);
+  g_assert_cmpfloat (
+    delay_locked_loop_time_to_frames (&dll, 1000),
+    ==, 0.0);
+
+  delay_locked_loop_update (&dll, 0, 480, 48000);
+  g_assert_true (dll.running);
+  g_assert_cmpfloat_with_epsilon (
+    dll.t1, 10000.0, 0.001);
+  g_assert_cmpfloat_with_epsilon (
+    delay_locked_loop_time_to_frames (&dll, 5000),
+    240.0, 0.001);
+
+  /* on time */
+  delay_locked_loop_update (
+    &dll, 10000, 480, 48000);
+  g_assert_cmpfloat_with_epsilon (
+    dll.t0, 10000.0, 0.001);
+  g_assert_cmpfloat_with_epsilon (
+    delay_locked_loop_time_to_frames (&dll, 5000),
+    -240.0, 0.001);
+
+  /* cycle size changed */
+  delay_locked_loop_update (
+    &dll, 20000, 960, 48000);
+  g_assert_cmpuint (dll.nframes, ==, 960);
+  g_assert_cmpfloat_with_epsilon (
+    dll.t1, 40000.0, 0.001);
+
+  /* xrun */
+  delay_locked_loop_update (
+    &dll, 100000, 960, 48000);
+  g_assert_cmpfloat_with_epsilon (
+    dll.t0, 100000.0, 0.001);
+  g_assert_cmpfloat_with_epsilon (
+    dll.e2, 20000.0, 0.001);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/delay_locked_loop/"
+
+  g_test_add_func (
+    TEST_PREFIX "test filter jitter",
+    (GTestFunc) test_filter_jitter);
+  g_test_add_func (
+    TEST_PREFIX "test reset",
+    (GTestFunc) test_reset);
+
+  return g_test_run ();
+}
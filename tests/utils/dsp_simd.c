@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2021 Alexandros Theodotou <alex at zrythm dot org>
+ *
+ * This file is part of Zrythm
+ *
+ * Zrythm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Zrythm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Zrythm.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "zrythm-test-config.h"
+
+#include <string.h>
+
+#include "utils/dsp.h"
+#include "utils/dsp_simd.h"
+#include "zrythm.h"
+
+#include "tests/helpers/zrythm.h"
+
+#include <glib.h>
+
+/** Largest buffer size checked. */
+#define MAX_SIZE 131
+
+/** Largest offset into the buffers checked (covers
+ * every position within a 64-byte vector). */
+#define MAX_OFFSET 15
+
+/** Extra samples after the checked range, to catch
+ * writes past the end. */
+#define GUARD_SIZE 32
+
+#define BUF_SIZE (MAX_OFFSET + MAX_SIZE + GUARD_SIZE)
+
+/** Sizes around multiples of each vector width. */
+static const size_t sizes[] = {
+  0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32,
+  33, 47, 63, 64, 65, 127, 128, MAX_SIZE,
+};
+
+static float src1[BUF_SIZE];
+static float src2[BUF_SIZE];
+static float dest_init[BUF_SIZE];
+static float expected[BUF_SIZE];
+static float actual[BUF_SIZE];
+
+/**
+ * Calls a dsp kernel on the given buffers.
+ *
+ * Kernels that return a value write it to
+ * \p dest[0].
+ */
+typedef void (*KernelFunc) (
+  float *       dest,
+  const float * src1,
+  const float * src2,
+  size_t        size);
+
+static void
+fill_random (
+  float * buf)
+{
+  for (size_t i = 0; i < BUF_SIZE; i++)
+    {
+      buf[i] =
+        (float)
+        g_test_rand_double_range (-2.0, 2.0);
+    }
+}
+
+/**
+ * Runs the kernel with the scalar path and with
+ * each built-in SIMD level supported by the CPU
+ * and checks that the results match, for all the
+ * sizes and offsets.
+ *
+ * @param epsilon Allowed difference, or 0 if the
+ *   results must be identical.
+ */
+static void
+check_kernel (
+  KernelFunc func,
+  float      epsilon)
+{
+  test_helper_zrythm_init ();
+
+  DspSimdLevel max_level = dsp_simd_detect_level ();
+  if (max_level == DSP_SIMD_LEVEL_NONE)
+    {
+      g_test_skip ("No built-in SIMD kernels");
+      test_helper_zrythm_cleanup ();
+      return;
+    }
+
+  fill_random (src1);
+  fill_random (src2);
+  fill_random (dest_init);
+
+  for (DspSimdLevel level = DSP_SIMD_LEVEL_SSE2;
+       level <= max_level; level++)
+    {
+      for (size_t i = 0; i < G_N_ELEMENTS (sizes);
+           i++)
+        {
+          size_t size = sizes[i];
+          for (size_t offset = 0;
+               offset <= MAX_OFFSET; offset++)
+            {
+              /* misalign the sources differently
+               * from the destination */
+              size_t src_offset = MAX_OFFSET - offset;
+
+              memcpy (
+                expected, dest_init, sizeof (expected));
+              memcpy (
+                actual, dest_init, sizeof (actual));
+
+              dsp_set_simd_level (
+                DSP_SIMD_LEVEL_NONE);
+              func (
+                &expected[offset], &src1[src_offset],
+                &src2[src_offset], size);
+
+              dsp_set_simd_level (level);
+              g_assert_cmpint (
+                dsp_get_simd_level (), ==, level);
+              func (
+                &actual[offset], &src1[src_offset],
+                &src2[src_offset], size);
+
+              for (size_t j = 0; j < BUF_SIZE; j++)
+                {
+                  if (epsilon > 0.f)
+                    {
+                      g_assert_cmpfloat_with_epsilon (
+                        actual[j], expected[j],
+                        epsilon);
+                    }
+                  else
+                    {
+                      g_assert_cmpfloat (
+                        actual[j], ==, expected[j]);
+                    }
+                }
+            }
+        }
+    }
+
+  dsp_set_simd_level (DSP_SIMD_LEVEL_NONE);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+fill (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_fill (dest, 0.3f, size);
+}
+
+static void
+limit1 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_limit1 (dest, -1.f, 1.f, size);
+}
+
+static void
+abs_max (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  float peak = 0.f;
+  dsp_abs_max ((float *) _src1, &peak, size);
+  dest[0] = peak;
+}
+
+static void
+min (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dest[0] = dsp_min ((float *) _src1, size);
+}
+
+static void
+max (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dest[0] = dsp_max ((float *) _src1, size);
+}
+
+static void
+copy (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_copy (dest, _src1, size);
+}
+
+static void
+add2 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_add2 (dest, _src1, size);
+}
+
+static void
+mul_k2 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_mul_k2 (dest, 0.7f, size);
+}
+
+static void
+mix2 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_mix2 (dest, _src1, 0.5f, 1.5f, size);
+}
+
+static void
+mix2_ramp (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_mix2_ramp (
+    dest, _src1, 0.5f, 0.2f, 1.2f, size);
+}
+
+static void
+mix_add2 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_mix_add2 (
+    dest, _src1, _src2, 0.5f, 1.5f, size);
+}
+
+static void
+mix2_limit1 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  dsp_mix2_limit1 (
+    dest, _src1, 0.5f, 1.5f, -1.f, 1.f, size);
+}
+
+/**
+ * Sums 5 sources, from both buffers at different
+ * offsets.
+ */
+static void
+gather_sum_limit1 (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  const float * srcs[] = {
+    _src1, _src2, _src1 + 1, _src2 + 1, _src1 + 2 };
+  const float ks[] = {
+    0.5f, -1.2f, 0.8f, 1.1f, -0.3f };
+  dsp_gather_sum_limit1 (
+    dest, srcs, ks, G_N_ELEMENTS (srcs), -1.f,
+    1.f, size);
+}
+
+static void
+gather_sum_limit1_single (
+  float *       dest,
+  const float * _src1,
+  const float * _src2,
+  size_t        size)
+{
+  const float * srcs[] = { _src1 };
+  const float ks[] = { 0.5f };
+  dsp_gather_sum_limit1 (
+    dest, srcs, ks, 1, -1.f, 1.f, size);
+}
+
+static void
+test_fill (void)
+{
+  check_kernel (fill, 0.f);
+}
+
+static void
+test_limit1 (void)
+{
+  check_kernel (limit1, 0.f);
+}
+
+static void
+test_abs_max (void)
+{
+  check_kernel (abs_max, 0.f);
+}
+
+static void
+test_min (void)
+{
+  check_kernel (min, 0.f);
+}
+
+static void
+test_max (void)
+{
+  check_kernel (max, 0.f);
+}
+
+static void
+test_copy (void)
+{
+  check_kernel (copy, 0.f);
+}
+
+static void
+test_add2 (void)
+{
+  check_kernel (add2, 0.f);
+}
+
+static void
+test_mul_k2 (void)
+{
+  check_kernel (mul_k2, 0.f);
+}
+
+static void
+test_mix2 (void)
+{
+  check_kernel (mix2, 0.00001f);
+}
+
+static void
+test_mix2_ramp (void)
+{
+  check_kernel (mix2_ramp, 0.0001f);
+}
+
+static void
+test_mix_add2 (void)
+{
+  check_kernel (mix_add2, 0.00001f);
+}
+
+static void
+test_mix2_limit1 (void)
+{
+  check_kernel (mix2_limit1, 0.00001f);
+}
+
+static void
+test_gather_sum_limit1 (void)
+{
+  check_kernel (gather_sum_limit1, 0.00001f);
+  check_kernel (gather_sum_limit1_single, 0.00001f);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/dsp_simd/"
+
+  g_test_add_func (
+    TEST_PREFIX "test fill",
+    (GTestFunc) test_fill);
+  g_test_add_func (
+    TEST_PREFIX "test limit1",
+    (GTestFunc) test_limit1);
+  g_test_add_func (
+    TEST_PREFIX "test abs max",
+    (GTestFunc) test_abs_max);
+  g_test_add_func (
+    TEST_PREFIX "test min",
+    (GTestFunc) test_min);
+  g_test_add_func (
+    TEST_PREFIX "test max",
+    (GTestFunc) test_max);
+  g_test_add_func (
+    TEST_PREFIX "test copy",
+    (GTestFunc) test_copy);
+  g_test_add_func (
+    TEST_PREFIX "test add2",
+    (GTestFunc) test_add2);
+  g_test_add_func (
+    TEST_PREFIX "test mul k2",
+    (GTestFunc) test_mul_k2);
+  g_test_add_func (
+    TEST_PREFIX "test mix2",
+    (GTestFunc) test_mix2);
+  g_test_add_func (
+    TEST_PREFIX "test mix2 ramp",
+    (GTestFunc) test_mix2_ramp);
+  g_test_add_func (
+    TEST_PREFIX "test mix add2",
+    (GTestFunc) test_mix_add2);
+  g_test_add_func (
+    TEST_PREFIX "test mix2 limit1",
+    (GTestFunc) test_mix2_limit1);
+  g_test_add_func (
+    TEST_PREFIX "test gather sum limit1",
+    (GTestFunc) test_gather_sum_limit1);
+
+  return g_test_run ();
+}